@@ -337,6 +337,81 @@ VLC_API void filter_DeleteBlend( vlc_blender_t * );
         return p_outpic;                                                \
     }
 
+/**
+ * Slice threading API
+ *
+ * CPU filters can split their work in horizontal bands (slices) that are
+ * processed concurrently by a pool of worker threads shared by the whole
+ * process, and by the calling thread.
+ *
+ * The pool is held by the filter when it opens, and released when it
+ * closes. Each slice must only write its own lines, so that the output does
+ * not depend on the number of slices.
+ */
+
+typedef struct filter_slices_t filter_slices_t;
+
+/** Maximum number of slices per filter_slices_Run() call */
+#define FILTER_SLICES_MAX 32
+
+/**
+ * Processes one slice.
+ *
+ * \param opaque data passed to filter_slices_Run()
+ * \param i_slice index of the slice, 0 <= i_slice < i_slices
+ * \param i_slices total number of slices
+ */
+typedef void (*filter_slice_cb)( void *opaque, unsigned i_slice,
+                                 unsigned i_slices );
+
+/**
+ * Gets a reference to the process-wide worker pool, starting it if needed.
+ *
+ * \return the pool, or NULL if there is a single CPU or the worker threads
+ * could not be started. NULL is a valid filter_slices_Run() argument.
+ */
+VLC_API filter_slices_t *filter_slices_Hold( void ) VLC_USED;
+
+/**
+ * Releases a reference to the worker pool.
+ *
+ * The worker threads are stopped with the last reference.
+ */
+VLC_API void filter_slices_Release( filter_slices_t * );
+
+/**
+ * Processes the slices of a picture and waits for all of them.
+ *
+ * The number of slices is the number of threads of the pool, at most
+ * i_max_slices. Without a pool, a single slice is processed on the calling
+ * thread. Several threads may use the same pool at the same time.
+ *
+ * \param slices pool from filter_slices_Hold(), or NULL
+ * \param i_max_slices maximum number of slices (1 to FILTER_SLICES_MAX)
+ * \return the number of slices that were processed
+ */
+VLC_API unsigned filter_slices_Run( filter_slices_t *slices,
+                                    unsigned i_max_slices,
+                                    filter_slice_cb cb, void *opaque );
+
+/**
+ * Splits i_count lines in contiguous, nearly equal ranges, and returns the
+ * range [*pi_start, *pi_end) of slice i_slice.
+ *
+ * The range boundaries are multiples of i_align (except the end of the
+ * last range), e.g. 2 to keep the lines sharing 4:2:0 chroma together.
+ */
+static inline void filter_slices_GetRange( int i_count, int i_align,
+                                           unsigned i_slice, unsigned i_slices,
+                                           int *pi_start, int *pi_end )
+{
+    const int64_t i_units = ( i_count + i_align - 1 ) / i_align;
+
+    *pi_start = __MIN( i_count, i_align * ( i_units * i_slice / i_slices ) );
+    *pi_end = __MIN( i_count,
+                     i_align * ( i_units * ( i_slice + 1 ) / i_slices ) );
+}
+
 /**
  * Filter chain management API
  * The filter chain management API is used to dynamically construct filters
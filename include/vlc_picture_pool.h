@@ -130,6 +130,29 @@ void picture_pool_Cancel( picture_pool_t *, bool canceled );
 VLC_API picture_pool_t * picture_pool_Reserve(picture_pool_t *, unsigned count)
 VLC_USED;
 
+/**
+ * Picture pool usage statistics
+ */
+struct picture_pool_stats
+{
+    unsigned long gets; /**< calls to picture_pool_Get() and picture_pool_Wait() */
+    unsigned long misses; /**< picture_pool_Get() calls without a free picture */
+    unsigned long waits; /**< picture_pool_Wait() calls that had to block */
+    unsigned used; /**< pictures currently handed out */
+    unsigned used_max; /**< highest number of pictures handed out at once */
+};
+
+/**
+ * Reads the usage statistics of a pool.
+ *
+ * The counters are sampled independently, so they may be slightly
+ * inconsistent with one another while other threads use the pool.
+ *
+ * @note This function is thread-safe.
+ */
+VLC_API void picture_pool_GetStats(const picture_pool_t *,
+                                   struct picture_pool_stats *);
+
 /**
  * @return the total number of pictures in the given pool
  * @note This function is thread-safe.
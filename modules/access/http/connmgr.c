@@ -103,8 +103,13 @@ struct vlc_http_mgr
     vlc_tls_client_t *creds;
     struct vlc_http_cookie_jar_t *jar;
     struct vlc_http_conn *conn;
+    bool multiplexed; /* the last stored connection is an HTTP/2 one */
+    vlc_mutex_t lock; /* requests can be sent from several threads */
 };
 
+/* The manager lock only protects the connection and credentials pointers:
+ * it is never held while connecting nor while waiting for a response. */
+
 static struct vlc_http_conn *vlc_http_mgr_find(struct vlc_http_mgr *mgr,
                                                const char *host, unsigned port)
 {
@@ -121,48 +126,93 @@ static void vlc_http_mgr_release(struct vlc_http_mgr *mgr,
     vlc_http_conn_release(conn);
 }
 
+/* Stores a new connection, unless another request stored one meanwhile.
+ * Either way, the stream already open on it remains usable. */
+static void vlc_http_mgr_insert(struct vlc_http_mgr *mgr,
+                                struct vlc_http_conn *conn, bool multiplexed)
+{
+    vlc_mutex_lock(&mgr->lock);
+    if (mgr->conn == NULL)
+    {
+        mgr->conn = conn;
+        mgr->multiplexed = multiplexed;
+    }
+    else
+        vlc_http_conn_release(conn);
+    vlc_mutex_unlock(&mgr->lock);
+}
+
+static
+struct vlc_http_msg *vlc_http_mgr_wait(struct vlc_http_mgr *mgr,
+                                       struct vlc_http_conn *conn,
+                                       struct vlc_http_stream *stream)
+{
+    struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
+    if (m != NULL)
+        return m;
+
+    /* NOTE: If the request were not idempotent, we would not know if it
+     * was processed by the other end. Thus POST is not used/supported so
+     * far, and CONNECT is treated as if it were idempotent (which works
+     * fine here). */
+
+    /* Get rid of closing or reset connection, if not done already */
+    vlc_mutex_lock(&mgr->lock);
+    if (mgr->conn == conn)
+        vlc_http_mgr_release(mgr, conn);
+    vlc_mutex_unlock(&mgr->lock);
+    return NULL;
+}
+
 static
 struct vlc_http_msg *vlc_http_mgr_reuse(struct vlc_http_mgr *mgr,
                                         const char *host, unsigned port,
                                         const struct vlc_http_msg *req)
 {
+    vlc_mutex_lock(&mgr->lock);
     struct vlc_http_conn *conn = vlc_http_mgr_find(mgr, host, port);
     if (conn == NULL)
+    {
+        vlc_mutex_unlock(&mgr->lock);
         return NULL;
+    }
 
     struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
-    if (stream != NULL)
-    {
-        struct vlc_http_msg *m = vlc_http_msg_get_initial(stream);
-        if (m != NULL)
-            return m;
-
-        /* NOTE: If the request were not idempotent, we would not know if it
-         * was processed by the other end. Thus POST is not used/supported so
-         * far, and CONNECT is treated as if it were idempotent (which works
-         * fine here). */
+    if (stream == NULL)
+    {   /* Get rid of closing or reset connection */
+        vlc_http_mgr_release(mgr, conn);
+        vlc_mutex_unlock(&mgr->lock);
+        return NULL;
     }
-    /* Get rid of closing or reset connection */
-    vlc_http_mgr_release(mgr, conn);
-    return NULL;
+    vlc_mutex_unlock(&mgr->lock);
+
+    return vlc_http_mgr_wait(mgr, conn, stream);
 }
 
 static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
                                               const char *host, unsigned port,
                                               const struct vlc_http_msg *req)
 {
+    vlc_tls_client_t *creds;
     vlc_tls_t *tls;
     bool http2 = true;
 
+    vlc_mutex_lock(&mgr->lock);
     if (mgr->creds == NULL && mgr->conn != NULL)
+    {
+        vlc_mutex_unlock(&mgr->lock);
         return NULL; /* switch from HTTP to HTTPS not implemented */
+    }
 
     if (mgr->creds == NULL)
     {   /* First TLS connection: load x509 credentials */
         mgr->creds = vlc_tls_ClientCreate(mgr->obj);
-        if (mgr->creds == NULL)
-            return NULL;
     }
+    creds = mgr->creds;
+    vlc_mutex_unlock(&mgr->lock);
+
+    if (creds == NULL)
+        return NULL;
 
     /* TODO? non-idempotent request support */
     struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
@@ -172,12 +222,12 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
     char *proxy = vlc_http_proxy_find(host, port, true);
     if (proxy != NULL)
     {
-        tls = vlc_https_connect_proxy(mgr->creds, mgr->creds,
+        tls = vlc_https_connect_proxy(creds, creds,
                                       host, port, &http2, proxy);
         free(proxy);
     }
     else
-        tls = vlc_https_connect(mgr->creds, host, port, &http2);
+        tls = vlc_https_connect(creds, host, port, &http2);
 
     if (tls == NULL)
         return NULL;
@@ -202,16 +252,26 @@ static struct vlc_http_msg *vlc_https_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    mgr->conn = conn;
+    /* The connection is not shared until the request is sent */
+    struct vlc_http_stream *stream = vlc_http_stream_open(conn, req);
+    if (stream == NULL)
+    {
+        vlc_http_conn_release(conn);
+        return NULL;
+    }
 
-    return vlc_http_mgr_reuse(mgr, host, port, req);
+    vlc_http_mgr_insert(mgr, conn, http2);
+    return vlc_http_mgr_wait(mgr, conn, stream);
 }
 
 static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
                                              const char *host, unsigned port,
                                              const struct vlc_http_msg *req)
 {
-    if (mgr->creds != NULL && mgr->conn != NULL)
+    vlc_mutex_lock(&mgr->lock);
+    bool https = mgr->creds != NULL && mgr->conn != NULL;
+    vlc_mutex_unlock(&mgr->lock);
+    if (https)
         return NULL; /* switch from HTTPS to HTTP not implemented */
 
     struct vlc_http_msg *resp = vlc_http_mgr_reuse(mgr, host, port, req);
@@ -252,7 +312,7 @@ static struct vlc_http_msg *vlc_http_request(struct vlc_http_mgr *mgr,
         return NULL;
     }
 
-    mgr->conn = conn;
+    vlc_http_mgr_insert(mgr, conn, false);
     return resp;
 }
 
@@ -266,6 +326,14 @@ struct vlc_http_msg *vlc_http_mgr_request(struct vlc_http_mgr *mgr, bool https,
     return (https ? vlc_https_request : vlc_http_request)(mgr, host, port, m);
 }
 
+bool vlc_http_mgr_is_multiplexed(struct vlc_http_mgr *mgr)
+{
+    vlc_mutex_lock(&mgr->lock);
+    bool multiplexed = mgr->multiplexed;
+    vlc_mutex_unlock(&mgr->lock);
+    return multiplexed;
+}
+
 struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *mgr)
 {
     return mgr->jar;
@@ -283,6 +351,8 @@ struct vlc_http_mgr *vlc_http_mgr_create(vlc_object_t *obj,
     mgr->creds = NULL;
     mgr->jar = jar;
     mgr->conn = NULL;
+    mgr->multiplexed = false;
+    vlc_mutex_init(&mgr->lock);
     return mgr;
 }
 
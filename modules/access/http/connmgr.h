@@ -52,6 +52,14 @@ struct vlc_http_msg *vlc_http_mgr_request(struct vlc_http_mgr *mgr, bool https,
                                           const char *host, unsigned port,
                                           const struct vlc_http_msg *req);
 
+/**
+ * Tells whether requests share a connection.
+ *
+ * @return true if the last connection of the manager uses HTTP/2, so that
+ * concurrent requests are sent as streams of that single connection
+ */
+bool vlc_http_mgr_is_multiplexed(struct vlc_http_mgr *mgr);
+
 struct vlc_http_cookie_jar_t *vlc_http_mgr_get_jar(struct vlc_http_mgr *);
 
 /**
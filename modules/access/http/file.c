@@ -43,6 +43,7 @@ struct vlc_http_file
 {
     struct vlc_http_resource resource;
     uintmax_t offset;
+    uintmax_t end;
 };
 
 static int vlc_http_file_req(const struct vlc_http_resource *res,
@@ -69,8 +70,14 @@ static int vlc_http_file_req(const struct vlc_http_resource *res,
         }
     }
 
-    if (vlc_http_msg_add_header(req, "Range", "bytes=%" PRIuMAX "-", *offset)
-     && *offset != 0)
+    int val;
+    if (file->end != UINTMAX_MAX)
+        val = vlc_http_msg_add_header(req, "Range", "bytes=%" PRIuMAX "-%"
+                                      PRIuMAX, *offset, file->end);
+    else
+        val = vlc_http_msg_add_header(req, "Range", "bytes=%" PRIuMAX "-",
+                                      *offset);
+    if (val && (*offset != 0 || file->end != UINTMAX_MAX))
         return -1;
     return 0;
 }
@@ -126,9 +133,17 @@ struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
     }
 
     file->offset = 0;
+    file->end = UINTMAX_MAX;
     return &file->resource;
 }
 
+void vlc_http_file_set_end(struct vlc_http_resource *res, uintmax_t end)
+{
+    struct vlc_http_file *file = (struct vlc_http_file *)res;
+
+    file->end = end;
+}
+
 static uintmax_t vlc_http_msg_get_file_size(const struct vlc_http_msg *resp)
 {
     int status = vlc_http_msg_get_status(resp);
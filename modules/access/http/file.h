@@ -46,6 +46,16 @@ struct vlc_http_resource *vlc_http_file_create(struct vlc_http_mgr *mgr,
                                                const char *url, const char *ua,
                                                const char *ref);
 
+/**
+ * Sets the last byte to request.
+ *
+ * Limits the requested byte range, so that a part of the file can be read
+ * without transferring the remainder. This applies to the next request.
+ *
+ * @param end offset of the last byte to request (inclusive)
+ */
+void vlc_http_file_set_end(struct vlc_http_resource *, uintmax_t end);
+
 /**
  * Gets file size.
  *
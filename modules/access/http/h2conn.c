@@ -454,6 +454,14 @@ static struct vlc_http_stream *vlc_h2_stream_open(struct vlc_http_conn *c,
 
     vlc_h2_conn_queue(conn, f);
 
+    unsigned weight = vlc_http_msg_get_weight(msg);
+    if (weight != 0)
+    {   /* The stream priority is a hint: go on without it */
+        f = vlc_h2_frame_priority(s->id, 0, weight);
+        if (likely(f != NULL))
+            vlc_h2_conn_queue(conn, f);
+    }
+
     s->older = conn->streams;
     if (s->older != NULL)
         s->older->newer = s;
@@ -282,7 +282,7 @@ static struct vlc_h2_frame *data(bool eos)
 
 static struct vlc_h2_frame *priority(void)
 {
-    return localize(resize(retype(data(false), 0x2), 5));
+    return vlc_h2_frame_priority(STREAM_ID, 0, 16);
 }
 
 static struct vlc_h2_frame *rst_stream(void)
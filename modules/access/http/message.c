@@ -47,6 +47,7 @@ struct vlc_http_msg
     char *path;
     char *(*headers)[2];
     unsigned count;
+    unsigned weight;
     struct vlc_http_stream *payload;
 };
 
@@ -189,6 +190,17 @@ const char *vlc_http_msg_get_path(const struct vlc_http_msg *m)
     return m->path;
 }
 
+void vlc_http_msg_set_weight(struct vlc_http_msg *m, unsigned weight)
+{
+    assert(weight <= 256);
+    m->weight = weight;
+}
+
+unsigned vlc_http_msg_get_weight(const struct vlc_http_msg *m)
+{
+    return m->weight;
+}
+
 void vlc_http_msg_destroy(struct vlc_http_msg *m)
 {
     if (m->payload != NULL)
@@ -223,6 +235,7 @@ vlc_http_req_create(const char *method, const char *scheme,
     m->authority = (authority != NULL) ? strdup(authority) : NULL;
     m->path = (path != NULL) ? strdup(path) : NULL;
     m->count = 0;
+    m->weight = 0;
     m->headers = NULL;
     m->payload = NULL;
 
@@ -250,6 +263,7 @@ struct vlc_http_msg *vlc_http_resp_create(unsigned status)
     m->authority = NULL;
     m->path = NULL;
     m->count = 0;
+    m->weight = 0;
     m->headers = NULL;
     m->payload = NULL;
     return m;
@@ -216,6 +216,23 @@ const char *vlc_http_msg_get_authority(const struct vlc_http_msg *);
  */
 const char *vlc_http_msg_get_path(const struct vlc_http_msg *);
 
+/**
+ * Sets request priority.
+ *
+ * Sets the HTTP/2 weight of the request stream, relative to the other
+ * streams of the connection. HTTP/1 connections ignore it.
+ *
+ * @param weight weight from 1 to 256, or 0 to leave the default (16)
+ */
+void vlc_http_msg_set_weight(struct vlc_http_msg *, unsigned weight);
+
+/**
+ * Gets request priority.
+ *
+ * @return HTTP/2 stream weight, or 0 if unspecified
+ */
+unsigned vlc_http_msg_get_weight(const struct vlc_http_msg *);
+
 /**
  * Looks up a token in a header field.
  *
@@ -68,6 +68,9 @@ vlc_http_res_req(const struct vlc_http_resource *res, void *opaque)
     if (res->referrer != NULL) /* TODO: validate URL */
         vlc_http_msg_add_header(req, "Referer", "%s", res->referrer);
 
+    if (res->weight != 0)
+        vlc_http_msg_set_weight(req, res->weight);
+
     vlc_http_msg_add_cookies(req, vlc_http_mgr_get_jar(res->manager));
 
     /* TODO: vlc_http_msg_add_header(req, "TE", "gzip, deflate"); */
@@ -217,6 +220,7 @@ int vlc_http_res_init(struct vlc_http_resource *restrict res,
                                                : NULL;
     res->agent = (ua != NULL) ? strdup(ua) : NULL;
     res->referrer = (ref != NULL) ? strdup(ref) : NULL;
+    res->weight = 0;
 
     const char *path = url.psz_path;
     if (path == NULL)
@@ -328,6 +332,11 @@ struct block_t *vlc_http_res_read(struct vlc_http_resource *res)
     return vlc_http_msg_read(res->response);
 }
 
+void vlc_http_res_set_weight(struct vlc_http_resource *res, unsigned weight)
+{
+    res->weight = weight;
+}
+
 int vlc_http_res_set_login(struct vlc_http_resource *res,
                            const char *username, const char *password)
 {
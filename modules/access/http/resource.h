@@ -56,6 +56,7 @@ struct vlc_http_resource
     char *password;
     char *agent;
     char *referrer;
+    unsigned weight;
 };
 
 int vlc_http_res_init(struct vlc_http_resource *,
@@ -96,6 +97,13 @@ char *vlc_http_res_get_type(struct vlc_http_resource *);
  */
 struct block_t *vlc_http_res_read(struct vlc_http_resource *);
 
+/**
+ * Sets the HTTP/2 weight of the next requests.
+ *
+ * @param weight weight from 1 to 256, or 0 for the default
+ */
+void vlc_http_res_set_weight(struct vlc_http_resource *res, unsigned weight);
+
 int vlc_http_res_set_login(struct vlc_http_resource *res,
                            const char *username, const char *password);
 char *vlc_http_res_get_basic_realm(struct vlc_http_resource *res);
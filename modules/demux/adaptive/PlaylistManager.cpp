@@ -36,6 +36,7 @@
 #include "logic/AlwaysLowestAdaptationLogic.hpp"
 #include "logic/PredictiveAdaptationLogic.hpp"
 #include "logic/NearOptimalAdaptationLogic.hpp"
+#include "logic/HybridAdaptationLogic.hpp"
 #include "tools/Debug.hpp"
 #include <vlc_stream.h>
 #include <vlc_demux.h>
@@ -48,6 +49,10 @@ using namespace adaptive::http;
 using namespace adaptive::logic;
 using namespace adaptive;
 
+/* playback speed deviation used for live latency control
+ * when the playlist does not provide any rate bounds */
+#define LATENCY_CATCHUP_RATE 0.04
+
 PlaylistManager::PlaylistManager( demux_t *p_demux_,
                                   SharedResources *res,
                                   AbstractPlaylist *pl,
@@ -63,9 +68,12 @@ PlaylistManager::PlaylistManager( demux_t *p_demux_,
     resources = res;
     failedupdates = 0;
     b_thread = false;
+    interrupt = NULL;
     b_buffering = false;
     b_canceled = false;
+    b_interrupted = false;
     nextPlaylistupdate = 0;
+    lastLatencyCheck = 0;
     demux.i_nzpcr = VLC_TICK_INVALID;
     demux.i_firstpcr = VLC_TICK_INVALID;
     vlc_mutex_init(&demux.lock);
@@ -157,10 +165,18 @@ bool PlaylistManager::start()
     if(b_thread)
         return false;
 
+    interrupt = vlc_interrupt_create();
+    if(!interrupt)
+        return false;
+
     b_thread = !vlc_clone(&thread, managerThread,
                           static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT);
     if(!b_thread)
+    {
+        vlc_interrupt_destroy(interrupt);
+        interrupt = NULL;
         return false;
+    }
 
     setBufferingRunState(true);
 
@@ -176,12 +192,17 @@ void PlaylistManager::stop()
 {
     if(b_thread)
     {
+        /* abort pending transfers and waits of the buffering thread */
+        vlc_interrupt_kill(interrupt);
+
         vlc_mutex_lock(&lock);
         b_canceled = true;
         vlc_cond_signal(&waitcond);
         vlc_mutex_unlock(&lock);
 
         vlc_join(thread, NULL);
+        vlc_interrupt_destroy(interrupt);
+        interrupt = NULL;
         b_thread = false;
     }
 }
@@ -436,6 +457,8 @@ int PlaylistManager::doDemux(vlc_tick_t increment)
 
     updateControlsPosition();
 
+    adjustLiveLatency();
+
     switch(status)
     {
     case AbstractStream::status_eof:
@@ -590,7 +613,11 @@ int PlaylistManager::doControl(int i_query, va_list args)
         }
 
         case DEMUX_GET_PTS_DELAY:
-            *va_arg (args, vlc_tick_t *) = VLC_TICK_FROM_SEC(1);
+            if(playlist->targetLatency.Get())
+                *va_arg (args, vlc_tick_t *) = std::min(VLC_TICK_FROM_SEC(1),
+                                                        playlist->targetLatency.Get() / 4);
+            else
+                *va_arg (args, vlc_tick_t *) = VLC_TICK_FROM_SEC(1);
             break;
 
         default:
@@ -601,8 +628,15 @@ int PlaylistManager::doControl(int i_query, va_list args)
 
 void PlaylistManager::setBufferingRunState(bool b)
 {
+    /* Buffering holds the lock: don't wait for it to give up
+     * on a live segment or playlist that is not published yet */
+    if(!b && b_thread)
+        vlc_interrupt_raise(interrupt);
+
     vlc_mutex_lock(&lock);
     b_buffering = b;
+    if(!b)
+        b_interrupted = true;
     vlc_cond_signal(&waitcond);
     vlc_mutex_unlock(&lock);
 }
@@ -619,6 +653,13 @@ void PlaylistManager::Run()
         if (b_canceled)
             break;
 
+        if(b_interrupted)
+        {
+            /* drop the interruption if it was raised after buffering */
+            vlc_mwait_i11e(VLC_TICK_0);
+            b_interrupted = false;
+        }
+
         if(needsUpdate())
         {
             int canc = vlc_savecancel();
@@ -666,10 +707,79 @@ void PlaylistManager::Run()
 
 void * PlaylistManager::managerThread(void *opaque)
 {
-    static_cast<PlaylistManager *>(opaque)->Run();
+    PlaylistManager *manager = static_cast<PlaylistManager *>(opaque);
+    vlc_interrupt_set(manager->interrupt);
+    manager->Run();
     return NULL;
 }
 
+void PlaylistManager::adjustLiveLatency()
+{
+    const vlc_tick_t target = playlist->targetLatency.Get();
+    if(!target || !playlist->isLive())
+        return;
+
+    const vlc_tick_t now = vlc_tick_now();
+    const vlc_tick_t elapsed = now - lastLatencyCheck;
+    if(elapsed < VLC_TICK_FROM_MS(250))
+        return;
+    lastLatencyCheck = now;
+    if(elapsed > VLC_TICK_FROM_SEC(1)) /* first or resumed check */
+        return;
+
+    /* Segments are fetched as soon as they are available, so what is
+     * buffered ahead of playback is our delay to the live edge */
+    vlc_tick_t buffered = -1;
+    std::vector<AbstractStream *>::const_iterator it;
+    for(it=streams.begin(); it!=streams.end(); ++it)
+    {
+        const AbstractStream *st = *it;
+        if(st->isValid() && !st->isDisabled() && st->isSelected())
+        {
+            const vlc_tick_t amount = st->getDemuxedAmount();
+            if(buffered < 0 || amount < buffered)
+                buffered = amount;
+        }
+    }
+    if(buffered < 0)
+        return;
+
+    vlc_tick_t system, delay;
+    if(es_out_ControlGetPcrSystem(p_demux->out, &system, &delay) != VLC_SUCCESS)
+        return;
+
+    /* Catch up by moving the clock origin no faster than the allowed
+     * playback rate, decoders and audio output absorb it */
+    const vlc_tick_t latency = buffered + delay;
+    const vlc_tick_t drift = latency - target;
+    vlc_tick_t shift = 0;
+    if(playlist->maxLatency.Get() && latency > playlist->maxLatency.Get())
+    {
+        shift = drift;
+    }
+    else if(drift > target / 10)
+    {
+        double rate = playlist->maxPlaybackRate.Get();
+        if(rate <= 1.0)
+            rate = 1.0 + LATENCY_CATCHUP_RATE;
+        shift = std::min(drift, (vlc_tick_t)(elapsed * (rate - 1.0)));
+    }
+    else if(drift < -target / 10)
+    {
+        double rate = playlist->minPlaybackRate.Get();
+        if(rate <= 0.0 || rate >= 1.0)
+            rate = 1.0 - LATENCY_CATCHUP_RATE;
+        shift = std::max(drift, -(vlc_tick_t)(elapsed * (1.0 - rate)));
+    }
+
+    if(shift)
+    {
+        AdvDebug(msg_Dbg(p_demux, "live latency %" PRId64 "ms target %" PRId64 "ms, shifting %" PRId64 "ms",
+                         MS_FROM_VLC_TICK(latency), MS_FROM_VLC_TICK(target), MS_FROM_VLC_TICK(shift)));
+        es_out_ControlModifyPcrSystem(p_demux->out, true, system - shift);
+    }
+}
+
 void PlaylistManager::updateControlsPosition()
 {
     vlc_mutex_locker locker(&cached.lock);
@@ -809,6 +919,16 @@ AbstractAdaptationLogic *PlaylistManager::createLogic(AbstractAdaptationLogic::L
             if(predictivelogic)
                 conn->setDownloadRateObserver(predictivelogic);
             logic = predictivelogic;
+            break;
+        }
+        case AbstractAdaptationLogic::Hybrid:
+        {
+            AbstractAdaptationLogic *hybridlogic =
+                    new (std::nothrow) HybridAdaptationLogic(obj);
+            if(hybridlogic)
+                conn->setDownloadRateObserver(hybridlogic);
+            logic = hybridlogic;
+            break;
         }
 
         default:
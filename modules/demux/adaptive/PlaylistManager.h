@@ -24,6 +24,7 @@
 
 #include "logic/AbstractAdaptationLogic.h"
 #include "Streams.hpp"
+#include <vlc_interrupt.h>
 #include <vector>
 
 namespace adaptive
@@ -86,6 +87,7 @@ namespace adaptive
             void unsetPeriod();
 
             void updateControlsPosition();
+            void adjustLiveLatency();
 
             /* local factories */
             virtual AbstractAdaptationLogic *createLogic(AbstractAdaptationLogic::LogicType,
@@ -113,6 +115,9 @@ namespace adaptive
             time_t                               nextPlaylistupdate;
             int                                  failedupdates;
 
+            /* low latency live delay control */
+            vlc_tick_t                           lastLatencyCheck;
+
             /* Controls */
             struct
             {
@@ -134,8 +139,10 @@ namespace adaptive
             vlc_thread_t thread;
             bool         b_thread;
             vlc_cond_t   waitcond;
+            vlc_interrupt_t *interrupt;
             bool         b_buffering;
             bool         b_canceled;
+            bool         b_interrupted;
     };
 
 }
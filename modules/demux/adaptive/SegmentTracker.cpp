@@ -89,6 +89,10 @@ SegmentTracker::SegmentTracker(SharedResources *res,
     setAdaptationLogic(logic_);
     adaptationSet = adaptSet;
     format = StreamFormat::UNKNOWN;
+    prefetched.chunk = NULL;
+    prefetched.rep = NULL;
+    prefetched.number = 0;
+    prefetched.duration = 0;
 }
 
 SegmentTracker::~SegmentTracker()
@@ -154,6 +158,7 @@ bool SegmentTracker::segmentsListReady() const
 
 void SegmentTracker::reset()
 {
+    resetPrefetch();
     notify(SegmentTrackerEvent(curRepresentation, NULL));
     curRepresentation = NULL;
     init_sent = false;
@@ -184,8 +189,20 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
        (curRepresentation && !curRepresentation->getAdaptationSet()->isSegmentAligned()) )
         rep = curRepresentation;
     else
+    {
         rep = logic->getNextRepresentation(adaptationSet, curRepresentation);
 
+        /* Abandon the next segment if it won't be there in time */
+        size_t downloaded, total;
+        if(prefetched.chunk && prefetched.rep == rep && prefetched.number == next &&
+           prefetched.chunk->getDownloadProgress(&downloaded, &total) &&
+           logic->abandonSegment(rep, downloaded, total))
+        {
+            resetPrefetch();
+            rep = logic->getNextRepresentation(adaptationSet, curRepresentation);
+        }
+    }
+
     if ( rep == NULL )
             return NULL;
 
@@ -263,27 +280,40 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     }
 
     bool b_gap = false;
-    segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA, next, &next, &b_gap);
-    if(!segment)
+    SegmentChunk *chunk = NULL;
+    vlc_tick_t duration;
+    if(prefetched.chunk && prefetched.rep == rep &&
+       prefetched.number == next && !initializing)
     {
-        return NULL;
+        chunk = prefetched.chunk;
+        duration = prefetched.duration;
+        prefetched.chunk = NULL;
     }
-
-    if(initializing)
+    else
     {
-        b_gap = false;
-        /* stop initializing after 1st chunk */
-        initializing = false;
-    }
+        resetPrefetch();
 
-    SegmentChunk *chunk = segment->toChunk(resources, connManager, next, rep);
+        segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA, next, &next, &b_gap);
+        if(!segment)
+        {
+            return NULL;
+        }
+
+        if(initializing)
+        {
+            b_gap = false;
+            /* stop initializing after 1st chunk */
+            initializing = false;
+        }
+
+        chunk = segment->toChunk(resources, connManager, next, rep);
+        duration = rep->inheritTimescale().ToTime(segment->duration.Get());
+    }
 
     /* Notify new segment length for stats / logic */
     if(chunk)
     {
-        const Timescale timescale = rep->inheritTimescale();
-        notify(SegmentTrackerEvent(rep->getAdaptationSet()->getID(),
-                                   timescale.ToTime(segment->duration.Get())));
+        notify(SegmentTrackerEvent(rep->getAdaptationSet()->getID(), duration));
     }
 
     /* We need to check segment/chunk format changes, as we can't rely on representation's (HLS)*/
@@ -303,11 +333,43 @@ SegmentChunk * SegmentTracker::getNextChunk(bool switch_allowed,
     {
         curNumber = next;
         next++;
+        prefetchNextChunk(rep, connManager);
     }
 
     return chunk;
 }
 
+void SegmentTracker::prefetchNextChunk(BaseRepresentation *rep,
+                                       AbstractConnectionManager *connManager)
+{
+    /* Start the following media segment download, so it can run in parallel
+     * with the current one. Only valid as long as we don't switch or seek. */
+    if(prefetched.chunk)
+        return;
+
+    bool b_gap = false;
+    uint64_t number;
+    ISegment *segment = rep->getNextSegment(BaseRepresentation::INFOTYPE_MEDIA,
+                                            next, &number, &b_gap);
+    if(!segment || b_gap || number != next)
+        return;
+
+    prefetched.chunk = segment->toChunk(resources, connManager, number, rep);
+    if(prefetched.chunk)
+    {
+        prefetched.rep = rep;
+        prefetched.number = number;
+        prefetched.duration = rep->inheritTimescale().ToTime(segment->duration.Get());
+    }
+}
+
+void SegmentTracker::resetPrefetch()
+{
+    delete prefetched.chunk;
+    prefetched.chunk = NULL;
+    prefetched.rep = NULL;
+}
+
 bool SegmentTracker::setPositionByTime(vlc_tick_t time, bool restarted, bool tryonly)
 {
     uint64_t segnumber;
@@ -336,6 +398,7 @@ bool SegmentTracker::setPositionByTime(vlc_tick_t time, bool restarted, bool try
 
 void SegmentTracker::setPositionByNumber(uint64_t segnumber, bool restarted)
 {
+    resetPrefetch();
     if(restarted)
     {
         initializing = true;
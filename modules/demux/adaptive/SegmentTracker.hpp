@@ -140,6 +140,8 @@ namespace adaptive
         private:
             void setAdaptationLogic(AbstractAdaptationLogic *);
             void notify(const SegmentTrackerEvent &) const;
+            void prefetchNextChunk(BaseRepresentation *, AbstractConnectionManager *);
+            void resetPrefetch();
             bool first;
             bool initializing;
             bool index_sent;
@@ -152,6 +154,13 @@ namespace adaptive
             BaseAdaptationSet *adaptationSet;
             BaseRepresentation *curRepresentation;
             std::list<SegmentTrackerListenerInterface *> listeners;
+            struct
+            {
+                SegmentChunk *chunk;
+                BaseRepresentation *rep;
+                uint64_t number;
+                vlc_tick_t duration;
+            } prefetched; /* next media segment, already downloading */
     };
 }
 
@@ -40,6 +40,13 @@ SharedResources::SharedResources(vlc_object_t *obj, bool local)
     connManager = m;
 }
 
+SharedResources::SharedResources(vlc_object_t *obj, AbstractConnectionManager *manager)
+{
+    authStorage = new AuthStorage(obj);
+    encryptionKeyring = new Keyring(obj);
+    connManager = manager;
+}
+
 SharedResources::~SharedResources()
 {
     delete connManager;
@@ -42,6 +42,7 @@ namespace adaptive
     {
         public:
             SharedResources(vlc_object_t *, bool = false);
+            SharedResources(vlc_object_t *, AbstractConnectionManager *);
             ~SharedResources();
             AuthStorage *getAuthStorage();
             Keyring     *getKeyring();
@@ -89,6 +89,7 @@ bool AbstractStream::init(const StreamFormat &format_, SegmentTracker *tracker,
                     format = format_;
                     segmentTracker = tracker;
                     segmentTracker->registerListener(this);
+                    segmentTracker->registerListener(conn);
                     segmentTracker->notifyBufferingState(true);
                     connManager = conn;
                     fakeesout->setExpectedTimestamp(segmentTracker->getPlaybackTime());
@@ -298,6 +299,7 @@ AbstractStream::buffering_status AbstractStream::getLastBufferStatus() const
 
 vlc_tick_t AbstractStream::getDemuxedAmount() const
 {
+    vlc_mutex_locker locker(&lock);
     return fakeEsOut()->commandsQueue()->getDemuxedAmount();
 }
 
@@ -427,7 +429,9 @@ AbstractStream::status AbstractStream::dequeue(vlc_tick_t nz_deadline, vlc_tick_
                  msg_Dbg(p_realdemux, "Stream %s pcr %" PRId64 " dts %" PRId64 " deadline %" PRId64 " [DRAINING]",
                          description.c_str(), pcrvalue, dtsvalue, nz_deadline));
 
-        *pi_pcr = fakeEsOut()->commandsQueue()->Process(p_realdemux->out, VLC_TICK_0 + nz_deadline);
+        /* Commands take the FakeESOut lock when needed, and the demuxer can
+           keep queuing while we output */
+        *pi_pcr = fakeesout->commandsQueue()->Process(p_realdemux->out, VLC_TICK_0 + nz_deadline);
         if(!fakeEsOut()->commandsQueue()->isEmpty())
             return AbstractStream::status_demuxed;
 
@@ -453,7 +457,7 @@ AbstractStream::status AbstractStream::dequeue(vlc_tick_t nz_deadline, vlc_tick_
 
     if(nz_deadline + VLC_TICK_0 <= bufferingLevel) /* demuxed */
     {
-        *pi_pcr = fakeEsOut()->commandsQueue()->Process( p_realdemux->out, VLC_TICK_0 + nz_deadline );
+        *pi_pcr = fakeesout->commandsQueue()->Process( p_realdemux->out, VLC_TICK_0 + nz_deadline );
         return AbstractStream::status_demuxed;
     }
 
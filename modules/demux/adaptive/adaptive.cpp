@@ -76,10 +76,39 @@ static void Close   (vlc_object_t *);
 #define ADAPT_ACCESS_TEXT N_("Use regular HTTP modules")
 #define ADAPT_ACCESS_LONGTEXT N_("Connect using HTTP access instead of custom HTTP code")
 
+#define ADAPT_HTTP2_TEXT N_("Use HTTP/2 for secure streams")
+#define ADAPT_HTTP2_LONGTEXT N_("Send segment and playlist requests to a host over a " \
+                                "single connection, as concurrent HTTP/2 streams when the " \
+                                "server supports it. Playlists get a higher priority. " \
+                                "Hosts which use HTTP/2 have no limit of connections.")
+
+#define ADAPT_WORKERS_TEXT N_("Parallel downloads")
+#define ADAPT_WORKERS_LONGTEXT N_("Number of segments downloaded at the same time. " \
+                                  "Streams with the lowest buffering level are served first.")
+
+#define ADAPT_HOSTCONN_TEXT N_("Maximum connections per host")
+#define ADAPT_HOSTCONN_LONGTEXT N_("Maximum number of concurrent segment requests " \
+                                   "to a single host (0 for no limit)")
+
+#define ADAPT_RANGEPARTS_TEXT N_("Byte range parts")
+#define ADAPT_RANGEPARTS_LONGTEXT N_("Split segments of known size into that many " \
+                                     "byte ranges, fetched over parallel connections")
+
+#define ADAPT_CACHERAM_TEXT N_("Segment cache size (MiB)")
+#define ADAPT_CACHERAM_LONGTEXT N_("Keep downloaded segments in memory up to that " \
+                                   "size, so seeking back does not fetch them again")
+
+#define ADAPT_CACHEDISK_TEXT N_("Segment disk cache size (MiB)")
+#define ADAPT_CACHEDISK_LONGTEXT N_("Keep segments evicted from memory in files " \
+                                    "up to that size, for the current session (0 to disable)")
+
+#define ADAPT_CACHEDIR_TEXT N_("Segment disk cache directory")
+
 static const AbstractAdaptationLogic::LogicType pi_logics[] = {
                                 AbstractAdaptationLogic::Default,
                                 AbstractAdaptationLogic::Predictive,
                                 AbstractAdaptationLogic::NearOptimal,
+                                AbstractAdaptationLogic::Hybrid,
                                 AbstractAdaptationLogic::RateBased,
                                 AbstractAdaptationLogic::FixedRate,
                                 AbstractAdaptationLogic::AlwaysLowest,
@@ -89,6 +118,7 @@ static const char *const ppsz_logics_values[] = {
                                 "",
                                 "predictive",
                                 "nearoptimal",
+                                "hybrid",
                                 "rate",
                                 "fixedrate",
                                 "lowest",
@@ -97,6 +127,7 @@ static const char *const ppsz_logics_values[] = {
 static const char *const ppsz_logics[] = { N_("Default"),
                                            N_("Predictive"),
                                            N_("Near Optimal"),
+                                           N_("Throughput and Buffer Hybrid"),
                                            N_("Bandwidth Adaptive"),
                                            N_("Fixed Bandwidth"),
                                            N_("Lowest Bandwidth/Quality"),
@@ -122,6 +153,18 @@ vlc_module_begin ()
                      ADAPT_HEIGHT_TEXT, ADAPT_HEIGHT_TEXT, false )
         add_integer( "adaptive-bw",     250, ADAPT_BW_TEXT,     ADAPT_BW_LONGTEXT,     false )
         add_bool   ( "adaptive-use-access", false, ADAPT_ACCESS_TEXT, ADAPT_ACCESS_LONGTEXT, true );
+        add_bool   ( "adaptive-http2", false, ADAPT_HTTP2_TEXT, ADAPT_HTTP2_LONGTEXT, true )
+        add_integer_with_range( "adaptive-download-workers", 3, 1, 16,
+                                ADAPT_WORKERS_TEXT, ADAPT_WORKERS_LONGTEXT, true )
+        add_integer_with_range( "adaptive-host-connections", 2, 0, 16,
+                                ADAPT_HOSTCONN_TEXT, ADAPT_HOSTCONN_LONGTEXT, true )
+        add_integer_with_range( "adaptive-range-parts", 1, 1, 8,
+                                ADAPT_RANGEPARTS_TEXT, ADAPT_RANGEPARTS_LONGTEXT, true )
+        add_integer_with_range( "adaptive-cache-ram", 32, 0, 1024,
+                                ADAPT_CACHERAM_TEXT, ADAPT_CACHERAM_LONGTEXT, true )
+        add_integer_with_range( "adaptive-cache-disk", 0, 0, 65536,
+                                ADAPT_CACHEDISK_TEXT, ADAPT_CACHEDISK_LONGTEXT, true )
+        add_directory( "adaptive-cache-dir", NULL, ADAPT_CACHEDIR_TEXT, NULL )
         set_callbacks( Open, Close )
 vlc_module_end ()
 
@@ -65,6 +65,11 @@ std::string AbstractChunkSource::getContentType() const
     return std::string();
 }
 
+bool AbstractChunkSource::getDownloadProgress(size_t *, size_t *) const
+{
+    return false;
+}
+
 enum RequestStatus AbstractChunkSource::getRequestStatus() const
 {
     return requeststatus;
@@ -116,7 +121,8 @@ block_t * AbstractChunk::doRead(size_t size, bool b_block)
             block->i_flags |= BLOCK_FLAG_HEADER;
         bytesRead += block->i_buffer;
         onDownload(&block);
-        block->i_flags &= ~BLOCK_FLAG_HEADER;
+        if(block)
+            block->i_flags &= ~BLOCK_FLAG_HEADER;
     }
 
     return block;
@@ -127,6 +133,11 @@ bool AbstractChunk::isEmpty() const
     return !source->hasMoreData();
 }
 
+bool AbstractChunk::getDownloadProgress(size_t *downloaded, size_t *total) const
+{
+    return source->getDownloadProgress(downloaded, total);
+}
+
 block_t * AbstractChunk::readBlock()
 {
     return doRead(0, true);
@@ -142,11 +153,14 @@ HTTPChunkSource::HTTPChunkSource(const std::string& url, AbstractConnectionManag
     AbstractChunkSource(),
     connection   (NULL),
     connManager  (manager),
+    rateObserver (manager),
     consumed     (0)
 {
     vlc_mutex_init(&lock);
     prepared = false;
     eof = false;
+    cached = false;
+    multiplexed = false;
     sourceid = id;
     setUseAccess(access);
     if(!init(url))
@@ -211,6 +225,14 @@ block_t * HTTPChunkSource::read(size_t readsize)
 
     vlc_tick_t time = vlc_tick_now();
     ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    /* chunked transfers return at each chunk boundary */
+    while(ret > 0 && (size_t)ret < readsize)
+    {
+        ssize_t more = connection->read(&p_block->p_buffer[ret], readsize - ret);
+        if(more <= 0)
+            break;
+        ret += more;
+    }
     time = vlc_tick_now() - time;
     if(ret < 0)
     {
@@ -224,8 +246,8 @@ block_t * HTTPChunkSource::read(size_t readsize)
         consumed += p_block->i_buffer;
         if((size_t)ret < readsize)
             eof = true;
-        if(ret && time)
-            connManager->updateDownloadRate(sourceid, p_block->i_buffer, time);
+        if(ret && time && !cached)
+            rateObserver->updateDownloadRate(sourceid, p_block->i_buffer, time);
     }
 
     return p_block;
@@ -240,6 +262,22 @@ std::string HTTPChunkSource::getContentType() const
         return std::string();
 }
 
+const ConnectionParams & HTTPChunkSource::getConnectionParams() const
+{
+    return params;
+}
+
+void HTTPChunkSource::setDownloadRateObserver(IDownloadRateObserver *obs)
+{
+    rateObserver = obs;
+}
+
+bool HTTPChunkSource::isMultiplexed() const
+{
+    vlc_mutex_locker locker(&lock);
+    return multiplexed;
+}
+
 bool HTTPChunkSource::prepare()
 {
     if(prepared)
@@ -265,12 +303,10 @@ bool HTTPChunkSource::prepare()
         {
             if(requeststatus == RequestStatus::Redirection)
             {
-                HTTPConnection *httpconn = dynamic_cast<HTTPConnection *>(connection);
-                if(httpconn)
-                    connparams = httpconn->getRedirection();
+                connparams = connection->getRedirection();
                 connection->setUsed(false);
                 connection = NULL;
-                if(httpconn)
+                if(!connparams.getUrl().empty())
                     continue;
             }
             break;
@@ -279,6 +315,8 @@ bool HTTPChunkSource::prepare()
         /* Because we don't know Chunk size at start, we need to get size
                from content length */
         contentLength = connection->getContentLength();
+        cached = connection->isCached();
+        multiplexed = connection->isMultiplexed();
         prepared = true;
         return true;
     }
@@ -364,23 +402,24 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
 
     vlc_mutex_unlock(&lock);
 
-    block_t *p_block = block_Alloc(readsize);
-    if(!p_block)
-    {
-        eof = true;
-        return;
-    }
-
     struct
     {
         size_t size;
         vlc_tick_t time;
     } rate = {0,0};
 
-    ssize_t ret = connection->read(p_block->p_buffer, readsize);
-    if(ret <= 0)
+    /* the connection hands over its buffers, cached ones included */
+    vlc_tick_t readtime = vlc_tick_now();
+    block_t *p_block = connection->readBlock(readsize);
+    const vlc_tick_t readend = vlc_tick_now();
+    readtime = readend - readtime;
+    if(p_block && p_block->i_buffer && readtime && !cached)
+        rateObserver->updateDownloadProgress(sourceid, p_block->i_buffer, readtime, readend);
+
+    if(!p_block || p_block->i_buffer == 0)
     {
-        block_Release(p_block);
+        if(p_block)
+            block_Release(p_block);
         p_block = NULL;
         vlc_mutex_locker locker( &lock );
         done = true;
@@ -390,11 +429,12 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
     }
     else
     {
-        p_block->i_buffer = (size_t) ret;
         vlc_mutex_locker locker( &lock );
         buffered += p_block->i_buffer;
         block_ChainLastAppend(&pp_tail, p_block);
-        if((size_t) ret < readsize)
+        /* short reads are not EOF: chunked transfers are handed over
+         * as each chunk arrives (CMAF low latency) */
+        if(contentLength && buffered + consumed >= contentLength)
         {
             done = true;
             rate.size = buffered + consumed;
@@ -403,9 +443,10 @@ void HTTPChunkBufferedSource::bufferize(size_t readsize)
         }
     }
 
-    if(rate.size && rate.time)
+    /* cache hits would report a bogus throughput */
+    if(rate.size && rate.time && !cached)
     {
-        connManager->updateDownloadRate(sourceid, rate.size, rate.time);
+        rateObserver->updateDownloadRate(sourceid, rate.size, rate.time);
     }
 
     vlc_cond_signal(&avail);
@@ -427,6 +468,16 @@ bool HTTPChunkBufferedSource::hasMoreData() const
     return !eof;
 }
 
+bool HTTPChunkBufferedSource::getDownloadProgress(size_t *downloaded, size_t *total) const
+{
+    vlc_mutex_locker locker( &lock );
+    if(!prepared || !contentLength)
+        return false;
+    *downloaded = buffered + consumed;
+    *total = contentLength;
+    return true;
+}
+
 block_t * HTTPChunkBufferedSource::readBlock()
 {
     block_t *p_block = NULL;
@@ -505,6 +556,177 @@ block_t * HTTPChunkBufferedSource::read(size_t readsize)
     return p_block;
 }
 
+HTTPChunkSplitSource::HTTPChunkSplitSource(const std::string &url,
+                                           AbstractConnectionManager *manager,
+                                           const adaptive::ID &id,
+                                           const BytesRange &range, unsigned count) :
+    AbstractChunkSource(),
+    current     (0),
+    connManager (manager),
+    sourceid    (id)
+{
+    vlc_mutex_init(&lock);
+    rate.parts = 0;
+    rate.size = 0;
+    rate.start = 0;
+    rate.end = 0;
+
+    setBytesRange(range);
+
+    /* range is inclusive */
+    const size_t total = range.getEndByte() - range.getStartByte() + 1;
+    if(count == 0)
+        count = 1;
+    const size_t partsize = total / count;
+
+    size_t start = range.getStartByte();
+    for(unsigned i=0; i<count; i++)
+    {
+        const size_t end = (i + 1 == count) ? range.getEndByte()
+                                            : start + partsize - 1;
+        HTTPChunkBufferedSource *part =
+                new (std::nothrow) HTTPChunkBufferedSource(url, manager, id);
+        if(!part)
+        {
+            requeststatus = RequestStatus::GenericError;
+            break;
+        }
+        part->setBytesRange(BytesRange(start, end));
+        /* rate is only meaningful for the whole range */
+        part->setDownloadRateObserver(this);
+        parts.push_back(part);
+        start = end + 1;
+    }
+}
+
+HTTPChunkSplitSource::~HTTPChunkSplitSource()
+{
+    std::vector<HTTPChunkBufferedSource *>::iterator it;
+    for(it = parts.begin(); it != parts.end(); ++it)
+        delete *it;
+}
+
+const std::vector<HTTPChunkBufferedSource *> & HTTPChunkSplitSource::getParts() const
+{
+    return parts;
+}
+
+void HTTPChunkSplitSource::updateDownloadRate(const adaptive::ID &, size_t size,
+                                              vlc_tick_t time)
+{
+    /* Called by each completed part. Parts are downloaded in parallel,
+       so report the whole range over the elapsed wall clock time */
+    vlc_tick_t now = vlc_tick_now();
+    vlc_mutex_lock(&lock);
+    if(rate.parts == 0 || now - time < rate.start)
+        rate.start = now - time;
+    rate.end = now;
+    rate.size += size;
+    bool b_complete = (++rate.parts == parts.size());
+    size = rate.size;
+    time = rate.end - rate.start;
+    vlc_mutex_unlock(&lock);
+
+    if(b_complete && size && time)
+        connManager->updateDownloadRate(sourceid, size, time);
+}
+
+void HTTPChunkSplitSource::updateDownloadProgress(const adaptive::ID &, size_t size,
+                                                  vlc_tick_t time, vlc_tick_t date)
+{
+    connManager->updateDownloadProgress(sourceid, size, time, date);
+}
+
+bool HTTPChunkSplitSource::getDownloadProgress(size_t *downloaded, size_t *total) const
+{
+    *downloaded = *total = 0;
+    for(size_t i=0; i<parts.size(); i++)
+    {
+        size_t partdownloaded, parttotal;
+        if(!parts[i]->getDownloadProgress(&partdownloaded, &parttotal))
+            return false;
+        *downloaded += partdownloaded;
+        *total += parttotal;
+    }
+    return !parts.empty();
+}
+
+bool HTTPChunkSplitSource::hasMoreData() const
+{
+    if(requeststatus != RequestStatus::Success)
+        return false;
+    for(size_t i=current; i<parts.size(); i++)
+        if(parts[i]->hasMoreData())
+            return true;
+    return false;
+}
+
+std::string HTTPChunkSplitSource::getContentType() const
+{
+    if(parts.empty())
+        return std::string();
+    return parts.front()->getContentType();
+}
+
+block_t * HTTPChunkSplitSource::readBlock()
+{
+    while(current < parts.size() && requeststatus == RequestStatus::Success)
+    {
+        HTTPChunkBufferedSource *part = parts[current];
+        /* Blocks are passed through as received from each part */
+        block_t *p_block = part->readBlock();
+        if(part->getRequestStatus() != RequestStatus::Success)
+        {
+            requeststatus = part->getRequestStatus();
+            if(p_block)
+                block_Release(p_block);
+            return NULL;
+        }
+
+        if(p_block && p_block->i_buffer)
+            return p_block;
+
+        if(!part->hasMoreData())
+        {
+            if(++current == parts.size())
+                return p_block; /* empty end of data block */
+        }
+
+        if(p_block)
+            block_Release(p_block);
+    }
+    return NULL;
+}
+
+block_t * HTTPChunkSplitSource::read(size_t size)
+{
+    block_t *p_chain = NULL;
+    block_t **pp_chain_last = &p_chain;
+    size_t total = 0;
+
+    while(total < size && current < parts.size() &&
+          requeststatus == RequestStatus::Success)
+    {
+        HTTPChunkBufferedSource *part = parts[current];
+        block_t *p_block = part->read(size - total);
+        if(part->getRequestStatus() != RequestStatus::Success)
+            requeststatus = part->getRequestStatus();
+        if(p_block)
+        {
+            total += p_block->i_buffer;
+            block_ChainLastAppend(&pp_chain_last, p_block);
+        }
+        if(!part->hasMoreData())
+            current++;
+        else if(!p_block)
+            break;
+    }
+
+    if(p_chain == NULL || p_chain->p_next == NULL)
+        return p_chain;
+    return block_ChainGather(p_chain);
+}
+
 HTTPChunk::HTTPChunk(const std::string &url, AbstractConnectionManager *manager,
                      const adaptive::ID &id, bool access):
     AbstractChunk(new HTTPChunkSource(url, manager, id, access))
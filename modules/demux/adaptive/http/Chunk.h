@@ -28,6 +28,7 @@
 #include "BytesRange.hpp"
 #include "ConnectionParams.hpp"
 #include "../ID.hpp"
+#include "../logic/IDownloadRateObserver.h"
 #include <vector>
 #include <string>
 #include <stdint.h>
@@ -53,6 +54,7 @@ namespace adaptive
                 void                setBytesRange   (const BytesRange &);
                 const BytesRange &  getBytesRange   () const;
                 virtual std::string getContentType  () const;
+                virtual bool        getDownloadProgress(size_t *, size_t *) const;
                 enum RequestStatus  getRequestStatus() const;
 
             protected:
@@ -71,6 +73,7 @@ namespace adaptive
                 size_t              getBytesRead            () const;
                 uint64_t            getStartByteInFile      () const;
                 bool                isEmpty                 () const;
+                bool                getDownloadProgress     (size_t *, size_t *) const;
 
                 virtual block_t *   readBlock       ();
                 virtual block_t *   read            (size_t);
@@ -97,6 +100,9 @@ namespace adaptive
                 virtual block_t *   read            (size_t); /* impl */
                 virtual bool        hasMoreData     () const; /* impl */
                 virtual std::string getContentType  () const; /* reimpl */
+                const ConnectionParams & getConnectionParams() const;
+                void                setDownloadRateObserver(IDownloadRateObserver *);
+                bool                isMultiplexed() const;
 
                 static const size_t CHUNK_SIZE = 32768;
 
@@ -104,10 +110,13 @@ namespace adaptive
                 virtual bool        prepare();
                 AbstractConnection    *connection;
                 AbstractConnectionManager *connManager;
+                IDownloadRateObserver *rateObserver;
                 mutable vlc_mutex_t lock;
                 size_t              consumed; /* read pointer */
                 bool                prepared;
                 bool                eof;
+                bool                cached; /* served from cache, no rate to report */
+                bool                multiplexed; /* over an HTTP/2 connection */
                 ID                  sourceid;
 
             private:
@@ -126,6 +135,7 @@ namespace adaptive
                 virtual block_t *  readBlock       (); /* reimpl */
                 virtual block_t *  read            (size_t); /* reimpl */
                 virtual bool       hasMoreData     () const; /* impl */
+                virtual bool       getDownloadProgress(size_t *, size_t *) const; /* reimpl */
                 void               hold();
                 void               release();
 
@@ -145,6 +155,41 @@ namespace adaptive
                 bool                held;
         };
 
+        /* Fetches a known size range as consecutive sub ranges, each one
+           downloaded on its own connection, and returns them in order */
+        class HTTPChunkSplitSource : public AbstractChunkSource,
+                                     public IDownloadRateObserver
+        {
+            public:
+                HTTPChunkSplitSource(const std::string &url, AbstractConnectionManager *,
+                                     const ID &, const BytesRange &, unsigned);
+                virtual ~HTTPChunkSplitSource();
+                virtual block_t *   readBlock       (); /* impl */
+                virtual block_t *   read            (size_t); /* impl */
+                virtual bool        hasMoreData     () const; /* impl */
+                virtual std::string getContentType  () const; /* reimpl */
+                virtual bool        getDownloadProgress(size_t *, size_t *) const; /* reimpl */
+                virtual void        updateDownloadRate(const ID &, size_t, vlc_tick_t); /* impl */
+                virtual void        updateDownloadProgress(const ID &, size_t, vlc_tick_t, vlc_tick_t); /* reimpl */
+                const std::vector<HTTPChunkBufferedSource *> & getParts() const;
+
+                static const size_t MIN_PART_SIZE = 512 * 1024;
+
+            private:
+                std::vector<HTTPChunkBufferedSource *> parts;
+                size_t              current;
+                AbstractConnectionManager *connManager;
+                ID                  sourceid;
+                vlc_mutex_t         lock;
+                struct
+                {
+                    unsigned parts;
+                    size_t size;
+                    vlc_tick_t start;
+                    vlc_tick_t end;
+                } rate;
+        };
+
         class HTTPChunk : public AbstractChunk
         {
             public:
@@ -29,41 +29,60 @@
 
 using namespace adaptive::http;
 
-Downloader::Downloader()
+Downloader::Job::Job(HTTPChunkBufferedSource *source_,
+                     const std::string &host_, const ID &id_)
+{
+    source = source_;
+    host = host_;
+    id = id_;
+    started = false;
+    busy = false;
+}
+
+Downloader::Downloader(unsigned workers_, unsigned hostlimit_)
 {
     vlc_mutex_init(&lock);
     vlc_cond_init(&waitcond);
+    vlc_cond_init(&updatedcond);
     killed = false;
-    thread_handle_valid = false;
+    workers = VLC_CLIP(workers_, 1, MAX_WORKERS);
+    hostlimit = hostlimit_;
 }
 
 bool Downloader::start()
 {
-    if(!thread_handle_valid &&
-       vlc_clone(&thread_handle, downloaderThread,
-                 static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+    if(!threads.empty())
+        return true;
+
+    for(unsigned i=0; i<workers; i++)
     {
-        return false;
+        vlc_thread_t thread_handle;
+        if(vlc_clone(&thread_handle, downloaderThread,
+                     static_cast<void *>(this), VLC_THREAD_PRIORITY_INPUT))
+            break;
+        threads.push_back(thread_handle);
     }
-    thread_handle_valid = true;
-    return true;
+    return !threads.empty();
 }
 
 Downloader::~Downloader()
 {
     vlc_mutex_lock( &lock );
     killed = true;
-    vlc_cond_signal(&waitcond);
+    vlc_cond_broadcast(&waitcond);
     vlc_mutex_unlock( &lock );
 
-    if(thread_handle_valid)
-        vlc_join(thread_handle, NULL);
+    std::vector<vlc_thread_t>::const_iterator it;
+    for(it = threads.begin(); it != threads.end(); ++it)
+        vlc_join(*it, NULL);
 }
+
 void Downloader::schedule(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
     source->hold();
-    chunks.push_back(source);
+    chunks.push_back(Job(source, source->getConnectionParams().getHostname(),
+                         source->sourceid));
     vlc_cond_signal(&waitcond);
     vlc_mutex_unlock(&lock);
 }
@@ -71,11 +90,40 @@ void Downloader::schedule(HTTPChunkBufferedSource *source)
 void Downloader::cancel(HTTPChunkBufferedSource *source)
 {
     vlc_mutex_lock(&lock);
+    for(;;)
+    {
+        std::list<Job>::iterator it;
+        for(it = chunks.begin(); it != chunks.end(); ++it)
+            if((*it).source == source)
+                break;
+        if(it == chunks.end())
+            break;
+        /* can't remove while a worker is reading into it */
+        if(!(*it).busy)
+        {
+            releaseJob(it);
+            chunks.erase(it);
+            vlc_cond_signal(&waitcond);
+            break;
+        }
+        vlc_cond_wait(&updatedcond, &lock);
+    }
     source->release();
-    chunks.remove(source);
     vlc_mutex_unlock(&lock);
 }
 
+void Downloader::setDeadline(const ID &id, vlc_tick_t level)
+{
+    vlc_mutex_locker locker(&lock);
+    deadlines[id] = level;
+}
+
+void Downloader::clearDeadline(const ID &id)
+{
+    vlc_mutex_locker locker(&lock);
+    deadlines.erase(id);
+}
+
 void * Downloader::downloaderThread(void *opaque)
 {
     Downloader *instance = static_cast<Downloader *>(opaque);
@@ -91,27 +139,89 @@ void Downloader::DownloadSource(HTTPChunkBufferedSource *source)
         source->bufferize(HTTPChunkSource::CHUNK_SIZE);
 }
 
+std::list<Downloader::Job>::iterator Downloader::getNextJob()
+{
+    /* Earliest deadline first: the stream with the lowest buffering level
+     * gets served first. Ties keep queue order, so a stream's segments
+     * are still completed in sequence. Streams that did not report any
+     * level yet come last. New requests need a host slot, unless the
+     * host multiplexes them over a single HTTP/2 connection. */
+    std::list<Job>::iterator best = chunks.end();
+    vlc_tick_t bestdeadline = 0;
+    std::list<Job>::iterator it;
+    for(it = chunks.begin(); it != chunks.end(); ++it)
+    {
+        const Job &job = *it;
+        if(job.busy)
+            continue;
+
+        if(!job.started && hostlimit &&
+           multiplexedhosts.find(job.host) == multiplexedhosts.end())
+        {
+            std::map<std::string, unsigned>::const_iterator slot = hostslots.find(job.host);
+            if(slot != hostslots.end() && (*slot).second >= hostlimit)
+                continue;
+        }
+
+        std::map<ID, vlc_tick_t>::const_iterator dl = deadlines.find(job.id);
+        vlc_tick_t deadline = (dl != deadlines.end()) ? (*dl).second : INT64_MAX;
+        if(best == chunks.end() || deadline < bestdeadline)
+        {
+            best = it;
+            bestdeadline = deadline;
+        }
+    }
+    return best;
+}
+
+void Downloader::releaseJob(std::list<Job>::iterator it)
+{
+    if((*it).started)
+    {
+        std::map<std::string, unsigned>::iterator slot = hostslots.find((*it).host);
+        if(slot != hostslots.end() && --(*slot).second == 0)
+            hostslots.erase(slot);
+        (*it).started = false;
+    }
+}
+
 void Downloader::Run()
 {
     vlc_mutex_lock(&lock);
     while(1)
     {
-        while(chunks.empty() && !killed)
+        std::list<Job>::iterator it;
+        while(!killed && (it = getNextJob()) == chunks.end())
             vlc_cond_wait(&waitcond, &lock);
 
         if(killed)
             break;
 
-        if(!chunks.empty())
+        Job &job = *it;
+        job.busy = true;
+        if(!job.started)
+        {
+            job.started = true;
+            hostslots[job.host]++;
+        }
+        HTTPChunkBufferedSource *source = job.source;
+
+        vlc_mutex_unlock(&lock);
+        DownloadSource(source);
+        vlc_mutex_lock(&lock);
+
+        job.busy = false;
+        if(source->isMultiplexed())
+            multiplexedhosts.insert(job.host);
+        if(source->isDone())
         {
-            HTTPChunkBufferedSource *source = chunks.front();
-            DownloadSource(source);
-            if(source->isDone())
-            {
-                chunks.pop_front();
-                source->release();
-            }
+            releaseJob(it);
+            chunks.erase(it);
+            source->release();
         }
+        /* either another job can use the slot, or this one is available */
+        vlc_cond_signal(&waitcond);
+        vlc_cond_broadcast(&updatedcond);
     }
     vlc_mutex_unlock(&lock);
 }
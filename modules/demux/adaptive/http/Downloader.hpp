@@ -21,9 +21,14 @@
 #define DOWNLOADER_HPP
 
 #include "Chunk.h"
+#include "../ID.hpp"
 
 #include <vlc_common.h>
 #include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
 
 namespace adaptive
 {
@@ -34,22 +39,43 @@ namespace adaptive
         class Downloader
         {
             public:
-                Downloader();
+                Downloader(unsigned = 1, unsigned = 0);
                 ~Downloader();
                 bool start();
                 void schedule(HTTPChunkBufferedSource *);
                 void cancel(HTTPChunkBufferedSource *);
+                void setDeadline(const ID &, vlc_tick_t);
+                void clearDeadline(const ID &);
+
+                static const unsigned MAX_WORKERS = 16;
 
             private:
+                class Job
+                {
+                    public:
+                        Job(HTTPChunkBufferedSource *, const std::string &, const ID &);
+                        HTTPChunkBufferedSource *source;
+                        std::string host;
+                        ID          id;
+                        bool        started; /* holds a host slot */
+                        bool        busy; /* bufferizing on a worker */
+                };
                 static void * downloaderThread(void *);
                 void Run();
                 void DownloadSource(HTTPChunkBufferedSource *);
-                vlc_thread_t thread_handle;
+                std::list<Job>::iterator getNextJob();
+                void releaseJob(std::list<Job>::iterator);
+                std::vector<vlc_thread_t> threads;
+                unsigned     workers;
+                unsigned     hostlimit;
                 vlc_mutex_t  lock;
                 vlc_cond_t   waitcond;
-                bool         thread_handle_valid;
+                vlc_cond_t   updatedcond;
                 bool         killed;
-                std::list<HTTPChunkBufferedSource *> chunks;
+                std::list<Job> chunks;
+                std::map<std::string, unsigned> hostslots;
+                std::set<std::string> multiplexedhosts; /* negotiated HTTP/2 */
+                std::map<ID, vlc_tick_t> deadlines;
         };
 
     }
@@ -30,6 +30,14 @@
 #include <cstdio>
 #include <sstream>
 #include <vlc_stream.h>
+#include <vlc_block.h>
+
+extern "C"
+{
+#include "../../../access/http/connmgr.h"
+#include "../../../access/http/resource.h"
+#include "../../../access/http/file.h"
+}
 
 using namespace adaptive::http;
 
@@ -65,6 +73,37 @@ const std::string & AbstractConnection::getContentType() const
     return contentType;
 }
 
+const ConnectionParams & AbstractConnection::getRedirection() const
+{
+    return locationparams;
+}
+
+block_t * AbstractConnection::readBlock(size_t len)
+{
+    block_t *p_block = block_Alloc(len);
+    if(!p_block)
+        return NULL;
+
+    ssize_t ret = read(p_block->p_buffer, len);
+    if(ret < 0)
+    {
+        block_Release(p_block);
+        return NULL;
+    }
+    p_block->i_buffer = ret;
+    return p_block;
+}
+
+bool AbstractConnection::isCached() const
+{
+    return false;
+}
+
+bool AbstractConnection::isMultiplexed() const
+{
+    return false;
+}
+
 HTTPConnection::HTTPConnection(vlc_object_t *p_object_, AuthStorage *auth,
                                Transport *socket_, const ConnectionParams &proxy, bool persistent)
     : AbstractConnection( p_object_ )
@@ -229,7 +268,8 @@ ssize_t HTTPConnection::read(void *p_buffer, size_t len)
     if(ret >= 0)
         bytesRead += ret;
 
-    if(ret < 0 || (size_t)ret < len || /* set EOF */
+    /* chunked reads return at chunk boundaries */
+    if(ret < 0 || ((size_t)ret < len && (!chunked || chunked_eof || ret == 0)) || /* set EOF */
        (contentLength == bytesRead && connectionClose))
     {
         transport->disconnect();
@@ -351,6 +391,9 @@ ssize_t HTTPConnection::readChunk(void *p_buffer, size_t len)
             ssize_t in = transport->read(&crlf, 2);
             if(in < 2 || memcmp(crlf, "\r\n", 2))
                 return (copied == 0) ? -1 : copied;
+            /* don't wait for the next chunk to deliver this one */
+            if(copied > 0)
+                break;
         }
     }
 
@@ -463,11 +506,6 @@ std::string HTTPConnection::extraRequestHeaders() const
     return ss.str();
 }
 
-const ConnectionParams & HTTPConnection::getRedirection() const
-{
-    return locationparams;
-}
-
 StreamUrlConnection::StreamUrlConnection(vlc_object_t *p_object)
     : AbstractConnection(p_object)
 {
@@ -579,6 +617,200 @@ void StreamUrlConnection::setUsed( bool b )
        reset();
 }
 
+H2Connection::H2Connection(vlc_object_t *p_object_, struct vlc_http_mgr *mgr_)
+    : AbstractConnection(p_object_)
+{
+    mgr = mgr_;
+    resource = NULL;
+    p_pending = NULL;
+    char *psz_useragent = var_InheritString(p_object_, "http-user-agent");
+    if(psz_useragent)
+        useragent = std::string(psz_useragent);
+    free(psz_useragent);
+}
+
+H2Connection::~H2Connection()
+{
+    reset();
+}
+
+void H2Connection::reset()
+{
+    if(p_pending)
+        block_Release(p_pending);
+    p_pending = NULL;
+    /* also cancels the stream if it was not read to the end */
+    if(resource)
+        vlc_http_res_destroy(resource);
+    resource = NULL;
+    bytesRead = 0;
+    contentLength = 0;
+    contentType = std::string();
+    bytesRange = BytesRange();
+}
+
+bool H2Connection::canReuse(const ConnectionParams &params_) const
+{
+    /* playlists are not cached, segments are */
+    return available && params.usesAccess() == params_.usesAccess() &&
+           params.getScheme() == params_.getScheme() &&
+           params.getHostname() == params_.getHostname() &&
+           params.getPort() == params_.getPort();
+}
+
+enum RequestStatus
+    H2Connection::request(const std::string &path, const BytesRange &range)
+{
+    reset();
+
+    /* Set new path for this query */
+    params.setPath(path);
+    locationparams = ConnectionParams();
+
+    msg_Dbg(p_object, "Retrieving %s @%zu", params.getUrl().c_str(),
+                      range.isValid() ? range.getStartByte() : 0);
+
+    resource = vlc_http_file_create(mgr, params.getUrl().c_str(),
+                                    useragent.empty() ? NULL : useragent.c_str(), NULL);
+    if(!resource)
+        return RequestStatus::GenericError;
+
+    /* playlist reloads must not wait behind segments */
+    if(params.usesAccess())
+        vlc_http_res_set_weight(resource, PLAYLIST_WEIGHT);
+
+    uintmax_t start = 0;
+    if(range.isValid())
+    {
+        start = range.getStartByte();
+        if(range.getEndByte() > 0)
+            vlc_http_file_set_end(resource, range.getEndByte());
+    }
+
+    /* Opens a new stream on the host connection, or sets it up */
+    if(vlc_http_file_seek(resource, start) != 0)
+    {
+        reset();
+        return RequestStatus::GenericError;
+    }
+
+    const int status = vlc_http_res_get_status(resource);
+    if(status >= 300 && status < 400)
+    {
+        char *psz_redirect = vlc_http_res_get_redirect(resource);
+        reset();
+        if(!psz_redirect)
+            return RequestStatus::GenericError;
+        locationparams = ConnectionParams(psz_redirect);
+        free(psz_redirect);
+        msg_Info(p_object, "%d redirection to %s", status, locationparams.getUrl().c_str());
+        if(locationparams.isLocal() && !params.isLocal())
+        {
+            msg_Err(p_object, "redirection to local rejected");
+            return RequestStatus::GenericError;
+        }
+        return RequestStatus::Redirection;
+    }
+    else if((status != 200 || start > 0) && status != 206)
+    {
+        msg_Err(p_object, "Failed reading %s: %d", params.getUrl().c_str(), status);
+        reset();
+        return RequestStatus::NotFound;
+    }
+
+    char *psz_type = vlc_http_res_get_type(resource);
+    if(psz_type)
+    {
+        contentType = std::string(psz_type);
+        free(psz_type);
+    }
+
+    bytesRange = range;
+    if(range.isValid() && range.getEndByte() > 0)
+    {
+        contentLength = range.getEndByte() - range.getStartByte() + 1;
+    }
+    else
+    {
+        uintmax_t size = vlc_http_file_get_size(resource);
+        if(size != UINTMAX_MAX && size > start)
+            contentLength = size - start;
+    }
+
+    return RequestStatus::Success;
+}
+
+ssize_t H2Connection::read(void *p_buffer, size_t len)
+{
+    if(!resource)
+        return VLC_EGENERIC;
+
+    if(len == 0)
+        return VLC_SUCCESS;
+
+    const size_t toRead = (contentLength) ? contentLength - bytesRead : len;
+    if (toRead == 0)
+        return VLC_SUCCESS;
+
+    if(len > toRead)
+        len = toRead;
+
+    /* Returns on each received frame, as chunked reads do */
+    size_t copied = 0;
+    while(copied == 0)
+    {
+        if(!p_pending && !(p_pending = vlc_http_file_read(resource)))
+            break;
+
+        copied = std::min(p_pending->i_buffer, len);
+        memcpy(p_buffer, p_pending->p_buffer, copied);
+        p_pending->p_buffer += copied;
+        p_pending->i_buffer -= copied;
+        if(p_pending->i_buffer == 0)
+        {
+            block_Release(p_pending);
+            p_pending = NULL;
+        }
+    }
+
+    bytesRead += copied;
+    return copied;
+}
+
+block_t * H2Connection::readBlock(size_t len)
+{
+    if(!resource)
+        return NULL;
+
+    const size_t toRead = (contentLength) ? contentLength - bytesRead : len;
+    if(toRead == 0 || len == 0)
+        return block_Alloc(0);
+
+    if(!p_pending && !(p_pending = vlc_http_file_read(resource)))
+        return block_Alloc(0);
+
+    /* Hands over the received frame as is */
+    if(p_pending->i_buffer > std::min(len, toRead))
+        return AbstractConnection::readBlock(len);
+
+    block_t *p_block = p_pending;
+    p_pending = NULL;
+    bytesRead += p_block->i_buffer;
+    return p_block;
+}
+
+bool H2Connection::isMultiplexed() const
+{
+    return vlc_http_mgr_is_multiplexed(mgr);
+}
+
+void H2Connection::setUsed( bool b )
+{
+    available = !b;
+    if(available)
+        reset();
+}
+
 NativeConnectionFactory::NativeConnectionFactory( AuthStorage *auth )
     : AbstractConnectionFactory()
 {
@@ -636,22 +868,76 @@ AbstractConnection * StreamUrlConnectionFactory::createConnection(vlc_object_t *
     return new (std::nothrow) StreamUrlConnection(p_object);
 }
 
+H2ConnectionFactory::H2ConnectionFactory( AuthStorage *auth )
+    : AbstractConnectionFactory()
+{
+    authStorage = auth;
+}
+
+H2ConnectionFactory::~H2ConnectionFactory()
+{
+    std::map<std::string, struct vlc_http_mgr *>::const_iterator it;
+    for(it = managers.begin(); it != managers.end(); ++it)
+        vlc_http_mgr_destroy((*it).second);
+}
+
+AbstractConnection * H2ConnectionFactory::createConnection(vlc_object_t *p_object,
+                                                           const ConnectionParams &params)
+{
+    if(params.getScheme() != "https" || params.getHostname().empty())
+        return NULL;
+
+    /* One manager, and then one connection, per host. Requests to it
+     * are sent as concurrent streams, without new handshakes */
+    std::ostringstream os;
+    os.imbue(std::locale("C"));
+    os << params.getHostname() << ":" << params.getPort();
+    const std::string key = os.str();
+
+    struct vlc_http_mgr *mgr;
+    std::map<std::string, struct vlc_http_mgr *>::const_iterator it = managers.find(key);
+    if(it != managers.end())
+    {
+        mgr = (*it).second;
+    }
+    else
+    {
+        mgr = vlc_http_mgr_create(p_object, authStorage->getJar());
+        if(!mgr)
+            return NULL;
+        managers.insert(std::pair<std::string, struct vlc_http_mgr *>(key, mgr));
+    }
+
+    return new (std::nothrow) H2Connection(p_object, mgr);
+}
+
 ConnectionFactory::ConnectionFactory( AuthStorage *authstorage )
 {
     native = new NativeConnectionFactory( authstorage );
     streamurl = new StreamUrlConnectionFactory();
+    h2 = new H2ConnectionFactory( authstorage );
 }
 
 ConnectionFactory::~ConnectionFactory()
 {
     delete native;
     delete streamurl;
+    delete h2;
 }
 
 AbstractConnection * ConnectionFactory::createConnection(vlc_object_t *p_object,
                                                          const ConnectionParams &params)
 {
     bool b_streamurl = var_InheritBool(p_object, "adaptive-use-access");
+    /* segments and playlists are multiplexed on the HTTP/2 connection */
+    if(!b_streamurl && params.getScheme() == "https" &&
+       var_InheritBool(p_object, "adaptive-http2"))
+    {
+        AbstractConnection *conn = h2->createConnection(p_object, params);
+        if(conn)
+            return conn;
+    }
+
     if(!b_streamurl && !params.usesAccess())
     {
         return native->createConnection(p_object, params);
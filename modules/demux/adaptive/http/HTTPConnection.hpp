@@ -29,6 +29,10 @@
 #include "BytesRange.hpp"
 #include <vlc_common.h>
 #include <string>
+#include <map>
+
+struct vlc_http_mgr;
+struct vlc_http_resource;
 
 namespace adaptive
 {
@@ -49,14 +53,21 @@ namespace adaptive
                 virtual enum RequestStatus
                                 request     (const std::string& path, const BytesRange & = BytesRange()) = 0;
                 virtual ssize_t read        (void *p_buffer, size_t len) = 0;
+                /* returns an empty block at the end of the reply,
+                 * NULL on error */
+                virtual block_t * readBlock (size_t len);
 
                 virtual size_t  getContentLength() const;
                 virtual const std::string & getContentType() const;
+                virtual const ConnectionParams & getRedirection() const;
+                virtual bool    isCached() const;
+                virtual bool    isMultiplexed() const;
                 virtual void    setUsed( bool ) = 0;
 
             protected:
                 vlc_object_t      *p_object;
                 ConnectionParams   params;
+                ConnectionParams   locationparams;
                 bool               available;
                 size_t             contentLength;
                 std::string        contentType;
@@ -77,7 +88,6 @@ namespace adaptive
                 virtual ssize_t read        (void *p_buffer, size_t len);
 
                 void setUsed( bool );
-                const ConnectionParams &getRedirection() const;
                 static const unsigned MAX_REDIRECTS = 3;
 
             protected:
@@ -98,7 +108,6 @@ namespace adaptive
                 std::string useragent;
 
                 AuthStorage        *authStorage;
-                ConnectionParams    locationparams;
                 ConnectionParams    proxyparams;
                 bool                connectionClose;
                 bool                chunked;
@@ -131,6 +140,34 @@ namespace adaptive
                 stream_t *p_streamurl;
        };
 
+       /* Request over a shared vlc_http_mgr, multiplexed with the
+        * other ones on a single HTTP/2 connection per host */
+       class H2Connection : public AbstractConnection
+       {
+            public:
+                H2Connection(vlc_object_t *, struct vlc_http_mgr *);
+                virtual ~H2Connection();
+
+                virtual bool    canReuse     (const ConnectionParams &) const;
+
+                virtual enum RequestStatus
+                                request     (const std::string& path, const BytesRange & = BytesRange());
+                virtual ssize_t read        (void *p_buffer, size_t len);
+                virtual block_t * readBlock (size_t len); /* reimpl */
+                virtual bool    isMultiplexed() const; /* reimpl */
+
+                virtual void    setUsed( bool );
+
+                static const unsigned PLAYLIST_WEIGHT = 256;
+
+            protected:
+                void reset();
+                struct vlc_http_mgr *mgr;
+                struct vlc_http_resource *resource;
+                block_t *p_pending;
+                std::string useragent;
+       };
+
        class AbstractConnectionFactory
        {
            public:
@@ -157,6 +194,17 @@ namespace adaptive
                virtual AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &);
        };
 
+       class H2ConnectionFactory : public AbstractConnectionFactory
+       {
+           public:
+               H2ConnectionFactory( AuthStorage * );
+               virtual ~H2ConnectionFactory();
+               virtual AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &);
+           private:
+               AuthStorage *authStorage;
+               std::map<std::string, struct vlc_http_mgr *> managers;
+       };
+
        class ConnectionFactory : public AbstractConnectionFactory
        {
            public:
@@ -166,6 +214,7 @@ namespace adaptive
            private:
                NativeConnectionFactory *native;
                StreamUrlConnectionFactory *streamurl;
+               H2ConnectionFactory *h2;
        };
     }
 }
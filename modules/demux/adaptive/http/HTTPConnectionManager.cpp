@@ -28,10 +28,16 @@
 #include "HTTPConnectionManager.h"
 #include "HTTPConnection.hpp"
 #include "ConnectionParams.hpp"
+#include "BytesRange.hpp"
+#include "Chunk.h"
 #include "Transport.hpp"
 #include "Downloader.hpp"
+#include "SegmentCache.hpp"
 #include <vlc_url.h>
 #include <vlc_http.h>
+#include <vlc_configuration.h>
+
+#include <algorithm>
 
 using namespace adaptive::http;
 
@@ -53,6 +59,13 @@ void AbstractConnectionManager::updateDownloadRate(const adaptive::ID &sourceid,
         rateObserver->updateDownloadRate(sourceid, size, time);
 }
 
+void AbstractConnectionManager::updateDownloadProgress(const adaptive::ID &sourceid, size_t size,
+                                                       vlc_tick_t time, vlc_tick_t date)
+{
+    if(rateObserver)
+        rateObserver->updateDownloadProgress(sourceid, size, time, date);
+}
+
 void AbstractConnectionManager::setDownloadRateObserver(IDownloadRateObserver *obs)
 {
     rateObserver = obs;
@@ -64,16 +77,47 @@ HTTPConnectionManager::HTTPConnectionManager    (vlc_object_t *p_object_, AuthSt
       localAllowed(false)
 {
     vlc_mutex_init(&lock);
-    downloader = new (std::nothrow) Downloader();
+    unsigned workers = var_InheritInteger(p_object, "adaptive-download-workers");
+    unsigned hostlimit = var_InheritInteger(p_object, "adaptive-host-connections");
+    downloader = new (std::nothrow) Downloader(workers, hostlimit);
     downloader->start();
+    rangeparts = var_InheritInteger(p_object, "adaptive-range-parts");
     factory = new ConnectionFactory(storage);
+
+    size_t ramsize = var_InheritInteger(p_object, "adaptive-cache-ram") << 20;
+    size_t disksize = var_InheritInteger(p_object, "adaptive-cache-disk") << 20;
+    if(ramsize || disksize)
+    {
+        std::string dir;
+        char *psz_dir = var_InheritString(p_object, "adaptive-cache-dir");
+        if(!psz_dir && disksize)
+        {
+            char *psz_cachedir = config_GetUserDir(VLC_CACHE_DIR);
+            if(psz_cachedir && asprintf(&psz_dir, "%s" DIR_SEP "adaptive", psz_cachedir) == -1)
+                psz_dir = NULL;
+            free(psz_cachedir);
+        }
+        if(psz_dir)
+            dir = psz_dir;
+        free(psz_dir);
+
+        SegmentCache *cache = new (std::nothrow) SegmentCache(p_object, ramsize, disksize, dir);
+        AbstractConnectionFactory *cachedfactory = NULL;
+        if(cache)
+            cachedfactory = new (std::nothrow) CachedConnectionFactory(factory, cache);
+        if(cachedfactory)
+            factory = cachedfactory;
+        else
+            delete cache;
+    }
 }
 
 HTTPConnectionManager::~HTTPConnectionManager   ()
 {
     delete downloader;
-    delete factory;
+    /* connections can still be using the factory's shared transports */
     this->closeAllConnections();
+    delete factory;
 }
 
 void HTTPConnectionManager::closeAllConnections      ()
@@ -141,11 +185,42 @@ AbstractConnection * HTTPConnectionManager::getConnection(ConnectionParams &para
     return conn;
 }
 
+AbstractChunkSource *HTTPConnectionManager::makeSource(const std::string &url,
+                                                      const ID &id, const BytesRange &range)
+{
+    /* Split large known size ranges over multiple connections */
+    if(rangeparts > 1 && range.isValid() &&
+       range.getEndByte() > range.getStartByte())
+    {
+        const size_t size = range.getEndByte() - range.getStartByte() + 1;
+        unsigned parts = std::min((size_t) rangeparts,
+                                  size / HTTPChunkSplitSource::MIN_PART_SIZE);
+        if(parts > 1)
+            return new (std::nothrow) HTTPChunkSplitSource(url, this, id, range, parts);
+    }
+
+    HTTPChunkBufferedSource *source = new (std::nothrow) HTTPChunkBufferedSource(url, this, id);
+    if(source && range.isValid())
+        source->setBytesRange(range);
+    return source;
+}
+
 void HTTPConnectionManager::start(AbstractChunkSource *source)
 {
     HTTPChunkBufferedSource *src = dynamic_cast<HTTPChunkBufferedSource *>(source);
     if(src)
+    {
         downloader->schedule(src);
+        return;
+    }
+
+    HTTPChunkSplitSource *split = dynamic_cast<HTTPChunkSplitSource *>(source);
+    if(split)
+    {
+        std::vector<HTTPChunkBufferedSource *>::const_iterator it;
+        for(it = split->getParts().begin(); it != split->getParts().end(); ++it)
+            downloader->schedule(*it);
+    }
 }
 
 void HTTPConnectionManager::cancel(AbstractChunkSource *source)
@@ -155,6 +230,21 @@ void HTTPConnectionManager::cancel(AbstractChunkSource *source)
         downloader->cancel(src);
 }
 
+void HTTPConnectionManager::trackerEvent(const SegmentTrackerEvent &event)
+{
+    /* Downloads are scheduled by stream buffering level */
+    if(event.type == SegmentTrackerEvent::BUFFERING_LEVEL_CHANGE)
+    {
+        downloader->setDeadline(*event.u.buffering_level.id,
+                                event.u.buffering_level.current);
+    }
+    else if(event.type == SegmentTrackerEvent::BUFFERING_STATE &&
+            !event.u.buffering.enabled)
+    {
+        downloader->clearDeadline(*event.u.buffering.id);
+    }
+}
+
 void HTTPConnectionManager::setLocalConnectionsAllowed()
 {
     localAllowed = true;
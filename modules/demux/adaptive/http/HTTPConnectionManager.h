@@ -26,6 +26,7 @@
 #define HTTPCONNECTIONMANAGER_H_
 
 #include "../logic/IDownloadRateObserver.h"
+#include "../SegmentTracker.hpp"
 
 #include <vlc_common.h>
 
@@ -42,18 +43,24 @@ namespace adaptive
         class AuthStorage;
         class Downloader;
         class AbstractChunkSource;
+        class BytesRange;
 
-        class AbstractConnectionManager : public IDownloadRateObserver
+        class AbstractConnectionManager : public IDownloadRateObserver,
+                                          public SegmentTrackerListenerInterface
         {
             public:
                 AbstractConnectionManager(vlc_object_t *);
                 ~AbstractConnectionManager();
                 virtual void    closeAllConnections () = 0;
                 virtual AbstractConnection * getConnection(ConnectionParams &) = 0;
+                virtual AbstractChunkSource *makeSource(const std::string &,
+                                                        const ID &, const BytesRange &) = 0;
                 virtual void start(AbstractChunkSource *) = 0;
                 virtual void cancel(AbstractChunkSource *) = 0;
 
                 virtual void updateDownloadRate(const ID &, size_t, vlc_tick_t); /* impl */
+                virtual void updateDownloadProgress(const ID &, size_t, vlc_tick_t, vlc_tick_t); /* reimpl */
+                virtual void trackerEvent(const SegmentTrackerEvent &) {} /* impl */
                 void setDownloadRateObserver(IDownloadRateObserver *);
 
             protected:
@@ -71,9 +78,12 @@ namespace adaptive
 
                 virtual void    closeAllConnections () /* impl */;
                 virtual AbstractConnection * getConnection(ConnectionParams &) /* impl */;
+                virtual AbstractChunkSource *makeSource(const std::string &,
+                                                        const ID &, const BytesRange &) /* impl */;
 
                 virtual void start(AbstractChunkSource *) /* impl */;
                 virtual void cancel(AbstractChunkSource *) /* impl */;
+                virtual void trackerEvent(const SegmentTrackerEvent &); /* reimpl */
                 void         setLocalConnectionsAllowed();
 
             private:
@@ -83,6 +93,7 @@ namespace adaptive
                 std::vector<AbstractConnection *>                   connectionPool;
                 AbstractConnectionFactory                          *factory;
                 bool                                                localAllowed;
+                unsigned                                            rangeparts;
                 AbstractConnection * reuseConnection(ConnectionParams &);
         };
     }
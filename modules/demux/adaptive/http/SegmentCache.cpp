@@ -0,0 +1,740 @@
+/*
+ * SegmentCache.cpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SegmentCache.hpp"
+
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_rand.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace adaptive::http;
+
+/* Disk entry: magic, key length, content type length (native endian),
+ * then the key, the content type and the segment data */
+#define DISK_MAGIC      "VLCSEGC1"
+#define DISK_HEADER_SIZE 16
+
+#define SESSION_PREFIX  "session-"
+#define SESSION_EXPIRY  (24 * 3600)
+
+namespace
+{
+    struct SegmentDataView
+    {
+        block_t      self;
+        SegmentData *data;
+    };
+}
+
+static void SegmentDataView_Release(block_t *p_block)
+{
+    SegmentDataView *view = container_of(p_block, SegmentDataView, self);
+    view->data->release();
+    delete view;
+}
+
+static const struct vlc_block_callbacks segmentDataViewCbs =
+{
+    SegmentDataView_Release,
+};
+
+SegmentData::SegmentData()
+    : refs(1)
+{
+    p_chain = NULL;
+    pp_last = &p_chain;
+    size = 0;
+}
+
+SegmentData::~SegmentData()
+{
+    block_ChainRelease(p_chain);
+}
+
+SegmentData * SegmentData::create()
+{
+    return new (std::nothrow) SegmentData();
+}
+
+SegmentData * SegmentData::hold()
+{
+    refs.fetch_add(1, std::memory_order_relaxed);
+    return this;
+}
+
+void SegmentData::release()
+{
+    if(refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete this;
+}
+
+void SegmentData::append(block_t *p_block)
+{
+    size += p_block->i_buffer;
+    block_ChainLastAppend(&pp_last, p_block);
+}
+
+block_t * SegmentData::view(const uint8_t *p_buffer, size_t len)
+{
+    SegmentDataView *view = new (std::nothrow) SegmentDataView;
+    if(!view)
+        return NULL;
+    view->data = hold();
+    return block_Init(&view->self, &segmentDataViewCbs,
+                      const_cast<uint8_t *>(p_buffer), len);
+}
+
+block_t * SegmentData::unshare(block_t *p_block)
+{
+    if(p_block->cbs != &segmentDataViewCbs)
+        return p_block;
+    block_t *p_copy = block_Duplicate(p_block);
+    block_Release(p_block);
+    return p_copy;
+}
+
+SegmentCache::Stats::Stats()
+{
+    hits = 0;
+    diskhits = 0;
+    misses = 0;
+    evictions = 0;
+    ramsize = 0;
+    disksize = 0;
+}
+
+SegmentCache::RamEntry::RamEntry(const std::string &key_, const std::string &type_,
+                                 SegmentData *data_)
+    : key(key_), type(type_), data(data_)
+{
+}
+
+SegmentCache::DiskEntry::DiskEntry(const std::string &name_, size_t size_)
+    : name(name_), size(size_)
+{
+}
+
+SegmentCache::SegmentCache(vlc_object_t *obj, size_t ramsize, size_t disksize,
+                           const std::string &dir_)
+{
+    p_object = obj;
+    ramMax = ramsize;
+    diskMax = dir_.empty() ? 0 : disksize;
+    dir = dir_;
+    vlc_mutex_init(&lock);
+    if(diskMax)
+        openSession();
+}
+
+SegmentCache::~SegmentCache()
+{
+    msg_Dbg(p_object, "segment cache: %" PRIu64 " hits (%" PRIu64 " from disk), "
+                      "%" PRIu64 " misses, %" PRIu64 " evictions",
+            stats.hits, stats.diskhits, stats.misses, stats.evictions);
+    std::list<RamEntry>::iterator it;
+    for(it = ramList.begin(); it != ramList.end(); ++it)
+        (*it).data->release();
+    if(diskMax)
+        closeSession();
+}
+
+std::string SegmentCache::makeKey(const ConnectionParams &params, const BytesRange &range)
+{
+    std::ostringstream os;
+    os.imbue(std::locale("C"));
+    os << params.getUrl();
+    if(range.isValid())
+        os << "#" << range.getStartByte() << "-" << range.getEndByte();
+    return os.str();
+}
+
+std::string SegmentCache::hashKey(const std::string &key)
+{
+    struct md5_s md5;
+    InitMD5(&md5);
+    AddMD5(&md5, key.c_str(), key.length());
+    EndMD5(&md5);
+    char *psz = psz_md5_hash(&md5);
+    if(!psz)
+        return std::string();
+    std::string hash(psz);
+    free(psz);
+    return hash;
+}
+
+std::string SegmentCache::getFilePath(const std::string &name) const
+{
+    return dir + DIR_SEP + name;
+}
+
+size_t SegmentCache::getMaxEntrySize() const
+{
+    return std::max(ramMax, diskMax);
+}
+
+SegmentCache::Stats SegmentCache::getStats() const
+{
+    vlc_mutex_locker locker(&lock);
+    return stats;
+}
+
+SegmentData * SegmentCache::get(const std::string &key, std::string *type)
+{
+    vlc_mutex_lock(&lock);
+
+    std::map<std::string, std::list<RamEntry>::iterator>::iterator it = ramIndex.find(key);
+    if(it != ramIndex.end())
+    {
+        ramList.splice(ramList.begin(), ramList, it->second);
+        SegmentData *data = (*it->second).data->hold();
+        *type = (*it->second).type;
+        stats.hits++;
+        vlc_mutex_unlock(&lock);
+        return data;
+    }
+
+    const std::string name = diskMax ? hashKey(key) : std::string();
+    std::map<std::string, std::list<DiskEntry>::iterator>::iterator dit = diskIndex.find(name);
+    if(dit != diskIndex.end())
+    {
+        diskList.splice(diskList.begin(), diskList, dit->second);
+        vlc_mutex_unlock(&lock);
+
+        SegmentData *data = readDisk(name, key, type);
+
+        vlc_mutex_lock(&lock);
+        if(data)
+        {
+            stats.hits++;
+            stats.diskhits++;
+            vlc_mutex_unlock(&lock);
+            return data;
+        }
+
+        /* unreadable or colliding, forget that file */
+        dit = diskIndex.find(name);
+        if(dit != diskIndex.end())
+        {
+            stats.disksize -= (*dit->second).size;
+            diskList.erase(dit->second);
+            diskIndex.erase(dit);
+        }
+    }
+
+    stats.misses++;
+    vlc_mutex_unlock(&lock);
+    return NULL;
+}
+
+void SegmentCache::put(const std::string &key, const std::string &type, SegmentData *data)
+{
+    std::list<RamEntry> demoted;
+
+    vlc_mutex_lock(&lock);
+    if(ramIndex.find(key) != ramIndex.end() || data->size > getMaxEntrySize())
+    {
+        vlc_mutex_unlock(&lock);
+        data->release();
+        return;
+    }
+
+    if(data->size <= ramMax)
+    {
+        ramList.push_front(RamEntry(key, type, data));
+        ramIndex[key] = ramList.begin();
+        stats.ramsize += data->size;
+        while(stats.ramsize > ramMax)
+        {
+            std::list<RamEntry>::iterator last = --ramList.end();
+            stats.ramsize -= (*last).data->size;
+            stats.evictions++;
+            ramIndex.erase((*last).key);
+            demoted.splice(demoted.end(), ramList, last);
+        }
+    }
+    else demoted.push_back(RamEntry(key, type, data));
+    vlc_mutex_unlock(&lock);
+
+    /* disk writes happen outside of the lock */
+    std::list<RamEntry>::const_iterator it;
+    for(it = demoted.begin(); it != demoted.end(); ++it)
+    {
+        if(diskMax && (*it).data->size <= diskMax)
+            writeDisk(*it);
+        (*it).data->release();
+    }
+}
+
+static void removeDir(const std::string &path)
+{
+    DIR *p_dir = vlc_opendir(path.c_str());
+    if(p_dir)
+    {
+        const char *psz_name;
+        while((psz_name = vlc_readdir(p_dir)) != NULL)
+        {
+            if(strcmp(psz_name, ".") && strcmp(psz_name, ".."))
+                vlc_unlink((path + DIR_SEP + psz_name).c_str());
+        }
+        closedir(p_dir);
+    }
+    rmdir(path.c_str());
+}
+
+void SegmentCache::openSession()
+{
+    if(vlc_mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST)
+    {
+        msg_Warn(p_object, "cannot create segment cache directory %s", dir.c_str());
+        diskMax = 0;
+        return;
+    }
+
+    /* Entries carry no validator, so they are only trusted for the session
+     * that stored them. Leftovers of sessions which did not close are
+     * swept once they have not been written for a day. */
+    DIR *p_dir = vlc_opendir(dir.c_str());
+    if(p_dir)
+    {
+        const time_t expiry = time(NULL) - SESSION_EXPIRY;
+        const char *psz_name;
+        while((psz_name = vlc_readdir(p_dir)) != NULL)
+        {
+            const std::string path = getFilePath(psz_name);
+            struct stat st;
+            if(!strncmp(psz_name, SESSION_PREFIX, strlen(SESSION_PREFIX)) &&
+               vlc_stat(path.c_str(), &st) == 0 && st.st_mtime < expiry)
+                removeDir(path);
+        }
+        closedir(p_dir);
+    }
+
+    for(unsigned i = 0; i < 8; i++)
+    {
+        uint8_t rnd[8];
+        vlc_rand_bytes(rnd, sizeof(rnd));
+        char psz_name[sizeof(SESSION_PREFIX) + 2 * sizeof(rnd)];
+        snprintf(psz_name, sizeof(psz_name), SESSION_PREFIX "%02x%02x%02x%02x%02x%02x%02x%02x",
+                 rnd[0], rnd[1], rnd[2], rnd[3], rnd[4], rnd[5], rnd[6], rnd[7]);
+        const std::string path = getFilePath(psz_name);
+        if(vlc_mkdir(path.c_str(), 0700) == 0)
+        {
+            dir = path;
+            msg_Dbg(p_object, "segment cache: storing to %s", dir.c_str());
+            return;
+        }
+        if(errno != EEXIST)
+            break;
+    }
+
+    msg_Warn(p_object, "cannot create segment cache session in %s", dir.c_str());
+    diskMax = 0;
+}
+
+void SegmentCache::closeSession()
+{
+    std::list<DiskEntry>::const_iterator it;
+    for(it = diskList.begin(); it != diskList.end(); ++it)
+        vlc_unlink(getFilePath((*it).name).c_str());
+    diskList.clear();
+    diskIndex.clear();
+    stats.disksize = 0;
+    /* also removes interrupted writes */
+    removeDir(dir);
+}
+
+void SegmentCache::evictDisk(std::list<std::string> *unlinked)
+{
+    while(stats.disksize > diskMax && !diskList.empty())
+    {
+        const DiskEntry &last = diskList.back();
+        stats.disksize -= last.size;
+        stats.evictions++;
+        diskIndex.erase(last.name);
+        unlinked->push_back(last.name);
+        diskList.pop_back();
+    }
+}
+
+SegmentData * SegmentCache::readDisk(const std::string &name, const std::string &key,
+                                     std::string *type) const
+{
+    int fd = vlc_open(getFilePath(name).c_str(), O_RDONLY);
+    if(fd == -1)
+        return NULL;
+    /* mapped whenever possible */
+    block_t *p_block = block_File(fd, false);
+    vlc_close(fd);
+    if(!p_block)
+        return NULL;
+
+    uint32_t keylen, typelen;
+    if(p_block->i_buffer < DISK_HEADER_SIZE ||
+       memcmp(p_block->p_buffer, DISK_MAGIC, 8))
+    {
+        block_Release(p_block);
+        return NULL;
+    }
+    memcpy(&keylen, &p_block->p_buffer[8], 4);
+    memcpy(&typelen, &p_block->p_buffer[12], 4);
+    if(p_block->i_buffer - DISK_HEADER_SIZE < (uint64_t) keylen + typelen ||
+       keylen != key.length() ||
+       memcmp(&p_block->p_buffer[DISK_HEADER_SIZE], key.c_str(), keylen))
+    {
+        block_Release(p_block);
+        return NULL;
+    }
+
+    SegmentData *data = SegmentData::create();
+    if(!data)
+    {
+        block_Release(p_block);
+        return NULL;
+    }
+    type->assign((const char *) &p_block->p_buffer[DISK_HEADER_SIZE + keylen], typelen);
+    p_block->p_buffer += DISK_HEADER_SIZE + keylen + typelen;
+    p_block->i_buffer -= DISK_HEADER_SIZE + keylen + typelen;
+    data->append(p_block);
+    return data;
+}
+
+static bool writeAll(int fd, const void *p_data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *) p_data;
+    while(size > 0)
+    {
+        ssize_t ret = vlc_write(fd, p, size);
+        if(ret <= 0)
+            return false;
+        p += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+void SegmentCache::writeDisk(const RamEntry &entry)
+{
+    const std::string name = hashKey(entry.key);
+    if(name.empty())
+        return;
+
+    vlc_mutex_lock(&lock);
+    bool b_stored = diskIndex.find(name) != diskIndex.end();
+    vlc_mutex_unlock(&lock);
+    if(b_stored)
+        return;
+
+    char *psz_tmp = strdup(getFilePath("tmpXXXXXX").c_str());
+    if(!psz_tmp)
+        return;
+    int fd = vlc_mkstemp(psz_tmp);
+    if(fd == -1)
+    {
+        free(psz_tmp);
+        return;
+    }
+
+    const uint32_t keylen = entry.key.length();
+    const uint32_t typelen = entry.type.length();
+    bool b_ok = writeAll(fd, DISK_MAGIC, 8) &&
+                writeAll(fd, &keylen, 4) &&
+                writeAll(fd, &typelen, 4) &&
+                writeAll(fd, entry.key.c_str(), keylen) &&
+                writeAll(fd, entry.type.c_str(), typelen);
+    for(const block_t *p_block = entry.data->p_chain; b_ok && p_block; p_block = p_block->p_next)
+        b_ok = writeAll(fd, p_block->p_buffer, p_block->i_buffer);
+    vlc_close(fd);
+
+    /* only complete files get their final name */
+    if(!b_ok || vlc_rename(psz_tmp, getFilePath(name).c_str()) != 0)
+    {
+        vlc_unlink(psz_tmp);
+        free(psz_tmp);
+        return;
+    }
+    free(psz_tmp);
+
+    std::list<std::string> unlinked;
+    vlc_mutex_lock(&lock);
+    if(diskIndex.find(name) == diskIndex.end())
+    {
+        const size_t size = DISK_HEADER_SIZE + keylen + typelen + entry.data->size;
+        diskList.push_front(DiskEntry(name, size));
+        diskIndex[name] = diskList.begin();
+        stats.disksize += size;
+        evictDisk(&unlinked);
+    }
+    vlc_mutex_unlock(&lock);
+
+    std::list<std::string>::const_iterator it;
+    for(it = unlinked.begin(); it != unlinked.end(); ++it)
+        vlc_unlink(getFilePath(*it).c_str());
+}
+
+CachedConnection::CachedConnection(vlc_object_t *p_object_, SegmentCache *cache_,
+                                   AbstractConnection *conn)
+    : AbstractConnection(p_object_)
+{
+    cache = cache_;
+    connection = conn;
+    p_cached = NULL;
+    p_served = NULL;
+    servedOffset = 0;
+    p_record = NULL;
+}
+
+CachedConnection::~CachedConnection()
+{
+    reset();
+    delete connection;
+}
+
+void CachedConnection::reset()
+{
+    if(p_cached)
+        p_cached->release();
+    p_cached = NULL;
+    p_served = NULL;
+    servedOffset = 0;
+    if(p_record)
+        p_record->release();
+    p_record = NULL;
+    key.clear();
+}
+
+bool CachedConnection::prepare(const ConnectionParams &params_)
+{
+    if(!AbstractConnection::prepare(params_))
+        return false;
+    return connection->prepare(params_);
+}
+
+bool CachedConnection::canReuse(const ConnectionParams &params_) const
+{
+    return available && !params_.usesAccess() && connection->canReuse(params_);
+}
+
+enum RequestStatus
+    CachedConnection::request(const std::string &path, const BytesRange &range)
+{
+    reset();
+    params.setPath(path);
+    key = SegmentCache::makeKey(params, range);
+    bytesRead = 0;
+
+    p_cached = cache->get(key, &contentType);
+    if(p_cached)
+    {
+        msg_Dbg(p_object, "Retrieving %s @%zu from cache", params.getUrl().c_str(),
+                           range.isValid() ? range.getStartByte() : 0);
+        contentLength = p_cached->size;
+        p_served = p_cached->p_chain;
+        return RequestStatus::Success;
+    }
+
+    enum RequestStatus status = connection->request(path, range);
+    contentLength = connection->getContentLength();
+    contentType = connection->getContentType();
+    if(status == RequestStatus::Success && contentLength <= cache->getMaxEntrySize())
+        p_record = SegmentData::create();
+    return status;
+}
+
+/* Keeps a received block for the cache, stores the data once complete.
+ * Returns false if the block can't be recorded. */
+bool CachedConnection::record(block_t *p_block)
+{
+    if(p_record->size + p_block->i_buffer > cache->getMaxEntrySize())
+        return false;
+
+    if(p_block->i_buffer)
+        p_record->append(p_block);
+
+    /* size is unknown for chunked replies, until the last one */
+    if((contentLength && p_record->size == contentLength) ||
+       (!contentLength && p_block->i_buffer == 0 && p_record->size))
+    {
+        cache->put(key, contentType, p_record);
+        p_record = NULL;
+        reset();
+    }
+    return true;
+}
+
+ssize_t CachedConnection::read(void *p_buffer, size_t len)
+{
+    if(p_cached)
+    {
+        size_t copied = 0;
+        while(p_served && copied < len)
+        {
+            size_t size = std::min(len - copied, p_served->i_buffer - servedOffset);
+            memcpy(&((uint8_t *)p_buffer)[copied], &p_served->p_buffer[servedOffset], size);
+            copied += size;
+            servedOffset += size;
+            if(servedOffset == p_served->i_buffer)
+            {
+                p_served = p_served->p_next;
+                servedOffset = 0;
+            }
+        }
+        bytesRead += copied;
+        return copied;
+    }
+
+    ssize_t ret = connection->read(p_buffer, len);
+    if(!p_record)
+        return ret;
+
+    block_t *p_block = (ret >= 0) ? block_Alloc(ret) : NULL;
+    if(!p_block)
+    {
+        /* incomplete */
+        reset();
+        return ret;
+    }
+    memcpy(p_block->p_buffer, p_buffer, ret);
+    if(!record(p_block))
+    {
+        block_Release(p_block);
+        reset();
+    }
+    else if(ret == 0)
+        block_Release(p_block);
+    return ret;
+}
+
+block_t * CachedConnection::readBlock(size_t len)
+{
+    if(p_cached)
+    {
+        /* hands over views on the cached blocks */
+        while(p_served && servedOffset == p_served->i_buffer)
+        {
+            p_served = p_served->p_next;
+            servedOffset = 0;
+        }
+        if(!p_served)
+            return block_Alloc(0);
+
+        size_t size = std::min(len, p_served->i_buffer - servedOffset);
+        block_t *p_block = p_cached->view(&p_served->p_buffer[servedOffset], size);
+        if(p_block)
+        {
+            servedOffset += size;
+            bytesRead += size;
+        }
+        return p_block;
+    }
+
+    block_t *p_block = connection->readBlock(len);
+    if(!p_record)
+        return p_block;
+
+    if(!p_block)
+    {
+        /* incomplete */
+        reset();
+        return NULL;
+    }
+
+    if(p_block->i_buffer == 0)
+    {
+        record(p_block);
+        return p_block;
+    }
+
+    /* the recorded block is handed over through a view */
+    SegmentData *data = p_record;
+    block_t *p_view = data->view(p_block->p_buffer, p_block->i_buffer);
+    if(!p_view || !record(p_block))
+    {
+        if(p_view)
+            block_Release(p_view);
+        reset();
+        return p_block;
+    }
+    return p_view;
+}
+
+const ConnectionParams & CachedConnection::getRedirection() const
+{
+    return connection->getRedirection();
+}
+
+bool CachedConnection::isCached() const
+{
+    return p_cached != NULL;
+}
+
+bool CachedConnection::isMultiplexed() const
+{
+    return connection->isMultiplexed();
+}
+
+void CachedConnection::setUsed(bool b)
+{
+    available = !b;
+    if(available)
+        reset();
+    connection->setUsed(b);
+}
+
+CachedConnectionFactory::CachedConnectionFactory(AbstractConnectionFactory *factory_,
+                                                 SegmentCache *cache_)
+    : AbstractConnectionFactory()
+{
+    factory = factory_;
+    cache = cache_;
+}
+
+CachedConnectionFactory::~CachedConnectionFactory()
+{
+    delete factory;
+    delete cache;
+}
+
+AbstractConnection * CachedConnectionFactory::createConnection(vlc_object_t *p_object,
+                                                               const ConnectionParams &params)
+{
+    AbstractConnection *conn = factory->createConnection(p_object, params);
+    /* playlists are always requested through access, and never cached */
+    if(!conn || params.usesAccess())
+        return conn;
+
+    CachedConnection *cached = new (std::nothrow) CachedConnection(p_object, cache, conn);
+    if(!cached)
+        delete conn;
+    return cached;
+}
@@ -0,0 +1,169 @@
+/*
+ * SegmentCache.hpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SEGMENTCACHE_HPP
+#define SEGMENTCACHE_HPP
+
+#include "HTTPConnection.hpp"
+
+#include <vlc_common.h>
+#include <atomic>
+#include <list>
+#include <map>
+#include <string>
+
+namespace adaptive
+{
+
+    namespace http
+    {
+
+        /* Segment data as a chain of blocks, shared between the cache and
+         * the readers. Readers get views on the blocks, which hold the data:
+         * it is never copied, and must not be modified in place. */
+        class SegmentData
+        {
+            public:
+                static SegmentData * create();
+                SegmentData * hold();
+                void      release();
+                void      append(block_t *);
+                block_t * view(const uint8_t *, size_t);
+                /* returns a block which can be modified in place */
+                static block_t * unshare(block_t *);
+
+                block_t  *p_chain;
+                size_t    size;
+
+            private:
+                SegmentData();
+                ~SegmentData();
+                block_t **pp_last;
+                std::atomic<unsigned> refs;
+        };
+
+        /* Segments data keyed by url and byte range, kept in memory
+         * then demoted to files in a per session directory, removed on
+         * close. Both tiers are bounded and evict LRU first. */
+        class SegmentCache
+        {
+            public:
+                SegmentCache(vlc_object_t *, size_t, size_t, const std::string &);
+                ~SegmentCache();
+
+                static std::string makeKey(const ConnectionParams &, const BytesRange &);
+                SegmentData * get(const std::string &, std::string *);
+                void      put(const std::string &, const std::string &, SegmentData *);
+                size_t    getMaxEntrySize() const;
+
+                class Stats
+                {
+                    public:
+                        Stats();
+                        uint64_t hits;
+                        uint64_t diskhits;
+                        uint64_t misses;
+                        uint64_t evictions;
+                        size_t   ramsize;
+                        size_t   disksize;
+                };
+                Stats getStats() const;
+
+            private:
+                class RamEntry
+                {
+                    public:
+                        RamEntry(const std::string &, const std::string &, SegmentData *);
+                        std::string  key;
+                        std::string  type;
+                        SegmentData *data;
+                };
+                class DiskEntry
+                {
+                    public:
+                        DiskEntry(const std::string &, size_t);
+                        std::string name;
+                        size_t      size;
+                };
+                static std::string hashKey(const std::string &);
+                std::string getFilePath(const std::string &) const;
+                void        openSession();
+                void        closeSession();
+                SegmentData * readDisk(const std::string &, const std::string &, std::string *) const;
+                void        writeDisk(const RamEntry &);
+                void        evictDisk(std::list<std::string> *);
+                vlc_object_t *p_object;
+                mutable vlc_mutex_t lock;
+                size_t       ramMax;
+                size_t       diskMax;
+                std::string  dir;
+                Stats        stats;
+                std::list<RamEntry> ramList;
+                std::map<std::string, std::list<RamEntry>::iterator> ramIndex;
+                std::list<DiskEntry> diskList;
+                std::map<std::string, std::list<DiskEntry>::iterator> diskIndex;
+        };
+
+        /* Serves requests from the cache, or records the replies
+         * from the wrapped connection into it */
+        class CachedConnection : public AbstractConnection
+        {
+            public:
+                CachedConnection(vlc_object_t *, SegmentCache *, AbstractConnection *);
+                virtual ~CachedConnection();
+
+                virtual bool    prepare     (const ConnectionParams &); /* reimpl */
+                virtual bool    canReuse     (const ConnectionParams &) const; /* impl */
+                virtual enum RequestStatus
+                                request     (const std::string& path, const BytesRange & = BytesRange()); /* impl */
+                virtual ssize_t read        (void *p_buffer, size_t len); /* impl */
+                virtual block_t * readBlock (size_t len); /* reimpl */
+                virtual const ConnectionParams & getRedirection() const; /* reimpl */
+                virtual bool    isCached() const; /* reimpl */
+                virtual bool    isMultiplexed() const; /* reimpl */
+                virtual void    setUsed( bool ); /* impl */
+
+            private:
+                void reset();
+                bool record(block_t *);
+                SegmentCache       *cache;
+                AbstractConnection *connection;
+                SegmentData        *p_cached;
+                const block_t      *p_served;    /* next cached block to read */
+                size_t              servedOffset;
+                std::string         key;
+                SegmentData        *p_record;
+        };
+
+        class CachedConnectionFactory : public AbstractConnectionFactory
+        {
+            public:
+                CachedConnectionFactory( AbstractConnectionFactory *, SegmentCache * );
+                virtual ~CachedConnectionFactory();
+                virtual AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &);
+            private:
+                AbstractConnectionFactory *factory;
+                SegmentCache *cache;
+        };
+
+    }
+
+}
+
+#endif // SEGMENTCACHE_HPP
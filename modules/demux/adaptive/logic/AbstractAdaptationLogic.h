@@ -50,6 +50,8 @@ namespace adaptive
                 virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *) = 0;
                 virtual void                updateDownloadRate     (const ID &, size_t, vlc_tick_t);
                 virtual void                trackerEvent           (const SegmentTrackerEvent &) {}
+                /* whether to drop a segment still downloading for a lower one */
+                virtual bool                abandonSegment         (BaseRepresentation *, size_t, size_t) { return false; }
                 void                        setMaxDeviceResolution (int, int);
 
                 enum LogicType
@@ -61,6 +63,7 @@ namespace adaptive
                     FixedRate,
                     Predictive,
                     NearOptimal,
+                    Hybrid,
                 };
 
             protected:
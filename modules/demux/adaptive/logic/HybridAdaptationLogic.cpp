@@ -0,0 +1,319 @@
+/*
+ * HybridAdaptationLogic.cpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "HybridAdaptationLogic.hpp"
+
+#include "Representationselectors.hpp"
+
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/BaseRepresentation.h"
+#include "../tools/Debug.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace adaptive::logic;
+using namespace adaptive;
+
+/*
+ * Throughput estimation from samples taken during downloads, with the
+ * selection margin set by the buffering level. Segments which won't
+ * complete before the buffer runs out are abandoned for a lower quality.
+ */
+
+#define SAMPLE_MIN_DURATION VLC_TICK_FROM_MS(100)
+
+ThroughputEstimator::ThroughputEstimator(vlc_tick_t fast_, vlc_tick_t slow_)
+{
+    fasthalflife = fast_;
+    slowhalflife = slow_;
+    fast = 0;
+    slow = 0;
+    variance = 0;
+    total = 0;
+}
+
+void ThroughputEstimator::push(size_t size, vlc_tick_t time)
+{
+    const double bps = (double) size * 8 * CLOCK_FREQ / time;
+    if(total == 0)
+    {
+        fast = slow = bps;
+        variance = 0;
+    }
+    else
+    {
+        const double fastalpha = pow(0.5, (double) time / fasthalflife);
+        const double slowalpha = pow(0.5, (double) time / slowhalflife);
+        const double diff = bps - fast;
+        fast += (1.0 - fastalpha) * diff;
+        variance = fastalpha * (variance + (1.0 - fastalpha) * diff * diff);
+        slow = slowalpha * slow + (1.0 - slowalpha) * bps;
+    }
+    total += time;
+}
+
+uint64_t ThroughputEstimator::get() const
+{
+    /* lowest trend, minus the deviation but keeping at least half of it */
+    const double mean = std::min(fast, slow);
+    return std::max(mean - sqrt(variance), mean / 2);
+}
+
+bool ThroughputEstimator::empty() const
+{
+    return total == 0;
+}
+
+HybridStats::HybridStats()
+{
+    buffering_level = 0;
+    buffering_target = 1;
+    last_duration = 1;
+    abandoned = false;
+}
+
+HybridAdaptationLogic::HybridAdaptationLogic(vlc_object_t *obj)
+    : AbstractAdaptationLogic(obj),
+      estimator(VLC_TICK_FROM_SEC(2), VLC_TICK_FROM_SEC(8))
+{
+    progress = false;
+    sample.size = 0;
+    sample.time = 0;
+    sample.busyend = VLC_TICK_INVALID;
+    usedBps = 0;
+    vlc_mutex_init(&lock);
+}
+
+HybridAdaptationLogic::~HybridAdaptationLogic()
+{
+}
+
+uint64_t HybridAdaptationLogic::getAvailableBw(const BaseRepresentation *curRep) const
+{
+    uint64_t bw = estimator.get();
+    if(curRep)
+        bw += curRep->getBandwidth();
+    return (bw > usedBps) ? bw - usedBps : 0;
+}
+
+BaseRepresentation *HybridAdaptationLogic::getNextRepresentation(BaseAdaptationSet *adaptSet, BaseRepresentation *prevRep)
+{
+    RepresentationSelector selector(maxwidth, maxheight);
+    BaseRepresentation *rep;
+
+    vlc_mutex_lock(&lock);
+
+    std::map<ID, HybridStats>::iterator it = streams.find(adaptSet->getID());
+    if(it == streams.end() || estimator.empty())
+    {
+        rep = selector.lowest(adaptSet);
+    }
+    else
+    {
+        HybridStats &stats = (*it).second;
+        const double f_buffering_level = (double) stats.buffering_level / stats.buffering_target;
+        const uint64_t i_available_bw = getAvailableBw(prevRep);
+
+        /* the lower the buffer, the larger the margin, and only
+         * switch up once we're safe */
+        uint64_t i_bw;
+        bool b_upswitch = false;
+        if(f_buffering_level < 0.3)
+            i_bw = i_available_bw / 2;
+        else if(f_buffering_level < 0.7)
+            i_bw = i_available_bw * 0.85;
+        else
+        {
+            i_bw = i_available_bw;
+            b_upswitch = true;
+        }
+
+        rep = selector.select(adaptSet, i_bw);
+        if(!rep)
+            rep = selector.lowest(adaptSet);
+
+        if(rep && prevRep)
+        {
+            if(stats.abandoned && rep->getBandwidth() >= prevRep->getBandwidth())
+                rep = selector.lower(adaptSet, prevRep);
+            else if(!b_upswitch && rep->getBandwidth() > prevRep->getBandwidth())
+                rep = prevRep;
+        }
+        stats.abandoned = false;
+
+        BwDebug( if( rep != prevRep )
+                    msg_Info(p_obj, "Stream %s buffering level %.2f, new bandwidth usage %zu KiB/s",
+                             adaptSet->getID().str().c_str(), f_buffering_level,
+                             rep->getBandwidth() / 8000); );
+    }
+
+    vlc_mutex_unlock(&lock);
+
+    return rep;
+}
+
+bool HybridAdaptationLogic::abandonSegment(BaseRepresentation *rep, size_t downloaded, size_t total)
+{
+    if(!rep || downloaded >= total)
+        return false;
+
+    vlc_mutex_lock(&lock);
+
+    std::map<ID, HybridStats>::iterator it = streams.find(rep->getAdaptationSet()->getID());
+    const uint64_t i_bw = estimator.get();
+    if(it == streams.end() || !i_bw)
+    {
+        vlc_mutex_unlock(&lock);
+        return false;
+    }
+
+    HybridStats &stats = (*it).second;
+    bool b_abandon = false;
+
+    /* Won't be complete before the buffered data runs out */
+    const vlc_tick_t remaining = vlc_tick_from_samples((total - downloaded) * 8, i_bw);
+    if(remaining > stats.buffering_level)
+    {
+        /* and a whole lower segment would come sooner */
+        RepresentationSelector selector(maxwidth, maxheight);
+        BaseRepresentation *lower = selector.lower(rep->getAdaptationSet(), rep);
+        if(lower && lower != rep &&
+           (vlc_tick_t)(stats.last_duration * lower->getBandwidth() / i_bw) < remaining)
+            b_abandon = true;
+    }
+
+    if(b_abandon)
+    {
+        stats.abandoned = true;
+        msg_Dbg(p_obj, "Stream %s abandoning segment at %zu%%, %" PRId64 "ms remaining "
+                       "with %" PRId64 "ms buffered", rep->getAdaptationSet()->getID().str().c_str(),
+                       downloaded * 100 / total, MS_FROM_VLC_TICK(remaining),
+                       MS_FROM_VLC_TICK(stats.buffering_level));
+    }
+
+    vlc_mutex_unlock(&lock);
+
+    return b_abandon;
+}
+
+void HybridAdaptationLogic::updateDownloadRate(const ID &, size_t size, vlc_tick_t time)
+{
+    if(unlikely(time == 0))
+        return;
+    vlc_mutex_lock(&lock);
+    /* only when sources can't report progress */
+    if(!progress)
+        estimator.push(size, time);
+    vlc_mutex_unlock(&lock);
+}
+
+void HybridAdaptationLogic::updateDownloadProgress(const ID &, size_t size,
+                                                   vlc_tick_t time, vlc_tick_t date)
+{
+    vlc_mutex_lock(&lock);
+    progress = true;
+    /* Accumulate up to observation window. Workers read concurrently,
+       so only account the part of [date - time, date] not already
+       covered by a previous read, or the rate is divided by the
+       number of workers */
+    sample.size += size;
+    vlc_tick_t start = date - time;
+    if(sample.busyend != VLC_TICK_INVALID && start < sample.busyend)
+        start = sample.busyend;
+    if(date > start)
+    {
+        sample.time += date - start;
+        sample.busyend = date;
+    }
+    if(sample.time >= SAMPLE_MIN_DURATION)
+    {
+        estimator.push(sample.size, sample.time);
+        BwDebug(msg_Dbg(p_obj, "bw sample %zu KiB/s -> estimate %" PRIu64 " KiB/s",
+                        (size_t)(CLOCK_FREQ * sample.size / sample.time / 1024),
+                        estimator.get() / 8192));
+        sample.size = 0;
+        sample.time = 0;
+    }
+    vlc_mutex_unlock(&lock);
+}
+
+void HybridAdaptationLogic::trackerEvent(const SegmentTrackerEvent &event)
+{
+    switch(event.type)
+    {
+    case SegmentTrackerEvent::SWITCHING:
+        {
+            vlc_mutex_lock(&lock);
+            if(event.u.switching.prev)
+                usedBps -= event.u.switching.prev->getBandwidth();
+            if(event.u.switching.next)
+                usedBps += event.u.switching.next->getBandwidth();
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::BUFFERING_STATE:
+        {
+            const ID &id = *event.u.buffering.id;
+            vlc_mutex_lock(&lock);
+            if(event.u.buffering.enabled)
+            {
+                if(streams.find(id) == streams.end())
+                    streams.insert(std::pair<ID, HybridStats>(id, HybridStats()));
+            }
+            else
+            {
+                std::map<ID, HybridStats>::iterator it = streams.find(id);
+                if(it != streams.end())
+                    streams.erase(it);
+            }
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::BUFFERING_LEVEL_CHANGE:
+        {
+            const ID &id = *event.u.buffering_level.id;
+            vlc_mutex_lock(&lock);
+            HybridStats &stats = streams[id];
+            stats.buffering_level = event.u.buffering_level.current;
+            stats.buffering_target = event.u.buffering_level.target;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    case SegmentTrackerEvent::SEGMENT_CHANGE:
+        {
+            const ID &id = *event.u.segment.id;
+            vlc_mutex_lock(&lock);
+            HybridStats &stats = streams[id];
+            stats.last_duration = event.u.segment.duration;
+            vlc_mutex_unlock(&lock);
+        }
+        break;
+
+    default:
+            break;
+    }
+}
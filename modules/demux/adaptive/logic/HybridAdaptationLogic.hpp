@@ -0,0 +1,92 @@
+/*
+ * HybridAdaptationLogic.hpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HYBRIDADAPTATIONLOGIC_HPP
+#define HYBRIDADAPTATIONLOGIC_HPP
+
+#include "AbstractAdaptationLogic.h"
+#include <map>
+
+namespace adaptive
+{
+    namespace logic
+    {
+        /* Exponentially weighted throughput mean and variance,
+         * weighted by the duration of each sample */
+        class ThroughputEstimator
+        {
+            public:
+                ThroughputEstimator(vlc_tick_t, vlc_tick_t);
+                void     push(size_t, vlc_tick_t);
+                uint64_t get() const;
+                bool     empty() const;
+
+            private:
+                vlc_tick_t fasthalflife;
+                vlc_tick_t slowhalflife;
+                double   fast;
+                double   slow;
+                double   variance;
+                vlc_tick_t total;
+        };
+
+        class HybridStats
+        {
+            friend class HybridAdaptationLogic;
+
+            public:
+                HybridStats();
+
+            private:
+                vlc_tick_t buffering_level;
+                vlc_tick_t buffering_target;
+                vlc_tick_t last_duration;
+                bool       abandoned;
+        };
+
+        class HybridAdaptationLogic : public AbstractAdaptationLogic
+        {
+            public:
+                HybridAdaptationLogic(vlc_object_t *);
+                virtual ~HybridAdaptationLogic();
+
+                virtual BaseRepresentation* getNextRepresentation(BaseAdaptationSet *, BaseRepresentation *);
+                virtual void                updateDownloadRate     (const ID &, size_t, vlc_tick_t); /* reimpl */
+                virtual void                updateDownloadProgress (const ID &, size_t, vlc_tick_t, vlc_tick_t); /* reimpl */
+                virtual void                trackerEvent           (const SegmentTrackerEvent &); /* reimpl */
+                virtual bool                abandonSegment         (BaseRepresentation *, size_t, size_t); /* reimpl */
+
+            private:
+                uint64_t                    getAvailableBw(const BaseRepresentation *) const;
+                std::map<ID, HybridStats>   streams;
+                ThroughputEstimator         estimator;
+                bool                        progress; /* receiving sub segment samples */
+                struct
+                {
+                    size_t size;
+                    vlc_tick_t time; /* busy time, overlapping reads counted once */
+                    vlc_tick_t busyend;
+                } sample;
+                uint64_t                    usedBps;
+                vlc_mutex_t                 lock;
+        };
+    }
+}
+
+#endif // HYBRIDADAPTATIONLOGIC_HPP
@@ -35,6 +35,9 @@ namespace adaptive
     {
         public:
             virtual void updateDownloadRate(const ID &, size_t, vlc_tick_t) = 0;
+            /* samples taken while the segment is still downloading:
+               size, read duration and date the read completed at */
+            virtual void updateDownloadProgress(const ID &, size_t, vlc_tick_t, vlc_tick_t) {}
             virtual ~IDownloadRateObserver(){}
     };
 }
@@ -46,6 +46,11 @@ AbstractPlaylist::AbstractPlaylist (vlc_object_t *p_object_) :
     minBufferTime = 0;
     timeShiftBufferDepth.Set( 0 );
     suggestedPresentationDelay.Set( 0 );
+    targetLatency.Set( 0 );
+    minLatency.Set( 0 );
+    maxLatency.Set( 0 );
+    minPlaybackRate.Set( 0.0 );
+    maxPlaybackRate.Set( 0.0 );
     b_needsUpdates = true;
 }
 
@@ -87,12 +92,18 @@ void AbstractPlaylist::setMinBuffering( vlc_tick_t min )
 
 vlc_tick_t AbstractPlaylist::getMinBuffering() const
 {
+    /* Low latency, can't buffer more than what we're behind live */
+    if(targetLatency.Get())
+        return std::min(std::max(minBufferTime, VLC_TICK_FROM_MS(500)),
+                        targetLatency.Get());
     return std::max(minBufferTime, VLC_TICK_FROM_SEC(6));
 }
 
 vlc_tick_t AbstractPlaylist::getMaxBuffering() const
 {
     const vlc_tick_t minbuf = getMinBuffering();
+    if(targetLatency.Get())
+        return std::max(minbuf, targetLatency.Get());
     return std::max(minbuf, VLC_TICK_FROM_SEC(60));
 }
 
@@ -145,6 +156,11 @@ bool AbstractPlaylist::needsUpdates() const
 void AbstractPlaylist::updateWith(AbstractPlaylist *updatedAbstractPlaylist)
 {
     availabilityEndTime.Set(updatedAbstractPlaylist->availabilityEndTime.Get());
+    targetLatency.Set(updatedAbstractPlaylist->targetLatency.Get());
+    minLatency.Set(updatedAbstractPlaylist->minLatency.Get());
+    maxLatency.Set(updatedAbstractPlaylist->maxLatency.Get());
+    minPlaybackRate.Set(updatedAbstractPlaylist->minPlaybackRate.Get());
+    maxPlaybackRate.Set(updatedAbstractPlaylist->maxPlaybackRate.Get());
 
     for(size_t i = 0; i < periods.size() && i < updatedAbstractPlaylist->periods.size(); i++)
         periods.at(i)->updateWith(updatedAbstractPlaylist->periods.at(i));
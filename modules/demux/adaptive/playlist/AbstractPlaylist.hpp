@@ -69,6 +69,12 @@ namespace adaptive
                 Property<vlc_tick_t>                   maxSegmentDuration;
                 Property<vlc_tick_t>                   timeShiftBufferDepth;
                 Property<vlc_tick_t>                   suggestedPresentationDelay;
+                /* Low latency service description */
+                Property<vlc_tick_t>                   targetLatency;
+                Property<vlc_tick_t>                   minLatency;
+                Property<vlc_tick_t>                   maxLatency;
+                Property<double>                       minPlaybackRate;
+                Property<double>                       maxPlaybackRate;
 
             protected:
                 vlc_object_t                       *p_object;
@@ -82,13 +82,14 @@ SegmentChunk* ISegment::toChunk(SharedResources *res, AbstractConnectionManager
                                 size_t index, BaseRepresentation *rep)
 {
     const std::string url = getUrlSegment().toString(index, rep);
-    HTTPChunkBufferedSource *source = new (std::nothrow) HTTPChunkBufferedSource(url, connManager,
-                                                                                 rep->getAdaptationSet()->getID());
+    BytesRange range;
+    if(startByte != endByte)
+        range = BytesRange(startByte, endByte);
+    AbstractChunkSource *source = connManager->makeSource(url,
+                                                          rep->getAdaptationSet()->getID(),
+                                                          range);
     if( source )
     {
-        if(startByte != endByte)
-            source->setBytesRange(BytesRange(startByte, endByte));
-
         SegmentChunk *chunk = createChunk(source, rep);
         if(chunk)
         {
@@ -114,6 +115,11 @@ bool ISegment::isTemplate() const
     return templated;
 }
 
+bool ISegment::isPartial() const
+{
+    return false;
+}
+
 void ISegment::setByteRange(size_t start, size_t end)
 {
     startByte = start;
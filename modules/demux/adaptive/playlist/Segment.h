@@ -69,6 +69,7 @@ namespace adaptive
                 virtual void                            setSequenceNumber(uint64_t);
                 virtual uint64_t                        getSequenceNumber() const;
                 virtual bool                            isTemplate      () const;
+                virtual bool                            isPartial       () const;
                 virtual size_t                          getOffset       () const;
                 virtual std::vector<ISegment*>          subSegments     () = 0;
                 virtual void                            addSubSegment   (SubSegment *) = 0;
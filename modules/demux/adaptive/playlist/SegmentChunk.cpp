@@ -25,6 +25,7 @@
 #include "Segment.h"
 #include "BaseRepresentation.h"
 #include "../encryption/CommonEncryption.hpp"
+#include "../http/SegmentCache.hpp"
 
 #include <vlc_block.h>
 
@@ -52,6 +53,10 @@ bool SegmentChunk::decrypt(block_t **pp_block)
 
     if(encryptionSession)
     {
+        /* decrypts in place, cached data included */
+        p_block = *pp_block = adaptive::http::SegmentData::unshare(p_block);
+        if(!p_block)
+            return false;
         bool b_last = isEmpty();
         p_block->i_buffer = encryptionSession->decrypt(p_block->p_buffer,
                                                        p_block->i_buffer, b_last);
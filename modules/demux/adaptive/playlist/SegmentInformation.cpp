@@ -183,8 +183,11 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
     const vlc_tick_t i_max_buffering = getPlaylist()->getMaxBuffering() +
                                     /* FIXME: add dynamic pts-delay */ VLC_TICK_FROM_SEC(1);
 
+    /* Low latency, start at the manifest target latency */
+    const vlc_tick_t i_target_latency = getPlaylist()->targetLatency.Get();
+
     /* Try to never buffer up to really end */
-    const uint64_t OFFSET_FROM_END = 3;
+    const uint64_t OFFSET_FROM_END = i_target_latency ? 0 : 3;
 
     if( mediaSegmentTemplate )
     {
@@ -208,7 +211,8 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
                 return 0;
             }
 
-            vlc_tick_t fromend = std::max( i_max_buffering, getPlaylist()->suggestedPresentationDelay.Get() );
+            vlc_tick_t fromend = i_target_latency ? i_target_latency :
+                                 std::max( i_max_buffering, getPlaylist()->suggestedPresentationDelay.Get() );
             if( endtime + duration <= timescale.ToScaled( fromend ) )
                 return start;
 
@@ -229,7 +233,16 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
                 i_delay = getPlaylist()->getMinBuffering();
 
             const uint64_t startnumber = mediaSegmentTemplate->inheritStartNumber();
-            end = mediaSegmentTemplate->getLiveTemplateNumber(vlc_tick_from_sec(time(NULL)));
+            const vlc_tick_t now = vlc_tick_from_sec(time(NULL));
+            end = mediaSegmentTemplate->getLiveTemplateNumber(now +
+                                    mediaSegmentTemplate->inheritAvailabilityTimeOffset());
+
+            if( i_target_latency )
+            {
+                uint64_t number = mediaSegmentTemplate->getLiveTemplateNumber(now - i_target_latency);
+                number = std::max( number, startnumber );
+                return std::min( number, end );
+            }
 
             const uint64_t count = timescale.ToScaled( i_delay ) / mediaSegmentTemplate->duration.Get();
             if( startnumber + count >= end )
@@ -252,7 +265,8 @@ uint64_t SegmentInformation::getLiveStartSegmentNumber(uint64_t def) const
         const std::vector<ISegment *> list = segmentList->getSegments();
 
         const ISegment *back = list.back();
-        vlc_tick_t fromend = std::max( i_max_buffering, getPlaylist()->suggestedPresentationDelay.Get() );
+        vlc_tick_t fromend = i_target_latency ? i_target_latency :
+                             std::max( i_max_buffering, getPlaylist()->suggestedPresentationDelay.Get() );
         stime_t bufferingstart = back->startTime.Get() + back->duration.Get() - timescale.ToScaled( fromend );
 
         uint64_t number;
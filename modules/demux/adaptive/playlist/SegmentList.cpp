@@ -101,6 +101,17 @@ void SegmentList::updateWith(SegmentList *updated, bool b_restamp)
             }
             addSegment(cur);
         }
+        else if(lastSegment->compare(cur) == 0 && lastSegment->isPartial())
+        {
+            /* Last segment was still being published on previous update */
+            cur->startTime.Set(lastSegment->startTime.Get());
+            cur->setParent(this);
+            totalLength -= lastSegment->duration.Get();
+            totalLength += cur->duration.Get();
+            delete segments.back();
+            segments.back() = cur;
+            lastSegment = prevSegment = cur;
+        }
         else
             delete cur;
     }
@@ -53,6 +53,7 @@ MediaSegmentTemplate::MediaSegmentTemplate( SegmentInformation *parent ) :
     debugName = "SegmentTemplate";
     classId = Segment::CLASSID_SEGMENT;
     startNumber = std::numeric_limits<uint64_t>::max();
+    availabilityTimeOffset = 0;
     segmentTimeline = NULL;
     initialisationSegment.Set( NULL );
     templated = true;
@@ -148,6 +149,19 @@ SegmentTimeline * MediaSegmentTemplate::inheritSegmentTimeline() const
     return NULL;
 }
 
+vlc_tick_t MediaSegmentTemplate::inheritAvailabilityTimeOffset() const
+{
+    const SegmentInformation *ulevel = parentSegmentInformation ? parentSegmentInformation
+                                                                : NULL;
+    for( ; ulevel ; ulevel = ulevel->parent )
+    {
+        if( ulevel->mediaSegmentTemplate &&
+            ulevel->mediaSegmentTemplate->availabilityTimeOffset > 0 )
+            return ulevel->mediaSegmentTemplate->availabilityTimeOffset;
+    }
+    return 0;
+}
+
 uint64_t MediaSegmentTemplate::getLiveTemplateNumber(vlc_tick_t playbacktime) const
 {
     uint64_t number = inheritStartNumber();
@@ -171,7 +185,10 @@ stime_t MediaSegmentTemplate::getMinAheadScaledTime(uint64_t number) const
     if( segmentTimeline )
         return segmentTimeline->getMinAheadScaledTime(number);
 
-    uint64_t current = getLiveTemplateNumber(vlc_tick_from_sec(time(NULL)));
+    /* availabilityTimeOffset allows requesting segments before they are
+       complete, chunked transfer will then deliver them as they are produced */
+    uint64_t current = getLiveTemplateNumber(vlc_tick_from_sec(time(NULL)) +
+                                             inheritAvailabilityTimeOffset());
     return (current - number) * inheritDuration();
 }
 
@@ -185,6 +202,11 @@ void MediaSegmentTemplate::setStartNumber( uint64_t v )
     startNumber = v;
 }
 
+void MediaSegmentTemplate::setAvailabilityTimeOffset( vlc_tick_t v )
+{
+    availabilityTimeOffset = v;
+}
+
 void MediaSegmentTemplate::setSegmentTimeline( SegmentTimeline *v )
 {
     delete segmentTimeline;
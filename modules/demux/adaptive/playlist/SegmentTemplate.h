@@ -53,6 +53,7 @@ namespace adaptive
                 virtual ~MediaSegmentTemplate();
                 void setStartNumber( uint64_t );
                 void setSegmentTimeline( SegmentTimeline * );
+                void setAvailabilityTimeOffset( vlc_tick_t );
                 void updateWith( MediaSegmentTemplate * );
                 virtual uint64_t getSequenceNumber() const; /* reimpl */
                 uint64_t getLiveTemplateNumber(vlc_tick_t) const;
@@ -63,10 +64,12 @@ namespace adaptive
                 virtual uint64_t inheritStartNumber() const;
                 stime_t inheritDuration() const;
                 SegmentTimeline * inheritSegmentTimeline() const;
+                vlc_tick_t inheritAvailabilityTimeOffset() const;
                 virtual void debug(vlc_object_t *, int = 0) const; /* reimpl */
 
             protected:
                 uint64_t startNumber;
+                vlc_tick_t availabilityTimeOffset;
                 SegmentTimeline *segmentTimeline;
                 SegmentInformation *parentSegmentInformation;
         };
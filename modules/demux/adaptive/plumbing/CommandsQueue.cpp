@@ -29,6 +29,7 @@
 #include <vlc_meta.h>
 #include <algorithm>
 #include <set>
+#include <typeinfo>
 
 using namespace adaptive;
 
@@ -73,6 +74,14 @@ EsOutSendCommand::EsOutSendCommand( FakeESOutID *p_es, block_t *p_block_ ) :
     p_block = p_block_;
 }
 
+void EsOutSendCommand::reset( FakeESOutID *p_es, block_t *p_block_ )
+{
+    if( p_block )
+        block_Release( p_block );
+    p_fakeid = p_es;
+    p_block = p_block_;
+}
+
 EsOutSendCommand::~EsOutSendCommand()
 {
     if( p_block )
@@ -185,8 +194,34 @@ void EsOutMetaCommand::Execute( es_out_t *out )
  * Commands Default Factory
  */
 
+CommandsFactory::CommandsFactory()
+{
+    vlc_mutex_init( &lock );
+}
+
+CommandsFactory::~CommandsFactory()
+{
+    for( size_t i=0; i<pool.size(); i++ )
+        delete pool[i];
+    for( size_t i=0; i<cache.size(); i++ )
+        delete cache[i];
+}
+
 EsOutSendCommand * CommandsFactory::createEsOutSendCommand( FakeESOutID *id, block_t *p_block ) const
 {
+    if( cache.empty() )
+    {
+        vlc_mutex_lock( &lock );
+        cache.swap( pool );
+        vlc_mutex_unlock( &lock );
+    }
+    if( !cache.empty() )
+    {
+        EsOutSendCommand *command = cache.back();
+        cache.pop_back();
+        command->reset( id, p_block );
+        return command;
+    }
     return new (std::nothrow) EsOutSendCommand( id, p_block );
 }
 
@@ -226,12 +261,65 @@ EsOutMetaCommand * CommandsFactory::createEsOutMetaCommand( int group, const vlc
     return NULL;
 }
 
+bool CommandsFactory::recyclable( const AbstractCommand *command ) const
+{
+    /* derived factories can return their own send commands */
+    return command->getType() == ES_OUT_PRIVATE_COMMAND_SEND &&
+           typeid(*command) == typeid(EsOutSendCommand);
+}
+
+void CommandsFactory::releaseCommand( AbstractCommand *command ) const
+{
+    if( recyclable( command ) )
+    {
+        EsOutSendCommand *sendcommand = static_cast<EsOutSendCommand *>(command);
+        sendcommand->reset( NULL, NULL );
+        vlc_mutex_lock( &lock );
+        if( pool.size() < POOL_SIZE )
+        {
+            pool.push_back( sendcommand );
+            command = NULL;
+        }
+        vlc_mutex_unlock( &lock );
+    }
+    delete command;
+}
+
+void CommandsFactory::releaseCommands( std::vector<AbstractCommand *> &commands ) const
+{
+    /* Recycle a whole batch under a single lock */
+    std::vector<AbstractCommand *>::iterator it = commands.begin();
+    std::vector<AbstractCommand *>::iterator kept = commands.begin();
+    for( ; it != commands.end(); ++it )
+    {
+        if( recyclable( *it ) )
+        {
+            static_cast<EsOutSendCommand *>(*it)->reset( NULL, NULL );
+            *kept++ = *it;
+        }
+        else delete *it;
+    }
+    commands.erase( kept, commands.end() );
+
+    vlc_mutex_lock( &lock );
+    while( !commands.empty() && pool.size() < POOL_SIZE )
+    {
+        pool.push_back( static_cast<EsOutSendCommand *>(commands.back()) );
+        commands.pop_back();
+    }
+    vlc_mutex_unlock( &lock );
+
+    for( size_t i=0; i<commands.size(); i++ )
+        delete commands[i];
+    commands.clear();
+}
+
 /*
  * Commands Queue management
  */
 #if 0
 /* For queue printing/debugging */
-std::ostream& operator<<(std::ostream& ostr, const std::list<AbstractCommand *>& list)
+std::ostream& operator<<(std::ostream& ostr, const std::deque<AbstractCommand *>& list)
 {
     for (auto &i : list) {
         ostr << "[" << i->getType() << "]" << SEC_FROM_VLC_TICK(i->getTime()) << " ";
@@ -240,6 +328,125 @@ std::ostream& operator<<(std::ostream& ostr, const std::list<AbstractCommand *>&
 }
 #endif
 
+CommandsRing::Segment::Segment()
+{
+    reset();
+}
+
+void CommandsRing::Segment::reset()
+{
+    written.store( 0, std::memory_order_relaxed );
+    next.store( NULL, std::memory_order_relaxed );
+    read = 0;
+}
+
+CommandsRing::CommandsRing()
+{
+    head = tail = new Segment();
+    spare.store( NULL );
+}
+
+CommandsRing::~CommandsRing()
+{
+    while( head )
+    {
+        Segment *next = head->next.load( std::memory_order_relaxed );
+        delete head;
+        head = next;
+    }
+    delete spare.load();
+}
+
+bool CommandsRing::push( AbstractCommand *command )
+{
+    unsigned i_written = tail->written.load( std::memory_order_relaxed );
+    if( i_written == SEGMENT_SIZE )
+    {
+        Segment *segment = spare.exchange( NULL, std::memory_order_acquire );
+        if( segment )
+            segment->reset();
+        else
+            segment = new (std::nothrow) Segment();
+        if( !segment )
+            return false;
+        tail->next.store( segment, std::memory_order_release );
+        tail = segment;
+        i_written = 0;
+    }
+    tail->slots[i_written] = command;
+    tail->written.store( i_written + 1, std::memory_order_release );
+    return true;
+}
+
+AbstractCommand * CommandsRing::pop()
+{
+    for( ;; )
+    {
+        if( head->read < head->written.load( std::memory_order_acquire ) )
+            return head->slots[head->read++];
+
+        if( head->read < SEGMENT_SIZE )
+            return NULL;
+
+        Segment *next = head->next.load( std::memory_order_acquire );
+        if( !next )
+            return NULL;
+
+        /* Segment is fully consumed, keep it for the producer */
+        Segment *old = head;
+        head = next;
+        Segment *expected = NULL;
+        if( !spare.compare_exchange_strong( expected, old, std::memory_order_release ) )
+            delete old;
+    }
+}
+
+bool CommandsRing::isEmpty() const
+{
+    if( head->read < head->written.load( std::memory_order_acquire ) )
+        return false;
+    return head->read < SEGMENT_SIZE ||
+           head->next.load( std::memory_order_acquire ) == NULL;
+}
+
+vlc_tick_t CommandsRing::getFirstTime() const
+{
+    /* Segments reachable from head are only released by the consumer,
+       and slots below the written count are no longer modified */
+    unsigned i = head->read;
+    for( const Segment *segment = head; segment; )
+    {
+        const unsigned i_written = segment->written.load( std::memory_order_acquire );
+        for( ; i < i_written; i++ )
+        {
+            const vlc_tick_t time = segment->slots[i]->getTime();
+            if( time != VLC_TICK_INVALID )
+                return time;
+        }
+        if( i_written < SEGMENT_SIZE )
+            break;
+        segment = segment->next.load( std::memory_order_acquire );
+        i = 0;
+    }
+    return VLC_TICK_INVALID;
+}
+
+CommandsQueue::SortEntry::SortEntry( AbstractCommand *command_, vlc_tick_t time_ )
+{
+    command = command_;
+    time = time_;
+    pcr = (command->getType() == ES_OUT_SET_GROUP_PCR);
+}
+
+bool CommandsQueue::SortEntry::operator<( const SortEntry &other ) const
+{
+    /* Reorder the initial clock PCR setting PCR0 DTS0 PCR0 DTS1 PCR1
+       so it appears after the block, avoiding it not being output */
+    if( time == other.time )
+        return !pcr && other.pcr;
+    return time < other.time;
+}
+
 CommandsQueue::CommandsQueue( CommandsFactory *f )
 {
     bufferinglevel = VLC_TICK_INVALID;
@@ -256,31 +463,18 @@ CommandsQueue::~CommandsQueue()
     delete commandsFactory;
 }
 
-static bool compareCommands( AbstractCommand *a, AbstractCommand *b )
-{
-    if(a->getTime() == b->getTime())
-    {
-        /* Reorder the initial clock PCR setting PCR0 DTS0 PCR0 DTS1 PCR1
-           so it appears after the block, avoiding it not being output */
-        if(a->getType() == ES_OUT_SET_GROUP_PCR &&
-           b->getType() == ES_OUT_PRIVATE_COMMAND_SEND)
-            return false;
-        return true;
-    }
-    else return (a->getTime() < b->getTime() && a->getTime() != VLC_TICK_INVALID);
-}
-
 void CommandsQueue::Schedule( AbstractCommand *command )
 {
     if( b_drop )
     {
-        delete command;
+        commandsFactory->releaseCommand( command );
     }
     else if( command->getType() == ES_OUT_SET_GROUP_PCR )
     {
         bufferinglevel = command->getTime();
         LockedCommit();
-        commands.push_back( command );
+        if( !ring.push( command ) )
+            commandsFactory->releaseCommand( command );
     }
     else
     {
@@ -293,6 +487,13 @@ const CommandsFactory * CommandsQueue::factory() const
     return commandsFactory;
 }
 
+void CommandsQueue::Fetch()
+{
+    AbstractCommand *command;
+    while( (command = ring.pop()) )
+        commands.push_back( command );
+}
+
 vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
 {
     vlc_tick_t lastdts = barrier;
@@ -306,15 +507,14 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
        ex: for a target time of 2, you must dequeue <= 2 until >= PCR2
        A0,A1,A2,B0,PCR0,B1,B2,PCR2,B3,A3,PCR3
     */
-    std::list<AbstractCommand *> output;
-    std::list<AbstractCommand *> in;
-
+    Fetch();
 
-    in.splice( in.end(), commands );
-
-    while( !in.empty() )
+    /* Commands kept for later are compacted in front of the remaining ones */
+    std::deque<AbstractCommand *>::iterator in = commands.begin();
+    std::deque<AbstractCommand *>::iterator kept = commands.begin();
+    for( ; in != commands.end(); ++in )
     {
-        AbstractCommand *command = in.front();
+        AbstractCommand *command = *in;
 
         if( command->getType() == ES_OUT_PRIVATE_COMMAND_DEL && b_datasent )
             break;
@@ -325,7 +525,6 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
         if(command->getType() == ES_OUT_SET_GROUP_PCR && command->getTime() > barrier )
             break;
 
-        in.pop_front();
         b_datasent = true;
 
         if( command->getType() == ES_OUT_PRIVATE_COMMAND_SEND )
@@ -340,14 +539,14 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
                 /* ensure no more non dated for that ES is sent
                  * since we're sure that data is above barrier */
                 disabled_esids.insert( id );
-                commands.push_back( command );
+                *kept++ = command;
             }
             else if( command->getTime() == VLC_TICK_INVALID )
             {
                 if( disabled_esids.find( id ) == disabled_esids.end() )
                     output.push_back( command );
                 else
-                    commands.push_back( command );
+                    *kept++ = command;
             }
             else /* Falls below barrier, send */
             {
@@ -357,17 +556,16 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
         else output.push_back( command ); /* will discard below */
     }
 
-    /* push remaining ones if broke above */
-    commands.splice( commands.end(), in );
+    /* keep remaining ones if broke above */
+    commands.erase( kept, in );
 
     if(commands.empty() && b_draining)
         b_draining = false;
 
     /* Now execute our selected commands */
-    while( !output.empty() )
+    for( size_t i=0; i<output.size(); i++ )
     {
-        AbstractCommand *command = output.front();
-        output.pop_front();
+        AbstractCommand *command = output[i];
 
         if( command->getType() == ES_OUT_PRIVATE_COMMAND_SEND )
         {
@@ -377,8 +575,8 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
         }
 
         command->Execute( out );
-        delete command;
     }
+    commandsFactory->releaseCommands( output );
     pcr = lastdts; /* Warn! no PCR update/lock release until execution */
 
 
@@ -387,9 +585,25 @@ vlc_tick_t CommandsQueue::Process( es_out_t *out, vlc_tick_t barrier )
 
 void CommandsQueue::LockedCommit()
 {
-    /* reorder all blocks by time between 2 PCR and merge with main list */
-    incoming.sort( compareCommands );
-    commands.splice( commands.end(), incoming );
+    /* reorder all blocks by time between 2 PCR and hand them over.
+       Non dated commands stay after the preceding dated one */
+    vlc_tick_t time = VLC_TICK_INVALID;
+    for( size_t i=0; i<incoming.size(); i++ )
+    {
+        if( incoming[i]->getTime() != VLC_TICK_INVALID )
+            time = incoming[i]->getTime();
+        sortbuffer.push_back( SortEntry( incoming[i], time ) );
+    }
+    incoming.clear();
+
+    std::stable_sort( sortbuffer.begin(), sortbuffer.end() );
+
+    for( size_t i=0; i<sortbuffer.size(); i++ )
+    {
+        if( !ring.push( sortbuffer[i].command ) )
+            commandsFactory->releaseCommand( sortbuffer[i].command );
+    }
+    sortbuffer.clear();
 }
 
 void CommandsQueue::Commit()
@@ -399,10 +613,11 @@ void CommandsQueue::Commit()
 
 void CommandsQueue::Abort( bool b_reset )
 {
-    commands.splice( commands.end(), incoming );
+    LockedCommit();
+    Fetch();
     while( !commands.empty() )
     {
-        delete commands.front();
+        commandsFactory->releaseCommand( commands.front() );
         commands.pop_front();
     }
 
@@ -417,7 +632,7 @@ void CommandsQueue::Abort( bool b_reset )
 
 bool CommandsQueue::isEmpty() const
 {
-    bool b_empty = commands.empty() && incoming.empty();
+    bool b_empty = commands.empty() && ring.isEmpty() && incoming.empty();
     return b_empty;
 }
 
@@ -466,24 +681,29 @@ vlc_tick_t CommandsQueue::getBufferingLevel() const
 
 vlc_tick_t CommandsQueue::getFirstDTS() const
 {
-    std::list<AbstractCommand *>::const_iterator it;
-    vlc_tick_t i_firstdts = pcr;
+    /* Committed commands not fetched yet are looked up in place */
+    vlc_tick_t i_dts = VLC_TICK_INVALID;
+    std::deque<AbstractCommand *>::const_iterator it;
     for( it = commands.begin(); it != commands.end(); ++it )
     {
-        const vlc_tick_t i_dts = (*it)->getTime();
+        i_dts = (*it)->getTime();
         if( i_dts != VLC_TICK_INVALID )
-        {
-            if( i_dts < i_firstdts || i_firstdts == VLC_TICK_INVALID )
-                i_firstdts = i_dts;
             break;
-        }
     }
+    if( i_dts == VLC_TICK_INVALID )
+        i_dts = ring.getFirstTime();
+
+    vlc_tick_t i_firstdts = pcr;
+    if( i_dts != VLC_TICK_INVALID &&
+        ( i_dts < i_firstdts || i_firstdts == VLC_TICK_INVALID ) )
+        i_firstdts = i_dts;
     return i_firstdts;
 }
 
 void CommandsQueue::LockedSetDraining()
 {
     LockedCommit();
+    Fetch();
     b_draining = !commands.empty();
 }
 
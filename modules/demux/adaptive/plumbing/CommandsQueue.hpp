@@ -24,7 +24,8 @@
 #include <vlc_es.h>
 
 #include <atomic>
-#include <list>
+#include <deque>
+#include <vector>
 
 namespace adaptive
 {
@@ -63,6 +64,7 @@ namespace adaptive
 
         protected:
             EsOutSendCommand( FakeESOutID *, block_t * );
+            void reset( FakeESOutID *, block_t * );
             block_t *p_block;
     };
 
@@ -133,11 +135,13 @@ namespace adaptive
             vlc_meta_t *p_meta;
     };
 
-    /* Factory so we can alter behaviour and filter on execution */
+    /* Factory so we can alter behaviour and filter on execution.
+       Send commands are recycled, as one is created per block */
     class CommandsFactory
     {
         public:
-            virtual ~CommandsFactory() {}
+            CommandsFactory();
+            virtual ~CommandsFactory();
             virtual EsOutSendCommand * createEsOutSendCommand( FakeESOutID *, block_t * ) const;
             virtual EsOutDelCommand * createEsOutDelCommand( FakeESOutID * ) const;
             virtual EsOutAddCommand * createEsOutAddCommand( FakeESOutID * ) const;
@@ -145,9 +149,53 @@ namespace adaptive
             virtual EsOutControlResetPCRCommand * creatEsOutControlResetPCRCommand() const;
             virtual EsOutDestroyCommand * createEsOutDestroyCommand() const;
             virtual EsOutMetaCommand * createEsOutMetaCommand( int, const vlc_meta_t * ) const;
+            void releaseCommand( AbstractCommand * ) const;
+            void releaseCommands( std::vector<AbstractCommand *> & ) const;
+
+        private:
+            static const size_t POOL_SIZE = 1024;
+            bool recyclable( const AbstractCommand * ) const;
+            mutable vlc_mutex_t lock;
+            /* released by the consumer, shared */
+            mutable std::vector<EsOutSendCommand *> pool;
+            /* taken from the pool by batches, producer only */
+            mutable std::vector<EsOutSendCommand *> cache;
+    };
+
+    /* Unbounded single producer, single consumer queue of commands,
+       stored in fixed size segments. Only the segment fill count and
+       link are shared, and the last released segment is kept for reuse */
+    class CommandsRing
+    {
+        public:
+            CommandsRing();
+            ~CommandsRing();
+            bool push( AbstractCommand * ); /* producer */
+            AbstractCommand * pop(); /* consumer */
+            bool isEmpty() const; /* consumer */
+            vlc_tick_t getFirstTime() const; /* consumer, first dated command */
+            static const unsigned SEGMENT_SIZE = 256;
+
+        private:
+            class Segment
+            {
+                public:
+                    Segment();
+                    void reset();
+                    AbstractCommand *slots[SEGMENT_SIZE];
+                    std::atomic<unsigned> written;
+                    std::atomic<Segment *> next;
+                    unsigned read;
+            };
+            Segment *head; /* consumer side */
+            Segment *tail; /* producer side */
+            std::atomic<Segment *> spare;
     };
 
-    /* Queuing for doing all the stuff in order */
+    /* Queuing for doing all the stuff in order.
+       Scheduling and producer side calls happen with the FakeESOut locked,
+       Process() only requires the stream one and can run concurrently
+       with the demuxer scheduling new commands */
     class CommandsQueue
     {
         public:
@@ -173,11 +221,26 @@ namespace adaptive
             CommandsFactory *commandsFactory;
             void LockedCommit();
             void LockedSetDraining();
-            std::list<AbstractCommand *> incoming;
-            std::list<AbstractCommand *> commands;
+            void Fetch();
+            class SortEntry
+            {
+                public:
+                    SortEntry( AbstractCommand *, vlc_tick_t );
+                    bool operator<( const SortEntry & ) const;
+                    AbstractCommand *command;
+                    vlc_tick_t time;
+                    bool pcr;
+            };
+            /* producer side, current PCR interval */
+            std::vector<AbstractCommand *> incoming;
+            std::vector<SortEntry> sortbuffer;
+            CommandsRing ring;
+            /* consumer side */
+            std::deque<AbstractCommand *> commands;
+            std::vector<AbstractCommand *> output;
             vlc_tick_t bufferinglevel;
             vlc_tick_t pcr;
-            bool b_draining;
+            std::atomic<bool> b_draining;
             bool b_drop;
             bool b_eof;
     };
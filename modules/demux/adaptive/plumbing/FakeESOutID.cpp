@@ -45,19 +45,20 @@ void FakeESOutID::setRealESID( es_out_id_t *real_es_id )
    p_real_es_id = real_es_id;
 }
 
+/* Called from commands execution, without the FakeESOut lock held */
 void FakeESOutID::notifyData()
 {
-    fakeesout->gc();
+    fakeesout->WithLock()->gc();
 }
 
 void FakeESOutID::create()
 {
-    fakeesout->createOrRecycleRealEsID( this );
+    fakeesout->WithLock()->createOrRecycleRealEsID( this );
 }
 
 void FakeESOutID::release()
 {
-    fakeesout->recycle( this );
+    fakeesout->WithLock()->recycle( this );
 }
 
 es_out_id_t * FakeESOutID::realESID()
@@ -53,6 +53,14 @@ ssize_t AbstractChunksSourceStream::read_Callback(stream_t *s, void *buf, size_t
     return me->Read(reinterpret_cast<uint8_t *>(buf), size);
 }
 
+block_t * AbstractChunksSourceStream::block_Callback(stream_t *s, bool *eof)
+{
+    AbstractChunksSourceStream *me = reinterpret_cast<AbstractChunksSourceStream *>(s->p_sys);
+    block_t *p_block = me->ReadBlock();
+    *eof = !p_block;
+    return p_block;
+}
+
 int AbstractChunksSourceStream::seek_Callback(stream_t *s, uint64_t i_pos)
 {
     AbstractChunksSourceStream *me = reinterpret_cast<AbstractChunksSourceStream *>(s->p_sys);
@@ -107,6 +115,8 @@ stream_t * AbstractChunksSourceStream::makeStream()
     {
         p_stream->pf_control = control_Callback;
         p_stream->pf_read = read_Callback;
+        /* hands over the downloaded blocks to block reading demuxers */
+        p_stream->pf_block = block_Callback;
         p_stream->pf_readdir = NULL;
         p_stream->pf_seek = seek_Callback;
         p_stream->p_sys = this;
@@ -193,6 +203,18 @@ ssize_t ChunksSourceStream::Read(uint8_t *buf, size_t size)
     return i_copied;
 }
 
+block_t * ChunksSourceStream::ReadBlock()
+{
+    block_t *p_ret = p_block;
+    p_block = NULL;
+    if(!p_ret && !b_eof)
+    {
+        p_ret = source->readNextBlock();
+        b_eof = !p_ret;
+    }
+    return p_ret;
+}
+
 int ChunksSourceStream::Seek(uint64_t)
 {
     return VLC_EGENERIC;
@@ -204,16 +226,22 @@ BufferedChunksSourceStream::BufferedChunksSourceStream(vlc_object_t *p_obj_, Abs
     i_global_offset = 0;
     i_bytestream_offset = 0;
     block_BytestreamInit( &bs );
+    p_peek = NULL;
 }
 
 BufferedChunksSourceStream::~BufferedChunksSourceStream()
 {
     block_BytestreamEmpty( &bs );
+    if(p_peek)
+        block_Release(p_peek);
 }
 
 void BufferedChunksSourceStream::Reset()
 {
     block_BytestreamEmpty( &bs );
+    if(p_peek)
+        block_Release(p_peek);
+    p_peek = NULL;
     i_bytestream_offset = 0;
     i_global_offset = 0;
     AbstractChunksSourceStream::Reset();
@@ -253,6 +281,48 @@ ssize_t BufferedChunksSourceStream::Read(uint8_t *buf, size_t size)
         i_toread -= i_read;
     }
 
+    trimBackend();
+
+    return i_copied;
+}
+
+block_t * BufferedChunksSourceStream::ReadBlock()
+{
+    block_t *p_block;
+    const size_t i_remain = block_BytestreamRemaining(&bs) - i_bytestream_offset;
+    if(i_remain)
+    {
+        /* Data ahead of a seek back or a partial read has to be copied
+         * as the backend still references it */
+        p_block = block_Alloc(i_remain);
+        if(!p_block)
+            return NULL;
+        block_PeekOffsetBytes(&bs, i_bytestream_offset, p_block->p_buffer, i_remain);
+        i_bytestream_offset += i_remain;
+        trimBackend();
+        return p_block;
+    }
+
+    if(b_eof)
+        return NULL;
+
+    /* Hand over the source block itself. We can't seek back into it
+     * afterwards, so the backend is dropped */
+    i_global_offset += i_bytestream_offset;
+    i_bytestream_offset = 0;
+    block_BytestreamEmpty(&bs);
+
+    p_block = source->readNextBlock();
+    if(p_block)
+        i_global_offset += p_block->i_buffer;
+    else
+        b_eof = true;
+
+    return p_block;
+}
+
+void BufferedChunksSourceStream::trimBackend()
+{
     if(i_bytestream_offset > MAX_BACKEND)
     {
         const size_t i_drop = i_bytestream_offset - MAX_BACKEND;
@@ -264,8 +334,6 @@ ssize_t BufferedChunksSourceStream::Read(uint8_t *buf, size_t size)
             i_global_offset += i_drop;
         }
     }
-
-    return i_copied;
 }
 
 int BufferedChunksSourceStream::Seek(uint64_t i_seek)
@@ -279,11 +347,47 @@ int BufferedChunksSourceStream::Seek(uint64_t i_seek)
 
 size_t BufferedChunksSourceStream::Peek(const uint8_t **pp, size_t sz)
 {
-    fillByteStream();
-    if(block_BytestreamRemaining(&bs) == 0)
+    /* Low latency chunks can be smaller than the probe size */
+    while(!b_eof && block_BytestreamRemaining(&bs) - i_bytestream_offset < sz)
+    {
+        block_t *p_add = source->readNextBlock();
+        if(p_add)
+            block_BytestreamPush(&bs, p_add);
+        else
+            b_eof = true;
+    }
+
+    const size_t i_remain = block_BytestreamRemaining(&bs) - i_bytestream_offset;
+    if(i_remain == 0)
         return 0;
-    *pp = bs.p_block->p_buffer;
-    return std::min(bs.p_block->i_buffer, sz);
+    if(sz > i_remain)
+        sz = i_remain;
+
+    size_t i_offset = bs.i_block_offset + i_bytestream_offset;
+    const block_t *p_block = bs.p_block;
+    while(i_offset >= p_block->i_buffer)
+    {
+        i_offset -= p_block->i_buffer;
+        p_block = p_block->p_next;
+    }
+
+    /* Only gather when the request spans several blocks */
+    if(p_block->i_buffer - i_offset < sz)
+    {
+        if(p_peek)
+            block_Release(p_peek);
+        p_peek = block_Alloc(sz);
+        if(p_peek)
+        {
+            block_PeekOffsetBytes(&bs, i_bytestream_offset, p_peek->p_buffer, sz);
+            *pp = p_peek->p_buffer;
+            return sz;
+        }
+        sz = p_block->i_buffer - i_offset;
+    }
+
+    *pp = &p_block->p_buffer[i_offset];
+    return sz;
 }
 
 std::string BufferedChunksSourceStream::getContentType()
@@ -48,6 +48,7 @@ namespace adaptive
 
         protected:
             virtual ssize_t Read(uint8_t *, size_t) = 0;
+            virtual block_t *ReadBlock() = 0;
             virtual int     Seek(uint64_t) = 0;
             virtual std::string getContentType() = 0;
             bool b_eof;
@@ -56,6 +57,7 @@ namespace adaptive
 
         private:
             static ssize_t read_Callback(stream_t *, void *, size_t);
+            static block_t *block_Callback(stream_t *, bool *);
             static int seek_Callback(stream_t *, uint64_t);
             static int control_Callback( stream_t *, int i_query, va_list );
             static void delete_Callback( stream_t * );
@@ -70,6 +72,7 @@ namespace adaptive
 
         protected:
             virtual ssize_t Read(uint8_t *, size_t); /* impl */
+            virtual block_t *ReadBlock(); /* impl */
             virtual int     Seek(uint64_t); /* impl */
             virtual size_t  Peek(const uint8_t **, size_t); /* impl */
             virtual std::string getContentType(); /* impl */
@@ -87,17 +90,20 @@ namespace adaptive
 
         protected:
             virtual ssize_t Read(uint8_t *, size_t); /* impl */
+            virtual block_t *ReadBlock(); /* impl */
             virtual int     Seek(uint64_t); /* impl */
             virtual size_t  Peek(const uint8_t **, size_t); /* impl */
             virtual std::string getContentType(); /* impl */
 
         private:
             void fillByteStream();
+            void trimBackend();
             static const int MAX_BACKEND = 5 * 1024 * 1024;
             static const int MIN_BACKEND_CLEANUP = 50 * 1024;
             uint64_t i_global_offset;
             size_t i_bytestream_offset;
             block_bytestream_t bs;
+            block_t *p_peek; /* gathered when spanning blocks */
     };
 }
 #endif // SOURCESTREAM_HPP
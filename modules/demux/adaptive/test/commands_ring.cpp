@@ -0,0 +1,240 @@
+/*
+ * commands_ring.cpp: adaptive commands ring and pool test
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Checks the single producer, single consumer commands ring: ordering
+ * across segment boundaries, reuse of the spare segment, concurrent
+ * producer and consumer, and the send commands recycling.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_threads.h>
+#include <vlc_tick.h>
+
+#include "../plumbing/CommandsQueue.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace adaptive;
+
+/* Counts the ring segments allocations */
+static std::atomic<unsigned> allocations(0);
+
+void * operator new(std::size_t size)
+{
+    allocations++;
+    void *p = malloc(size ? size : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    allocations++;
+    return malloc(size ? size : 1);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t &) noexcept
+{
+    free(p);
+}
+
+namespace
+{
+    class TestCommand : public AbstractCommand
+    {
+        public:
+            TestCommand() : AbstractCommand(0), time(VLC_TICK_INVALID) {}
+            virtual void Execute(es_out_t *) {}
+            virtual vlc_tick_t getTime() const { return time; }
+            vlc_tick_t time;
+    };
+}
+
+#define CHECK(cond) do { \
+    if(!(cond)) { \
+        fprintf(stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, #cond); \
+        return 1; \
+    } } while(0)
+
+static int TestSegments(std::vector<TestCommand> &commands)
+{
+    const unsigned size = CommandsRing::SEGMENT_SIZE;
+    CommandsRing ring;
+    CHECK(ring.isEmpty());
+    CHECK(ring.pop() == NULL);
+    CHECK(ring.getFirstTime() == VLC_TICK_INVALID);
+
+    /* fill exactly one segment, then cross to a second one */
+    unsigned pushed = 0;
+    const unsigned before = allocations;
+    for(; pushed < size; pushed++)
+        CHECK(ring.push(&commands[pushed]));
+    CHECK(allocations == before);
+    CHECK(ring.push(&commands[pushed++]));
+    CHECK(allocations == before + 1);
+    CHECK(!ring.isEmpty());
+
+    /* first dated command is looked up past the first segment */
+    commands[size].time = VLC_TICK_0 + 42;
+    CHECK(ring.getFirstTime() == VLC_TICK_0 + 42);
+
+    /* pop everything in order, the first segment becomes the spare one */
+    for(unsigned i = 0; i < pushed; i++)
+        CHECK(ring.pop() == &commands[i]);
+    CHECK(ring.pop() == NULL);
+    CHECK(ring.isEmpty());
+    CHECK(ring.getFirstTime() == VLC_TICK_INVALID);
+
+    /* filling the second segment and crossing again reuses the spare one */
+    for(unsigned i = 0; i < size; i++)
+        CHECK(ring.push(&commands[pushed + i]));
+    CHECK(allocations == before + 1);
+
+    /* nothing was popped since, so a third one has to be allocated */
+    for(unsigned i = 0; i < size; i++)
+        CHECK(ring.push(&commands[pushed + size + i]));
+    CHECK(allocations == before + 2);
+
+    for(unsigned i = 0; i < 2 * size; i++)
+        CHECK(ring.pop() == &commands[pushed + i]);
+    CHECK(ring.isEmpty());
+    return 0;
+}
+
+namespace
+{
+    struct ThreadedTest
+    {
+        CommandsRing ring;
+        std::vector<TestCommand> *commands;
+        std::atomic<bool> failed;
+    };
+}
+
+static void * Producer(void *data)
+{
+    ThreadedTest *test = static_cast<ThreadedTest *>(data);
+    for(size_t i = 0; i < test->commands->size(); i++)
+    {
+        if(!test->ring.push(&(*test->commands)[i]))
+        {
+            test->failed = true;
+            break;
+        }
+    }
+    return NULL;
+}
+
+static int TestThreaded(std::vector<TestCommand> &commands)
+{
+    ThreadedTest test;
+    test.commands = &commands;
+    test.failed = false;
+
+    vlc_thread_t th;
+    if(vlc_clone(&th, Producer, &test, VLC_THREAD_PRIORITY_LOW))
+        return 1;
+
+    size_t popped = 0;
+    while(popped < commands.size() && !test.failed)
+    {
+        AbstractCommand *command = test.ring.pop();
+        if(!command)
+            continue; /* the producer never waits */
+        if(command != &commands[popped])
+        {
+            test.failed = true;
+            break;
+        }
+        popped++;
+    }
+    vlc_join(th, NULL);
+
+    CHECK(!test.failed);
+    CHECK(popped == commands.size());
+    CHECK(test.ring.isEmpty());
+    return 0;
+}
+
+static int TestRecycling()
+{
+    CommandsFactory factory;
+
+    block_t *p_block = block_Alloc(16);
+    CHECK(p_block);
+    EsOutSendCommand *send = factory.createEsOutSendCommand(NULL, p_block);
+    CHECK(send);
+    CHECK(send->getTime() == VLC_TICK_INVALID);
+
+    /* released commands are handed back by the next creation */
+    std::vector<AbstractCommand *> released;
+    released.push_back(send);
+    released.push_back(factory.createEsOutDestroyCommand());
+    factory.releaseCommands(released);
+    CHECK(released.empty());
+
+    p_block = block_Alloc(16);
+    CHECK(p_block);
+    p_block->i_dts = VLC_TICK_0 + 1;
+    EsOutSendCommand *reused = factory.createEsOutSendCommand(NULL, p_block);
+    CHECK(reused == send);
+    CHECK(reused->getTime() == VLC_TICK_0 + 1);
+
+    factory.releaseCommand(reused);
+    return 0;
+}
+
+int main(void)
+{
+    std::vector<TestCommand> commands(4 * CommandsRing::SEGMENT_SIZE);
+    int ret = TestSegments(commands);
+
+    if(ret == 0)
+    {
+        std::vector<TestCommand> many(100 * CommandsRing::SEGMENT_SIZE + 7);
+        ret = TestThreaded(many);
+    }
+
+    if(ret == 0)
+        ret = TestRecycling();
+
+    return ret;
+}
@@ -0,0 +1,327 @@
+/*
+ * hls_parts.cpp: low latency HLS parts source test
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Reads a segment still being published, part by part, from playlists and
+ * parts served from a temporary directory by the simulator network: a
+ * blocking reload is answered with the "<playlist>.<msn>.<part>" snapshot.
+ * Also checks that waiting for new parts can be interrupted.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_interrupt.h>
+#include <vlc_stream.h>
+
+#include "sim/SimNetwork.hpp"
+
+#include "../SharedResources.hpp"
+#include "../playlist/BasePeriod.h"
+#include "../playlist/BaseAdaptationSet.h"
+#include "../playlist/SegmentChunk.hpp"
+#include "../../hls/playlist/M3U8.hpp"
+#include "../../hls/playlist/Parser.hpp"
+#include "../../hls/playlist/Representation.hpp"
+#include "../../hls/playlist/HLSSegment.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace adaptive;
+using namespace adaptive::sim;
+using namespace hls::playlist;
+
+#define SIM_HOST "http://sim.local/"
+
+#define HEADER \
+    "#EXTM3U\n" \
+    "#EXT-X-VERSION:9\n" \
+    "#EXT-X-TARGETDURATION:4\n"
+
+static const char blocking_playlist[] =
+    HEADER
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4.0,\n"
+    "seg10.ts\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"part11.0.ts\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"part11.1.ts\"\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"part11.2.ts\"\n";
+
+/* answer to the reload blocking until part 2 of segment 11 is listed */
+static const char blocking_snapshot[] =
+    HEADER
+    "#EXT-X-PART-INF:PART-TARGET=1.0\n"
+    "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=3.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4.0,\n"
+    "seg10.ts\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"part11.0.ts\",INDEPENDENT=YES\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"part11.1.ts\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"part11.2.ts\"\n"
+    "#EXT-X-PART:DURATION=1.0,URI=\"part11.3.ts\"\n"
+    "#EXTINF:4.0,\n"
+    "seg11.ts\n"
+    "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"part12.0.ts\"\n";
+
+/* no blocking reload and no new part ever: polls every PART-TARGET */
+static const char polling_playlist[] =
+    HEADER
+    "#EXT-X-PART-INF:PART-TARGET=2.0\n"
+    "#EXT-X-MEDIA-SEQUENCE:10\n"
+    "#EXTINF:4.0,\n"
+    "seg10.ts\n"
+    "#EXT-X-PART:DURATION=2.0,URI=\"part11.0.ts\",INDEPENDENT=YES\n";
+
+namespace
+{
+    class TestDir
+    {
+        public:
+            TestDir()
+            {
+                char psz_template[] = "/tmp/vlc-hls-parts-XXXXXX";
+                if(mkdtemp(psz_template))
+                    root = psz_template;
+            }
+
+            ~TestDir()
+            {
+                std::vector<std::string>::const_iterator it;
+                for(it = files.begin(); it != files.end(); ++it)
+                    vlc_unlink((*it).c_str());
+                if(!root.empty())
+                    rmdir(root.c_str());
+            }
+
+            bool write(const std::string &name, const std::string &data)
+            {
+                const std::string path = root + "/" + name;
+                FILE *fp = vlc_fopen(path.c_str(), "wb");
+                if(!fp)
+                    return false;
+                files.push_back(path);
+                bool b_ok = fwrite(data.c_str(), 1, data.size(), fp) == data.size();
+                return (fclose(fp) == 0) && b_ok;
+            }
+
+            std::string root;
+
+        private:
+            std::vector<std::string> files;
+    };
+
+    struct Interrupter
+    {
+        vlc_interrupt_t *ctx;
+        vlc_tick_t       delay;
+    };
+}
+
+static void *InterruptThread(void *data)
+{
+    Interrupter *interrupter = static_cast<Interrupter *>(data);
+    vlc_tick_sleep(interrupter->delay);
+    vlc_interrupt_raise(interrupter->ctx);
+    return NULL;
+}
+
+/* Reads the partial segment of the live playlist into data, returns the
+ * real time it took or VLC_TICK_INVALID on error */
+static vlc_tick_t ReadPartialSegment(vlc_object_t *obj, SimNetwork *network,
+                                     const char *psz_playlist, const std::string &name,
+                                     std::string *data)
+{
+    SimConnectionManager *manager = new SimConnectionManager(obj, network);
+    SharedResources resources(obj, manager);
+    const std::string url = std::string(SIM_HOST) + name;
+
+    stream_t *s = vlc_stream_MemoryNew(obj, (uint8_t *) psz_playlist,
+                                       strlen(psz_playlist), true);
+    if(!s)
+        return VLC_TICK_INVALID;
+    M3U8Parser parser(&resources);
+    M3U8 *playlist = parser.parse(obj, s, url);
+    vlc_stream_Delete(s);
+    if(!playlist)
+        return VLC_TICK_INVALID;
+
+    Representation *rep = NULL;
+    if(playlist->getFirstPeriod() &&
+       !playlist->getFirstPeriod()->getAdaptationSets().empty())
+    {
+        BaseAdaptationSet *set = playlist->getFirstPeriod()->getAdaptationSets().front();
+        if(!set->getRepresentations().empty())
+            rep = dynamic_cast<Representation *>(set->getRepresentations().front());
+    }
+
+    /* segment #11 is being published */
+    HLSSegment *segment = NULL;
+    if(rep)
+        segment = dynamic_cast<HLSSegment *>(
+                    rep->getSegment(SegmentInformation::INFOTYPE_MEDIA, 11));
+    if(!segment || !segment->isPartial())
+    {
+        fprintf(stderr, "no partial segment in %s\n", name.c_str());
+        delete playlist;
+        return VLC_TICK_INVALID;
+    }
+
+    /* read through a parts source */
+    const vlc_tick_t start = vlc_tick_now();
+    SegmentChunk *chunk = segment->toChunk(&resources, manager, 0, rep);
+    if(!chunk)
+    {
+        delete playlist;
+        return VLC_TICK_INVALID;
+    }
+    block_t *p_block;
+    while((p_block = chunk->readBlock()))
+    {
+        data->append((const char *) p_block->p_buffer, p_block->i_buffer);
+        block_Release(p_block);
+    }
+    const bool b_more = !chunk->isEmpty();
+    delete chunk;
+    const vlc_tick_t elapsed = vlc_tick_now() - start;
+
+    delete playlist;
+    if(b_more)
+    {
+        fprintf(stderr, "%s: chunk has more data after end\n", name.c_str());
+        return VLC_TICK_INVALID;
+    }
+    return elapsed;
+}
+
+static int TestBlockingReload(vlc_object_t *obj, SimNetwork *network, TestDir *dir)
+{
+    std::string expected;
+    for(unsigned i = 0; i < 4; i++)
+    {
+        char psz_name[16];
+        snprintf(psz_name, sizeof(psz_name), "part11.%u.ts", i);
+        const std::string part = std::string(psz_name) + ":" + std::string(100 + i, 'a' + i);
+        if(!dir->write(psz_name, part))
+            return 1;
+        expected += part;
+    }
+    if(!dir->write("live.m3u8", blocking_playlist) ||
+       !dir->write("live.m3u8.11.2", blocking_snapshot))
+        return 1;
+
+    std::string data;
+    if(ReadPartialSegment(obj, network, blocking_playlist,
+                          "live.m3u8", &data) == VLC_TICK_INVALID)
+        return 1;
+
+    if(data != expected)
+    {
+        fprintf(stderr, "blocking reload: read %zu bytes, expected %zu\n",
+                data.size(), expected.size());
+        return 1;
+    }
+    return 0;
+}
+
+static int TestInterruptedReload(vlc_object_t *obj, SimNetwork *network, TestDir *dir)
+{
+    const std::string part = "polled part";
+    if(!dir->write("poll.m3u8", polling_playlist) ||
+       !dir->write("part11.0.ts", part))
+        return 1;
+
+    vlc_interrupt_t *ctx = vlc_interrupt_create();
+    if(!ctx)
+        return 1;
+    vlc_interrupt_t *oldctx = vlc_interrupt_set(ctx);
+
+    /* as when seeking while waiting for the next part */
+    Interrupter interrupter = { ctx, VLC_TICK_FROM_MS(100) };
+    vlc_thread_t thread;
+    if(vlc_clone(&thread, InterruptThread, &interrupter, VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_interrupt_set(oldctx);
+        vlc_interrupt_destroy(ctx);
+        return 1;
+    }
+
+    std::string data;
+    vlc_tick_t elapsed = ReadPartialSegment(obj, network, polling_playlist,
+                                            "poll.m3u8", &data);
+    vlc_join(thread, NULL);
+    vlc_interrupt_set(oldctx);
+    vlc_interrupt_destroy(ctx);
+
+    if(elapsed == VLC_TICK_INVALID)
+        return 1;
+
+    if(data != part)
+    {
+        fprintf(stderr, "interrupted reload: read %zu bytes, expected %zu\n",
+                data.size(), part.size());
+        return 1;
+    }
+
+    /* without interruption, this would poll for 10 x 2 s */
+    if(elapsed >= VLC_TICK_FROM_SEC(2))
+    {
+        fprintf(stderr, "interrupted reload: took %" PRId64 " ms\n",
+                MS_FROM_VLC_TICK(elapsed));
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    TestDir dir;
+    if(dir.root.empty())
+        return 77; /* skipped */
+
+    const char *args[] = { "--quiet" };
+    libvlc_instance_t *vlc = libvlc_new(1, args);
+    if(!vlc)
+        return 1;
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    /* no bandwidth limit nor latency */
+    BandwidthTrace trace;
+    SimNetwork network(trace, dir.root, 0);
+
+    int ret = TestBlockingReload(obj, &network, &dir);
+    if(ret == 0)
+        ret = TestInterruptedReload(obj, &network, &dir);
+
+    libvlc_release(vlc);
+    return ret;
+}
@@ -0,0 +1,457 @@
+/*
+ * SimNetwork.cpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "SimNetwork.hpp"
+
+#include "../../http/BytesRange.hpp"
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_url.h>
+
+#include <sys/stat.h>
+
+using namespace adaptive::sim;
+
+BandwidthTrace::Interval::Interval(vlc_tick_t start_, vlc_tick_t end_, uint64_t bps_)
+{
+    start = start_;
+    end = end_;
+    bps = bps_;
+}
+
+BandwidthTrace::BandwidthTrace()
+{
+    period = 0;
+}
+
+bool BandwidthTrace::load(const char *psz_path)
+{
+    FILE *fp = vlc_fopen(psz_path, "rt");
+    if(!fp)
+        return false;
+
+    intervals.clear();
+    period = 0;
+
+    bool b_usable = false;
+    char line[256];
+    while(fgets(line, sizeof(line), fp))
+    {
+        unsigned duration;
+        unsigned kbps;
+        if(line[0] == '#' || sscanf(line, "%u %u", &duration, &kbps) != 2 || !duration)
+            continue;
+        const vlc_tick_t end = period + VLC_TICK_FROM_MS(duration);
+        intervals.push_back(Interval(period, end, (uint64_t) kbps * 1000));
+        period = end;
+        if(kbps)
+            b_usable = true;
+    }
+    fclose(fp);
+
+    /* would never complete any transfer */
+    if(!b_usable)
+        intervals.clear();
+
+    return b_usable;
+}
+
+vlc_tick_t BandwidthTrace::transfer(vlc_tick_t now, size_t size) const
+{
+    if(intervals.empty())
+        return 0;
+
+    double bits = (double) size * 8;
+    vlc_tick_t elapsed = 0;
+    vlc_tick_t pos = now % period;
+
+    std::vector<Interval>::const_iterator it = intervals.begin();
+    while((*it).end <= pos)
+        ++it;
+
+    while(bits > 0)
+    {
+        const Interval &interval = *it;
+        const vlc_tick_t avail = interval.end - pos;
+        const double capacity = (double) interval.bps * avail / CLOCK_FREQ;
+        if(capacity >= bits)
+        {
+            elapsed += bits * CLOCK_FREQ / interval.bps;
+            break;
+        }
+        bits -= capacity;
+        elapsed += avail;
+        pos = interval.end;
+        if(++it == intervals.end())
+        {
+            it = intervals.begin();
+            pos = 0;
+        }
+    }
+
+    return elapsed;
+}
+
+SimNetwork::SimNetwork(const BandwidthTrace &trace_, const std::string &root_, vlc_tick_t rtt_)
+    : trace(trace_)
+{
+    root = root_;
+    rtt = rtt_;
+    clock = 0;
+}
+
+vlc_tick_t SimNetwork::now() const
+{
+    return clock;
+}
+
+void SimNetwork::elapse(vlc_tick_t d)
+{
+    clock += d;
+}
+
+void SimNetwork::transfer(size_t size)
+{
+    clock += trace.transfer(clock, size);
+}
+
+void SimNetwork::roundtrip()
+{
+    clock += rtt;
+}
+
+std::string SimNetwork::getLocalPath(const ConnectionParams &params) const
+{
+    std::string path = params.getPath();
+    std::string query;
+    std::size_t pos = path.find_first_of("?#");
+    if(pos != std::string::npos)
+    {
+        query = path.substr(pos + 1);
+        path.resize(pos);
+    }
+    char *psz_decoded = vlc_uri_decode_duplicate(path.c_str());
+    if(psz_decoded)
+    {
+        path = psz_decoded;
+        free(psz_decoded);
+    }
+
+    /* HLS blocking playlist reloads are answered with the playlist
+     * snapshot "<playlist>.<msn>.<part>" if there is one */
+    unsigned long long msn;
+    unsigned part;
+    if(sscanf(query.c_str(), "_HLS_msn=%llu&_HLS_part=%u", &msn, &part) == 2)
+    {
+        char psz_suffix[48];
+        snprintf(psz_suffix, sizeof(psz_suffix), ".%llu.%u", msn, part);
+        const std::string snapshot = root + path + psz_suffix;
+        struct stat st;
+        if(vlc_stat(snapshot.c_str(), &st) == 0)
+            return snapshot;
+    }
+
+    return root + path;
+}
+
+SimConnection::SimConnection(vlc_object_t *p_object_, SimNetwork *network_)
+    : AbstractConnection(p_object_)
+{
+    network = network_;
+    file = NULL;
+}
+
+SimConnection::~SimConnection()
+{
+    close();
+}
+
+void SimConnection::close()
+{
+    if(file)
+        fclose(file);
+    file = NULL;
+    bytesRead = 0;
+    contentLength = 0;
+    bytesRange = BytesRange();
+}
+
+bool SimConnection::canReuse(const ConnectionParams &) const
+{
+    return available;
+}
+
+enum RequestStatus
+    SimConnection::request(const std::string &path, const BytesRange &range)
+{
+    close();
+
+    params.setPath(path);
+    network->roundtrip();
+
+    const std::string localpath = network->getLocalPath(params);
+    file = vlc_fopen(localpath.c_str(), "rb");
+    if(!file)
+    {
+        msg_Err(p_object, "no file %s for %s", localpath.c_str(), params.getUrl().c_str());
+        return RequestStatus::NotFound;
+    }
+
+    struct stat st;
+    if(fstat(fileno(file), &st) != 0)
+    {
+        close();
+        return RequestStatus::GenericError;
+    }
+
+    size_t start = 0;
+    size_t end = st.st_size;
+    if(range.isValid())
+    {
+        start = range.getStartByte();
+        if(range.getEndByte() > 0 && range.getEndByte() + 1 < end)
+            end = range.getEndByte() + 1;
+    }
+
+    if(start >= end || fseek(file, start, SEEK_SET) != 0)
+    {
+        close();
+        return RequestStatus::GenericError;
+    }
+
+    contentLength = end - start;
+    bytesRange = range;
+    return RequestStatus::Success;
+}
+
+ssize_t SimConnection::read(void *p_buffer, size_t len)
+{
+    if(!file)
+        return -1;
+
+    if(len > contentLength - bytesRead)
+        len = contentLength - bytesRead;
+    if(len == 0)
+        return 0;
+
+    size_t ret = fread(p_buffer, 1, len, file);
+    bytesRead += ret;
+    network->transfer(ret);
+
+    if(ret < len || bytesRead == contentLength)
+    {
+        fclose(file);
+        file = NULL;
+    }
+
+    return ret;
+}
+
+void SimConnection::setUsed(bool b)
+{
+    available = !b;
+    if(available)
+        close();
+}
+
+SimConnectionFactory::SimConnectionFactory(SimNetwork *network_)
+    : AbstractConnectionFactory()
+{
+    network = network_;
+}
+
+AbstractConnection * SimConnectionFactory::createConnection(vlc_object_t *p_object,
+                                                            const ConnectionParams &)
+{
+    return new (std::nothrow) SimConnection(p_object, network);
+}
+
+SimChunkSource::SimChunkSource(const std::string &url, SimConnectionManager *manager,
+                               const ID &id, const BytesRange &range)
+    : AbstractChunkSource(),
+      params(url)
+{
+    connManager = manager;
+    connection = NULL;
+    sourceid = id;
+    consumed = 0;
+    downloadstart = 0;
+    prepared = false;
+    eof = false;
+    bytesRange = range;
+}
+
+SimChunkSource::~SimChunkSource()
+{
+    if(connection)
+        connection->setUsed(false);
+}
+
+bool SimChunkSource::prepare()
+{
+    if(prepared)
+        return true;
+
+    downloadstart = connManager->getNetwork()->now();
+    connection = connManager->getConnection(params);
+    if(!connection)
+        return false;
+
+    requeststatus = connection->request(params.getPath(), bytesRange);
+    if(requeststatus != RequestStatus::Success)
+        return false;
+
+    contentLength = connection->getContentLength();
+    prepared = true;
+    return true;
+}
+
+block_t * SimChunkSource::read(size_t readsize)
+{
+    if(eof || !prepare())
+    {
+        eof = true;
+        return NULL;
+    }
+
+    if(readsize > contentLength - consumed)
+        readsize = contentLength - consumed;
+
+    block_t *p_block = readsize ? block_Alloc(readsize) : NULL;
+    if(!p_block)
+    {
+        eof = true;
+        return NULL;
+    }
+
+    SimNetwork *network = connManager->getNetwork();
+    vlc_tick_t time = network->now();
+    ssize_t ret = connection->read(p_block->p_buffer, readsize);
+    time = network->now() - time;
+    if(ret <= 0)
+    {
+        block_Release(p_block);
+        eof = true;
+        return NULL;
+    }
+
+    p_block->i_buffer = ret;
+    consumed += ret;
+    connManager->reportDownload(sourceid, ret, time, false);
+    if(consumed == contentLength)
+    {
+        eof = true;
+        connManager->reportDownload(sourceid, consumed,
+                                    network->now() - downloadstart, true);
+    }
+
+    return p_block;
+}
+
+block_t * SimChunkSource::readBlock()
+{
+    return read(HTTPChunkSource::CHUNK_SIZE);
+}
+
+bool SimChunkSource::hasMoreData() const
+{
+    return !eof;
+}
+
+bool SimChunkSource::getDownloadProgress(size_t *downloaded, size_t *total) const
+{
+    if(!prepared)
+        return false;
+    *downloaded = consumed;
+    *total = contentLength;
+    return true;
+}
+
+SimConnectionManager::SimConnectionManager(vlc_object_t *p_object_, SimNetwork *network_)
+    : AbstractConnectionManager(p_object_)
+{
+    network = network_;
+    factory = new SimConnectionFactory(network);
+}
+
+SimConnectionManager::~SimConnectionManager()
+{
+    delete factory;
+    closeAllConnections();
+}
+
+void SimConnectionManager::closeAllConnections()
+{
+    vlc_delete_all(connectionPool);
+}
+
+AbstractConnection * SimConnectionManager::getConnection(ConnectionParams &params)
+{
+    AbstractConnection *conn = NULL;
+    std::vector<AbstractConnection *>::const_iterator it;
+    for(it = connectionPool.begin(); it != connectionPool.end() && !conn; ++it)
+    {
+        if((*it)->canReuse(params))
+            conn = *it;
+    }
+
+    if(!conn)
+    {
+        conn = factory->createConnection(p_object, params);
+        if(!conn)
+            return NULL;
+        connectionPool.push_back(conn);
+    }
+
+    if(!conn->prepare(params))
+        return NULL;
+    conn->setUsed(true);
+    return conn;
+}
+
+AbstractChunkSource *SimConnectionManager::makeSource(const std::string &url,
+                                                      const ID &id, const BytesRange &range)
+{
+    return new (std::nothrow) SimChunkSource(url, this, id, range);
+}
+
+void SimConnectionManager::updateDownloadRate(const ID &, size_t, vlc_tick_t)
+{
+    /* playlists reads are timed with the real clock, not reported */
+}
+
+void SimConnectionManager::reportDownload(const ID &id, size_t size,
+                                          vlc_tick_t time, bool b_complete)
+{
+    if(time == 0)
+        return;
+    if(b_complete)
+        AbstractConnectionManager::updateDownloadRate(id, size, time);
+    else
+        AbstractConnectionManager::updateDownloadProgress(id, size, time, network->now());
+}
+
+SimNetwork * SimConnectionManager::getNetwork() const
+{
+    return network;
+}
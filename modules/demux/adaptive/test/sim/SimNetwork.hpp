@@ -0,0 +1,157 @@
+/*
+ * SimNetwork.hpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef SIMNETWORK_HPP
+#define SIMNETWORK_HPP
+
+#include "../../http/HTTPConnection.hpp"
+#include "../../http/HTTPConnectionManager.h"
+#include "../../http/Chunk.h"
+#include "../../ID.hpp"
+
+#include <vlc_common.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace adaptive
+{
+    namespace sim
+    {
+        using namespace http;
+
+        /* Recorded link capacity, as "<duration ms> <kbit/s>" lines,
+         * looped over when exhausted */
+        class BandwidthTrace
+        {
+            public:
+                BandwidthTrace();
+                bool load(const char *);
+                vlc_tick_t transfer(vlc_tick_t, size_t) const;
+
+            private:
+                class Interval
+                {
+                    public:
+                        Interval(vlc_tick_t, vlc_tick_t, uint64_t);
+                        vlc_tick_t start;
+                        vlc_tick_t end;
+                        uint64_t   bps;
+                };
+                std::vector<Interval> intervals;
+                vlc_tick_t period;
+        };
+
+        /* Simulated time and link, serving urls from a local directory */
+        class SimNetwork
+        {
+            public:
+                SimNetwork(const BandwidthTrace &, const std::string &, vlc_tick_t);
+                vlc_tick_t now() const;
+                void       elapse(vlc_tick_t);
+                void       transfer(size_t);
+                void       roundtrip();
+                std::string getLocalPath(const ConnectionParams &) const;
+
+            private:
+                const BandwidthTrace &trace;
+                std::string root;
+                vlc_tick_t  rtt;
+                vlc_tick_t  clock;
+        };
+
+        class SimConnection : public AbstractConnection
+        {
+            public:
+                SimConnection(vlc_object_t *, SimNetwork *);
+                virtual ~SimConnection();
+
+                virtual bool    canReuse     (const ConnectionParams &) const; /* impl */
+                virtual enum RequestStatus
+                                request     (const std::string& path, const BytesRange & = BytesRange()); /* impl */
+                virtual ssize_t read        (void *p_buffer, size_t len); /* impl */
+                virtual void    setUsed( bool ); /* impl */
+
+            private:
+                void close();
+                SimNetwork *network;
+                FILE       *file;
+        };
+
+        class SimConnectionFactory : public AbstractConnectionFactory
+        {
+            public:
+                SimConnectionFactory(SimNetwork *);
+                virtual ~SimConnectionFactory() {}
+                virtual AbstractConnection * createConnection(vlc_object_t *, const ConnectionParams &);
+            private:
+                SimNetwork *network;
+        };
+
+        class SimConnectionManager;
+
+        /* Downloads on read, reporting rates like buffered sources do */
+        class SimChunkSource : public AbstractChunkSource
+        {
+            public:
+                SimChunkSource(const std::string &, SimConnectionManager *,
+                               const ID &, const BytesRange &);
+                virtual ~SimChunkSource();
+                virtual block_t *   readBlock       (); /* impl */
+                virtual block_t *   read            (size_t); /* impl */
+                virtual bool        hasMoreData     () const; /* impl */
+                virtual bool        getDownloadProgress(size_t *, size_t *) const; /* reimpl */
+
+            private:
+                bool prepare();
+                SimConnectionManager *connManager;
+                AbstractConnection   *connection;
+                ConnectionParams      params;
+                ID                    sourceid;
+                size_t                consumed;
+                vlc_tick_t            downloadstart;
+                bool                  prepared;
+                bool                  eof;
+        };
+
+        class SimConnectionManager : public AbstractConnectionManager
+        {
+            public:
+                SimConnectionManager(vlc_object_t *, SimNetwork *);
+                virtual ~SimConnectionManager();
+
+                virtual void    closeAllConnections () /* impl */;
+                virtual AbstractConnection * getConnection(ConnectionParams &) /* impl */;
+                virtual AbstractChunkSource *makeSource(const std::string &,
+                                                        const ID &, const BytesRange &) /* impl */;
+                virtual void start(AbstractChunkSource *) {} /* impl */
+                virtual void cancel(AbstractChunkSource *) {} /* impl */
+                virtual void updateDownloadRate(const ID &, size_t, vlc_tick_t); /* reimpl */
+                void         reportDownload(const ID &, size_t, vlc_tick_t, bool);
+                SimNetwork * getNetwork() const;
+
+            private:
+                SimNetwork                        *network;
+                AbstractConnectionFactory         *factory;
+                std::vector<AbstractConnection *>  connectionPool;
+        };
+    }
+}
+
+#endif // SIMNETWORK_HPP
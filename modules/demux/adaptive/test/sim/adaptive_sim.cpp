@@ -0,0 +1,526 @@
+/*
+ * adaptive_sim.cpp: offline adaptation logic simulator
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Plays a local VOD playlist with each adaptation logic over a recorded
+ * bandwidth trace, in simulated time, and reports startup delay, stalls,
+ * average bitrate and switches. Files are served from the playlist
+ * directory as if from http://sim.local/.
+ *
+ * The trace is a text file of "<duration ms> <kbit/s>" lines.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_stream.h>
+
+#include "SimNetwork.hpp"
+
+#include "../../SharedResources.hpp"
+#include "../../SegmentTracker.hpp"
+#include "../../playlist/AbstractPlaylist.hpp"
+#include "../../playlist/BasePeriod.h"
+#include "../../playlist/BaseAdaptationSet.h"
+#include "../../playlist/BaseRepresentation.h"
+#include "../../playlist/SegmentChunk.hpp"
+#include "../../logic/AlwaysBestAdaptationLogic.h"
+#include "../../logic/AlwaysLowestAdaptationLogic.hpp"
+#include "../../logic/HybridAdaptationLogic.hpp"
+#include "../../logic/NearOptimalAdaptationLogic.hpp"
+#include "../../logic/PredictiveAdaptationLogic.hpp"
+#include "../../logic/RateBasedAdaptationLogic.h"
+#include "../../xml/DOMParser.h"
+#include "../../../dash/DASHManager.h"
+#include "../../../dash/mpd/IsoffMainParser.h"
+#include "../../../hls/HLSManager.hpp"
+#include "../../../hls/playlist/Parser.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <getopt.h>
+
+using namespace adaptive;
+using namespace adaptive::sim;
+using namespace adaptive::logic;
+using namespace adaptive::playlist;
+
+#define SIM_HOST "http://sim.local/"
+
+static const struct
+{
+    const char *psz_name;
+    AbstractAdaptationLogic::LogicType type;
+} logics[] = {
+    { "nearoptimal", AbstractAdaptationLogic::NearOptimal },
+    { "predictive",  AbstractAdaptationLogic::Predictive },
+    { "rate",        AbstractAdaptationLogic::RateBased },
+    { "hybrid",      AbstractAdaptationLogic::Hybrid },
+    { "lowest",      AbstractAdaptationLogic::AlwaysLowest },
+    { "highest",     AbstractAdaptationLogic::AlwaysBest },
+};
+
+namespace
+{
+    class SimStream : public SegmentTrackerListenerInterface
+    {
+        public:
+            SimStream(SharedResources *res, AbstractAdaptationLogic *logic,
+                      BaseAdaptationSet *adaptSet)
+                : tracker(res, logic, adaptSet)
+            {
+                buffered = 0;
+                ended = false;
+                failures = 0;
+                bandwidth = 0;
+                duration = 0;
+                bits = 0;
+                media = 0;
+                switches = 0;
+                tracker.registerListener(this);
+            }
+
+            virtual void trackerEvent(const SegmentTrackerEvent &event)
+            {
+                if(event.type == SegmentTrackerEvent::SWITCHING &&
+                   event.u.switching.next)
+                {
+                    if(event.u.switching.prev &&
+                       event.u.switching.prev != event.u.switching.next)
+                        switches++;
+                    bandwidth = event.u.switching.next->getBandwidth();
+                }
+                else if(event.type == SegmentTrackerEvent::SEGMENT_CHANGE)
+                {
+                    duration = event.u.segment.duration;
+                }
+            }
+
+            SegmentTracker tracker;
+            vlc_tick_t buffered;
+            bool       ended;
+            unsigned   failures;
+            uint64_t   bandwidth; /* current representation */
+            vlc_tick_t duration; /* of the last media segment */
+            double     bits;
+            vlc_tick_t media;
+            unsigned   switches;
+    };
+
+    class SimPlayback
+    {
+        public:
+            SimPlayback()
+            {
+                playing = false;
+                started = false;
+                startup = 0;
+                stalls = 0;
+                stalltime = 0;
+            }
+
+            /* Consumes buffers as time passes, until a stream runs dry */
+            void advance(std::vector<SimStream *> &streams, vlc_tick_t dt)
+            {
+                if(!playing)
+                {
+                    if(started)
+                        stalltime += dt;
+                    else
+                        startup += dt;
+                    return;
+                }
+
+                vlc_tick_t playable = dt;
+                std::vector<SimStream *>::const_iterator it;
+                for(it = streams.begin(); it != streams.end(); ++it)
+                {
+                    if(!(*it)->ended)
+                        playable = std::min(playable, (*it)->buffered);
+                }
+
+                for(it = streams.begin(); it != streams.end(); ++it)
+                    (*it)->buffered = std::max<vlc_tick_t>((*it)->buffered - playable, 0);
+
+                if(playable < dt)
+                {
+                    playing = false;
+                    stalls++;
+                    stalltime += dt - playable;
+                }
+            }
+
+            void check(const std::vector<SimStream *> &streams, vlc_tick_t threshold)
+            {
+                if(playing)
+                    return;
+                std::vector<SimStream *>::const_iterator it;
+                for(it = streams.begin(); it != streams.end(); ++it)
+                {
+                    if(!(*it)->ended && (*it)->buffered < threshold)
+                        return;
+                }
+                playing = started = true;
+            }
+
+            bool       playing;
+            bool       started;
+            vlc_tick_t startup;
+            unsigned   stalls;
+            vlc_tick_t stalltime;
+    };
+
+    class SimResult
+    {
+        public:
+            SimResult()
+            {
+                startup = 0;
+                stalls = 0;
+                stalltime = 0;
+                bitrate = 0;
+                switches = 0;
+                complete = false;
+            }
+            vlc_tick_t startup;
+            unsigned   stalls;
+            vlc_tick_t stalltime;
+            uint64_t   bitrate;
+            unsigned   switches;
+            bool       complete;
+    };
+}
+
+static AbstractAdaptationLogic *CreateLogic(vlc_object_t *obj,
+                                            AbstractAdaptationLogic::LogicType type)
+{
+    switch(type)
+    {
+        case AbstractAdaptationLogic::AlwaysLowest:
+            return new (std::nothrow) AlwaysLowestAdaptationLogic(obj);
+        case AbstractAdaptationLogic::AlwaysBest:
+            return new (std::nothrow) AlwaysBestAdaptationLogic(obj);
+        case AbstractAdaptationLogic::RateBased:
+            return new (std::nothrow) RateBasedAdaptationLogic(obj);
+        case AbstractAdaptationLogic::Predictive:
+            return new (std::nothrow) PredictiveAdaptationLogic(obj);
+        case AbstractAdaptationLogic::Hybrid:
+            return new (std::nothrow) HybridAdaptationLogic(obj);
+        case AbstractAdaptationLogic::NearOptimal:
+        default:
+            return new (std::nothrow) NearOptimalAdaptationLogic(obj);
+    }
+}
+
+static AbstractPlaylist *ParsePlaylist(vlc_object_t *obj, SharedResources *res,
+                                       std::vector<uint8_t> &data,
+                                       const std::string &url)
+{
+    stream_t *s = vlc_stream_MemoryNew(obj, &data[0], data.size(), true);
+    if(!s)
+        return NULL;
+
+    AbstractPlaylist *playlist = NULL;
+    if(hls::HLSManager::isHTTPLiveStreaming(s))
+    {
+        hls::playlist::M3U8Parser parser(res);
+        playlist = parser.parse(obj, s, url);
+    }
+    else
+    {
+        xml::DOMParser xmlParser;
+        if(xmlParser.reset(s) && xmlParser.parse(true) &&
+           dash::DASHManager::isDASH(xmlParser.getRootNode()))
+        {
+            dash::mpd::IsoffMainParser mpdparser(xmlParser.getRootNode(), obj, s, url);
+            playlist = mpdparser.parse();
+        }
+    }
+
+    vlc_stream_Delete(s);
+    return playlist;
+}
+
+
+static int Simulate(vlc_object_t *obj, AbstractAdaptationLogic::LogicType type,
+                    const BandwidthTrace &trace, const std::string &root,
+                    std::vector<uint8_t> &data, const std::string &url,
+                    vlc_tick_t rtt, vlc_tick_t limit, SimResult *result)
+{
+    SimNetwork network(trace, root, rtt);
+    SimConnectionManager *manager = new SimConnectionManager(obj, &network);
+    SharedResources resources(obj, manager);
+
+    AbstractPlaylist *playlist = ParsePlaylist(obj, &resources, data, url);
+    if(!playlist)
+    {
+        fprintf(stderr, "cannot parse playlist %s\n", url.c_str());
+        return VLC_EGENERIC;
+    }
+
+    if(playlist->isLive() || !playlist->getFirstPeriod())
+    {
+        fprintf(stderr, "only on demand playlists can be simulated\n");
+        delete playlist;
+        return VLC_EGENERIC;
+    }
+
+    AbstractAdaptationLogic *logic = CreateLogic(obj, type);
+    if(!logic)
+    {
+        delete playlist;
+        return VLC_ENOMEM;
+    }
+    manager->setDownloadRateObserver(logic);
+
+    std::vector<SimStream *> streams;
+    const std::vector<BaseAdaptationSet *> &sets =
+            playlist->getFirstPeriod()->getAdaptationSets();
+    std::vector<BaseAdaptationSet *>::const_iterator it;
+    for(it = sets.begin(); it != sets.end(); ++it)
+    {
+        SimStream *st = new SimStream(&resources, logic, *it);
+        st->tracker.notifyBufferingState(true);
+        streams.push_back(st);
+    }
+
+    const vlc_tick_t minbuffering = playlist->getMinBuffering();
+    const vlc_tick_t maxbuffering = playlist->getMaxBuffering();
+    SimPlayback playback;
+    vlc_tick_t last = network.now();
+
+    while(network.now() < limit)
+    {
+        SimStream *st = NULL;
+        std::vector<SimStream *>::const_iterator its;
+        for(its = streams.begin(); its != streams.end(); ++its)
+        {
+            if(!(*its)->ended && (!st || (*its)->buffered < st->buffered))
+                st = *its;
+        }
+        if(!st)
+        {
+            result->complete = true;
+            break;
+        }
+
+        bool b_media = false;
+        if(st->buffered >= maxbuffering)
+        {
+            /* idle until there's room for another segment */
+            network.elapse(st->buffered - maxbuffering + VLC_TICK_FROM_MS(100));
+        }
+        else
+        {
+            st->tracker.notifyBufferingLevel(minbuffering, st->buffered, maxbuffering);
+            st->duration = 0;
+            SegmentChunk *chunk = st->tracker.getNextChunk(true, manager);
+            if(chunk)
+            {
+                block_t *p_block;
+                while((p_block = chunk->readBlock()))
+                    block_Release(p_block);
+                if(chunk->getRequestStatus() != RequestStatus::Success)
+                    st->ended = true;
+                b_media = (st->duration > 0);
+                delete chunk;
+                st->failures = 0;
+            }
+            /* format changes also return no chunk once */
+            else if(++st->failures > 2)
+            {
+                st->ended = true;
+            }
+        }
+
+        playback.advance(streams, network.now() - last);
+        last = network.now();
+
+        if(b_media)
+        {
+            st->buffered += st->duration;
+            st->bits += (double) st->bandwidth * st->duration;
+            st->media += st->duration;
+        }
+        playback.check(streams, minbuffering);
+    }
+
+    result->startup = playback.startup;
+    result->stalls = playback.stalls;
+    result->stalltime = playback.stalltime;
+    for(size_t i=0; i<streams.size(); i++)
+    {
+        SimStream *st = streams[i];
+        if(st->media)
+            result->bitrate += st->bits / st->media;
+        result->switches += st->switches;
+        st->tracker.notifyBufferingState(false);
+        delete st;
+    }
+
+    delete logic;
+    delete playlist;
+    return VLC_SUCCESS;
+}
+
+static int ReadFile(const char *psz_path, std::vector<uint8_t> *data)
+{
+    FILE *fp = vlc_fopen(psz_path, "rb");
+    if(!fp)
+        return VLC_EGENERIC;
+    uint8_t buf[4096];
+    size_t i_read;
+    while((i_read = fread(buf, 1, sizeof(buf), fp)) > 0)
+        data->insert(data->end(), buf, buf + i_read);
+    fclose(fp);
+    return data->empty() ? VLC_EGENERIC : VLC_SUCCESS;
+}
+
+static void Usage(const char *psz_name)
+{
+    fprintf(stderr, "Usage: %s [-l logic]... [-r rtt_ms] [-d max_s] [-v] "
+                    "<playlist> <trace>\n", psz_name);
+    fprintf(stderr, "logics:");
+    for(size_t i=0; i<ARRAY_SIZE(logics); i++)
+        fprintf(stderr, " %s", logics[i].psz_name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<size_t> selected;
+    vlc_tick_t rtt = VLC_TICK_FROM_MS(50);
+    vlc_tick_t limit = VLC_TICK_FROM_SEC(4 * 3600);
+    bool b_verbose = false;
+
+    int c;
+    while((c = getopt(argc, argv, "l:r:d:v")) != -1)
+    {
+        switch(c)
+        {
+            case 'l':
+            {
+                size_t i;
+                for(i=0; i<ARRAY_SIZE(logics); i++)
+                {
+                    if(!strcmp(optarg, logics[i].psz_name))
+                        break;
+                }
+                if(i == ARRAY_SIZE(logics))
+                {
+                    Usage(argv[0]);
+                    return 1;
+                }
+                selected.push_back(i);
+                break;
+            }
+            case 'r':
+                rtt = VLC_TICK_FROM_MS(atoi(optarg));
+                break;
+            case 'd':
+                limit = VLC_TICK_FROM_SEC(atoi(optarg));
+                break;
+            case 'v':
+                b_verbose = true;
+                break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if(argc - optind != 2)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    if(selected.empty())
+    {
+        for(size_t i=0; i<ARRAY_SIZE(logics); i++)
+            selected.push_back(i);
+    }
+
+    const std::string playlistpath(argv[optind]);
+    std::vector<uint8_t> data;
+    if(ReadFile(playlistpath.c_str(), &data) != VLC_SUCCESS)
+    {
+        fprintf(stderr, "cannot read playlist %s\n", playlistpath.c_str());
+        return 1;
+    }
+
+    BandwidthTrace trace;
+    if(!trace.load(argv[optind + 1]))
+    {
+        fprintf(stderr, "cannot load bandwidth trace %s\n", argv[optind + 1]);
+        return 1;
+    }
+
+    /* Serve the playlist and everything next to it */
+    std::string root = ".";
+    std::string name = playlistpath;
+    std::size_t pos = playlistpath.find_last_of(DIR_SEP_CHAR);
+    if(pos != std::string::npos)
+    {
+        root = playlistpath.substr(0, pos);
+        name = playlistpath.substr(pos + 1);
+    }
+    const std::string url = std::string(SIM_HOST) + name;
+
+    const char *args[] = { "--quiet" };
+    libvlc_instance_t *vlc = libvlc_new(b_verbose ? 0 : 1, args);
+    if(!vlc)
+        return 1;
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    printf("%-12s %10s %7s %10s %10s %9s\n", "logic", "startup_ms",
+           "stalls", "stall_ms", "avg_kbps", "switches");
+
+    int ret = 0;
+    for(size_t i=0; i<selected.size(); i++)
+    {
+        SimResult result;
+        if(Simulate(obj, logics[selected[i]].type, trace, root, data, url,
+                    rtt, limit, &result) != VLC_SUCCESS)
+        {
+            ret = 1;
+            break;
+        }
+        printf("%-12s %10" PRId64 " %7u %10" PRId64 " %10" PRIu64 " %9u%s\n",
+               logics[selected[i]].psz_name,
+               MS_FROM_VLC_TICK(result.startup), result.stalls,
+               MS_FROM_VLC_TICK(result.stalltime), result.bitrate / 1000,
+               result.switches, result.complete ? "" : " (incomplete)");
+    }
+
+    libvlc_release(vlc);
+    return ret;
+}
@@ -50,7 +50,7 @@ void DashIndexChunk::onDownload(block_t **pp_block)
 {
     decrypt(pp_block);
 
-    if(!rep || ((*pp_block)->i_flags & BLOCK_FLAG_HEADER) == 0 )
+    if(!rep || !*pp_block || ((*pp_block)->i_flags & BLOCK_FLAG_HEADER) == 0 )
         return;
 
     IndexReader br(rep->getPlaylist()->getVLCObject());
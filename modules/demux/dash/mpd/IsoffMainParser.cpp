@@ -44,6 +44,7 @@
 #include "../../adaptive/tools/Debug.hpp"
 #include "../../adaptive/tools/Conversions.hpp"
 #include <vlc_stream.h>
+#include <vlc_charset.h>
 #include <cstdio>
 #include <limits>
 
@@ -81,6 +82,7 @@ MPD * IsoffMainParser::parse()
     {
         parseMPDAttributes(mpd, root);
         parseProgramInformation(DOMHelper::getFirstChildElementByName(root, "ProgramInformation"), mpd);
+        parseServiceDescription(DOMHelper::getFirstChildElementByName(root, "ServiceDescription"), mpd);
         parseMPDBaseUrl(mpd, root);
         parsePeriods(mpd, root);
         mpd->debug();
@@ -182,6 +184,15 @@ size_t IsoffMainParser::parseSegmentTemplate(Node *templateNode, SegmentInformat
     if(templateNode->hasAttribute("duration"))
         mediaTemplate->duration.Set(Integer<stime_t>(templateNode->getAttributeValue("duration")));
 
+    /* Low latency, segment can be requested before its end, and
+     * is then transferred as it is produced (availabilityTimeComplete=false) */
+    if(templateNode->hasAttribute("availabilityTimeOffset"))
+    {
+        double offset = us_strtod(templateNode->getAttributeValue("availabilityTimeOffset").c_str(), NULL);
+        if(offset > 0.0 && offset < 3600.0) /* INF is not for live edge */
+            mediaTemplate->setAvailabilityTimeOffset(vlc_tick_from_sec(offset));
+    }
+
     InitSegmentTemplate *initTemplate = NULL;
 
     if(templateNode->hasAttribute("initialization"))
@@ -512,6 +523,41 @@ void IsoffMainParser::parseProgramInformation(Node * node, MPD *mpd)
     }
 }
 
+void IsoffMainParser::parseServiceDescription(Node *node, MPD *mpd)
+{
+    if(!node)
+        return;
+
+    /* values are in milliseconds */
+    Node *latency = DOMHelper::getFirstChildElementByName(node, "Latency");
+    if(latency)
+    {
+        if(latency->hasAttribute("target"))
+            mpd->targetLatency.Set(VLC_TICK_FROM_MS(Integer<uint64_t>(latency->getAttributeValue("target"))));
+        if(latency->hasAttribute("min"))
+            mpd->minLatency.Set(VLC_TICK_FROM_MS(Integer<uint64_t>(latency->getAttributeValue("min"))));
+        if(latency->hasAttribute("max"))
+            mpd->maxLatency.Set(VLC_TICK_FROM_MS(Integer<uint64_t>(latency->getAttributeValue("max"))));
+    }
+
+    Node *rate = DOMHelper::getFirstChildElementByName(node, "PlaybackRate");
+    if(rate)
+    {
+        if(rate->hasAttribute("min"))
+        {
+            double min = us_strtod(rate->getAttributeValue("min").c_str(), NULL);
+            if(min > 0.5 && min <= 1.0)
+                mpd->minPlaybackRate.Set(min);
+        }
+        if(rate->hasAttribute("max"))
+        {
+            double max = us_strtod(rate->getAttributeValue("max").c_str(), NULL);
+            if(max >= 1.0 && max < 2.0)
+                mpd->maxPlaybackRate.Set(max);
+        }
+    }
+}
+
 Profile IsoffMainParser::getProfile() const
 {
     Profile res(Profile::Unknown);
@@ -73,6 +73,12 @@ void MPD::debug()
             SEC_FROM_VLC_TICK(duration.Get()),
             minBufferTime);
     msg_Dbg(p_object, "BaseUrl=%s", getUrlSegment().toString().c_str());
+    if(targetLatency.Get())
+        msg_Dbg(p_object, "Low latency target=%" PRId64 "ms min=%" PRId64 "ms max=%" PRId64
+                "ms rate=%.2f-%.2f",
+                MS_FROM_VLC_TICK(targetLatency.Get()), MS_FROM_VLC_TICK(minLatency.Get()),
+                MS_FROM_VLC_TICK(maxLatency.Get()),
+                minPlaybackRate.Get(), maxPlaybackRate.Get());
 
     std::vector<BasePeriod *>::const_iterator i;
     for(i = periods.begin(); i != periods.end(); ++i)
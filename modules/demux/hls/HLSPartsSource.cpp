@@ -0,0 +1,287 @@
+/*
+ * HLSPartsSource.cpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "HLSPartsSource.hpp"
+#include "playlist/Parser.hpp"
+#include "playlist/Representation.hpp"
+#include "../adaptive/http/HTTPConnectionManager.h"
+#include "../adaptive/playlist/AbstractPlaylist.hpp"
+
+#include <vlc_block.h>
+#include <vlc_interrupt.h>
+
+#include <cinttypes>
+
+using namespace hls;
+using namespace hls::playlist;
+
+HLSPartsSource::HLSPartsSource(SharedResources *res, AbstractConnectionManager *manager,
+                               const adaptive::ID &id, const Representation *representation,
+                               const Url &base, uint64_t number,
+                               const std::vector<HLSPart> &list, const HLSPart &preloadhint)
+    : AbstractChunkSource(),
+      resources(res),
+      connManager(manager),
+      sourceid(id),
+      rep(representation),
+      baseUrl(base),
+      msn(number),
+      parts(list),
+      hint(preloadhint)
+{
+    requested = 0;
+    b_complete = false;
+    stalled = 0;
+    current = NULL;
+    pending = NULL;
+    b_currenthint = false;
+    b_pendinghint = false;
+    b_currentread = false;
+    /* start transfer of the first part right away */
+    openPending();
+}
+
+HLSPartsSource::~HLSPartsSource()
+{
+    delete current;
+    delete pending;
+}
+
+AbstractChunkSource * HLSPartsSource::makePartSource(const HLSPart &part)
+{
+    Url url(part.url);
+    if(!url.hasScheme())
+        url = Url(baseUrl).append(url);
+
+    AbstractChunkSource *source = connManager->makeSource(url.toString(), sourceid, part.range);
+    if(source)
+        connManager->start(source);
+    return source;
+}
+
+bool HLSPartsSource::openPending()
+{
+    if(pending)
+        return true;
+
+    if(requested < parts.size())
+    {
+        pending = makePartSource(parts[requested++]);
+        b_pendinghint = false;
+    }
+    else if(requested == parts.size() && hint.isValid() && !b_complete)
+    {
+        /* server holds the request until that next part is available */
+        pending = makePartSource(hint);
+        hint = HLSPart();
+        b_pendinghint = true;
+        requested++;
+    }
+    else return false;
+
+    if(!pending)
+        requeststatus = RequestStatus::GenericError;
+    return pending != NULL;
+}
+
+bool HLSPartsSource::openNext()
+{
+    while(!openPending())
+    {
+        if(requeststatus != RequestStatus::Success || b_complete)
+            return false;
+        if(!reload())
+            return false;
+    }
+
+    current = pending;
+    b_currenthint = b_pendinghint;
+    b_currentread = false;
+    pending = NULL;
+
+    /* keep next part transferring while this one is read */
+    openPending();
+
+    return requeststatus == RequestStatus::Success;
+}
+
+void HLSPartsSource::closeCurrent()
+{
+    delete current;
+    current = NULL;
+}
+
+bool HLSPartsSource::checkCurrent()
+{
+    if(current->getRequestStatus() == RequestStatus::Success)
+        return true;
+
+    if(b_currenthint && !b_currentread && !pending)
+    {
+        /* preload hint was refused, request that part again once listed */
+        closeCurrent();
+        requested--;
+    }
+    else
+    {
+        requeststatus = current->getRequestStatus();
+        closeCurrent();
+    }
+    return false;
+}
+
+bool HLSPartsSource::reload()
+{
+    const bool b_blocking = rep->canBlockReload();
+    if(!b_blocking)
+    {
+        const vlc_tick_t wait = rep->getPartTarget();
+        if(vlc_msleep_i11e(wait ? wait : VLC_TICK_FROM_MS(500)))
+        {
+            /* stopping or seeking */
+            b_complete = true;
+            return false;
+        }
+    }
+
+    /* A blocking reload is answered once the first part we don't know
+     * about is listed, along with the hint for the following one */
+    const std::string url = b_blocking ? rep->getBlockingReloadUrl(msn, parts.size())
+                                       : rep->getPlaylistUrl().toString();
+
+    std::vector<HLSPart> newparts;
+    HLSPart newhint;
+    bool b_newcomplete;
+    M3U8Parser parser(resources);
+    if(!parser.getSegmentParts(rep->getPlaylist()->getVLCObject(), url, msn,
+                               newparts, newhint, &b_newcomplete))
+    {
+        /* failed or interrupted request, playlist updates will catch up */
+        b_complete = true;
+        return false;
+    }
+
+    if(b_newcomplete || newparts.size() > requested ||
+       (newparts.size() == requested && newhint.isValid()))
+    {
+        parts.swap(newparts);
+        hint = newhint;
+        b_complete = b_newcomplete;
+        stalled = 0;
+        return true;
+    }
+
+    if(++stalled < MAX_STALLED_RELOADS)
+        return true;
+
+    msg_Warn(rep->getPlaylist()->getVLCObject(),
+             "no new part for segment #%" PRIu64 " after %u reloads", msn, stalled);
+    b_complete = true;
+    return false;
+}
+
+block_t * HLSPartsSource::readBlock()
+{
+    while(requeststatus == RequestStatus::Success)
+    {
+        if(!current && !openNext())
+            return NULL;
+
+        block_t *p_block = current->readBlock();
+        if(!checkCurrent())
+        {
+            if(p_block)
+                block_Release(p_block);
+            continue;
+        }
+
+        /* Blocks are passed through as received from each part */
+        if(p_block && p_block->i_buffer)
+        {
+            b_currentread = true;
+            return p_block;
+        }
+
+        if(p_block)
+            block_Release(p_block);
+
+        if(!current->hasMoreData())
+            closeCurrent();
+    }
+    return NULL;
+}
+
+block_t * HLSPartsSource::read(size_t size)
+{
+    block_t *p_chain = NULL;
+    block_t **pp_chain_last = &p_chain;
+    size_t total = 0;
+
+    while(total < size && requeststatus == RequestStatus::Success)
+    {
+        if(!current && !openNext())
+            break;
+
+        block_t *p_block = current->read(size - total);
+        if(!checkCurrent())
+        {
+            if(p_block)
+                block_Release(p_block);
+            continue;
+        }
+
+        if(p_block)
+        {
+            b_currentread |= !!p_block->i_buffer;
+            total += p_block->i_buffer;
+            block_ChainLastAppend(&pp_chain_last, p_block);
+        }
+
+        if(!current->hasMoreData())
+            closeCurrent();
+        else if(!p_block)
+            break;
+    }
+
+    if(p_chain == NULL || p_chain->p_next == NULL)
+        return p_chain;
+    return block_ChainGather(p_chain);
+}
+
+bool HLSPartsSource::hasMoreData() const
+{
+    if(requeststatus != RequestStatus::Success)
+        return false;
+    if(current && current->hasMoreData())
+        return true;
+    return pending || !b_complete || requested < parts.size();
+}
+
+std::string HLSPartsSource::getContentType() const
+{
+    if(current)
+        return current->getContentType();
+    else if(pending)
+        return pending->getContentType();
+    return std::string();
+}
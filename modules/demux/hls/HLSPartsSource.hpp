@@ -0,0 +1,91 @@
+/*
+ * HLSPartsSource.hpp
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN and VLC authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef HLSPARTSSOURCE_HPP
+#define HLSPARTSSOURCE_HPP
+
+#include "../adaptive/http/Chunk.h"
+#include "../adaptive/playlist/Url.hpp"
+#include "playlist/HLSSegment.hpp"
+
+#include <vector>
+
+namespace adaptive
+{
+    class SharedResources;
+}
+
+namespace hls
+{
+    namespace playlist
+    {
+        class Representation;
+    }
+
+    using namespace adaptive;
+    using namespace adaptive::http;
+    using namespace adaptive::playlist;
+
+    /* Low latency HLS: reads a segment still being published as the
+     * sequence of its EXT-X-PART, reloading the playlist to discover
+     * new parts until the segment is complete */
+    class HLSPartsSource : public AbstractChunkSource
+    {
+        public:
+            HLSPartsSource(SharedResources *, AbstractConnectionManager *,
+                           const ID &, const playlist::Representation *,
+                           const Url &, uint64_t,
+                           const std::vector<playlist::HLSPart> &,
+                           const playlist::HLSPart &);
+            virtual ~HLSPartsSource();
+            virtual block_t *   readBlock       (); /* impl */
+            virtual block_t *   read            (size_t); /* impl */
+            virtual bool        hasMoreData     () const; /* impl */
+            virtual std::string getContentType  () const; /* reimpl */
+
+            static const unsigned MAX_STALLED_RELOADS = 10;
+
+        private:
+            bool                openNext();
+            bool                openPending();
+            void                closeCurrent();
+            bool                checkCurrent();
+            bool                reload();
+            AbstractChunkSource *makePartSource(const playlist::HLSPart &);
+
+            SharedResources    *resources;
+            AbstractConnectionManager *connManager;
+            ID                  sourceid;
+            const playlist::Representation *rep;
+            Url                 baseUrl;
+            uint64_t            msn;
+            std::vector<playlist::HLSPart> parts;
+            playlist::HLSPart   hint;
+            size_t              requested; /* number of parts already requested */
+            bool                b_complete;
+            unsigned            stalled;
+            AbstractChunkSource *current;
+            AbstractChunkSource *pending;
+            bool                b_currenthint;
+            bool                b_pendinghint;
+            bool                b_currentread;
+    };
+}
+
+#endif // HLSPARTSSOURCE_HPP
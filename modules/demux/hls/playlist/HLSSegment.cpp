@@ -22,16 +22,33 @@
 #endif
 
 #include "HLSSegment.hpp"
+#include "Representation.hpp"
+#include "../HLSPartsSource.hpp"
 #include "../../adaptive/playlist/BaseRepresentation.h"
+#include "../../adaptive/playlist/BaseAdaptationSet.h"
+#include "../../adaptive/playlist/SegmentChunk.hpp"
 
 
+using namespace hls;
 using namespace hls::playlist;
 
+HLSPart::HLSPart()
+{
+    duration = 0;
+    independent = false;
+}
+
+bool HLSPart::isValid() const
+{
+    return !url.empty();
+}
+
 HLSSegment::HLSSegment( ICanonicalUrl *parent, uint64_t seq ) :
     Segment( parent )
 {
     setSequenceNumber(seq);
     utcTime = 0;
+    b_partial = false;
 }
 
 HLSSegment::~HLSSegment()
@@ -62,6 +79,59 @@ vlc_tick_t HLSSegment::getUTCTime() const
     return utcTime;
 }
 
+uint64_t HLSSegment::getMediaSequenceNumber() const
+{
+    /* numbered after EXT-X-MEDIA-SEQUENCE */
+    return getSequenceNumber();
+}
+
+bool HLSSegment::isPartial() const
+{
+    return b_partial;
+}
+
+const std::vector<HLSPart> & HLSSegment::getParts() const
+{
+    return parts;
+}
+
+const HLSPart & HLSSegment::getPreloadHint() const
+{
+    return preloadHint;
+}
+
+SegmentChunk* HLSSegment::toChunk(SharedResources *res, AbstractConnectionManager *connManager,
+                                  size_t index, BaseRepresentation *rep)
+{
+    Representation *hlsrep = dynamic_cast<Representation *>(rep);
+    if(!b_partial || !hlsrep)
+        return Segment::toChunk(res, connManager, index, rep);
+
+    /* Segment is still being published: fetch it part by part */
+    HLSPartsSource *source = new (std::nothrow) HLSPartsSource(res, connManager,
+                                                               rep->getAdaptationSet()->getID(),
+                                                               hlsrep, getParentUrlSegment(),
+                                                               getMediaSequenceNumber(),
+                                                               parts, preloadHint);
+    if(!source)
+        return NULL;
+
+    SegmentChunk *chunk = createChunk(source, rep);
+    if(!chunk)
+    {
+        delete source;
+        return NULL;
+    }
+
+    chunk->discontinuity = discontinuity;
+    if(!prepareChunk(res, chunk, rep))
+    {
+        delete chunk;
+        return NULL;
+    }
+    return chunk;
+}
+
 int HLSSegment::compare(ISegment *segment) const
 {
     HLSSegment *hlssegment = dynamic_cast<HLSSegment *>(segment);
@@ -22,6 +22,9 @@
 
 #include "../../adaptive/playlist/Segment.h"
 #include "../../adaptive/encryption/CommonEncryption.hpp"
+#include "../../adaptive/http/BytesRange.hpp"
+
+#include <vector>
 
 namespace hls
 {
@@ -30,6 +33,20 @@ namespace hls
         using namespace adaptive;
         using namespace adaptive::playlist;
         using namespace adaptive::encryption;
+        using namespace adaptive::http;
+
+        /* Low latency EXT-X-PART / EXT-X-PRELOAD-HINT */
+        class HLSPart
+        {
+            public:
+                HLSPart();
+                bool isValid() const;
+
+                std::string url;
+                BytesRange  range;
+                vlc_tick_t  duration;
+                bool        independent;
+        };
 
         class HLSSegment : public Segment
         {
@@ -39,10 +56,20 @@ namespace hls
                 HLSSegment( ICanonicalUrl *parent, uint64_t sequence );
                 virtual ~HLSSegment();
                 vlc_tick_t getUTCTime() const;
+                uint64_t getMediaSequenceNumber() const;
                 virtual int compare(ISegment *) const; /* reimpl */
+                virtual bool isPartial() const; /* reimpl */
+                virtual SegmentChunk* toChunk(SharedResources *, AbstractConnectionManager *,
+                                              size_t, BaseRepresentation *); /* reimpl */
+                const std::vector<HLSPart> & getParts() const;
+                const HLSPart & getPreloadHint() const;
 
             protected:
                 vlc_tick_t utcTime;
+                /* Segment is still being published, only its parts are available */
+                bool b_partial;
+                std::vector<HLSPart> parts;
+                HLSPart preloadHint;
                 virtual bool prepareChunk(SharedResources *, SegmentChunk *,
                                           BaseRepresentation *); /* reimpl */
         };
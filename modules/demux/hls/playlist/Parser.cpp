@@ -157,7 +157,7 @@ void M3U8Parser::createAndFillRepresentation(vlc_object_t *p_obj, BaseAdaptation
 
 bool M3U8Parser::appendSegmentsFromPlaylistURI(vlc_object_t *p_obj, Representation *rep)
 {
-    block_t *p_block = Retrieve::HTTP(resources, rep->getPlaylistUrl().toString());
+    block_t *p_block = Retrieve::HTTP(resources, rep->getPlaylistUpdateUrl());
     if(p_block)
     {
         stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
@@ -211,6 +211,57 @@ static bool parseEncryption(const AttributesTag *keytag, const Url &playlistUrl,
     }
 }
 
+static bool parsePart(const AttributesTag *tag, HLSPart &part, std::size_t *prevoffset)
+{
+    const Attribute *uriAttr = tag->getAttributeByName("URI");
+    const Attribute *gapAttr = tag->getAttributeByName("GAP");
+    if(!uriAttr || (gapAttr && gapAttr->value == "YES"))
+        return false;
+
+    part.url = uriAttr->quotedString();
+
+    const Attribute *attr = tag->getAttributeByName("DURATION");
+    if(attr)
+        part.duration = vlc_tick_from_sec(attr->floatingPoint());
+
+    attr = tag->getAttributeByName("INDEPENDENT");
+    part.independent = (attr && attr->value == "YES");
+
+    attr = tag->getAttributeByName("BYTERANGE");
+    if(attr)
+    {
+        std::pair<std::size_t,std::size_t> range = attr->unescapeQuotes().getByteRange();
+        if(range.first == 0) /* first == offset, second = size */
+            range.first = *prevoffset;
+        *prevoffset = range.first + range.second;
+        part.range = BytesRange(range.first, *prevoffset - 1);
+    }
+    else *prevoffset = 0;
+
+    return true;
+}
+
+static bool parsePreloadHint(const AttributesTag *tag, HLSPart &part)
+{
+    const Attribute *typeAttr = tag->getAttributeByName("TYPE");
+    const Attribute *uriAttr = tag->getAttributeByName("URI");
+    if(!typeAttr || typeAttr->value != "PART" || !uriAttr)
+        return false;
+
+    part.url = uriAttr->quotedString();
+
+    const Attribute *startAttr = tag->getAttributeByName("BYTERANGE-START");
+    const Attribute *lengthAttr = tag->getAttributeByName("BYTERANGE-LENGTH");
+    const std::size_t start = startAttr ? startAttr->decimal() : 0;
+    const std::size_t length = lengthAttr ? lengthAttr->decimal() : 0;
+    if(length) /* open ended otherwise */
+        part.range = BytesRange(start, start + length - 1);
+    else if(start)
+        part.range = BytesRange(start, 0);
+
+    return true;
+}
+
 void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::list<Tag *> &tagslist)
 {
     SegmentList *segmentList = new (std::nothrow) SegmentList(rep);
@@ -227,6 +278,9 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
     const SingleValueTag *ctx_byterange = NULL;
     CommonEncryption encryption;
     const ValuesListTag *ctx_extinf = NULL;
+    std::vector<HLSPart> ctx_parts;
+    std::size_t prevpartoffset = 0;
+    HLSPart preloadHint;
 
     std::list<Tag *>::const_iterator it;
     for(it = tagslist.begin(); it != tagslist.end(); ++it)
@@ -303,6 +357,41 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
 
                 if(encryption.method != CommonEncryption::Method::NONE)
                     segment->setEncryption(encryption);
+
+                segment->parts.swap(ctx_parts);
+                ctx_parts.clear();
+                prevpartoffset = 0;
+            }
+            break;
+
+            case AttributesTag::EXTXPART:
+            {
+                HLSPart part;
+                if(parsePart(static_cast<const AttributesTag *>(tag), part, &prevpartoffset))
+                    ctx_parts.push_back(part);
+            }
+            break;
+
+            case AttributesTag::EXTXPRELOADHINT:
+                parsePreloadHint(static_cast<const AttributesTag *>(tag), preloadHint);
+                break;
+
+            case AttributesTag::EXTXPARTINF:
+            {
+                const Attribute *attr = static_cast<const AttributesTag *>(tag)->getAttributeByName("PART-TARGET");
+                if(attr)
+                    rep->partTarget = vlc_tick_from_sec(attr->floatingPoint());
+            }
+            break;
+
+            case AttributesTag::EXTXSERVERCONTROL:
+            {
+                const AttributesTag *ctrltag = static_cast<const AttributesTag *>(tag);
+                const Attribute *attr = ctrltag->getAttributeByName("CAN-BLOCK-RELOAD");
+                rep->b_canblockreload = (attr && attr->value == "YES");
+                attr = ctrltag->getAttributeByName("PART-HOLD-BACK");
+                if(attr)
+                    rep->partHoldBack = vlc_tick_from_sec(attr->floatingPoint());
             }
             break;
 
@@ -362,6 +451,31 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
         }
     }
 
+    /* Low latency: trailing parts belong to the segment being published */
+    if(rep->isLive() && !ctx_parts.empty())
+    {
+        HLSSegment *segment = new (std::nothrow) HLSSegment(rep, sequenceNumber);
+        if(segment)
+        {
+            vlc_tick_t nzDuration = 0;
+            std::vector<HLSPart>::const_iterator pit;
+            for(pit = ctx_parts.begin(); pit != ctx_parts.end(); ++pit)
+                nzDuration += (*pit).duration;
+
+            segment->b_partial = true;
+            segment->parts.swap(ctx_parts);
+            segment->preloadHint = preloadHint;
+            segment->duration.Set(rep->getTimescale().ToScaled(nzDuration));
+            segment->startTime.Set(rep->getTimescale().ToScaled(nzStartTime));
+            if(absReferenceTime != VLC_TICK_INVALID)
+                segment->utcTime = absReferenceTime;
+            segment->discontinuity = discontinuity;
+            if(encryption.method != CommonEncryption::Method::NONE)
+                segment->setEncryption(encryption);
+            segmentList->addSegment(segment);
+        }
+    }
+
     if(rep->isLive())
     {
         rep->getPlaylist()->duration.Set(0);
@@ -373,6 +487,77 @@ void M3U8Parser::parseSegments(vlc_object_t *, Representation *rep, const std::l
 
     rep->updateSegmentList(segmentList, true);
 }
+bool M3U8Parser::getSegmentParts(vlc_object_t *p_obj, const std::string &uri, uint64_t msn,
+                                 std::vector<HLSPart> &parts, HLSPart &hint, bool *pb_complete)
+{
+    block_t *p_block = Retrieve::HTTP(resources, uri);
+    if(!p_block)
+        return false;
+
+    stream_t *substream = vlc_stream_MemoryNew(p_obj, p_block->p_buffer, p_block->i_buffer, true);
+    if(!substream)
+    {
+        block_Release(p_block);
+        return false;
+    }
+
+    std::list<Tag *> tagslist = parseEntries(substream);
+    vlc_stream_Delete(substream);
+    block_Release(p_block);
+
+    parts.clear();
+    hint = HLSPart();
+    *pb_complete = false;
+
+    uint64_t sequenceNumber = 0;
+    std::size_t prevpartoffset = 0;
+
+    std::list<Tag *>::const_iterator it;
+    for(it = tagslist.begin(); it != tagslist.end(); ++it)
+    {
+        const Tag *tag = *it;
+        switch(tag->getType())
+        {
+            case SingleValueTag::EXTXMEDIASEQUENCE:
+                sequenceNumber = (static_cast<const SingleValueTag*>(tag))->getValue().decimal();
+                /* segment has already expired */
+                if(msn < sequenceNumber)
+                    *pb_complete = true;
+                break;
+
+            case AttributesTag::EXTXPART:
+            {
+                HLSPart part;
+                if(parsePart(static_cast<const AttributesTag *>(tag), part, &prevpartoffset) &&
+                   sequenceNumber == msn)
+                    parts.push_back(part);
+            }
+            break;
+
+            case AttributesTag::EXTXPRELOADHINT:
+                if(sequenceNumber == msn)
+                    parsePreloadHint(static_cast<const AttributesTag *>(tag), hint);
+                break;
+
+            case SingleValueTag::URI:
+                if(static_cast<const SingleValueTag *>(tag)->getValue().value.empty())
+                    break;
+                if(sequenceNumber++ == msn)
+                    *pb_complete = true;
+                prevpartoffset = 0;
+                break;
+
+            case Tag::EXTXENDLIST:
+                *pb_complete = true;
+                break;
+        }
+    }
+
+    releaseTagsList(tagslist);
+
+    return true;
+}
+
 M3U8 * M3U8Parser::parse(vlc_object_t *p_object, stream_t *p_stream, const std::string &playlisturl)
 {
     char *psz_line = vlc_stream_ReadLine(p_stream);
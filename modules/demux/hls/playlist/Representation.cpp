@@ -33,6 +33,7 @@
 #include "../../adaptive/playlist/SegmentList.h"
 
 #include <ctime>
+#include <sstream>
 
 using namespace hls;
 using namespace hls::playlist;
@@ -42,8 +43,12 @@ Representation::Representation  ( BaseAdaptationSet *set ) :
 {
     b_live = true;
     b_loaded = false;
+    b_blockingreload = false;
     nextUpdateTime = 0;
     targetDuration = 0;
+    b_canblockreload = false;
+    partHoldBack = 0;
+    partTarget = 0;
     streamFormat = StreamFormat::UNKNOWN;
 }
 
@@ -101,14 +106,23 @@ void Representation::debug(vlc_object_t *obj, int indent) const
 void Representation::scheduleNextUpdate(uint64_t number)
 {
     const AbstractPlaylist *playlist = getPlaylist();
-    const time_t now = time(NULL);
+    const vlc_tick_t now = vlc_tick_now();
 
     /* Compute new update time */
     vlc_tick_t minbuffer = getMinAheadTime(number);
 
+    b_blockingreload = false;
+    if(partTarget && minbuffer < vlc_tick_from_sec( targetDuration ))
+    {
+        /* Low latency: close to the live edge, new parts are only announced
+         * by reloading. Blocking reloads are held by the server until the
+         * next part is published, otherwise poll at part rate. */
+        b_blockingreload = b_canblockreload;
+        minbuffer = b_blockingreload ? 0 : partTarget;
+    }
     /* Update frequency must always be at least targetDuration (if any)
      * but we need to update before reaching that last segment, thus -1 */
-    if(targetDuration)
+    else if(targetDuration)
     {
         if(minbuffer > vlc_tick_from_sec( 2 * targetDuration + 1 ))
             minbuffer -= vlc_tick_from_sec( targetDuration + 1 );
@@ -123,25 +137,26 @@ void Representation::scheduleNextUpdate(uint64_t number)
             minbuffer /= 2;
     }
 
-    nextUpdateTime = now + SEC_FROM_VLC_TICK(minbuffer);
+    nextUpdateTime = now + minbuffer;
 
-    msg_Dbg(playlist->getVLCObject(), "Updated playlist ID %s, next update in %" PRId64 "s",
-            getID().str().c_str(), (int64_t) nextUpdateTime - now);
+    msg_Dbg(playlist->getVLCObject(), "Updated playlist ID %s, next update in %" PRId64 "ms%s",
+            getID().str().c_str(), MS_FROM_VLC_TICK(nextUpdateTime - now),
+            b_blockingreload ? " (blocking)" : "");
 
-    debug(playlist->getVLCObject(), 0);
+    if(!partTarget)
+        debug(playlist->getVLCObject(), 0);
 }
 
 bool Representation::needsUpdate() const
 {
-    return !b_loaded || (isLive() && nextUpdateTime < time(NULL));
+    return !b_loaded || (isLive() && nextUpdateTime <= vlc_tick_now());
 }
 
 bool Representation::runLocalUpdates(SharedResources *res,
                                      vlc_tick_t, uint64_t, bool)
 {
-    const time_t now = time(NULL);
     AbstractPlaylist *playlist = getPlaylist();
-    if(!b_loaded || (isLive() && nextUpdateTime < now))
+    if(!b_loaded || (isLive() && nextUpdateTime <= vlc_tick_now()))
     {
         M3U8Parser parser(res);
         parser.appendSegmentsFromPlaylistURI(playlist->getVLCObject(), this);
@@ -153,6 +168,65 @@ bool Representation::runLocalUpdates(SharedResources *res,
     return true;
 }
 
+bool Representation::canBlockReload() const
+{
+    return b_canblockreload;
+}
+
+vlc_tick_t Representation::getPartTarget() const
+{
+    return partTarget;
+}
+
+std::string Representation::getBlockingReloadUrl(uint64_t msn, size_t part) const
+{
+    std::string url = getPlaylistUrl().toString();
+    std::stringstream ss;
+    ss.imbue(std::locale("C"));
+    ss << url << ((url.find('?') == std::string::npos) ? '?' : '&');
+    ss << "_HLS_msn=" << msn << "&_HLS_part=" << part;
+    return ss.str();
+}
+
+std::string Representation::getPlaylistUpdateUrl() const
+{
+    std::vector<ISegment *> list;
+    getSegments(INFOTYPE_MEDIA, list);
+    const HLSSegment *last = list.empty() ? NULL : dynamic_cast<HLSSegment *>(list.back());
+    if(!b_blockingreload || !last)
+        return getPlaylistUrl().toString();
+
+    /* Ask for the part following the last known one */
+    if(last->isPartial())
+        return getBlockingReloadUrl(last->getMediaSequenceNumber(), last->getParts().size());
+    else
+        return getBlockingReloadUrl(last->getMediaSequenceNumber() + 1, 0);
+}
+
+uint64_t Representation::getLiveStartSegmentNumber(uint64_t def) const
+{
+    if(!partHoldBack)
+        return BaseRepresentation::getLiveStartSegmentNumber(def);
+
+    std::vector<ISegment *> list;
+    getSegments(INFOTYPE_MEDIA, list);
+    if(list.empty())
+        return BaseRepresentation::getLiveStartSegmentNumber(def);
+
+    /* Low latency: start with the latest segment leaving at least
+     * PART-HOLD-BACK from the live edge */
+    const Timescale timescale = inheritTimescale();
+    vlc_tick_t fromend = 0;
+    std::vector<ISegment *>::const_reverse_iterator it;
+    for(it = list.rbegin(); it != list.rend(); ++it)
+    {
+        fromend += timescale.ToTime((*it)->duration.Get());
+        if(fromend >= partHoldBack)
+            return (*it)->getSequenceNumber();
+    }
+    return list.front()->getSequenceNumber();
+}
+
 uint64_t Representation::translateSegmentNumber(uint64_t num, const SegmentInformation *from) const
 {
     if(consistentSegmentNumber())
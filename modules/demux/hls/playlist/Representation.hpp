@@ -53,14 +53,25 @@ namespace hls
                 virtual bool runLocalUpdates(SharedResources *,
                                              vlc_tick_t, uint64_t, bool); /* reimpl */
                 virtual uint64_t translateSegmentNumber(uint64_t, const SegmentInformation *) const; /* reimpl */
+                virtual uint64_t getLiveStartSegmentNumber(uint64_t) const; /* reimpl */
+
+                bool canBlockReload() const;
+                vlc_tick_t getPartTarget() const;
+                std::string getBlockingReloadUrl(uint64_t, size_t) const;
+                std::string getPlaylistUpdateUrl() const;
 
             private:
                 StreamFormat streamFormat;
                 bool b_live;
                 bool b_loaded;
-                time_t nextUpdateTime;
+                bool b_blockingreload;
+                vlc_tick_t nextUpdateTime;
                 time_t targetDuration;
                 Url playlistUrl;
+                /* Low latency, from EXT-X-SERVER-CONTROL and EXT-X-PART-INF */
+                bool b_canblockreload;
+                vlc_tick_t partHoldBack;
+                vlc_tick_t partTarget;
         };
     }
 }
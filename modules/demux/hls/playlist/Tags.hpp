@@ -98,6 +98,10 @@ namespace hls
                     EXTXMEDIA,
                     EXTXSTREAMINF,
                     EXTXSESSIONKEY,
+                    EXTXPART,
+                    EXTXPARTINF,
+                    EXTXPRELOADHINT,
+                    EXTXSERVERCONTROL,
                 };
                 AttributesTag(int, const std::string &);
                 virtual ~AttributesTag();
@@ -0,0 +1,415 @@
+/*****************************************************************************
+ * cluster_prefetcher.cpp : matroska demuxer
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "cluster_prefetcher.hpp"
+
+#include <vlc_stream.h>
+
+#include <new>
+
+/* amount of cluster data read ahead */
+#define PREFETCH_MAX_QUEUED  (32 << 20)
+/* larger clusters are left to the regular parser */
+#define PREFETCH_MAX_CLUSTER (64 << 20)
+
+namespace mkv {
+
+namespace {
+
+typedef cluster_prefetcher_c::block_info_t  block_info_t;
+typedef cluster_prefetcher_c::cluster_info_t cluster_info_t;
+
+/* Frames of a block read with its data, as BlockDecode() expects them */
+void GetFrames( KaxInternalBlock & kblock, block_info_t & block )
+{
+    block.i_track = kblock.TrackNum();
+    block.i_timecode = kblock.GlobalTimecode();
+    for( unsigned int i = 0; i < kblock.NumberFrames(); i++ )
+    {
+        DataBuffer & data = kblock.GetBuffer( i );
+        block.frames.push_back( mkv_frame_t{ data.Buffer(), data.Size() } );
+    }
+}
+
+/* as matroska_segment_c::BlockGet() for the elements of a BlockGroup */
+bool ParseBlockGroup( KaxBlockGroup & group, KaxCluster & cluster, block_info_t & block )
+{
+    KaxBlock *p_block = NULL;
+
+    block.b_simple              = false;
+    block.b_key_picture         = true;
+    block.b_discardable_picture = false;
+    block.i_duration            = 0;
+
+    for( unsigned int i = 0; i < group.ListSize(); ++i )
+    {
+        EbmlElement *el = group[i];
+
+        if( MKV_CHECKED_PTR_DECL( p_kblock, KaxBlock, el ) )
+        {
+            p_block = p_kblock;
+        }
+        else if( MKV_CHECKED_PTR_DECL( p_kduration, KaxBlockDuration, el ) )
+        {
+            block.i_duration = static_cast<uint64>( *p_kduration );
+        }
+        else if( MKV_CHECKED_PTR_DECL( p_kreference, KaxReferenceBlock, el ) )
+        {
+            if( block.b_key_picture )
+                block.b_key_picture = false;
+            else if( static_cast<int64>( *p_kreference ) )
+                block.b_discardable_picture = true;
+        }
+#if LIBMATROSKA_VERSION >= 0x010401
+        else if( MKV_CHECKED_PTR_DECL( p_kdiscardp, KaxDiscardPadding, el ) )
+        {
+            int64 i_padding = static_cast<int64>( *p_kdiscardp );
+            if( block.i_duration < i_padding )
+                block.i_duration = 0;
+            else
+                block.i_duration -= i_padding;
+        }
+#endif
+    }
+
+    if( p_block == NULL )
+        return false;
+
+    p_block->SetParent( cluster );
+    block.i_fpos = p_block->GetElementPosition();
+    GetFrames( *p_block, block );
+    return true;
+}
+
+bool ParseCluster( cluster_info_t & info, uint64_t i_timescale )
+{
+    KaxCluster & cluster = *info.p_cluster;
+    bool b_timecode = false;
+
+    for( unsigned int i = 0; i < cluster.ListSize(); ++i )
+    {
+        EbmlElement *el = cluster[i];
+        block_info_t block;
+
+        if( MKV_CHECKED_PTR_DECL( p_ctc, KaxClusterTimecode, el ) )
+        {
+            cluster.InitTimecode( static_cast<uint64>( *p_ctc ), i_timescale );
+            info.i_timecode = cluster.GlobalTimecode();
+            b_timecode = true;
+            continue;
+        }
+
+        /* blocks prior to the mandatory Timecode are ignored */
+        if( !b_timecode )
+            continue;
+
+        if( MKV_CHECKED_PTR_DECL( p_ksblock, KaxSimpleBlock, el ) )
+        {
+            p_ksblock->SetParent( cluster );
+            block.b_simple              = true;
+            block.b_key_picture         = p_ksblock->IsKeyframe();
+            block.b_discardable_picture = p_ksblock->IsDiscardable();
+            block.i_duration            = 0;
+            block.i_fpos = p_ksblock->GetElementPosition();
+            GetFrames( *p_ksblock, block );
+        }
+        else if( MKV_CHECKED_PTR_DECL( p_kbgroup, KaxBlockGroup, el ) )
+        {
+            if( !ParseBlockGroup( *p_kbgroup, cluster, block ) )
+                return false;
+        }
+        else /* CRC-32, Void, Position, PrevSize, SilentTracks... */
+            continue;
+
+        info.blocks.push_back( std::move( block ) );
+    }
+
+    return b_timecode;
+}
+
+} // namespace
+
+cluster_prefetcher_c::cluster_prefetcher_c( demux_t *demux )
+    :p_demux( demux )
+    ,i_timescale( MKVD_TIMECODESCALE )
+    ,p_io( NULL )
+    ,p_es( NULL )
+    ,b_started( false )
+    ,p_interrupt( NULL )
+    ,b_abort( false )
+    ,b_eos( false )
+    ,i_start_pos( 0 )
+    ,i_end_pos( 0 )
+    ,i_resume_pos( 0 )
+    ,i_queued( 0 )
+    ,p_current( NULL )
+    ,i_current_block( 0 )
+{
+    vlc_mutex_init( &lock );
+    vlc_cond_init( &wait_data );
+    vlc_cond_init( &wait_space );
+}
+
+cluster_prefetcher_c::~cluster_prefetcher_c()
+{
+    Stop();
+    delete p_es;
+    delete p_io;
+}
+
+bool cluster_prefetcher_c::Open( stream_t *s_demux )
+{
+    assert( p_io == NULL );
+
+    if( s_demux->psz_url == NULL )
+        return false;
+
+    /* not all accesses can be opened twice, and stream filters would be
+     * skipped: only use a stream with the same seekable content */
+    stream_t *s = vlc_stream_NewURL( p_demux, s_demux->psz_url );
+    if( s == NULL )
+    {
+        msg_Warn( p_demux, "cannot open the input again, clusters are not read ahead" );
+        return false;
+    }
+
+    bool b_seekable;
+    uint64_t i_size, i_demux_size;
+    if( vlc_stream_Control( s, STREAM_CAN_SEEK, &b_seekable ) || !b_seekable ||
+        vlc_stream_GetSize( s, &i_size ) ||
+        vlc_stream_GetSize( s_demux, &i_demux_size ) || i_size != i_demux_size )
+    {
+        msg_Warn( p_demux, "input opened again differs, clusters are not read ahead" );
+        vlc_stream_Delete( s );
+        return false;
+    }
+
+    p_io = new (std::nothrow) vlc_stream_io_callback( s, true );
+    if( unlikely( p_io == NULL ) )
+    {
+        vlc_stream_Delete( s );
+        return false;
+    }
+    p_es = new (std::nothrow) EbmlStream( *p_io );
+    if( unlikely( p_es == NULL ) )
+    {
+        delete p_io;
+        p_io = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool cluster_prefetcher_c::Start( uint64_t i_cluster_pos, uint64_t i_end,
+                                  uint64_t timescale )
+{
+    assert( !b_started );
+
+    if( p_es == NULL )
+        return false;
+
+    p_interrupt = vlc_interrupt_create();
+    if( unlikely( p_interrupt == NULL ) )
+        return false;
+
+    i_timescale  = timescale;
+    i_start_pos  = i_cluster_pos;
+    i_end_pos    = i_end;
+    i_resume_pos = i_cluster_pos;
+    b_abort      = false;
+    b_eos        = false;
+
+    if( vlc_clone( &thread, Thread, this, VLC_THREAD_PRIORITY_INPUT ) )
+    {
+        vlc_interrupt_destroy( p_interrupt );
+        return false;
+    }
+
+    b_started = true;
+    return true;
+}
+
+uint64_t cluster_prefetcher_c::Stop()
+{
+    if( b_started )
+    {
+        vlc_mutex_lock( &lock );
+        b_abort = true;
+        vlc_cond_signal( &wait_space );
+        vlc_mutex_unlock( &lock );
+
+        vlc_interrupt_kill( p_interrupt );
+        vlc_join( thread, NULL );
+        vlc_interrupt_destroy( p_interrupt );
+        b_started = false;
+    }
+
+    while( !queue.empty() )
+    {
+        delete queue.front();
+        queue.pop_front();
+    }
+    i_queued = 0;
+
+    delete p_current;
+    p_current = NULL;
+
+    return i_resume_pos;
+}
+
+const cluster_prefetcher_c::block_info_t *
+cluster_prefetcher_c::GetBlock( bool *pb_new_cluster )
+{
+    *pb_new_cluster = false;
+
+    while( p_current == NULL || i_current_block >= p_current->blocks.size() )
+    {
+        cluster_info_t *p_next = NULL;
+
+        vlc_mutex_lock( &lock );
+        while( queue.empty() && !b_eos )
+        {
+            void *data[2];
+
+            /* an interruption of the demuxer ends the read-ahead */
+            vlc_interrupt_forward_start( p_interrupt, data );
+            vlc_cond_wait( &wait_data, &lock );
+            vlc_interrupt_forward_stop( data );
+        }
+        if( !queue.empty() )
+        {
+            p_next = queue.front();
+            queue.pop_front();
+            i_queued -= p_next->i_size;
+            vlc_cond_signal( &wait_space );
+        }
+        vlc_mutex_unlock( &lock );
+
+        if( p_next == NULL )
+            return NULL;
+
+        delete p_current;
+        p_current = p_next;
+        i_current_block = 0;
+        i_resume_pos = p_next->i_fpos + p_next->i_size;
+        *pb_new_cluster = true;
+    }
+
+    return &p_current->blocks[i_current_block++];
+}
+
+cluster_prefetcher_c::cluster_info_t *
+cluster_prefetcher_c::ReadCluster( uint64_t i_pos )
+{
+    KaxCluster *cluster = NULL;
+
+    try
+    {
+        p_io->setFilePointer( i_pos, seek_beginning );
+        if( p_io->IsEOF() )
+            return NULL;
+
+        /* reads the element header at that position only */
+        EbmlElement *el = p_es->FindNextID( EBML_INFO(KaxCluster), PREFETCH_MAX_CLUSTER );
+        if( el == NULL )
+            return NULL;
+        if( !MKV_IS_ID( el, KaxCluster ) || !el->IsFiniteSize() ||
+            el->GetElementPosition() != i_pos )
+        {
+            delete el;
+            return NULL;
+        }
+        cluster = static_cast<KaxCluster *>( el );
+
+        EbmlElement *el_upper = NULL;
+        int i_upper_level = 0;
+        cluster->Read( *p_es, EBML_CONTEXT(cluster), i_upper_level, el_upper, true, SCOPE_ALL_DATA );
+        if( i_upper_level != 0 || p_io->IsEOF() ||
+            p_io->getFilePointer() != cluster->GetEndPosition() )
+        {
+            /* truncated, or escaping its parent */
+            delete el_upper;
+            msg_Dbg( p_demux, "cluster at %" PRIu64 " left to the parser", i_pos );
+            delete cluster;
+            return NULL;
+        }
+    }
+    catch(...)
+    {
+        msg_Dbg( p_demux, "cluster at %" PRIu64 " left to the parser", i_pos );
+        delete cluster;
+        return NULL;
+    }
+
+    cluster_info_t *p_cluster = new (std::nothrow) cluster_info_t( cluster );
+    if( unlikely( p_cluster == NULL ) )
+    {
+        delete cluster;
+        return NULL;
+    }
+
+    if( !ParseCluster( *p_cluster, i_timescale ) )
+    {
+        msg_Dbg( p_demux, "cluster at %" PRIu64 " left to the parser", i_pos );
+        delete p_cluster;
+        return NULL;
+    }
+    return p_cluster;
+}
+
+void cluster_prefetcher_c::Thread()
+{
+    vlc_interrupt_set( p_interrupt );
+
+    uint64_t i_pos = i_start_pos;
+
+    vlc_mutex_lock( &lock );
+    while( !b_abort && i_pos < i_end_pos )
+    {
+        if( i_queued >= PREFETCH_MAX_QUEUED )
+        {
+            vlc_cond_wait( &wait_space, &lock );
+            continue;
+        }
+        vlc_mutex_unlock( &lock );
+
+        cluster_info_t *p_cluster = ReadCluster( i_pos );
+
+        vlc_mutex_lock( &lock );
+        if( p_cluster == NULL )
+            break;
+
+        i_pos += p_cluster->i_size;
+        i_queued += p_cluster->i_size;
+        queue.push_back( p_cluster );
+        vlc_cond_signal( &wait_data );
+    }
+    b_eos = true;
+    vlc_cond_signal( &wait_data );
+    vlc_mutex_unlock( &lock );
+}
+
+void *cluster_prefetcher_c::Thread( void *data )
+{
+    static_cast<cluster_prefetcher_c *>( data )->Thread();
+    return NULL;
+}
+
+} // namespace
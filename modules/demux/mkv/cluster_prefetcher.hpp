@@ -0,0 +1,123 @@
+/*****************************************************************************
+ * cluster_prefetcher.hpp : matroska demuxer
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_MKV_CLUSTER_PREFETCHER_HPP_
+#define VLC_MKV_CLUSTER_PREFETCHER_HPP_
+
+#include "mkv.hpp"
+
+#include <vlc_threads.h>
+#include <vlc_interrupt.h>
+
+#include <deque>
+
+namespace mkv {
+
+/*
+ * Reads the clusters following a cluster on a separate thread, from a
+ * stream of its own, and parses them into blocks with their lacing resolved.
+ *
+ * Clusters are fully read by libmatroska from that second stream, so
+ * elements never cross threads. Anything but a well formed cluster of known
+ * size ends the read-ahead, and is left to the regular parser from Stop()'s
+ * position.
+ */
+class cluster_prefetcher_c
+{
+public:
+    struct block_info_t
+    {
+        uint64_t     i_fpos;      /* position of the (Simple)Block element */
+        unsigned int i_track;
+        int64_t      i_timecode;  /* global timecode, in ns */
+        int64_t      i_duration;  /* BlockDuration, less DiscardPadding */
+        bool         b_simple;
+        bool         b_key_picture;
+        bool         b_discardable_picture;
+        mkv_frames_t frames;      /* pointing to the cluster blocks data */
+    };
+
+    struct cluster_info_t
+    {
+        cluster_info_t( KaxCluster *cluster )
+            :i_fpos( cluster->GetElementPosition() )
+            ,i_size( cluster->GetEndPosition() - cluster->GetElementPosition() )
+            ,i_timecode( -1 ), p_cluster( cluster )
+        { }
+        ~cluster_info_t() { delete p_cluster; }
+
+        uint64_t   i_fpos;
+        uint64_t   i_size;        /* whole element, with its header */
+        int64_t    i_timecode;    /* in ns */
+        KaxCluster *p_cluster;
+        std::vector<block_info_t> blocks;
+    };
+
+    cluster_prefetcher_c( demux_t * );
+    ~cluster_prefetcher_c();
+
+    /* Opens the second stream from the URL of the demuxer one. Fails when
+     * the access cannot open it again, or when it does not provide the same
+     * seekable content: clusters are then only read by the regular parser. */
+    bool Open( stream_t *s_demux );
+
+    bool Start( uint64_t i_cluster_pos, uint64_t i_end_pos, uint64_t i_timescale );
+    /* returns the position to resume parsing from */
+    uint64_t Stop();
+    bool IsStarted() const { return b_started; }
+
+    /* next block of the clusters read ahead, or NULL once they ended */
+    const block_info_t *GetBlock( bool *pb_new_cluster );
+    const cluster_info_t *CurrentCluster() const { return p_current; }
+
+private:
+    void Thread();
+    static void *Thread( void * );
+
+    cluster_info_t *ReadCluster( uint64_t i_pos );
+
+    demux_t         *p_demux;
+    uint64_t        i_timescale;
+    /* only used by the thread once started */
+    vlc_stream_io_callback *p_io;
+    EbmlStream      *p_es;
+
+    bool            b_started;
+    vlc_thread_t    thread;
+    vlc_interrupt_t *p_interrupt;
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait_data;
+    vlc_cond_t      wait_space;
+    bool            b_abort;
+    bool            b_eos;
+
+    uint64_t        i_start_pos;
+    uint64_t        i_end_pos;
+    uint64_t        i_resume_pos; /* end of the last cluster handed out */
+    size_t          i_queued;     /* bytes of the queued clusters */
+    std::deque<cluster_info_t *> queue;
+
+    cluster_info_t  *p_current;   /* handed out, owned by the demux thread */
+    size_t          i_current_block;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,222 @@
+/*****************************************************************************
+ * cluster_prefetcher_test.cpp : matroska clusters read-ahead test
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Reads clusters written to a temporary file ahead: simple blocks and block
+ * groups, Xiph and EBML lacing, and the end of the read-ahead on a cluster
+ * of unknown size. Also checks a second stream with a different content is
+ * refused.
+ */
+
+#include "cluster_prefetcher.hpp"
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_fs.h>
+#include <vlc_stream.h>
+#include <vlc_url.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+using namespace mkv;
+
+#define CHECK(cond) do { \
+    if( !(cond) ) { \
+        fprintf( stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, #cond ); \
+        return 1; \
+    } } while(0)
+
+/* EBML writing, with 8 bytes sizes so that elements can be nested as is */
+static std::string Element( uint32_t i_id, const std::string & payload )
+{
+    std::string out;
+    for( int i = 3; i >= 0; i-- )
+        if( ( i_id >> ( 8 * i ) ) || !out.empty() )
+            out += char( i_id >> ( 8 * i ) );
+    out += char( 0x01 );
+    for( int i = 6; i >= 0; i-- )
+        out += char( uint64_t( payload.size() ) >> ( 8 * i ) );
+    return out + payload;
+}
+
+static std::string Integer( uint32_t i_id, int64_t i_value )
+{
+    std::string payload;
+    for( int i = 7; i >= 0; i-- )
+        payload += char( uint64_t( i_value ) >> ( 8 * i ) );
+    return Element( i_id, payload );
+}
+
+/* track 1 to 127, relative timecode, flags, then the laced frames */
+static std::string Block( unsigned i_track, int16_t i_timecode,
+                          uint8_t i_flags, const std::string & data )
+{
+    std::string out;
+    out += char( 0x80 | i_track );
+    out += char( uint16_t( i_timecode ) >> 8 );
+    out += char( i_timecode );
+    out += char( i_flags );
+    return out + data;
+}
+
+#define ID_CLUSTER        0x1F43B675
+#define ID_TIMECODE       0xE7
+#define ID_SIMPLEBLOCK    0xA3
+#define ID_BLOCKGROUP     0xA0
+#define ID_BLOCK          0xA1
+#define ID_BLOCKDURATION  0x9B
+#define ID_REFERENCEBLOCK 0xFB
+
+static bool IsFrame( const mkv_frame_t & frame, const char *psz )
+{
+    return frame.i_size == strlen( psz ) &&
+           !memcmp( frame.p_buffer, psz, frame.i_size );
+}
+
+static int TestReadAhead( demux_t *p_demux, stream_t *s,
+                          uint64_t i_end, uint64_t i_unknown_pos )
+{
+    cluster_prefetcher_c prefetcher( p_demux );
+    CHECK( prefetcher.Open( s ) );
+    CHECK( prefetcher.Start( 0, i_end, 1000000 ) );
+
+    const cluster_prefetcher_c::block_info_t *p_block;
+    bool b_new_cluster;
+
+    /* first cluster, timecode 10 */
+    p_block = prefetcher.GetBlock( &b_new_cluster );
+    CHECK( p_block && b_new_cluster );
+    CHECK( prefetcher.CurrentCluster()->i_fpos == 0 );
+    CHECK( prefetcher.CurrentCluster()->i_timecode == 10000000 );
+    CHECK( p_block->b_simple && p_block->b_key_picture );
+    CHECK( p_block->i_track == 1 && p_block->i_timecode == 10000000 );
+    CHECK( p_block->frames.size() == 1 && IsFrame( p_block->frames[0], "key" ) );
+
+    p_block = prefetcher.GetBlock( &b_new_cluster );
+    CHECK( p_block && !b_new_cluster );
+    CHECK( !p_block->b_simple && !p_block->b_key_picture );
+    CHECK( p_block->i_track == 2 && p_block->i_timecode == 15000000 );
+    CHECK( p_block->i_duration == 20 );
+    CHECK( p_block->frames.size() == 2 );
+    CHECK( IsFrame( p_block->frames[0], "abc" ) && IsFrame( p_block->frames[1], "defg" ) );
+
+    /* second cluster, timecode 20 */
+    p_block = prefetcher.GetBlock( &b_new_cluster );
+    CHECK( p_block && b_new_cluster );
+    CHECK( prefetcher.CurrentCluster()->i_timecode == 20000000 );
+    CHECK( p_block->b_simple && !p_block->b_key_picture );
+    CHECK( p_block->i_track == 1 && p_block->i_timecode == 21000000 );
+    CHECK( p_block->frames.size() == 3 );
+    CHECK( IsFrame( p_block->frames[0], "ab" ) && IsFrame( p_block->frames[1], "cde" ) &&
+           IsFrame( p_block->frames[2], "f" ) );
+
+    /* the cluster of unknown size is left to the regular parser */
+    CHECK( prefetcher.GetBlock( &b_new_cluster ) == NULL );
+    CHECK( prefetcher.Stop() == i_unknown_pos );
+    return 0;
+}
+
+static int TestDifferentStream( demux_t *p_demux, const char *psz_url )
+{
+    /* same URL, another content: the input was filtered for instance */
+    static const uint8_t data[] = { 0x1F, 0x43, 0xB6, 0x75 };
+    stream_t *s = vlc_stream_MemoryNew( p_demux, (uint8_t *) data, sizeof(data), true );
+    CHECK( s );
+    s->psz_url = strdup( psz_url );
+
+    cluster_prefetcher_c prefetcher( p_demux );
+    bool b_opened = prefetcher.Open( s );
+    vlc_stream_Delete( s );
+    CHECK( !b_opened );
+    CHECK( !prefetcher.Start( 0, sizeof(data), 1000000 ) );
+    return 0;
+}
+
+int main( void )
+{
+    std::string file;
+
+    file += Element( ID_CLUSTER,
+        Integer( ID_TIMECODE, 10 ) +
+        Element( ID_SIMPLEBLOCK, Block( 1, 0, 0x80, "key" ) ) +
+        Element( ID_BLOCKGROUP,
+            Element( ID_BLOCK,
+                /* Xiph lacing, 2 frames, the first one of 3 bytes */
+                Block( 2, 5, 0x02, std::string( "\x01\x03", 2 ) + "abcdefg" ) ) +
+            Integer( ID_BLOCKDURATION, 20 ) +
+            Integer( ID_REFERENCEBLOCK, -5 ) ) );
+
+    file += Element( ID_CLUSTER,
+        Integer( ID_TIMECODE, 20 ) +
+        /* EBML lacing, 3 frames: 2 bytes, then +1 */
+        Element( ID_SIMPLEBLOCK, Block( 1, 1, 0x06, "\x02\x82\xC0" "abcdef" ) ) );
+
+    const uint64_t i_unknown_pos = file.size();
+    file += std::string( "\x1F\x43\xB6\x75\x01\xFF\xFF\xFF\xFF\xFF\xFF\xFF", 12 );
+    file += Integer( ID_TIMECODE, 30 );
+
+    char psz_path[] = "/tmp/vlc-mkv-prefetch-XXXXXX";
+    int fd = vlc_mkstemp( psz_path );
+    if( fd == -1 )
+        return 77; /* skipped */
+    bool b_written = write( fd, file.c_str(), file.size() ) == (ssize_t) file.size();
+    vlc_close( fd );
+
+    char *psz_url = vlc_path2uri( psz_path, NULL );
+    if( !b_written || psz_url == NULL )
+    {
+        vlc_unlink( psz_path );
+        free( psz_url );
+        return 1;
+    }
+
+    /* the modules from the build tree */
+    setenv( "VLC_PLUGIN_PATH", ".", 1 );
+    const char *args[] = { "--quiet" };
+    libvlc_instance_t *vlc = libvlc_new( 1, args );
+    if( vlc == NULL )
+    {
+        vlc_unlink( psz_path );
+        free( psz_url );
+        return 1;
+    }
+
+    int ret = 77; /* skipped without a file access */
+    demux_t *p_demux = (demux_t *) vlc_object_create( vlc->p_libvlc_int, sizeof(*p_demux) );
+    stream_t *s = p_demux ? vlc_stream_NewURL( p_demux, psz_url ) : NULL;
+    if( s != NULL )
+    {
+        ret = TestReadAhead( p_demux, s, file.size(), i_unknown_pos );
+        if( ret == 0 )
+            ret = TestDifferentStream( p_demux, psz_url );
+        vlc_stream_Delete( s );
+    }
+    if( p_demux )
+        vlc_object_delete( p_demux );
+
+    libvlc_release( vlc );
+    vlc_unlink( psz_path );
+    free( psz_url );
+    return ret;
+}
@@ -33,6 +33,9 @@ namespace mkv {
 demux_sys_t::~demux_sys_t()
 {
     size_t i;
+    /* before their streams go away */
+    for ( i=0; i<opened_segments.size(); i++ )
+        opened_segments[i]->SaveSeekIndex();
     for ( i=0; i<streams.size(); i++ )
         delete streams[i];
     for ( i=0; i<opened_segments.size(); i++ )
@@ -27,9 +27,11 @@
 #include "util.hpp"
 #include "Ebml_parser.hpp"
 #include "Ebml_dispatcher.hpp"
+#include "stream_io_callback.hpp"
 
 #include <new>
 #include <iterator>
+#include <sstream>
 
 namespace mkv {
 
@@ -48,10 +50,15 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,i_attachments_position(-1)
     ,cluster(NULL)
     ,i_block_pos(0)
+    ,p_prefetch(NULL)
+    ,i_prefetch_pos(0)
+    ,b_prefetched(false)
     ,p_segment_uid(NULL)
     ,p_prev_segment_uid(NULL)
     ,p_next_segment_uid(NULL)
     ,b_cues(false)
+    ,b_seek_index(false)
+    ,i_seek_index_size(0)
     ,psz_muxing_application(NULL)
     ,psz_writing_application(NULL)
     ,psz_segment_filename(NULL)
@@ -63,10 +70,24 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,b_preloaded(false)
     ,b_ref_external_segments(false)
 {
+    stream_t *s = static_cast<vlc_stream_io_callback&>( es.I_O() ).GetStream();
+
+    if( sys.b_seekable && !sys.b_fastseekable && !sys.demuxer.b_preparsing &&
+        s->psz_url != NULL && var_InheritBool( &sys.demuxer, "mkv-prefetch" ) )
+    {
+        p_prefetch = new (std::nothrow) cluster_prefetcher_c( &sys.demuxer );
+        if( p_prefetch != NULL && !p_prefetch->Open( s ) )
+        {
+            delete p_prefetch;
+            p_prefetch = NULL;
+        }
+    }
 }
 
 matroska_segment_c::~matroska_segment_c()
 {
+    delete p_prefetch;
+
     free( psz_writing_application );
     free( psz_muxing_application );
     free( psz_segment_filename );
@@ -574,6 +595,7 @@ bool matroska_segment_c::Preload( )
         return false;
 
     EbmlElement *el = NULL;
+    bool b_clusters_walked = false;
 
     ep.Reset( &sys.demuxer );
 
@@ -625,11 +647,13 @@ bool matroska_segment_c::Preload( )
         }
         else if( MKV_CHECKED_PTR_DECL ( kc_ptr, KaxCluster, el ) )
         {
-            if( sys.b_seekable &&
+            b_seek_index = LoadSeekIndex();
+            if( !b_seek_index && sys.b_seekable &&
                 var_InheritBool( &sys.demuxer, "mkv-preload-clusters" ) )
             {
                 PreloadClusters        ( kc_ptr->GetElementPosition() );
                 es.I_O().setFilePointer( kc_ptr->GetElementPosition() );
+                b_clusters_walked = true;
             }
             msg_Dbg( &sys.demuxer, "|   + Cluster" );
 
@@ -687,6 +711,11 @@ bool matroska_segment_c::Preload( )
     if( cluster )
         EnsureDuration();
 
+    /* only save what was learnt past this point, unless the clusters
+     * were all walked */
+    if( !b_clusters_walked )
+        i_seek_index_size = _seeker.index_size();
+
     return true;
 }
 
@@ -799,6 +828,8 @@ bool matroska_segment_c::Seek( demux_t &demuxer, vlc_tick_t i_absolute_mk_date,
     SegmentSeeker::track_ids_t selected_tracks;
     SegmentSeeker::track_ids_t priority;
 
+    PrefetchStop();
+
     // reset information for all tracks //
 
     for( tracks_map_t::iterator it = tracks.begin(); it != tracks.end(); ++it )
@@ -896,22 +927,25 @@ bool matroska_segment_c::Seek( demux_t &demuxer, vlc_tick_t i_absolute_mk_date,
 }
 
 
+mkv_track_t * matroska_segment_c::FindTrack( mkv_track_t::track_id_t i_track )
+{
+    tracks_map_t::iterator track_it = tracks.find( i_track );
+
+    if (track_it == tracks.end())
+        return NULL;
+
+    return track_it->second.get();
+}
+
 mkv_track_t * matroska_segment_c::FindTrackByBlock(
                                              const KaxBlock *p_block, const KaxSimpleBlock *p_simpleblock )
 {
-    tracks_map_t::iterator track_it;
-
     if (p_block != NULL)
-        track_it = tracks.find( p_block->TrackNum() );
+        return FindTrack( p_block->TrackNum() );
     else if( p_simpleblock != NULL)
-        track_it = tracks.find( p_simpleblock->TrackNum() );
+        return FindTrack( p_simpleblock->TrackNum() );
     else
-        track_it = tracks.end();
-
-    if (track_it == tracks.end())
         return NULL;
-
-    return track_it->second.get();
 }
 
 void matroska_segment_c::ComputeTrackPriority()
@@ -1021,7 +1055,7 @@ void matroska_segment_c::EnsureDuration()
 
     // find the last Cluster from the Cues
 
-    if ( b_cues && _seeker._cluster_positions.size() )
+    if ( ( b_cues || b_seek_index ) && _seeker._cluster_positions.size() )
         i_last_cluster_pos = *_seeker._cluster_positions.rbegin();
     else if( !cluster->IsFiniteSize() )
         return;
@@ -1100,6 +1134,102 @@ void matroska_segment_c::EnsureDuration()
     es.I_O().setFilePointer( i_current_position, seek_beginning );
 }
 
+/*****************************************************************************
+ * Seek index persistence
+ *****************************************************************************
+ * Segments without Cues can only be indexed by walking the clusters. Keep
+ * what was found in the cache directory, keyed by the segment UID and
+ * checked against the file size and modification time.
+ *****************************************************************************/
+#define SEEK_INDEX_MAGIC   "VLCMKIDX"
+#define SEEK_INDEX_VERSION 1
+
+bool matroska_segment_c::GetSeekIndexId( std::string & dir, std::string & key,
+                                         seek_index_id_t & id ) const
+{
+    stream_t *s = static_cast<vlc_stream_io_callback&>( es.I_O() ).GetStream();
+    uint64_t i_size;
+
+    if( !sys.b_seekable || sys.demuxer.b_preparsing ||
+        !var_InheritBool( &sys.demuxer, "mkv-seek-index" ) ||
+        s->psz_url == NULL || vlc_stream_GetSize( s, &i_size ) || i_size == 0 )
+        return false;
+
+    if( p_segment_uid && p_segment_uid->GetSize() )
+        key.assign( reinterpret_cast<const char *>( p_segment_uid->GetBuffer() ),
+                    p_segment_uid->GetSize() );
+    else
+    {
+        /* the UID is optional, fall back to the segment location */
+        std::ostringstream oss;
+        oss << s->psz_url << '#' << segment->GetElementPosition();
+        key = oss.str();
+    }
+
+    char *psz_dir = seek_index_GetDir( VLC_OBJECT( &sys.demuxer ), NULL, "mkv-index" );
+    if( psz_dir == NULL )
+        return false;
+    dir = psz_dir;
+    free( psz_dir );
+
+    id.psz_magic = SEEK_INDEX_MAGIC;
+    id.i_version = SEEK_INDEX_VERSION;
+    id.psz_ext = ".mkvidx";
+    id.p_key = key.data();
+    id.i_key = key.size();
+    id.i_size = i_size;
+    id.i_mtime = seek_index_GetModificationTime( s->psz_url );
+    return true;
+}
+
+bool matroska_segment_c::LoadSeekIndex()
+{
+    std::string dir, key;
+    seek_index_id_t id;
+
+    if( !GetSeekIndexId( dir, key, id ) )
+        return false;
+
+    FILE *p_file = seek_index_Open( dir.c_str(), &id );
+    if( p_file == NULL )
+        return false;
+
+    /* don't mix a partial read with what was found so far */
+    SegmentSeeker seeker = _seeker;
+    bool b_ok = seeker.read_index( p_file, id.i_size );
+    fclose( p_file );
+
+    if( !b_ok )
+    {
+        msg_Warn( &sys.demuxer, "ignoring invalid seek index" );
+        return false;
+    }
+
+    _seeker = seeker;
+    msg_Dbg( &sys.demuxer, "loaded seek index with %zu cluster(s)",
+             _seeker._cluster_positions.size() );
+    return true;
+}
+
+static bool WriteSeekIndex( FILE *p_file, const void *p_seeker )
+{
+    return static_cast<const SegmentSeeker *>( p_seeker )->write_index( p_file );
+}
+
+void matroska_segment_c::SaveSeekIndex()
+{
+    std::string dir, key;
+    seek_index_id_t id;
+
+    if( !b_preloaded || b_cues || _seeker.index_size() == i_seek_index_size ||
+        !GetSeekIndexId( dir, key, id ) )
+        return;
+
+    if( seek_index_Save( VLC_OBJECT( &sys.demuxer ), dir.c_str(), &id,
+                         WriteSeekIndex, &_seeker ) == VLC_SUCCESS )
+        i_seek_index_size = _seeker.index_size();
+}
+
 bool matroska_segment_c::ESCreate()
 {
     /* add all es */
@@ -1156,6 +1286,7 @@ bool matroska_segment_c::ESCreate()
 
 void matroska_segment_c::ESDestroy( )
 {
+    PrefetchStop();
     sys.ev.ResetPci();
 
     for( tracks_map_t::iterator it = tracks.begin(); it != tracks.end(); ++it )
@@ -1171,6 +1302,122 @@ void matroska_segment_c::ESDestroy( )
     }
 }
 
+/* Once BlockGet() is in a cluster, the next ones are read and parsed ahead on
+ * a separate thread. When BlockGet() reaches them, blocks are taken from the
+ * read-ahead until it ends, and BlockGet() resumes after the last cluster it
+ * handed out. */
+bool matroska_segment_c::PrefetchUpdate()
+{
+    if( p_prefetch == NULL || cluster == NULL )
+        return false;
+
+    const uint64_t i_cluster_pos = cluster->GetElementPosition();
+
+    if( p_prefetch->IsStarted() )
+    {
+        if( i_cluster_pos < i_prefetch_pos )
+            return false;
+
+        if( i_cluster_pos == i_prefetch_pos )
+        {
+            /* this block was read ahead as well */
+            b_prefetched = true;
+            return true;
+        }
+
+        /* the next clusters were not where expected */
+        p_prefetch->Stop();
+    }
+
+    if( !cluster->IsFiniteSize() )
+        return false;
+
+    i_prefetch_pos = cluster->GetEndPosition();
+    p_prefetch->Start( i_prefetch_pos,
+                       segment->IsFiniteSize() ? segment->GetEndPosition() : UINT64_MAX,
+                       i_timescale );
+    return false;
+}
+
+void matroska_segment_c::PrefetchStop()
+{
+    if( p_prefetch == NULL || !p_prefetch->IsStarted() )
+        return;
+
+    uint64_t i_pos = p_prefetch->Stop();
+
+    if( b_prefetched )
+    {
+        b_prefetched = false;
+
+        /* the parser is still in the cluster the read-ahead started from */
+        cluster = NULL;
+        es.I_O().setFilePointer( i_pos, seek_beginning );
+        ep.reconstruct( &es, segment, &sys.demuxer );
+    }
+}
+
+const cluster_prefetcher_c::block_info_t *
+matroska_segment_c::PrefetchBlockGet( bool *pb_key_picture, bool *pb_discardable_picture, int64_t *pi_duration )
+{
+    if( !b_prefetched )
+        return NULL;
+
+    const cluster_prefetcher_c::block_info_t *p_block;
+    bool b_new_cluster;
+
+    while( ( p_block = p_prefetch->GetBlock( &b_new_cluster ) ) != NULL )
+    {
+        if( b_new_cluster )
+        {
+            const cluster_prefetcher_c::cluster_info_t *p_cluster = p_prefetch->CurrentCluster();
+            SegmentSeeker::Cluster cinfo = {
+                /* fpos     */ p_cluster->i_fpos,
+                /* pts      */ vlc_tick_t( VLC_TICK_FROM_NS( p_cluster->i_timecode ) ),
+                /* duration */ vlc_tick_t( -1 ),
+                /* size     */ p_cluster->i_size
+            };
+            _seeker.add_cluster( cinfo );
+        }
+
+        /* Check blocks validity to protect againts broken files */
+        const mkv_track_t *p_track = FindTrack( p_block->i_track );
+        if( p_track == NULL )
+            continue;
+
+        *pb_key_picture         = p_block->b_key_picture;
+        *pb_discardable_picture = p_block->b_discardable_picture;
+        *pi_duration            = p_block->i_duration;
+
+        if( p_block->b_simple )
+        {
+            if( *pb_key_picture )
+                _seeker.add_seekpoint( p_block->i_track,
+                    SegmentSeeker::Seekpoint( p_block->i_fpos, VLC_TICK_FROM_NS(p_block->i_timecode) ) );
+        }
+        else
+        {
+            if( p_track->fmt.i_cat == SPU_ES )
+                _seeker.add_seekpoint( p_block->i_track,
+                    SegmentSeeker::Seekpoint( p_block->i_fpos, VLC_TICK_FROM_NS(p_block->i_timecode) ) );
+
+            /* if the second bit of a Theora frame is 1 it's not a keyframe */
+            if( *pb_key_picture && p_track->fmt.i_codec == VLC_CODEC_THEORA )
+            {
+                const mkv_frame_t & frame = p_block->frames[0];
+                if( !frame.i_size || ( frame.p_buffer[0] & 0x40 ) )
+                    *pb_key_picture = false;
+            }
+        }
+
+        return p_block;
+    }
+
+    /* the read-ahead ended, parse from where it stopped */
+    PrefetchStop();
+    return NULL;
+}
+
 int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_simpleblock, bool *pb_key_picture, bool *pb_discardable_picture, int64_t *pi_duration )
 {
     pp_simpleblock = NULL;
@@ -27,6 +27,8 @@
 #include "demux.hpp"
 #include "mkv.hpp"
 #include "matroska_segment_seeker.hpp"
+#include "cluster_prefetcher.hpp"
+#include "../seek_index.h"
 #include <vector>
 #include <string>
 
@@ -110,11 +112,16 @@ public:
 
     KaxCluster              *cluster;
     uint64                  i_block_pos;
+    cluster_prefetcher_c    *p_prefetch;     /* NULL unless reading clusters ahead */
+    uint64_t                i_prefetch_pos;  /* first cluster read ahead */
+    bool                    b_prefetched;    /* blocks are taken from p_prefetch */
     KaxSegmentUID           *p_segment_uid;
     KaxPrevUID              *p_prev_segment_uid;
     KaxNextUID              *p_next_segment_uid;
 
     bool                    b_cues;
+    bool                    b_seek_index; /* seeker state restored from a previous session */
+    size_t                  i_seek_index_size;
 
     /* info */
     char                    *psz_muxing_application;
@@ -146,18 +153,26 @@ public:
     bool Seek( demux_t &, vlc_tick_t i_mk_date, vlc_tick_t i_mk_time_offset, bool b_accurate );
 
     int BlockGet( KaxBlock * &, KaxSimpleBlock * &, bool *, bool *, int64_t *);
+    const cluster_prefetcher_c::block_info_t * PrefetchBlockGet( bool *, bool *, int64_t * );
+    bool PrefetchUpdate( );
+    void PrefetchStop( );
 
+    mkv_track_t * FindTrack( mkv_track_t::track_id_t );
     mkv_track_t * FindTrackByBlock(const KaxBlock *, const KaxSimpleBlock * );
 
     bool ESCreate( );
     void ESDestroy( );
 
+    void SaveSeekIndex( );
+
     static bool CompareSegmentUIDs( const matroska_segment_c * item_a, const matroska_segment_c * item_b );
 
     bool SameFamily( const matroska_segment_c & of_segment ) const;
 
 private:
     void LoadCues( KaxCues *cues );
+    bool LoadSeekIndex( );
+    bool GetSeekIndexId( std::string & dir, std::string & key, seek_index_id_t & ) const;
     void LoadTags( KaxTags *tags );
     bool LoadSeekHeadItem( const EbmlCallbacks & ClassInfos, int64_t i_element_position );
     void ParseInfo( KaxInfo *info );
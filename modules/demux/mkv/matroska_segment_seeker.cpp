@@ -74,6 +74,12 @@ SegmentSeeker::add_cluster( KaxCluster * const p_cluster )
             : UINT64_MAX
     };
 
+    return add_cluster( cinfo );
+}
+
+SegmentSeeker::cluster_map_t::iterator
+SegmentSeeker::add_cluster( Cluster const& cinfo )
+{
     add_cluster_position( cinfo.fpos );
 
     cluster_map_t::iterator it = _clusters.lower_bound( cinfo.pts );
@@ -519,4 +525,160 @@ SegmentSeeker::mkv_jump_to( matroska_segment_c& ms, fptr_t fpos )
         ms.es.I_O().setFilePointer( fpos );
 }
 
+size_t
+SegmentSeeker::index_size() const
+{
+    size_t i_count = _ranges_searched.size() + _cluster_positions.size() + _clusters.size();
+
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin(); it != _tracks_seekpoints.end(); ++it )
+        i_count += it->second.size();
+
+    return i_count;
+}
+
+bool
+SegmentSeeker::write_index( FILE * p_file ) const
+{
+    if( !seek_index_Write64( p_file, _ranges_searched.size() ) )
+        return false;
+    for( ranges_t::const_iterator it = _ranges_searched.begin(); it != _ranges_searched.end(); ++it )
+    {
+        if( !seek_index_Write64( p_file, it->start ) || !seek_index_Write64( p_file, it->end ) )
+            return false;
+    }
+
+    if( !seek_index_Write64( p_file, _cluster_positions.size() ) )
+        return false;
+    for( cluster_positions_t::const_iterator it = _cluster_positions.begin(); it != _cluster_positions.end(); ++it )
+    {
+        if( !seek_index_Write64( p_file, *it ) )
+            return false;
+    }
+
+    if( !seek_index_Write64( p_file, _clusters.size() ) )
+        return false;
+    for( cluster_map_t::const_iterator it = _clusters.begin(); it != _clusters.end(); ++it )
+    {
+        Cluster const& cluster = it->second;
+        if( !seek_index_Write64( p_file, cluster.fpos ) ||
+            !seek_index_Write64( p_file, cluster.pts ) ||
+            !seek_index_Write64( p_file, cluster.duration ) ||
+            !seek_index_Write64( p_file, cluster.size ) )
+            return false;
+    }
+
+    if( !seek_index_Write64( p_file, _tracks_seekpoints.size() ) )
+        return false;
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin(); it != _tracks_seekpoints.end(); ++it )
+    {
+        if( !seek_index_Write64( p_file, it->first ) || !seek_index_Write64( p_file, it->second.size() ) )
+            return false;
+
+        for( seekpoints_t::const_iterator sp = it->second.begin(); sp != it->second.end(); ++sp )
+        {
+            if( !seek_index_Write64( p_file, sp->fpos ) ||
+                !seek_index_Write64( p_file, sp->pts ) ||
+                !seek_index_Write64( p_file, (int64_t) sp->trust_level ) )
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+SegmentSeeker::read_index( FILE * p_file, fptr_t i_size )
+{
+    uint64_t i_count, a, b, c, d;
+
+    /* counts can't exceed the file size, reading a damaged index
+     * stops at the first short read */
+
+    ranges_t ranges;
+    if( !seek_index_Read64( p_file, &i_count ) || i_count > i_size )
+        return false;
+    for( ; i_count; --i_count )
+    {
+        if( !seek_index_Read64( p_file, &a ) || !seek_index_Read64( p_file, &b ) || a > b || b > i_size )
+            return false;
+        ranges.push_back( Range( a, b ) );
+    }
+
+    cluster_positions_t positions;
+    if( !seek_index_Read64( p_file, &i_count ) || i_count > i_size )
+        return false;
+    for( ; i_count; --i_count )
+    {
+        if( !seek_index_Read64( p_file, &a ) || a >= i_size ||
+            ( !positions.empty() && a < positions.back() ) )
+            return false;
+        positions.push_back( a );
+    }
+
+    cluster_map_t clusters;
+    if( !seek_index_Read64( p_file, &i_count ) || i_count > i_size )
+        return false;
+    for( ; i_count; --i_count )
+    {
+        if( !seek_index_Read64( p_file, &a ) || !seek_index_Read64( p_file, &b ) ||
+            !seek_index_Read64( p_file, &c ) || !seek_index_Read64( p_file, &d ) || a >= i_size )
+            return false;
+        Cluster cluster = { a, vlc_tick_t( b ), vlc_tick_t( c ), d };
+        clusters.insert( cluster_map_t::value_type( cluster.pts, cluster ) );
+    }
+
+    tracks_seekpoints_t tracks;
+    if( !seek_index_Read64( p_file, &i_count ) || i_count > i_size )
+        return false;
+    for( ; i_count; --i_count )
+    {
+        uint64_t i_points;
+        if( !seek_index_Read64( p_file, &a ) || a > std::numeric_limits<track_id_t>::max() ||
+            !seek_index_Read64( p_file, &i_points ) || i_points > i_size )
+            return false;
+
+        seekpoints_t& seekpoints = tracks[ track_id_t( a ) ];
+        for( ; i_points; --i_points )
+        {
+            if( !seek_index_Read64( p_file, &b ) || !seek_index_Read64( p_file, &c ) || !seek_index_Read64( p_file, &d ) ||
+                b >= i_size )
+                return false;
+
+            Seekpoint::TrustLevel level;
+            switch( int64_t( d ) )
+            {
+                case Seekpoint::TRUSTED:      level = Seekpoint::TRUSTED; break;
+                case Seekpoint::QUESTIONABLE: level = Seekpoint::QUESTIONABLE; break;
+                default:                      level = Seekpoint::DISABLED; break;
+            }
+
+            Seekpoint sp( b, vlc_tick_t( c ), level );
+            if( !seekpoints.empty() && sp < seekpoints.back() )
+                return false;
+            seekpoints.push_back( sp );
+        }
+    }
+
+    /* merge with what was found while opening (cues, first cluster) */
+    for( ranges_t::const_iterator it = ranges.begin(); it != ranges.end(); ++it )
+        mark_range_as_searched( *it );
+
+    for( cluster_positions_t::const_iterator it = positions.begin(); it != positions.end(); ++it )
+    {
+        if( !std::binary_search( _cluster_positions.begin(), _cluster_positions.end(), *it ) )
+            add_cluster_position( *it );
+    }
+
+    for( cluster_map_t::const_iterator it = clusters.begin(); it != clusters.end(); ++it )
+        _clusters.insert( *it );
+
+    for( tracks_seekpoints_t::const_iterator it = tracks.begin(); it != tracks.end(); ++it )
+    {
+        for( seekpoints_t::const_iterator sp = it->second.begin(); sp != it->second.end(); ++sp )
+            add_seekpoint( it->first, *sp );
+    }
+
+    return true;
+}
+
 } // namespace
@@ -26,6 +26,7 @@
 #include "mkv.hpp"
 
 #include <algorithm>
+#include <cstdio>
 #include <vector>
 #include <map>
 #include <limits>
@@ -110,6 +111,7 @@ class SegmentSeeker
 
         cluster_positions_t::iterator add_cluster_position( fptr_t pos );
         cluster_map_t      ::iterator add_cluster( KaxCluster * const );
+        cluster_map_t      ::iterator add_cluster( Cluster const& );
 
         void mkv_jump_to( matroska_segment_c&, fptr_t );
 
@@ -119,6 +121,11 @@ class SegmentSeeker
         void mark_range_as_searched( Range );
         ranges_t get_search_areas( fptr_t start, fptr_t end ) const;
 
+        /* persisted state, see matroska_segment_c::LoadSeekIndex */
+        bool read_index( FILE *, fptr_t i_size );
+        bool write_index( FILE * ) const;
+        size_t index_size() const;
+
     public:
         ranges_t            _ranges_searched;
         tracks_seekpoints_t _tracks_seekpoints;
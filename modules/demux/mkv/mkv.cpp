@@ -80,6 +80,17 @@ vlc_module_begin ()
             N_("Preload clusters"),
             N_("Find all cluster positions by jumping cluster-to-cluster before playback"), true );
 
+    add_bool( "mkv-seek-index", false,
+            N_("Keep a seek index"),
+            N_("Store the cluster positions found in files without Cues, "
+               "to seek directly the next time they are played."), true );
+
+    add_bool( "mkv-prefetch", false,
+            N_("Read ahead clusters"),
+            N_("Read and parse upcoming clusters on a separate thread, over a "
+               "second connection, for network sources that cannot seek fast "
+               "(SMB, NFS, HTTP...)."), true );
+
     add_shortcut( "mka", "mkv" )
 vlc_module_end ()
 
@@ -518,16 +529,42 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
                   vlc_tick_t i_pts, int64_t i_duration, bool b_key_picture,
                   bool b_discardable_picture )
 {
-    demux_sys_t *p_sys = (demux_sys_t *)p_demux->p_sys;
-    matroska_segment_c *p_segment = p_sys->p_current_vsegment->CurrentSegment();
-
     KaxInternalBlock& internal_block = simpleblock
         ? static_cast<KaxInternalBlock&>( *simpleblock )
         : static_cast<KaxInternalBlock&>( *block );
 
+    mkv_frames_t frames;
+    size_t frame_size = 0;
+    size_t block_size = internal_block.GetSize();
+    const unsigned i_number_frames = internal_block.NumberFrames();
+
+    for( unsigned int i_frame = 0; i_frame < i_number_frames; i_frame++ )
+    {
+        DataBuffer *data = &internal_block.GetBuffer(i_frame);
+
+        frame_size += data->Size();
+        if( !data->Buffer() || data->Size() > frame_size || frame_size > block_size  )
+        {
+            msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
+            break;
+        }
+        frames.push_back( mkv_frame_t{ data->Buffer(), data->Size() } );
+    }
+
+    BlockDecode( p_demux, internal_block.TrackNum(), frames, i_pts, i_duration,
+                 b_key_picture, b_discardable_picture );
+}
+
+void BlockDecode( demux_t *p_demux, unsigned int i_track, const mkv_frames_t & frames,
+                  vlc_tick_t i_pts, int64_t i_duration, bool b_key_picture,
+                  bool b_discardable_picture )
+{
+    demux_sys_t *p_sys = (demux_sys_t *)p_demux->p_sys;
+    matroska_segment_c *p_segment = p_sys->p_current_vsegment->CurrentSegment();
+
     if( !p_segment ) return;
 
-    mkv_track_t *p_track = p_segment->FindTrackByBlock( block, simpleblock );
+    mkv_track_t *p_track = p_segment->FindTrack( i_track );
     if( p_track == NULL )
     {
         msg_Err( p_demux, "invalid track number" );
@@ -557,31 +594,23 @@ void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock
         }
     }
 
-    size_t frame_size = 0;
-    size_t block_size = internal_block.GetSize();
-    const unsigned i_number_frames = internal_block.NumberFrames();
+    const unsigned i_number_frames = frames.size();
 
     for( unsigned int i_frame = 0; i_frame < i_number_frames; i_frame++ )
     {
         block_t *p_block;
-        DataBuffer *data = &internal_block.GetBuffer(i_frame);
+        const mkv_frame_t *data = &frames[i_frame];
 
-        frame_size += data->Size();
-        if( !data->Buffer() || data->Size() > frame_size || frame_size > block_size  )
-        {
-            msg_Warn( p_demux, "Cannot read frame (too long or no frame)" );
-            break;
-        }
         size_t extra_data = track.fmt.i_codec == VLC_CODEC_PRORES ? 8 : 0;
 
         if( track.i_compression_type == MATROSKA_COMPRESSION_HEADER &&
             track.p_compression_data != NULL &&
             track.i_encoding_scope & MATROSKA_ENCODING_SCOPE_ALL_FRAMES )
-            p_block = MemToBlock( data->Buffer(), data->Size(), track.p_compression_data->GetSize() + extra_data );
+            p_block = MemToBlock( data->p_buffer, data->i_size, track.p_compression_data->GetSize() + extra_data );
         else if( unlikely( track.fmt.i_codec == VLC_CODEC_WAVPACK ) )
-            p_block = packetize_wavpack( track, data->Buffer(), data->Size() );
+            p_block = packetize_wavpack( track, data->p_buffer, data->i_size );
         else
-            p_block = MemToBlock( data->Buffer(), data->Size(), extra_data );
+            p_block = MemToBlock( data->p_buffer, data->i_size, extra_data );
 
         if( p_block == NULL )
         {
@@ -734,13 +763,17 @@ static int Demux( demux_t *p_demux)
     if ( p_segment == NULL )
         return VLC_DEMUXER_EOF;
 
-    KaxBlock *block;
-    KaxSimpleBlock *simpleblock;
+    KaxBlock *block = NULL;
+    KaxSimpleBlock *simpleblock = NULL;
     int64_t i_block_duration = 0;
     bool b_key_picture;
     bool b_discardable_picture;
 
-    if( p_segment->BlockGet( block, simpleblock, &b_key_picture, &b_discardable_picture, &i_block_duration ) )
+    const cluster_prefetcher_c::block_info_t *p_prefetched =
+        p_segment->PrefetchBlockGet( &b_key_picture, &b_discardable_picture, &i_block_duration );
+
+    if( p_prefetched == NULL &&
+        p_segment->BlockGet( block, simpleblock, &b_key_picture, &b_discardable_picture, &i_block_duration ) )
     {
         if ( p_vsegment->CurrentEdition() && p_vsegment->CurrentEdition()->b_ordered )
         {
@@ -761,12 +794,36 @@ static int Demux( demux_t *p_demux)
         return VLC_DEMUXER_EOF;
     }
 
-    KaxInternalBlock& internal_block = block
-        ? static_cast<KaxInternalBlock&>( *block )
-        : static_cast<KaxInternalBlock&>( *simpleblock );
+    if( p_prefetched == NULL && p_segment->PrefetchUpdate() )
+    {
+        /* the next blocks are taken from the clusters read ahead */
+        delete block;
+        return VLC_DEMUXER_SUCCESS;
+    }
+
+    unsigned int i_track;
+    uint64_t i_block_fpos;
+    int64_t i_block_timecode;
+
+    if( p_prefetched )
+    {
+        i_track          = p_prefetched->i_track;
+        i_block_fpos     = p_prefetched->i_fpos;
+        i_block_timecode = p_prefetched->i_timecode;
+    }
+    else
+    {
+        KaxInternalBlock& internal_block = block
+            ? static_cast<KaxInternalBlock&>( *block )
+            : static_cast<KaxInternalBlock&>( *simpleblock );
+
+        i_track          = internal_block.TrackNum();
+        i_block_fpos     = internal_block.GetElementPosition();
+        i_block_timecode = internal_block.GlobalTimecode();
+    }
 
     {
-        mkv_track_t *p_track = p_segment->FindTrackByBlock( block, simpleblock );
+        mkv_track_t *p_track = p_segment->FindTrack( i_track );
 
         if( p_track == NULL )
         {
@@ -780,9 +837,7 @@ static int Demux( demux_t *p_demux)
 
         if( track.i_skip_until_fpos != std::numeric_limits<uint64_t>::max() ) {
 
-            uint64_t block_fpos = internal_block.GetElementPosition();
-
-            if ( track.i_skip_until_fpos > block_fpos )
+            if ( track.i_skip_until_fpos > i_block_fpos )
             {
                 delete block;
                 return VLC_DEMUXER_SUCCESS; // this block shall be ignored
@@ -827,7 +882,7 @@ static int Demux( demux_t *p_demux)
     /* set pts */
     {
         p_sys->i_pts = p_sys->i_mk_chapter_time + VLC_TICK_0;
-        p_sys->i_pts += VLC_TICK_FROM_NS(internal_block.GlobalTimecode());
+        p_sys->i_pts += VLC_TICK_FROM_NS(i_block_timecode);
     }
 
     if ( p_vsegment->CurrentEdition() &&
@@ -839,7 +894,10 @@ static int Demux( demux_t *p_demux)
         return VLC_DEMUXER_EOF;
     }
 
-    BlockDecode( p_demux, block, simpleblock, p_sys->i_pts, i_block_duration, b_key_picture, b_discardable_picture );
+    if( p_prefetched )
+        BlockDecode( p_demux, i_track, p_prefetched->frames, p_sys->i_pts, i_block_duration, b_key_picture, b_discardable_picture );
+    else
+        BlockDecode( p_demux, block, simpleblock, p_sys->i_pts, i_block_duration, b_key_picture, b_discardable_picture );
 
     delete block;
 
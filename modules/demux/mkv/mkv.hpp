@@ -118,9 +118,20 @@ enum
 
 using namespace LIBMATROSKA_NAMESPACE;
 
+/* a frame of a block, after lacing */
+struct mkv_frame_t
+{
+    const uint8_t *p_buffer;
+    size_t         i_size;
+};
+typedef std::vector<mkv_frame_t> mkv_frames_t;
+
 void BlockDecode( demux_t *p_demux, KaxBlock *block, KaxSimpleBlock *simpleblock,
                   vlc_tick_t i_pts, vlc_tick_t i_duration, bool b_key_picture,
                   bool b_discardable_picture );
+void BlockDecode( demux_t *p_demux, unsigned int i_track, const mkv_frames_t & frames,
+                  vlc_tick_t i_pts, vlc_tick_t i_duration, bool b_key_picture,
+                  bool b_discardable_picture );
 
 class attachment_c
 {
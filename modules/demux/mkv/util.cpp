@@ -150,7 +150,7 @@ block_t *block_zlib_decompress( vlc_object_t *p_this, block_t *p_in_block ) {
 #endif
 
 /* Utility function for BlockDecode */
-block_t *MemToBlock( uint8_t *p_mem, size_t i_mem, size_t offset)
+block_t *MemToBlock( const uint8_t *p_mem, size_t i_mem, size_t offset)
 {
     if( unlikely( i_mem > SIZE_MAX - offset ) )
         return NULL;
@@ -300,7 +300,7 @@ Cook_PrivateTrackData::~Cook_PrivateTrackData()
 }
 
 static inline void fill_wvpk_block(uint16_t version, uint32_t block_samples, uint32_t flags,
-                                   uint32_t crc, uint8_t * src, size_t srclen, uint8_t * dst)
+                                   uint32_t crc, const uint8_t * src, size_t srclen, uint8_t * dst)
 {
     const uint8_t wvpk_header[] = {'w','v','p','k',         /* ckId */
                                     0x0, 0x0, 0x0, 0x0,     /* ckSize */
@@ -318,7 +318,7 @@ static inline void fill_wvpk_block(uint16_t version, uint32_t block_samples, uin
     memcpy( dst + 32, src, srclen );
 }
 
-block_t * packetize_wavpack( const mkv_track_t & tk, uint8_t * buffer, size_t  size)
+block_t * packetize_wavpack( const mkv_track_t & tk, const uint8_t * buffer, size_t  size)
 {
     uint16_t version = 0x403;
     uint32_t block_samples;
@@ -31,7 +31,7 @@ int32_t zlib_decompress_extra( demux_t * p_demux, mkv_track_t & tk );
 block_t *block_zlib_decompress( vlc_object_t *p_this, block_t *p_in_block );
 #endif
 
-block_t *MemToBlock( uint8_t *p_mem, size_t i_mem, size_t offset);
+block_t *MemToBlock( const uint8_t *p_mem, size_t i_mem, size_t offset);
 void handle_real_audio(demux_t * p_demux, mkv_track_t * p_tk, block_t * p_blk, vlc_tick_t i_pts);
 void send_Block( demux_t * p_demux, mkv_track_t * p_tk, block_t * p_block, unsigned int i_number_frames, int64_t i_duration );
 
@@ -90,7 +90,7 @@ public:
     size_t   i_subpacket;
 };
 
-block_t * packetize_wavpack( const mkv_track_t &, uint8_t *, size_t);
+block_t * packetize_wavpack( const mkv_track_t &, const uint8_t *, size_t);
 
 /* helper functions to print the mkv parse tree */
 void MkvTree_va( demux_t& demuxer, int i_level, const char* fmt, va_list args);
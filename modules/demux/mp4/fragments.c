@@ -23,6 +23,10 @@
 
 #include "fragments.h"
 #include <limits.h>
+#include <string.h>
+
+/* How many fragments we can go back to start on a sync sample */
+#define MP4_FRAGMENT_RAP_BACKTRACK 8
 
 void MP4_Fragments_Index_Delete( mp4_fragments_index_t *p_index )
 {
@@ -30,6 +34,7 @@ void MP4_Fragments_Index_Delete( mp4_fragments_index_t *p_index )
     {
         free( p_index->pi_pos );
         free( p_index->p_times );
+        free( p_index->pi_flags );
         free( p_index );
     }
 }
@@ -43,53 +48,172 @@ mp4_fragments_index_t * MP4_Fragments_Index_New( unsigned i_tracks, unsigned i_n
     {
         p_index->p_times = calloc( (size_t)i_num * i_tracks, sizeof(*p_index->p_times) );
         p_index->pi_pos = calloc( i_num, sizeof(*p_index->pi_pos) );
-        if( !p_index->p_times || !p_index->pi_pos )
+        p_index->pi_flags = calloc( i_num, sizeof(*p_index->pi_flags) );
+        if( !p_index->p_times || !p_index->pi_pos || !p_index->pi_flags )
         {
             MP4_Fragments_Index_Delete( p_index );
             return NULL;
         }
-        p_index->i_entries = i_num;
+        p_index->i_entries = 0;
+        p_index->i_alloc = i_num;
         p_index->i_last_time = 0;
         p_index->i_tracks = i_tracks;
+        p_index->b_complete = false;
     }
     return p_index;
 }
 
-stime_t MP4_Fragment_Index_GetTrackStartTime( mp4_fragments_index_t *p_index,
-                                              unsigned i_track_index, uint64_t i_moof_pos )
+static bool MP4_Fragments_Index_Grow( mp4_fragments_index_t *p_index )
 {
-    for( size_t i=0; i<p_index->i_entries; i++ )
+    if( p_index->i_entries < p_index->i_alloc )
+        return true;
+
+    unsigned i_alloc = p_index->i_alloc * 2;
+    if( i_alloc <= p_index->i_alloc || SIZE_MAX / i_alloc < p_index->i_tracks )
+        return false;
+
+    stime_t *p_times = realloc( p_index->p_times,
+                                sizeof(*p_times) * i_alloc * p_index->i_tracks );
+    if( !p_times )
+        return false;
+    p_index->p_times = p_times;
+
+    uint64_t *pi_pos = realloc( p_index->pi_pos, sizeof(*pi_pos) * i_alloc );
+    if( !pi_pos )
+        return false;
+    p_index->pi_pos = pi_pos;
+
+    uint8_t *pi_flags = realloc( p_index->pi_flags, sizeof(*pi_flags) * i_alloc );
+    if( !pi_flags )
+        return false;
+    p_index->pi_flags = pi_flags;
+
+    p_index->i_alloc = i_alloc;
+    return true;
+}
+
+/* first entry with position >= i_pos */
+static unsigned MP4_Fragments_Index_FindPos( const mp4_fragments_index_t *p_index,
+                                             uint64_t i_pos )
+{
+    unsigned i_low = 0, i_high = p_index->i_entries;
+    while( i_low < i_high )
     {
-        if( p_index->pi_pos[i] >= i_moof_pos )
-            return p_index->p_times[i * p_index->i_tracks + i_track_index];
+        unsigned i_mid = i_low + (i_high - i_low) / 2;
+        if( p_index->pi_pos[i_mid] < i_pos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
     }
-    return 0;
+    return i_low;
+}
+
+bool MP4_Fragments_Index_Add( mp4_fragments_index_t *p_index, uint64_t i_pos,
+                              const stime_t *p_times, uint8_t i_flags, uint64_t i_prev_pos )
+{
+    unsigned i = MP4_Fragments_Index_FindPos( p_index, i_pos );
+    if( i < p_index->i_entries && p_index->pi_pos[i] == i_pos )
+    {
+        p_index->pi_flags[i] |= i_flags;
+    }
+    else
+    {
+        if( !MP4_Fragments_Index_Grow( p_index ) )
+            return false;
+
+        const unsigned i_move = p_index->i_entries - i;
+        const unsigned i_tracks = p_index->i_tracks;
+        memmove( &p_index->pi_pos[i + 1], &p_index->pi_pos[i],
+                 sizeof(*p_index->pi_pos) * i_move );
+        memmove( &p_index->pi_flags[i + 1], &p_index->pi_flags[i],
+                 sizeof(*p_index->pi_flags) * i_move );
+        memmove( &p_index->p_times[(size_t)(i + 1) * i_tracks],
+                 &p_index->p_times[(size_t)i * i_tracks],
+                 sizeof(*p_index->p_times) * i_move * i_tracks );
+
+        p_index->pi_pos[i] = i_pos;
+        p_index->pi_flags[i] = i_flags;
+        memcpy( &p_index->p_times[(size_t)i * i_tracks], p_times,
+                sizeof(*p_times) * i_tracks );
+        p_index->i_entries++;
+    }
+
+    if( i > 0 && i_prev_pos != UINT64_MAX && p_index->pi_pos[i - 1] == i_prev_pos )
+        p_index->pi_flags[i - 1] |= MP4_FRAGMENT_LINKED;
+
+    return true;
+}
+
+bool MP4_Fragment_Index_GetTrackStartTime( mp4_fragments_index_t *p_index,
+                                           unsigned i_track_index, uint64_t i_moof_pos,
+                                           stime_t *pi_time )
+{
+    unsigned i = MP4_Fragments_Index_FindPos( p_index, i_moof_pos );
+    if( i == p_index->i_entries || p_index->pi_pos[i] != i_moof_pos )
+        return false;
+    *pi_time = p_index->p_times[(size_t)i * p_index->i_tracks + i_track_index];
+    return true;
 }
 
 stime_t MP4_Fragment_Index_GetTrackDuration( mp4_fragments_index_t *p_index, unsigned i )
 {
+    if( p_index->i_entries == 0 )
+        return 0;
     return p_index->p_times[(size_t)(p_index->i_entries - 1) * p_index->i_tracks + i];
 }
 
 bool MP4_Fragments_Index_Lookup( mp4_fragments_index_t *p_index, stime_t *pi_time,
                                  uint64_t *pi_pos, unsigned i_track_index )
 {
-    if( *pi_time >= p_index->i_last_time || p_index->i_entries < 1 ||
-        i_track_index >= p_index->i_tracks )
+    if( p_index->i_entries < 1 || i_track_index >= p_index->i_tracks ||
+        (p_index->b_complete && *pi_time >= p_index->i_last_time) )
         return false;
 
-    for( size_t i=1; i<p_index->i_entries; i++ )
+    const stime_t *p_times = &p_index->p_times[i_track_index];
+    const unsigned i_tracks = p_index->i_tracks;
+
+    /* first fragment starting after the time */
+    unsigned i_low = 0, i_high = p_index->i_entries;
+    while( i_low < i_high )
+    {
+        unsigned i_mid = i_low + (i_high - i_low) / 2;
+        if( p_times[(size_t)i_mid * i_tracks] <= *pi_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+
+    unsigned i;
+    if( i_low == 0 )
+    {
+        if( !p_index->b_complete )
+            return false;
+        i = 0;
+    }
+    else
+    {
+        i = i_low - 1;
+        /* Fragments seen while playing: we need to know where it ends */
+        if( !p_index->b_complete && !(p_index->pi_flags[i] & MP4_FRAGMENT_LINKED) )
+            return false;
+    }
+
+    /* Prefer starting with a sync sample */
+    for( unsigned j = i, k = 0; k < MP4_FRAGMENT_RAP_BACKTRACK; k++ )
     {
-        if( p_index->p_times[i * p_index->i_tracks + i_track_index] > *pi_time )
+        if( p_index->pi_flags[j] & MP4_FRAGMENT_RAP )
         {
-            *pi_time = p_index->p_times[(i - 1) * p_index->i_tracks + i_track_index];
-            *pi_pos = p_index->pi_pos[i - 1];
-            return true;
+            i = j;
+            break;
         }
+        if( j == 0 || !(p_index->b_complete ||
+                        (p_index->pi_flags[j - 1] & MP4_FRAGMENT_LINKED)) )
+            break;
+        j--;
     }
 
-    *pi_time = p_index->p_times[(size_t)(p_index->i_entries - 1) * p_index->i_tracks];
-    *pi_pos = p_index->pi_pos[p_index->i_entries - 1];
+    *pi_time = p_times[(size_t)i * i_tracks];
+    *pi_pos = p_index->pi_pos[i];
     return true;
 }
 
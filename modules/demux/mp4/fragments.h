@@ -23,20 +23,32 @@
 #include <vlc_common.h>
 #include "libmp4.h"
 
+#define MP4_FRAGMENT_RAP     0x01 /* seek track starts with a sync sample */
+#define MP4_FRAGMENT_LINKED  0x02 /* next entry is the next fragment */
+
 typedef struct mp4_fragments_index_t
 {
     uint64_t *pi_pos;
     stime_t  *p_times; // movie scaled
+    uint8_t  *pi_flags;
     unsigned i_entries;
+    unsigned i_alloc;
     stime_t i_last_time; // movie scaled
     unsigned i_tracks;
+    bool     b_complete; /* all fragments, from file probing */
 } mp4_fragments_index_t;
 
 void MP4_Fragments_Index_Delete( mp4_fragments_index_t *p_index );
 mp4_fragments_index_t * MP4_Fragments_Index_New( unsigned i_tracks, unsigned i_num );
 
-stime_t MP4_Fragment_Index_GetTrackStartTime( mp4_fragments_index_t *p_index,
-                                              unsigned i_track_index, uint64_t i_moof_pos );
+/* Inserts or updates the fragment at i_pos, with its per track start times.
+ * i_prev_pos is the fragment demuxed just before, or UINT64_MAX */
+bool MP4_Fragments_Index_Add( mp4_fragments_index_t *p_index, uint64_t i_pos,
+                              const stime_t *p_times, uint8_t i_flags, uint64_t i_prev_pos );
+
+bool MP4_Fragment_Index_GetTrackStartTime( mp4_fragments_index_t *p_index,
+                                           unsigned i_track_index, uint64_t i_moof_pos,
+                                           stime_t *pi_time );
 stime_t MP4_Fragment_Index_GetTrackDuration( mp4_fragments_index_t *p_index, unsigned i_track_index );
 
 bool MP4_Fragments_Index_Lookup( mp4_fragments_index_t *p_index,
@@ -121,6 +121,7 @@ typedef struct
         MP4_Box_t      *p_fragment_atom;
         uint64_t        i_post_mdat_offset;
         uint32_t        i_lastseqnumber;
+        uint64_t        i_lastmoofpos; /* previous fragment, for indexing */
     } context;
 
     /* */
@@ -183,6 +184,7 @@ static int  ProbeIndex( demux_t *p_demux );
 
 static int FragCreateTrunIndex( demux_t *, MP4_Box_t *, MP4_Box_t *, stime_t );
 
+static void FragIndexFragment( demux_t *, MP4_Box_t *, uint64_t );
 static int FragGetMoofBySidxIndex( demux_t *p_demux, vlc_tick_t i_target_time,
                                    uint64_t *pi_moof_pos, vlc_tick_t *pi_sampletime );
 static int FragGetMoofByTfraIndex( demux_t *p_demux, const vlc_tick_t i_target_time, unsigned i_track_ID,
@@ -334,32 +336,50 @@ static es_out_id_t * MP4_AddTrackES( es_out_t *out, mp4_track_t *p_track )
     return p_es;
 }
 
-/* Return time in microsecond of a track */
-static inline vlc_tick_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
+/* Sum of the i_count sample durations from i_start, relative to the chunk */
+static stime_t MP4_ChunkGetDuration( const mp4_track_t *p_track, const mp4_chunk_t *ck,
+                                     uint32_t i_start, uint32_t i_count )
 {
-    demux_sys_t *p_sys = p_demux->p_sys;
-    const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
+    const MP4_Box_data_stts_t *stts = p_track->p_stts;
+    if( !stts || i_start >= ck->i_sample_count )
+        return 0;
 
-    unsigned int i_index = 0;
-    unsigned int i_sample = p_track->i_sample - p_chunk->i_sample_first;
-    int64_t sdts = p_chunk->i_first_dts;
+    i_count = __MIN( i_count, ck->i_sample_count - i_start );
 
-    while( i_sample > 0 && i_index < p_chunk->i_entries_dts )
+    uint32_t i_index = ck->i_index_dts;
+    uint64_t i_skip = (uint64_t) ck->i_skip_dts + i_start;
+    stime_t i_duration = 0;
+
+    while( i_count > 0 && i_index < stts->i_entry_count )
     {
-        if( i_sample > p_chunk->p_sample_count_dts[i_index] )
+        const uint32_t i_entry_count = stts->pi_sample_count[i_index];
+        if( i_skip >= i_entry_count )
         {
-            sdts += p_chunk->p_sample_count_dts[i_index] *
-                p_chunk->p_sample_delta_dts[i_index];
-            i_sample -= p_chunk->p_sample_count_dts[i_index];
-            i_index++;
+            i_skip -= i_entry_count;
         }
         else
         {
-            sdts += i_sample * p_chunk->p_sample_delta_dts[i_index];
-            break;
+            uint32_t i_run = __MIN( i_entry_count - i_skip, i_count );
+            i_duration += (stime_t) i_run * (uint32_t) stts->pi_sample_delta[i_index];
+            i_count -= i_run;
+            i_skip = 0;
         }
+        i_index++;
     }
 
+    return i_duration;
+}
+
+/* Return time in microsecond of a track */
+static inline vlc_tick_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
+
+    int64_t sdts = p_chunk->i_first_dts +
+                   MP4_ChunkGetDuration( p_track, p_chunk, 0,
+                                         p_track->i_sample - p_chunk->i_sample_first );
+
     vlc_tick_t i_dts = MP4_rescale_mtime( sdts, p_track->i_timescale );
 
     /* now handle elst */
@@ -388,24 +408,26 @@ static inline bool MP4_TrackGetPTSDelta( demux_t *p_demux, mp4_track_t *p_track,
                                          vlc_tick_t *pi_delta )
 {
     VLC_UNUSED( p_demux );
-    mp4_chunk_t *ck = &p_track->chunk[p_track->i_chunk];
+    const MP4_Box_data_ctts_t *ctts = p_track->p_ctts;
+    const mp4_chunk_t *ck = &p_track->chunk[p_track->i_chunk];
 
-    unsigned int i_index = 0;
-    unsigned int i_sample = p_track->i_sample - ck->i_sample_first;
-
-    if( ck->p_sample_count_pts == NULL || ck->p_sample_offset_pts == NULL )
+    if( ctts == NULL )
         return false;
 
-    for( i_index = 0; i_index < ck->i_entries_pts ; i_index++ )
+    uint64_t i_sample = (uint64_t) ck->i_skip_pts +
+                        p_track->i_sample - ck->i_sample_first;
+
+    for( uint32_t i_index = ck->i_index_pts; i_index < ctts->i_entry_count ; i_index++ )
     {
-        if( i_sample < ck->p_sample_count_pts[i_index] )
+        if( i_sample < ctts->pi_sample_count[i_index] )
         {
-            *pi_delta = MP4_rescale_mtime( ck->p_sample_offset_pts[i_index],
+            *pi_delta = MP4_rescale_mtime( ctts->pi_sample_offset[i_index] +
+                                           p_track->i_cts_shift,
                                            p_track->i_timescale );
             return true;
         }
 
-        i_sample -= ck->p_sample_count_pts[i_index];
+        i_sample -= ctts->pi_sample_count[i_index];
     }
     return false;
 }
@@ -416,43 +438,9 @@ static inline vlc_tick_t MP4_GetSamplesDuration( demux_t *p_demux, mp4_track_t *
     VLC_UNUSED( p_demux );
 
     const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
-    stime_t i_duration = 0;
-
-    /* Forward to right index, and set remaining count in that index */
-    unsigned i_index = 0;
-    unsigned i_remain = 0;
-    for( unsigned i = p_chunk->i_sample_first;
-         i<p_track->i_sample && i_index < p_chunk->i_entries_dts; )
-    {
-        if( p_track->i_sample - i >= p_chunk->p_sample_count_dts[i_index] )
-        {
-            i += p_chunk->p_sample_count_dts[i_index];
-            i_index++;
-        }
-        else
-        {
-            i_remain = p_track->i_sample - i;
-            break;
-        }
-    }
-
-    /* Compute total duration from all samples from index */
-    while( i_nb_samples > 0 && i_index < p_chunk->i_entries_dts )
-    {
-        if( i_nb_samples >= p_chunk->p_sample_count_dts[i_index] - i_remain )
-        {
-            i_duration += (p_chunk->p_sample_count_dts[i_index] - i_remain) *
-                          (int64_t) p_chunk->p_sample_delta_dts[i_index];
-            i_nb_samples -= (p_chunk->p_sample_count_dts[i_index] - i_remain);
-            i_index++;
-            i_remain = 0;
-        }
-        else
-        {
-            i_duration += i_nb_samples * p_chunk->p_sample_delta_dts[i_index];
-            break;
-        }
-    }
+    stime_t i_duration = MP4_ChunkGetDuration( p_track, p_chunk,
+                                               p_track->i_sample - p_chunk->i_sample_first,
+                                               i_nb_samples );
 
     return MP4_rescale_mtime( i_duration, p_track->i_timescale );
 }
@@ -797,6 +785,7 @@ static int Open( vlc_object_t * p_this )
     p_demux->pf_control = Control;
 
     p_sys->context.i_lastseqnumber = UINT32_MAX;
+    p_sys->context.i_lastmoofpos = UINT64_MAX;
 
     p_demux->p_sys = p_sys;
 
@@ -1712,10 +1701,12 @@ static int FragSeekLoadFragment( demux_t *p_demux, uint32_t i_moox, stime_t i_mo
     /* map context */
     p_sys->context.p_fragment_atom = p_moox;
     p_sys->context.i_current_box_type = i_moox;
+    p_sys->context.i_lastmoofpos = UINT64_MAX;
 
     if( i_moox == ATOM_moof )
     {
-        FragPrepareChunk( p_demux, p_moox, NULL, i_moox_time, true );
+        if( FragPrepareChunk( p_demux, p_moox, NULL, i_moox_time, true ) == VLC_SUCCESS )
+            FragIndexFragment( p_demux, p_moox, UINT64_MAX );
         p_sys->context.i_lastseqnumber = FragGetMoofSequenceNumber( p_moox );
 
         p_sys->i_nztime = FragGetDemuxTimeFromTracksTime( p_sys );
@@ -1836,9 +1827,20 @@ static int FragSeekToTime( demux_t *p_demux, vlc_tick_t i_nztime, bool b_accurat
         }
         else if( !p_sys->b_fragments_probed )
         {
-            int i_ret = ProbeFragmentsChecked( p_demux );
-            if( i_ret != VLC_SUCCESS )
-                return i_ret;
+            /* Try fragments already played before probing the whole file */
+            stime_t i_basetime = MP4_rescale_qtime( i_nztime, p_sys->i_timescale );
+            if( p_sys->p_fragsindex &&
+                MP4_Fragments_Index_Lookup( p_sys->p_fragsindex, &i_basetime, &i64, i_seek_track_index ) )
+            {
+                msg_Dbg( p_demux, "seeking to played fragment pos %" PRId64 " %" PRId64, i64,
+                         MP4_rescale_mtime( i_basetime, p_sys->i_timescale ) );
+            }
+            else
+            {
+                int i_ret = ProbeFragmentsChecked( p_demux );
+                if( i_ret != VLC_SUCCESS )
+                    return i_ret;
+            }
         }
 
         if( p_sys->b_fragments_probed && p_sys->p_fragsindex )
@@ -2327,12 +2329,10 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
         ck->i_offset = BOXDATA(p_co64)->i_chunk_offset[i_chunk];
 
         ck->i_first_dts = 0;
-        ck->i_entries_dts = 0;
-        ck->p_sample_count_dts = NULL;
-        ck->p_sample_delta_dts = NULL;
-        ck->i_entries_pts = 0;
-        ck->p_sample_count_pts = NULL;
-        ck->p_sample_offset_pts = NULL;
+        ck->i_index_dts = 0;
+        ck->i_skip_dts = 0;
+        ck->i_index_pts = 0;
+        ck->i_skip_pts = 0;
     }
 
     /* now we read index for SampleEntry( soun vide mp4a mp4v ...)
@@ -2394,52 +2394,26 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
-static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
-                              const uint32_t i_index,
-                              uint32_t i_index_samples_left,
-                              uint32_t i_sample_count,
-                              const uint32_t *pi_index_sample_count,
-                              const uint32_t i_table_count )
+/* Moves a run length table cursor forward by i_samples */
+static bool xTTS_Advance( const uint32_t *pi_sample_count, uint32_t i_entry_count,
+                          uint32_t *pi_index, uint32_t *pi_skip, uint32_t i_samples )
 {
-    uint32_t i_array_offset;
-    while( i_sample_count > 0 )
+    while( i_samples > 0 )
     {
-        if ( likely((UINT32_MAX - i_index) >= *pi_entry) )
-            i_array_offset = i_index + *pi_entry;
-        else
-            return VLC_EGENERIC;
-
-        if ( i_array_offset >= i_table_count )
-        {
-            msg_Err( p_demux, "invalid index counting total samples %u %u", i_array_offset,  i_table_count );
-            return VLC_EBADVAR;
-        }
+        if( *pi_index >= i_entry_count )
+            return false;
 
-        if ( i_index_samples_left )
+        const uint32_t i_left = pi_sample_count[*pi_index] - *pi_skip;
+        if( i_left > i_samples )
         {
-            if ( i_index_samples_left > i_sample_count )
-            {
-                i_index_samples_left -= i_sample_count;
-                i_sample_count = 0;
-                *pi_entry +=1; /* No samples left, go copy */
-                break;
-            }
-            else
-            {
-                i_sample_count -= i_index_samples_left;
-                i_index_samples_left = 0;
-                *pi_entry += 1;
-                continue;
-            }
-        }
-        else
-        {
-            i_sample_count -= __MIN( i_sample_count, pi_index_sample_count[i_array_offset] );
-            *pi_entry += 1;
+            *pi_skip += i_samples;
+            break;
         }
+        i_samples -= i_left;
+        *pi_skip = 0;
+        (*pi_index)++;
     }
-
-    return VLC_SUCCESS;
+    return true;
 }
 
 static int TrackCreateSamplesIndex( demux_t *p_demux,
@@ -2479,18 +2453,9 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     }
     else
     {
-        /* 2: each sample can have a different size */
+        /* 2: each sample can have a different size, use the table as stored */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        p_demux_track->p_sample_size = stsz->i_entry_size;
     }
 
     if ( p_demux_track->i_chunk_count && p_demux_track->i_sample_size == 0 )
@@ -2503,120 +2468,47 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
         }
     }
 
-    /* Use stts table to create a sample number -> dts table.
+    /* Use stts table to map sample number -> dts.
      * XXX: if we don't want to waste too much memory, we can't expand
-     *  the box! so each chunk will contain an "extract" of this table
-     *  for fast research (problem with raw stream where a sample is sometime
-     *  just channels*bits_per_sample/8 */
-
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
+     *  the box! so each chunk only keeps its position in the run length
+     *  table, which is walked on access */
 
     int64_t i_next_dts = 0;
     /* Find stts
      *  Gives mapping between sample and decoding time
      */
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "stts" );
-    if( !p_box )
+    if( !p_box || !p_box->data.p_stts )
     {
         msg_Warn( p_demux, "cannot find STTS box" );
         return VLC_EGENERIC;
     }
     else
     {
-        MP4_Box_data_stts_t *stts = p_box->data.p_stts;
+        const MP4_Box_data_stts_t *stts = p_box->data.p_stts;
 
         msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
 
-        /* Create sample -> dts table per chunk */
+        p_demux_track->p_stts = stts;
+
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_skip = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
 
-            /* save first dts */
             ck->i_first_dts = i_next_dts;
+            ck->i_index_dts = i_index;
+            ck->i_skip_dts = i_skip;
+            ck->i_duration = MP4_ChunkGetDuration( p_demux_track, ck, 0, ck->i_sample_count );
+            i_next_dts += ck->i_duration;
 
-            /* count how many entries are needed for this chunk
-             * for p_sample_delta_dts and p_sample_count_dts */
-            ck->i_entries_dts = 0;
-
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_dts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            ck->p_sample_delta_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
+            if( !xTTS_Advance( stts->pi_sample_count, stts->i_entry_count,
+                               &i_index, &i_skip, ck->i_sample_count ) )
             {
-                free( ck->p_sample_count_dts );
-                free( ck->p_sample_delta_dts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
-                ck->i_entries_dts = 0;
-                return VLC_ENOMEM;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
-            {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_current_index_samples_left ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( stts->pi_sample_count[i_index] ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
+                msg_Err( p_demux, "invalid STTS table, not enough samples" );
+                return VLC_EGENERIC;
             }
         }
     }
@@ -2628,94 +2520,28 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     p_box = MP4_BoxGet( p_demux_track->p_stbl, "ctts" );
     if( p_box && p_box->data.p_ctts )
     {
-        MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
+        const MP4_Box_data_ctts_t *ctts = p_box->data.p_ctts;
 
         msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
 
-        int64_t i_cts_shift = 0;
+        p_demux_track->p_ctts = ctts;
+        p_demux_track->i_cts_shift = 0;
         const MP4_Box_t *p_cslg = MP4_BoxGet( p_demux_track->p_stbl, "cslg" );
         if( p_cslg && BOXDATA(p_cslg) )
-            i_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
+            p_demux_track->i_cts_shift = BOXDATA(p_cslg)->ct_to_dts_shift;
 
-        /* Create pts-dts table per chunk */
         uint32_t i_index = 0;
-        uint32_t i_current_index_samples_left = 0;
+        uint32_t i_skip = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_offset_pts and p_sample_count_pts */
-            ck->i_entries_pts = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_pts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_pts = calloc( ck->i_entries_pts, sizeof( uint32_t ) );
-            ck->p_sample_offset_pts = calloc( ck->i_entries_pts, sizeof( int32_t ) );
-            if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
-            {
-                free( ck->p_sample_count_pts );
-                free( ck->p_sample_offset_pts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
-                ck->i_entries_pts = 0;
-                return VLC_ENOMEM;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
-            {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index] + i_cts_shift;
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
 
+            ck->i_index_pts = i_index;
+            ck->i_skip_pts = i_skip;
 
-            }
+            xTTS_Advance( ctts->pi_sample_count, ctts->i_entry_count,
+                          &i_index, &i_skip, ck->i_sample_count );
         }
     }
 
@@ -3016,53 +2842,55 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         i_start = MP4_rescale_qtime( start, p_track->i_timescale );
     }
 
-    /* we start from sample 0/chunk 0, hope it won't take too much time */
     /* *** find good chunk *** */
-    for( i_chunk = 0; ; i_chunk++ )
+    /* chunks first dts are increasing, use them as time to sample index */
+    i_chunk = 0;
+    if( p_track->i_chunk_count > 1 )
     {
-        if( i_chunk + 1 >= p_track->i_chunk_count )
+        uint32_t i_low = 0, i_high = p_track->i_chunk_count - 1;
+        while( i_low < i_high )
         {
-            /* at the end and can't check if i_start in this chunk,
-               it will be check while searching i_sample */
-            i_chunk = p_track->i_chunk_count - 1;
-            break;
-        }
-
-        if( (uint64_t)i_start >= p_track->chunk[i_chunk].i_first_dts &&
-            (uint64_t)i_start <  p_track->chunk[i_chunk + 1].i_first_dts )
-        {
-            break;
+            uint32_t i_mid = i_low + (i_high - i_low + 1) / 2;
+            if( (uint64_t)i_start >= p_track->chunk[i_mid].i_first_dts )
+                i_low = i_mid;
+            else
+                i_high = i_mid - 1;
         }
+        i_chunk = i_low;
     }
 
     /* *** find sample in the chunk *** */
-    i_sample = p_track->chunk[i_chunk].i_sample_first;
-    i_dts    = p_track->chunk[i_chunk].i_first_dts;
+    const mp4_chunk_t *ck = &p_track->chunk[i_chunk];
+    i_sample = ck->i_sample_first;
+    i_dts    = ck->i_first_dts;
 
-    for( uint_fast32_t i_index = 0;
-         i_index < p_track->chunk[i_chunk].i_entries_dts &&
-         i_sample < p_track->chunk[i_chunk].i_sample_count;
-         i_index++ )
+    if( p_track->p_stts )
     {
-        if( i_dts +
-            p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-            p_track->chunk[i_chunk].p_sample_delta_dts[i_index] < (uint64_t)i_start )
-        {
-            i_dts    +=
-                p_track->chunk[i_chunk].p_sample_count_dts[i_index] *
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
+        const MP4_Box_data_stts_t *stts = p_track->p_stts;
+        uint32_t i_skip = ck->i_skip_dts;
+        uint32_t i_left = ck->i_sample_count;
 
-            i_sample += p_track->chunk[i_chunk].p_sample_count_dts[i_index];
-        }
-        else
+        for( uint32_t i_index = ck->i_index_dts;
+             i_index < stts->i_entry_count && i_left > 0;
+             i_index++ )
         {
-            if( p_track->chunk[i_chunk].p_sample_delta_dts[i_index] <= 0 )
+            const uint32_t i_run = __MIN( stts->pi_sample_count[i_index] - i_skip, i_left );
+            const uint32_t i_delta = stts->pi_sample_delta[i_index];
+            i_skip = 0;
+
+            if( i_dts + (uint64_t) i_run * i_delta < (uint64_t)i_start )
             {
+                i_dts    += (uint64_t) i_run * i_delta;
+                i_sample += i_run;
+                i_left   -= i_run;
+            }
+            else
+            {
+                if( i_delta == 0 )
+                    break;
+                i_sample += ( i_start - i_dts ) / i_delta;
                 break;
             }
-            i_sample += ( i_start - i_dts ) /
-                p_track->chunk[i_chunk].p_sample_delta_dts[i_index];
-            break;
         }
     }
 
@@ -3482,15 +3310,6 @@ static void MP4_TrackSetup( demux_t *p_demux, mp4_track_t *p_track,
     p_track->b_ok = true;
 }
 
-static void DestroyChunk( mp4_chunk_t *ck )
-{
-    free( ck->p_sample_count_dts );
-    free( ck->p_sample_delta_dts );
-    free( ck->p_sample_count_pts );
-    free( ck->p_sample_offset_pts );
-    free( ck->p_sample_size );
-}
-
 /****************************************************************************
  * MP4_TrackClean:
  ****************************************************************************
@@ -3503,16 +3322,8 @@ static void MP4_TrackClean( es_out_t *out, mp4_track_t *p_track )
     if( p_track->p_es )
         es_out_Del( out, p_track->p_es );
 
-    if( p_track->chunk )
-    {
-        for( unsigned int i_chunk = 0; i_chunk < p_track->i_chunk_count; i_chunk++ )
-            DestroyChunk( &p_track->chunk[i_chunk] );
-    }
     free( p_track->chunk );
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
-
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
 
@@ -4133,6 +3944,80 @@ static bool GetMoofTrackDuration( MP4_Box_t *p_moov, MP4_Box_t *p_moof,
     return true;
 }
 
+static bool FragIsRandomAccess( MP4_Box_t *p_moov, MP4_Box_t *p_moof, unsigned i_track_ID )
+{
+    MP4_Box_t *p_traf = MP4_GetTrafByTrackID( p_moof, i_track_ID );
+    if( !p_traf )
+        return false;
+
+    const MP4_Box_t *p_tfhd = MP4_BoxGet( p_traf, "tfhd" );
+    const MP4_Box_t *p_trun = MP4_BoxGet( p_traf, "trun" );
+    if( !p_tfhd || !BOXDATA(p_tfhd) || !p_trun || !BOXDATA(p_trun) ||
+        !BOXDATA(p_trun)->i_sample_count )
+        return false;
+
+    /* first sample flags, from the most specific box */
+    uint32_t i_flags;
+    if( BOXDATA(p_trun)->i_flags & MP4_TRUN_FIRST_FLAGS )
+        i_flags = BOXDATA(p_trun)->i_first_sample_flags;
+    else if( BOXDATA(p_trun)->i_flags & MP4_TRUN_SAMPLE_FLAGS )
+        i_flags = BOXDATA(p_trun)->p_samples[0].i_flags;
+    else if( BOXDATA(p_tfhd)->i_flags & MP4_TFHD_DFLT_SAMPLE_FLAGS )
+        i_flags = BOXDATA(p_tfhd)->i_default_sample_flags;
+    else
+    {
+        const MP4_Box_t *p_trex = MP4_GetTrexByTrackID( p_moov, i_track_ID );
+        if( !p_trex || !BOXDATA(p_trex) )
+            return false;
+        i_flags = BOXDATA(p_trex)->i_default_sample_flags;
+    }
+
+    return !(i_flags & MP4_SAMPLE_IS_NON_SYNC);
+}
+
+/* Records the fragments played so far, so we can seek back to them
+ * without probing the whole file */
+static void FragIndexFragment( demux_t *p_demux, MP4_Box_t *p_moof, uint64_t i_prev_pos )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    p_sys->context.i_lastmoofpos = p_moof->i_pos;
+
+    if( p_sys->b_fragments_probed || !p_sys->b_seekable || !p_sys->i_tracks )
+        return;
+
+    if( !p_sys->p_fragsindex )
+    {
+        p_sys->p_fragsindex = MP4_Fragments_Index_New( p_sys->i_tracks, 64 );
+        if( !p_sys->p_fragsindex )
+            return;
+    }
+
+    stime_t *pi_track_times = vlc_alloc( p_sys->i_tracks, sizeof(*pi_track_times) );
+    if( !pi_track_times )
+        return;
+
+    /* tracks without run in that fragment keep their current time */
+    for( unsigned i=0; i<p_sys->i_tracks; i++ )
+    {
+        const mp4_track_t *p_track = &p_sys->track[i];
+        stime_t i_time = p_track->i_time;
+        if( p_track->context.runs.i_count )
+            i_time = p_track->context.runs.p_array[0].i_first_dts;
+        pi_track_times[i] = MP4_rescale( i_time, p_track->i_timescale, p_sys->i_timescale );
+    }
+
+    const unsigned i_seek_track_index = GetSeekTrackIndex( p_sys );
+    uint8_t i_flags = 0;
+    if( FragIsRandomAccess( p_sys->p_moov, p_moof,
+                            p_sys->track[i_seek_track_index].i_track_ID ) )
+        i_flags |= MP4_FRAGMENT_RAP;
+
+    MP4_Fragments_Index_Add( p_sys->p_fragsindex, p_moof->i_pos,
+                             pi_track_times, i_flags, i_prev_pos );
+    free( pi_track_times );
+}
+
 static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -4154,6 +4039,8 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
         if( i_moof )
         {
             *pb_fragmented = true;
+            /* replaces the fragments seen while playing */
+            MP4_Fragments_Index_Delete( p_sys->p_fragsindex );
             p_sys->p_fragsindex = MP4_Fragments_Index_New( p_sys->i_tracks, i_moof );
             if( !p_sys->p_fragsindex )
             {
@@ -4171,6 +4058,7 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
             }
 
             unsigned index = 0;
+            const unsigned i_seek_track_index = GetSeekTrackIndex( p_sys );
 
             for( MP4_Box_t *p_moof = p_vroot->p_first; p_moof; p_moof = p_moof->p_next )
             {
@@ -4202,8 +4090,15 @@ static int ProbeFragments( demux_t *p_demux, bool b_force, bool *pb_fragmented )
                         pi_track_times[i] += i_duration;
                 }
 
+                p_sys->p_fragsindex->pi_flags[index] = MP4_FRAGMENT_LINKED;
+                if( FragIsRandomAccess( p_sys->p_moov, p_moof,
+                                        p_sys->track[i_seek_track_index].i_track_ID ) )
+                    p_sys->p_fragsindex->pi_flags[index] |= MP4_FRAGMENT_RAP;
                 p_sys->p_fragsindex->pi_pos[index++] = p_moof->i_pos;
             }
+            p_sys->p_fragsindex->i_entries = index;
+            p_sys->p_fragsindex->pi_flags[index - 1] &= ~MP4_FRAGMENT_LINKED;
+            p_sys->p_fragsindex->b_complete = true;
 
             for( unsigned i=0; i<p_sys->i_tracks; i++ )
             {
@@ -4596,11 +4491,13 @@ static int FragCreateTrunIndex( demux_t *p_demux, MP4_Box_t *p_moof,
             {
                 unsigned i_track_index = (p_track - p_sys->track);
                 assert(&p_sys->track[i_track_index] == p_track);
-                i_traf_start_time = MP4_Fragment_Index_GetTrackStartTime( p_sys->p_fragsindex,
-                                                                          i_track_index, p_moof->i_pos );
-                i_traf_start_time = MP4_rescale( i_traf_start_time,
-                                                 p_sys->i_timescale, p_track->i_timescale );
-                b_has_base_media_decode_time = true;
+                if( MP4_Fragment_Index_GetTrackStartTime( p_sys->p_fragsindex, i_track_index,
+                                                          p_moof->i_pos, &i_traf_start_time ) )
+                {
+                    i_traf_start_time = MP4_rescale( i_traf_start_time,
+                                                     p_sys->i_timescale, p_track->i_timescale );
+                    b_has_base_media_decode_time = true;
+                }
             }
 
             if( !b_has_base_media_decode_time && p_chunksidx )
@@ -4987,6 +4884,9 @@ static int DemuxFrag( demux_t *p_demux )
                         goto end;
                     }
 
+                    FragIndexFragment( p_demux, p_sys->context.p_fragment_atom,
+                                       b_discontinuity ? UINT64_MAX : p_sys->context.i_lastmoofpos );
+
                     if( b_discontinuity )
                     {
                         p_sys->i_nztime = FragGetDemuxTimeFromTracksTime( p_sys );
@@ -49,6 +49,7 @@
 #include "sections.h"
 #include "pes.h"
 #include "timestamps.h"
+#include "ts_index.h"
 
 #include "ts.h"
 
@@ -111,6 +112,14 @@ static void Close ( vlc_object_t * );
     "Seek and position based on a percent byte position, not a PCR generated " \
     "time position. If seeking doesn't work property, turn on this option." )
 
+#define SEEK_INDEX_TEXT N_("Keep a seek index")
+#define SEEK_INDEX_LONGTEXT N_( \
+    "Record PCR positions while playing seekable files, and store them " \
+    "to answer later seeks and duration without probing the file." )
+#define SEEK_INDEX_PATH_TEXT N_("Seek index directory")
+#define SEEK_INDEX_PATH_LONGTEXT N_( \
+    "Directory where seek indexes are stored. Defaults to the user cache directory." )
+
 #define CC_CHECK_TEXT       "Check packets continuity counter"
 #define CC_CHECK_LONGTEXT   "Detect discontinuities and drop packet duplicates. " \
                             "(bluRay sources are known broken and have false positives). "
@@ -157,6 +166,8 @@ vlc_module_begin ()
 
     add_bool( "ts-split-es", true, SPLIT_ES_TEXT, SPLIT_ES_LONGTEXT, false )
     add_bool( "ts-seek-percent", false, SEEK_PERCENT_TEXT, SEEK_PERCENT_LONGTEXT, true )
+    add_bool( "ts-seek-index", false, SEEK_INDEX_TEXT, SEEK_INDEX_LONGTEXT, true )
+    add_directory( "ts-seek-index-path", NULL, SEEK_INDEX_PATH_TEXT, SEEK_INDEX_PATH_LONGTEXT )
     add_bool( "ts-cc-check", true, CC_CHECK_TEXT, CC_CHECK_LONGTEXT, true )
     add_bool( "ts-pmtfix-waitdata", true, TS_SKIP_GHOST_PROGRAM_TEXT, NULL, true )
     add_bool( "ts-patfix", true, TS_PATFIX_TEXT, NULL, true )
@@ -196,9 +207,13 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *, block_t *, size_t );
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, stime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static block_t* ReadTSPacketBatched( demux_t *p_demux );
+static void ConsumeTSPackets( demux_t *p_demux );
+static void ProbePendingBounds( demux_t *p_demux );
+static block_t* DetachTSPacket( demux_sys_t *, block_t *, size_t );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, stime_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
-static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t );
+static void PCRHandle( demux_t *p_demux, ts_pid_t *, stime_t, bool );
 static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
 
 #define TS_PACKET_SIZE_188 188
@@ -207,6 +222,7 @@ static void PCRFixHandle( demux_t *, ts_pmt_t *, block_t * );
 #define TS_PACKET_SIZE_MAX 204
 #define TS_HEADER_SIZE 4
 
+#define TS_BATCH_PACKETS  (7 * 8)
 #define PROBE_CHUNK_COUNT 500
 #define PROBE_MAX         (PROBE_CHUNK_COUNT * 10)
 
@@ -404,6 +420,10 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_size = i_packet_size;
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
+    p_sys->batch.p_peek = NULL;
+    p_sys->batch.i_peek = 0;
+    p_sys->batch.i_pos = 0;
+    p_sys->batch.s = NULL;
     p_sys->csa = NULL;
     p_sys->b_start_record = false;
 
@@ -530,6 +550,16 @@ static int Open( vlc_object_t *p_this )
     vlc_stream_Control( p_sys->stream, STREAM_CAN_FASTSEEK,
                         &p_sys->b_canfastseek );
 
+    p_sys->p_index = NULL;
+    if( p_sys->b_canfastseek && !p_sys->b_access_control &&
+        !p_demux->b_preparsing && var_InheritBool( p_demux, "ts-seek-index" ) )
+    {
+        p_sys->p_index = ts_index_New();
+        if( p_sys->p_index )
+            ts_index_Load( p_sys->p_index, VLC_OBJECT(p_demux), p_demux->psz_url,
+                           stream_Size( p_sys->stream ), p_sys->i_packet_size );
+    }
+
     if( !p_sys->b_access_control && var_CreateGetBool( p_demux, "ts-pmtfix-waitdata" ) )
         p_sys->es_creation = DELAY_ES;
     else
@@ -555,11 +585,45 @@ static void FreeDictAttachment( void *p_value, void *p_obj )
     vlc_input_attachment_Delete( (input_attachment_t *) p_value );
 }
 
+static void SaveSeekIndex( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    ts_pid_t *patpid = GetPID(p_sys, 0);
+
+    if( patpid->type == TYPE_PAT )
+    {
+        ts_pat_t *p_pat = patpid->u.p_pat;
+        for( int i = 0; i < p_pat->programs.i_size; i++ )
+        {
+            const ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+            if( p_pmt->pcr.i_first > -1 && SETANDVALID(p_pmt->i_last_dts) )
+            {
+                const ts_index_bounds_t bounds = {
+                    .i_first = p_pmt->pcr.i_first,
+                    .i_first_dts = p_pmt->pcr.i_first_dts,
+                    .i_last = p_pmt->i_last_dts,
+                    .i_last_pos = p_pmt->i_last_dts_byte,
+                };
+                ts_index_SetBounds( p_sys->p_index, p_pmt->i_number, &bounds );
+            }
+        }
+    }
+
+    ts_index_Save( p_sys->p_index, VLC_OBJECT(p_demux), p_demux->psz_url,
+                   stream_Size( p_sys->stream ), p_sys->i_packet_size );
+}
+
 static void Close( vlc_object_t *p_this )
 {
     demux_t     *p_demux = (demux_t*)p_this;
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    if( p_sys->p_index )
+    {
+        SaveSeekIndex( p_demux );
+        ts_index_Delete( p_sys->p_index );
+    }
+
     PIDRelease( p_demux, GetPID(p_sys, 0) );
 
     vlc_mutex_lock( &p_sys->csa_lock );
@@ -637,14 +701,17 @@ static int Demux( demux_t *p_demux )
         bool         b_frame = false;
         int          i_header = 0;
         block_t     *p_pkt;
-        if( !(p_pkt = ReadTSPacket( p_demux )) )
+        if( !(p_pkt = ReadTSPacketBatched( p_demux )) )
         {
+            ConsumeTSPackets( p_demux );
+            ProbePendingBounds( p_demux );
             return VLC_DEMUXER_EOF;
         }
 
         if( p_sys->b_start_record )
         {
             /* Enable recording once synchronized */
+            ConsumeTSPackets( p_demux );
             vlc_stream_Control( p_sys->stream, STREAM_SET_RECORD_STATE, true,
                                 "ts" );
             p_sys->b_start_record = false;
@@ -690,7 +757,8 @@ static int Demux( demux_t *p_demux )
         /* Adaptation field cannot be scrambled */
         stime_t i_pcr = GetPCR( p_pkt );
         if( i_pcr >= 0 )
-            PCRHandle( p_demux, p_pid, i_pcr );
+            PCRHandle( p_demux, p_pid, i_pcr,
+                       p_pkt->p_buffer[5] & 0x40 /* random access indicator */ );
 
         /* Probe streams to build PAT/PMT after MIN_PAT_INTERVAL in case we don't see any PAT */
         if( !SEEN( GetPID( p_sys, 0 ) ) &&
@@ -767,6 +835,9 @@ static int Demux( demux_t *p_demux )
             break;
     }
 
+    ConsumeTSPackets( p_demux );
+    ProbePendingBounds( p_demux );
+
     demux_UpdateTitleFromStream( p_demux );
     return VLC_DEMUXER_SUCCESS;
 }
@@ -1809,11 +1880,17 @@ static block_t* ReadTSPacket( demux_t *p_demux )
 
             while( i_skip < i_peek - p_sys->i_packet_size )
             {
-                if( p_peek[i_skip + p_sys->i_packet_header_size] == 0x47 &&
-                        p_peek[i_skip + p_sys->i_packet_header_size + p_sys->i_packet_size] == 0x47 )
+                /* jump to the next candidate sync byte */
+                const uint8_t *p_sync = memchr( &p_peek[i_skip + p_sys->i_packet_header_size],
+                                                0x47, i_peek - p_sys->i_packet_size - i_skip );
+                if( p_sync == NULL )
                 {
+                    i_skip = i_peek - p_sys->i_packet_size;
                     break;
                 }
+                i_skip = p_sync - p_peek - p_sys->i_packet_header_size;
+                if( p_sync[p_sys->i_packet_size] == 0x47 )
+                    break;
                 i_skip++;
             }
             msg_Dbg( p_demux, "skipping %d bytes of garbage", i_skip );
@@ -1834,6 +1911,83 @@ static block_t* ReadTSPacket( demux_t *p_demux )
     return p_pkt;
 }
 
+static void TSPacketViewRelease( block_t *p_pkt )
+{
+    VLC_UNUSED(p_pkt);
+}
+
+static const struct vlc_block_callbacks TSPacketViewCbs =
+{
+    TSPacketViewRelease,
+};
+
+/* Packets are peeked by batches, and parsed in place from the stream
+ * buffer. They are only consumed when the demux call is done, or
+ * before anything else touches the stream. */
+static block_t* ReadTSPacketBatched( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    /* the stream can also be replaced by a filter (ARIB CAM) */
+    if( p_sys->batch.i_pos + p_sys->i_packet_size > p_sys->batch.i_peek ||
+        p_sys->batch.s != p_sys->stream )
+    {
+        ConsumeTSPackets( p_demux );
+        p_sys->batch.s = p_sys->stream;
+        ssize_t i_peek = vlc_stream_Peek( p_sys->stream, &p_sys->batch.p_peek,
+                                          p_sys->i_packet_size * TS_BATCH_PACKETS );
+        if( i_peek < (ssize_t) p_sys->i_packet_size )
+            return ReadTSPacket( p_demux ); /* handles EOF and truncation */
+        p_sys->batch.i_peek = i_peek - i_peek % p_sys->i_packet_size;
+    }
+
+    const uint8_t *p = &p_sys->batch.p_peek[p_sys->batch.i_pos];
+    if( p[p_sys->i_packet_header_size] != 0x47 )
+    {
+        /* regular path does the resync */
+        ConsumeTSPackets( p_demux );
+        return ReadTSPacket( p_demux );
+    }
+    p_sys->batch.i_pos += p_sys->i_packet_size;
+
+    /* Skip header (BluRay streams), see ReadTSPacket */
+    return block_Init( &p_sys->batch.view, &TSPacketViewCbs,
+                       (uint8_t *) &p[p_sys->i_packet_header_size],
+                       p_sys->i_packet_size - p_sys->i_packet_header_size );
+}
+
+static void ConsumeTSPackets( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( p_sys->batch.i_pos > 0 &&
+        vlc_stream_Read( p_sys->batch.s, NULL, p_sys->batch.i_pos ) < (ssize_t) p_sys->batch.i_pos )
+        msg_Warn( p_demux, "could not consume peeked packets" );
+    p_sys->batch.p_peek = NULL;
+    p_sys->batch.i_peek = 0;
+    p_sys->batch.i_pos = 0;
+}
+
+/* Packets from a batch must be copied when kept or modified.
+ * Also skips the first i_skip bytes */
+static block_t* DetachTSPacket( demux_sys_t *p_sys, block_t *p_pkt, size_t i_skip )
+{
+    if( p_pkt != &p_sys->batch.view )
+    {
+        p_pkt->p_buffer += i_skip;
+        p_pkt->i_buffer -= i_skip;
+        return p_pkt;
+    }
+
+    block_t *p_copy = block_Alloc( p_pkt->i_buffer - i_skip );
+    if( likely(p_copy) )
+    {
+        memcpy( p_copy->p_buffer, &p_pkt->p_buffer[i_skip], p_copy->i_buffer );
+        p_copy->i_flags = p_pkt->i_flags;
+    }
+    return p_copy;
+}
+
 static stime_t GetPCR( const block_t *p_pkt )
 {
     const uint8_t *p = p_pkt->p_buffer;
@@ -1956,6 +2110,15 @@ static int SeekToTime( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_scaled
     if( i_head_pos >= i_tail_pos )
         return VLC_EGENERIC;
 
+    /* Direct hit from the index, or narrowed search range */
+    if( p_sys->p_index )
+    {
+        uint64_t i_pos;
+        if( ts_index_Find( p_sys->p_index, p_pmt->i_number, i_scaledtime,
+                           &i_pos, &i_head_pos, &i_tail_pos ) )
+            return vlc_stream_Seek( p_sys->stream, i_pos );
+    }
+
     bool b_found = false;
     while( (i_head_pos + p_sys->i_packet_size) <= i_tail_pos && !b_found )
     {
@@ -2206,6 +2369,29 @@ int ProbeEnd( demux_t *p_demux, int i_program )
     return (b_found) ? VLC_SUCCESS : VLC_EGENERIC;
 }
 
+/* Probes the boundaries of the programs seen while parsing the last
+ * batch of packets, which must have been consumed */
+static void ProbePendingBounds( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    ts_pid_t *patpid = GetPID(p_sys, 0);
+
+    if( patpid->type != TYPE_PAT )
+        return;
+
+    ts_pat_t *p_pat = patpid->u.p_pat;
+    for( int i = 0; i < p_pat->programs.i_size; i++ )
+    {
+        ts_pmt_t *p_pmt = p_pat->programs.p_elems[i]->u.p_pmt;
+        if( p_pmt->b_probe_pending )
+        {
+            p_pmt->b_probe_pending = false;
+            ProbeStart( p_demux, p_pmt->i_number );
+            ProbeEnd( p_demux, p_pmt->i_number );
+        }
+    }
+}
+
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
@@ -2250,15 +2436,17 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr )
     {
         es_out_Control( p_demux->out, ES_OUT_SET_GROUP_PCR, p_pmt->i_number, FROM_SCALE(i_pcr) );
         /* growing files/named fifo handling */
+        /* including the packets parsed but not consumed yet */
+        const uint64_t i_pos = vlc_stream_Tell( p_sys->stream ) + p_sys->batch.i_pos;
         if( p_sys->b_access_control == false &&
-            vlc_stream_Tell( p_sys->stream ) > p_pmt->i_last_dts_byte )
+            i_pos > p_pmt->i_last_dts_byte )
         {
             if( p_pmt->i_last_dts_byte == 0 ) /* first run */
                 p_pmt->i_last_dts_byte = stream_Size( p_sys->stream );
             else
             {
                 p_pmt->i_last_dts = i_pcr;
-                p_pmt->i_last_dts_byte = vlc_stream_Tell( p_sys->stream );
+                p_pmt->i_last_dts_byte = i_pos;
             }
         }
     }
@@ -2352,7 +2540,23 @@ static void PCRCheckDTS( demux_t *p_demux, ts_pmt_t *p_pmt, stime_t i_pcr)
     }
 }
 
-static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr )
+static void SeekIndexAdd( demux_t *p_demux, const ts_pmt_t *p_pmt, stime_t i_pcr, bool b_rap )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    if( !p_sys->p_index || p_pmt->pcr.i_first == -1 )
+        return;
+
+    /* start of the current packet, including the batched ones not yet consumed */
+    const uint64_t i_pos = vlc_stream_Tell( p_sys->stream ) + p_sys->batch.i_pos;
+    if( i_pos < p_sys->i_packet_size )
+        return;
+
+    ts_index_Add( p_sys->p_index, p_pmt->i_number, i_pos - p_sys->i_packet_size,
+                  TimeStampWrapAround( p_pmt->pcr.i_first, i_pcr ), b_rap );
+}
+
+static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr, bool b_rap )
 {
     demux_sys_t   *p_sys = p_demux->p_sys;
 
@@ -2379,6 +2583,7 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr )
             {
                 /* ? update PCR for the whole group program ? */
                 ProgramSetPCR( p_demux, p_pmt, i_program_pcr );
+                SeekIndexAdd( p_demux, p_pmt, i_pcr, b_rap );
             }
         }
         else /* set PCR provided by current pid to program(s) referencing it */
@@ -2389,6 +2594,7 @@ static void PCRHandle( demux_t *p_demux, ts_pid_t *pid, stime_t i_pcr )
                 /* We've found a target group for update */
                 PCRCheckDTS( p_demux, p_pmt, i_pcr );
                 ProgramSetPCR( p_demux, p_pmt, i_program_pcr );
+                SeekIndexAdd( p_demux, p_pmt, i_pcr, b_rap );
             }
         }
 
@@ -2502,6 +2708,10 @@ static block_t * ProcessTSPacket( demux_t *p_demux, ts_pid_t *pid, block_t *p_pk
     {
         if( p_sys->csa )
         {
+            /* decrypted in place */
+            if( !(p_pkt = DetachTSPacket( p_sys, p_pkt, 0 )) )
+                return NULL;
+            p = p_pkt->p_buffer;
             vlc_mutex_lock( &p_sys->csa_lock );
             csa_Decrypt( p_sys->csa, p_pkt->p_buffer, p_sys->i_csa_pkt_size );
             vlc_mutex_unlock( &p_sys->csa_lock );
@@ -2619,8 +2829,9 @@ static bool GatherPESData( demux_t *p_demux, ts_pid_t *p_pid, block_t *p_pkt, si
                                  .priv = p_pid,
                                  .pf_parse = PESDataChainHandle };
     const bool b_unit_start = p_pkt->p_buffer[1]&0x40;
-    p_pkt->p_buffer += i_skip; /* point to PES */
-    p_pkt->i_buffer -= i_skip;
+    /* point to PES, only gathered payloads get copied out of batches */
+    if( !(p_pkt = DetachTSPacket( p_sys, p_pkt, i_skip )) )
+        return false;
     return ts_pes_Gather( &cb, p_pid->u.p_stream,
                           p_pkt, b_unit_start,
                           p_sys->b_valid_scrambling );
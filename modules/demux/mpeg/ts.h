@@ -24,6 +24,7 @@
     typedef struct arib_instance_t arib_instance_t;
 #endif
 typedef struct csa_t csa_t;
+typedef struct ts_index_t ts_index_t;
 
 #define TS_USER_PMT_NUMBER (0)
 
@@ -71,9 +72,22 @@ struct demux_sys_t
     /* how many TS packet we read at once */
     unsigned    i_ts_read;
 
+    /* Packets peeked at once from the stream, and parsed in place */
+    struct
+    {
+        const uint8_t *p_peek;
+        size_t      i_peek;
+        size_t      i_pos; /* next packet offset, also not yet consumed bytes */
+        stream_t   *s;     /* stream peeked from */
+        block_t     view;  /* current packet */
+    } batch;
+
     bool        b_cc_check;
     bool        b_ignore_time_for_positions;
 
+    /* Persistent PCR seek index, NULL if disabled */
+    ts_index_t  *p_index;
+
     ts_standards_e standard;
 
     struct
@@ -0,0 +1,414 @@
+/*****************************************************************************
+ * ts_index.c : TS demuxer persistent seek index
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include "../seek_index.h"
+#include "timestamps.h"
+#include "ts_index.h"
+
+#define TS_INDEX_MAGIC      "VLCTSIDX"
+#define TS_INDEX_VERSION    1
+#define TS_INDEX_EXT        ".tsidx"
+
+/* one entry per interval, which is also the binary search precision */
+#define TS_INDEX_INTERVAL   TO_SCALE_NZ(VLC_TICK_FROM_MS(500))
+/* how far back from the target we'd rather restart on a random access point */
+#define TS_INDEX_RAP_WINDOW TO_SCALE_NZ(VLC_TICK_FROM_SEC(1))
+
+typedef struct
+{
+    uint64_t i_pos;
+    stime_t  i_time;
+    bool     b_rap;
+} ts_index_entry_t;
+
+typedef struct
+{
+    int                 i_program;
+    bool                b_bounds;
+    ts_index_bounds_t   bounds;
+    ts_index_entry_t   *p_entries;
+    size_t              i_entries;
+    size_t              i_alloc;
+} ts_index_table_t;
+
+struct ts_index_t
+{
+    ts_index_table_t   *p_tables;
+    size_t              i_tables;
+};
+
+ts_index_t * ts_index_New( void )
+{
+    return calloc( 1, sizeof(ts_index_t) );
+}
+
+static void ts_index_Clear( ts_index_t *p_index )
+{
+    for( size_t i=0; i<p_index->i_tables; i++ )
+        free( p_index->p_tables[i].p_entries );
+    free( p_index->p_tables );
+    p_index->p_tables = NULL;
+    p_index->i_tables = 0;
+}
+
+void ts_index_Delete( ts_index_t *p_index )
+{
+    ts_index_Clear( p_index );
+    free( p_index );
+}
+
+static ts_index_table_t * GetTable( const ts_index_t *p_index, int i_program )
+{
+    for( size_t i=0; i<p_index->i_tables; i++ )
+    {
+        if( p_index->p_tables[i].i_program == i_program )
+            return &p_index->p_tables[i];
+    }
+    return NULL;
+}
+
+static ts_index_table_t * CreateTable( ts_index_t *p_index, int i_program )
+{
+    ts_index_table_t *p_table = GetTable( p_index, i_program );
+    if( p_table )
+        return p_table;
+
+    p_table = realloc( p_index->p_tables,
+                       (p_index->i_tables + 1) * sizeof(*p_table) );
+    if( !p_table )
+        return NULL;
+    p_index->p_tables = p_table;
+    p_table = &p_index->p_tables[p_index->i_tables++];
+    memset( p_table, 0, sizeof(*p_table) );
+    p_table->i_program = i_program;
+    return p_table;
+}
+
+static bool EnsureEntries( ts_index_table_t *p_table, size_t i_count )
+{
+    if( i_count <= p_table->i_alloc )
+        return true;
+    size_t i_alloc = __MAX( i_count, p_table->i_alloc ? p_table->i_alloc * 2 : 256 );
+    ts_index_entry_t *p_entries = realloc( p_table->p_entries,
+                                           i_alloc * sizeof(*p_entries) );
+    if( !p_entries )
+        return false;
+    p_table->p_entries = p_entries;
+    p_table->i_alloc = i_alloc;
+    return true;
+}
+
+/* first entry with position >= i_pos */
+static size_t LowerBoundPos( const ts_index_table_t *p_table, uint64_t i_pos )
+{
+    size_t i_low = 0, i_high = p_table->i_entries;
+    while( i_low < i_high )
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_table->p_entries[i_mid].i_pos < i_pos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+/* first entry with time > i_time */
+static size_t UpperBoundTime( const ts_index_table_t *p_table, stime_t i_time )
+{
+    size_t i_low = 0, i_high = p_table->i_entries;
+    while( i_low < i_high )
+    {
+        size_t i_mid = i_low + (i_high - i_low) / 2;
+        if( p_table->p_entries[i_mid].i_time <= i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
+}
+
+void ts_index_Add( ts_index_t *p_index, int i_program, uint64_t i_pos, stime_t i_time, bool b_rap )
+{
+    ts_index_table_t *p_table = CreateTable( p_index, i_program );
+    if( !p_table )
+        return;
+
+    size_t i = LowerBoundPos( p_table, i_pos );
+    ts_index_entry_t *p_prev = (i > 0) ? &p_table->p_entries[i - 1] : NULL;
+    ts_index_entry_t *p_next = (i < p_table->i_entries) ? &p_table->p_entries[i] : NULL;
+
+    if( p_next && p_next->i_pos == i_pos )
+    {
+        p_next->b_rap |= b_rap;
+        return;
+    }
+
+    /* Entries must stay ordered by both time and position,
+     * so anything after a discontinuity is left to the binary search */
+    if( (p_prev && p_prev->i_time >= i_time) ||
+        (p_next && p_next->i_time <= i_time) )
+        return;
+
+    if( p_prev && i_time - p_prev->i_time < TS_INDEX_INTERVAL &&
+        !(b_rap && !p_prev->b_rap) )
+        return;
+
+    if( p_next && p_next->i_time - i_time < TS_INDEX_INTERVAL &&
+        !(b_rap && !p_next->b_rap) )
+        return;
+
+    if( !EnsureEntries( p_table, p_table->i_entries + 1 ) )
+        return;
+
+    memmove( &p_table->p_entries[i + 1], &p_table->p_entries[i],
+             (p_table->i_entries - i) * sizeof(ts_index_entry_t) );
+    p_table->p_entries[i].i_pos = i_pos;
+    p_table->p_entries[i].i_time = i_time;
+    p_table->p_entries[i].b_rap = b_rap;
+    p_table->i_entries++;
+}
+
+bool ts_index_Find( const ts_index_t *p_index, int i_program, stime_t i_time,
+                    uint64_t *pi_pos, uint64_t *pi_head, uint64_t *pi_tail )
+{
+    const ts_index_table_t *p_table = GetTable( p_index, i_program );
+    if( !p_table || !p_table->i_entries )
+        return false;
+
+    size_t i = UpperBoundTime( p_table, i_time );
+    if( i < p_table->i_entries && p_table->p_entries[i].i_pos < *pi_tail )
+        *pi_tail = p_table->p_entries[i].i_pos;
+
+    if( i == 0 )
+        return false;
+
+    const ts_index_entry_t *p_floor = &p_table->p_entries[i - 1];
+    if( p_floor->i_pos > *pi_head )
+        *pi_head = p_floor->i_pos;
+
+    if( i_time - p_floor->i_time >= 2 * TS_INDEX_INTERVAL )
+        return false;
+
+    /* Prefer restarting from a random access point */
+    *pi_pos = p_floor->i_pos;
+    for( size_t j = i; j > 0; j-- )
+    {
+        const ts_index_entry_t *p_entry = &p_table->p_entries[j - 1];
+        if( i_time - p_entry->i_time > TS_INDEX_RAP_WINDOW )
+            break;
+        if( p_entry->b_rap )
+        {
+            *pi_pos = p_entry->i_pos;
+            break;
+        }
+    }
+
+    return true;
+}
+
+void ts_index_SetBounds( ts_index_t *p_index, int i_program, const ts_index_bounds_t *p_bounds )
+{
+    ts_index_table_t *p_table = CreateTable( p_index, i_program );
+    if( p_table )
+    {
+        p_table->bounds = *p_bounds;
+        p_table->b_bounds = true;
+    }
+}
+
+bool ts_index_GetBounds( const ts_index_t *p_index, int i_program, ts_index_bounds_t *p_bounds )
+{
+    const ts_index_table_t *p_table = GetTable( p_index, i_program );
+    if( !p_table || !p_table->b_bounds )
+        return false;
+    *p_bounds = p_table->bounds;
+    return true;
+}
+
+/*****************************************************************************
+ * Storage
+ *****************************************************************************/
+static char * GetIndexDir( vlc_object_t *p_obj )
+{
+    return seek_index_GetDir( p_obj, "ts-seek-index-path", "ts-index" );
+}
+
+static void GetIndexId( seek_index_id_t *p_id, const char *psz_url, uint64_t i_size )
+{
+    p_id->psz_magic = TS_INDEX_MAGIC;
+    p_id->i_version = TS_INDEX_VERSION;
+    p_id->psz_ext = TS_INDEX_EXT;
+    p_id->p_key = psz_url;
+    p_id->i_key = strlen( psz_url );
+    p_id->i_size = i_size;
+    p_id->i_mtime = seek_index_GetModificationTime( psz_url );
+}
+
+static bool WriteTable( FILE *p_file, const ts_index_table_t *p_table )
+{
+    if( !seek_index_Write32( p_file, p_table->i_program ) ||
+        !seek_index_Write32( p_file, p_table->b_bounds ) ||
+        !seek_index_Write64( p_file, p_table->bounds.i_first ) ||
+        !seek_index_Write64( p_file, p_table->bounds.i_first_dts ) ||
+        !seek_index_Write64( p_file, p_table->bounds.i_last ) ||
+        !seek_index_Write64( p_file, p_table->bounds.i_last_pos ) ||
+        !seek_index_Write32( p_file, p_table->i_entries ) )
+        return false;
+
+    for( size_t i=0; i<p_table->i_entries; i++ )
+    {
+        const ts_index_entry_t *p_entry = &p_table->p_entries[i];
+        /* positions are packet aligned, way below 2^63 */
+        if( !seek_index_Write64( p_file, p_entry->i_pos | ((uint64_t)p_entry->b_rap << 63) ) ||
+            !seek_index_Write64( p_file, p_entry->i_time ) )
+            return false;
+    }
+    return true;
+}
+
+static bool ReadTable( FILE *p_file, ts_index_table_t *p_table,
+                       uint64_t i_size, unsigned i_packet_size )
+{
+    uint32_t i_program, i_bounds, i_entries;
+    uint64_t i_first, i_first_dts, i_last, i_last_pos;
+    if( !seek_index_Read32( p_file, &i_program ) ||
+        !seek_index_Read32( p_file, &i_bounds ) ||
+        !seek_index_Read64( p_file, &i_first ) ||
+        !seek_index_Read64( p_file, &i_first_dts ) ||
+        !seek_index_Read64( p_file, &i_last ) ||
+        !seek_index_Read64( p_file, &i_last_pos ) ||
+        !seek_index_Read32( p_file, &i_entries ) )
+        return false;
+
+    p_table->i_program = (int32_t) i_program;
+    p_table->b_bounds = i_bounds;
+    p_table->bounds.i_first = i_first;
+    p_table->bounds.i_first_dts = i_first_dts;
+    p_table->bounds.i_last = i_last;
+    p_table->bounds.i_last_pos = i_last_pos;
+
+    if( i_entries > i_size / i_packet_size ||
+        !EnsureEntries( p_table, i_entries ) )
+        return false;
+
+    for( ; p_table->i_entries < i_entries; p_table->i_entries++ )
+    {
+        ts_index_entry_t *p_entry = &p_table->p_entries[p_table->i_entries];
+        uint64_t i_pos, i_time;
+        if( !seek_index_Read64( p_file, &i_pos ) || !seek_index_Read64( p_file, &i_time ) )
+            return false;
+        p_entry->b_rap = i_pos >> 63;
+        p_entry->i_pos = i_pos & ~(UINT64_C(1) << 63);
+        p_entry->i_time = i_time;
+        if( p_entry->i_pos >= i_size ||
+           (p_table->i_entries && (p_entry[-1].i_pos >= p_entry->i_pos ||
+                                   p_entry[-1].i_time >= p_entry->i_time)) )
+            return false;
+    }
+    return true;
+}
+
+int ts_index_Load( ts_index_t *p_index, vlc_object_t *p_obj, const char *psz_url,
+                   uint64_t i_size, unsigned i_packet_size )
+{
+    char *psz_dir = GetIndexDir( p_obj );
+    if( !psz_dir )
+        return VLC_EGENERIC;
+
+    seek_index_id_t id;
+    GetIndexId( &id, psz_url, i_size );
+    FILE *p_file = seek_index_Open( psz_dir, &id );
+    free( psz_dir );
+    if( !p_file )
+        return VLC_EGENERIC;
+
+    int i_ret = VLC_EGENERIC;
+    uint32_t i_packet, i_tables;
+
+    if( !seek_index_Read32( p_file, &i_packet ) || i_packet != i_packet_size ||
+        !seek_index_Read32( p_file, &i_tables ) || i_tables > UINT16_MAX )
+        goto end;
+
+    ts_index_Clear( p_index );
+    for( uint32_t i=0; i<i_tables; i++ )
+    {
+        ts_index_table_t *p_table = CreateTable( p_index, -1 );
+        if( !p_table || !ReadTable( p_file, p_table, i_size, i_packet_size ) )
+        {
+            ts_index_Clear( p_index );
+            goto end;
+        }
+    }
+
+    msg_Dbg( p_obj, "loaded seek index with %zu program(s)", p_index->i_tables );
+    i_ret = VLC_SUCCESS;
+
+end:
+    fclose( p_file );
+    return i_ret;
+}
+
+typedef struct
+{
+    const ts_index_t *p_index;
+    unsigned i_packet_size;
+} ts_index_writer_t;
+
+static bool WriteIndex( FILE *p_file, const void *p_data )
+{
+    const ts_index_writer_t *p_writer = p_data;
+    const ts_index_t *p_index = p_writer->p_index;
+
+    if( !seek_index_Write32( p_file, p_writer->i_packet_size ) ||
+        !seek_index_Write32( p_file, p_index->i_tables ) )
+        return false;
+    for( size_t i=0; i<p_index->i_tables; i++ )
+    {
+        if( !WriteTable( p_file, &p_index->p_tables[i] ) )
+            return false;
+    }
+    return true;
+}
+
+int ts_index_Save( const ts_index_t *p_index, vlc_object_t *p_obj, const char *psz_url,
+                   uint64_t i_size, unsigned i_packet_size )
+{
+    if( !p_index->i_tables )
+        return VLC_SUCCESS;
+
+    char *psz_dir = GetIndexDir( p_obj );
+    if( !psz_dir )
+        return VLC_EGENERIC;
+
+    seek_index_id_t id;
+    GetIndexId( &id, psz_url, i_size );
+    const ts_index_writer_t writer = {
+        .p_index = p_index,
+        .i_packet_size = i_packet_size,
+    };
+    int i_ret = seek_index_Save( p_obj, psz_dir, &id, WriteIndex, &writer );
+    free( psz_dir );
+    return i_ret;
+}
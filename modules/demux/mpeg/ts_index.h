@@ -0,0 +1,52 @@
+/*****************************************************************************
+ * ts_index.h : TS demuxer persistent seek index
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+#ifndef VLC_TS_INDEX_H
+#define VLC_TS_INDEX_H
+
+/* PCR time to packet offset map, per program, stored per recording
+ * in the cache directory. Times are 90kHz unwrapped against pcr.i_first */
+
+typedef struct ts_index_t ts_index_t;
+
+typedef struct
+{
+    stime_t  i_first;
+    stime_t  i_first_dts;
+    stime_t  i_last;
+    uint64_t i_last_pos;
+} ts_index_bounds_t;
+
+ts_index_t * ts_index_New( void );
+void ts_index_Delete( ts_index_t * );
+
+int  ts_index_Load( ts_index_t *, vlc_object_t *, const char *psz_url,
+                    uint64_t i_size, unsigned i_packet_size );
+int  ts_index_Save( const ts_index_t *, vlc_object_t *, const char *psz_url,
+                    uint64_t i_size, unsigned i_packet_size );
+
+void ts_index_Add( ts_index_t *, int i_program, uint64_t i_pos, stime_t i_time, bool b_rap );
+/* Returns true if an entry is close enough before i_time to seek there directly.
+ * Otherwise narrows [*pi_head, *pi_tail] to the surrounding entries. */
+bool ts_index_Find( const ts_index_t *, int i_program, stime_t i_time,
+                    uint64_t *pi_pos, uint64_t *pi_head, uint64_t *pi_tail );
+
+void ts_index_SetBounds( ts_index_t *, int i_program, const ts_index_bounds_t * );
+bool ts_index_GetBounds( const ts_index_t *, int i_program, ts_index_bounds_t * );
+
+#endif
@@ -0,0 +1,213 @@
+/*****************************************************************************
+ * ts_index_test.c: TS demuxer persistent seek index test
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_url.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "timestamps.h"
+#include "ts_index.h"
+
+#define PACKET_SIZE 188
+#define FILE_SIZE   (PACKET_SIZE * 100)
+#define MTIME       1000000000
+
+#define CHECK(cond) do { \
+    if( !(cond) ) { \
+        fprintf( stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, #cond ); \
+        return 1; \
+    } } while(0)
+
+/* Recordings are indexed by the hash of their url */
+static char * IndexPath( const char *psz_dir, const char *psz_url )
+{
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, psz_url, strlen( psz_url ) );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    char *psz_path;
+    if( !psz_hash ||
+        asprintf( &psz_path, "%s/%s.tsidx", psz_dir, psz_hash ) == -1 )
+        psz_path = NULL;
+    free( psz_hash );
+    return psz_path;
+}
+
+static char * CreateRecording( const char *psz_dir, const char *psz_name )
+{
+    char *psz_path;
+    if( asprintf( &psz_path, "%s/%s", psz_dir, psz_name ) == -1 )
+        return NULL;
+
+    char *psz_url = NULL;
+    FILE *p_file = vlc_fopen( psz_path, "wb" );
+    if( p_file )
+    {
+        bool b_ok = !ftruncate( fileno( p_file ), FILE_SIZE );
+        if( !fclose( p_file ) && b_ok &&
+            !utime( psz_path, &(struct utimbuf){ MTIME, MTIME } ) )
+            psz_url = vlc_path2uri( psz_path, NULL );
+    }
+    free( psz_path );
+    return psz_url;
+}
+
+static int Load( vlc_object_t *p_obj, const char *psz_url,
+                 uint64_t i_size, unsigned i_packet_size )
+{
+    ts_index_t *p_index = ts_index_New();
+    if( !p_index )
+        return VLC_ENOMEM;
+    int i_ret = ts_index_Load( p_index, p_obj, psz_url, i_size, i_packet_size );
+    ts_index_Delete( p_index );
+    return i_ret;
+}
+
+static int Test( vlc_object_t *p_obj, const char *psz_dir )
+{
+    char *psz_url = CreateRecording( psz_dir, "a.ts" );
+    char *psz_other = CreateRecording( psz_dir, "b.ts" );
+    CHECK( psz_url && psz_other );
+    char *psz_index = IndexPath( psz_dir, psz_url );
+    char *psz_other_index = IndexPath( psz_dir, psz_other );
+    CHECK( psz_index && psz_other_index );
+
+    const ts_index_bounds_t bounds = {
+        .i_first = 1000,
+        .i_first_dts = 2000,
+        .i_last = 180000,
+        .i_last_pos = FILE_SIZE - PACKET_SIZE,
+    };
+
+    ts_index_t *p_index = ts_index_New();
+    CHECK( p_index );
+    ts_index_Add( p_index, 1, 0 * PACKET_SIZE, 0, true );
+    ts_index_Add( p_index, 1, 10 * PACKET_SIZE, 45000, false );
+    ts_index_Add( p_index, 1, 20 * PACKET_SIZE, 90000, true );
+    ts_index_Add( p_index, 1, 30 * PACKET_SIZE, 135000, false );
+    ts_index_SetBounds( p_index, 1, &bounds );
+    CHECK( ts_index_Save( p_index, p_obj, psz_url, FILE_SIZE, PACKET_SIZE ) == VLC_SUCCESS );
+    CHECK( ts_index_Save( p_index, p_obj, psz_other, FILE_SIZE, PACKET_SIZE ) == VLC_SUCCESS );
+    ts_index_Delete( p_index );
+
+    /* round trip */
+    p_index = ts_index_New();
+    CHECK( p_index );
+    CHECK( ts_index_Load( p_index, p_obj, psz_url, FILE_SIZE, PACKET_SIZE ) == VLC_SUCCESS );
+
+    ts_index_bounds_t loaded;
+    CHECK( ts_index_GetBounds( p_index, 1, &loaded ) );
+    CHECK( !memcmp( &loaded, &bounds, sizeof(bounds) ) );
+    CHECK( !ts_index_GetBounds( p_index, 2, &loaded ) );
+
+    uint64_t i_pos = 0, i_head = 0, i_tail = FILE_SIZE;
+    CHECK( ts_index_Find( p_index, 1, 100000, &i_pos, &i_head, &i_tail ) );
+    CHECK( i_pos == 20 * PACKET_SIZE ); /* random access point */
+    CHECK( i_head == 20 * PACKET_SIZE && i_tail == 30 * PACKET_SIZE );
+    ts_index_Delete( p_index );
+
+    /* the recording changed */
+    CHECK( Load( p_obj, psz_url, FILE_SIZE + PACKET_SIZE, PACKET_SIZE ) == VLC_EGENERIC );
+    CHECK( Load( p_obj, psz_url, FILE_SIZE, 204 ) == VLC_EGENERIC );
+
+    char *psz_path = vlc_uri2path( psz_url );
+    CHECK( psz_path );
+    int i_touched = utime( psz_path, &(struct utimbuf){ MTIME, MTIME + 1 } );
+    free( psz_path );
+    CHECK( i_touched == 0 );
+    CHECK( Load( p_obj, psz_url, FILE_SIZE, PACKET_SIZE ) == VLC_EGENERIC );
+
+    /* never indexed */
+    CHECK( Load( p_obj, "file:///nonexistent.ts", FILE_SIZE, PACKET_SIZE ) == VLC_EGENERIC );
+
+    /* hash collision: the index of another recording is found */
+    CHECK( vlc_rename( psz_index, psz_other_index ) == 0 );
+    CHECK( Load( p_obj, psz_other, FILE_SIZE, PACKET_SIZE ) == VLC_EGENERIC );
+
+    /* damaged index */
+    p_index = ts_index_New();
+    CHECK( p_index );
+    ts_index_Add( p_index, 1, 0, 0, true );
+    int i_ret = ts_index_Save( p_index, p_obj, psz_other, FILE_SIZE, PACKET_SIZE );
+    ts_index_Delete( p_index );
+    CHECK( i_ret == VLC_SUCCESS );
+    CHECK( Load( p_obj, psz_other, FILE_SIZE, PACKET_SIZE ) == VLC_SUCCESS );
+    CHECK( truncate( psz_other_index, 64 ) == 0 );
+    CHECK( Load( p_obj, psz_other, FILE_SIZE, PACKET_SIZE ) == VLC_EGENERIC );
+
+    vlc_unlink( psz_other_index );
+    free( psz_index );
+    free( psz_other_index );
+    free( psz_url );
+    free( psz_other );
+    return 0;
+}
+
+int main( void )
+{
+    char psz_dir[] = "/tmp/vlc-ts-index-XXXXXX";
+    if( mkdtemp( psz_dir ) == NULL )
+        return 77; /* skipped */
+
+    setenv( "VLC_PLUGIN_PATH", ".", 1 );
+    const char *args[] = { "--quiet" };
+    libvlc_instance_t *vlc = libvlc_new( 1, args );
+    if( vlc == NULL )
+        return 1;
+
+    int ret = 1;
+    vlc_object_t *p_obj = vlc_object_create( vlc->p_libvlc_int, sizeof(*p_obj) );
+    if( p_obj )
+    {
+        var_Create( p_obj, "ts-seek-index-path", VLC_VAR_STRING );
+        var_SetString( p_obj, "ts-seek-index-path", psz_dir );
+        ret = Test( p_obj, psz_dir );
+        vlc_object_delete( p_obj );
+    }
+    libvlc_release( vlc );
+
+    char *psz_path;
+    if( asprintf( &psz_path, "%s/a.ts", psz_dir ) != -1 )
+    {
+        vlc_unlink( psz_path );
+        free( psz_path );
+    }
+    if( asprintf( &psz_path, "%s/b.ts", psz_dir ) != -1 )
+    {
+        vlc_unlink( psz_path );
+        free( psz_path );
+    }
+    rmdir( psz_dir );
+    return ret;
+}
@@ -43,6 +43,7 @@
 #include "ts_strings.h"
 
 #include "timestamps.h"
+#include "ts_index.h"
 
 #include "../../codec/jpeg2000.h"
 #include "../../codec/opus_header.h"
@@ -2169,9 +2170,23 @@ static void PMTCallBack( void *data, dvbpsi_pmt_t *p_dvbpsipmt )
     /* Probe Boundaries */
     if( p_sys->b_canfastseek && p_pmt->i_last_dts == TS_TICK_UNKNOWN )
     {
-        p_pmt->i_last_dts = 0;
-        ProbeStart( p_demux, p_pmt->i_number );
-        ProbeEnd( p_demux, p_pmt->i_number );
+        ts_index_bounds_t bounds;
+        if( p_sys->p_index &&
+            ts_index_GetBounds( p_sys->p_index, p_pmt->i_number, &bounds ) )
+        {
+            /* Unchanged file, already probed */
+            p_pmt->pcr.i_first = bounds.i_first;
+            p_pmt->pcr.i_first_dts = bounds.i_first_dts;
+            p_pmt->i_last_dts = bounds.i_last;
+            p_pmt->i_last_dts_byte = bounds.i_last_pos;
+        }
+        else
+        {
+            /* Probing seeks, and would invalidate the batched packets
+             * being parsed: done by the demuxer once they are consumed */
+            p_pmt->i_last_dts = 0;
+            p_pmt->b_probe_pending = true;
+        }
     }
 
     dvbpsi_pmt_delete( p_dvbpsipmt );
@@ -123,6 +123,7 @@ ts_pmt_t *ts_pmt_New( demux_t *p_demux )
 
     pmt->i_last_dts = TS_TICK_UNKNOWN;
     pmt->i_last_dts_byte = 0;
+    pmt->b_probe_pending = false;
 
     pmt->p_atsc_si_basepid      = NULL;
     pmt->p_si_sdt_pid = NULL;
@@ -75,6 +75,7 @@ struct ts_pmt_t
 
     stime_t i_last_dts;
     uint64_t i_last_dts_byte;
+    bool     b_probe_pending; /* boundaries probed once packets are consumed */
 
     /* ARIB specific */
     struct
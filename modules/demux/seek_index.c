@@ -0,0 +1,207 @@
+/*****************************************************************************
+ * seek_index.c: persistent demuxer seek indexes
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_configuration.h>
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_url.h>
+
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "seek_index.h"
+
+char * seek_index_GetDir( vlc_object_t *p_obj, const char *psz_var, const char *psz_name )
+{
+    char *psz_dir;
+    if( psz_var )
+    {
+        psz_dir = var_InheritString( p_obj, psz_var );
+        if( psz_dir && *psz_dir )
+            return psz_dir;
+        free( psz_dir );
+    }
+
+    char *psz_cache = config_GetUserDir( VLC_CACHE_DIR );
+    if( !psz_cache )
+        return NULL;
+    if( asprintf( &psz_dir, "%s" DIR_SEP "%s", psz_cache, psz_name ) == -1 )
+        psz_dir = NULL;
+    free( psz_cache );
+    return psz_dir;
+}
+
+/* a media rewritten in place keeps its url, and often its size */
+int64_t seek_index_GetModificationTime( const char *psz_url )
+{
+    int64_t i_mtime = 0;
+    char *psz_path = vlc_uri2path( psz_url );
+    if( psz_path )
+    {
+        struct stat st;
+        if( vlc_stat( psz_path, &st ) == 0 )
+            i_mtime = st.st_mtime;
+        free( psz_path );
+    }
+    return i_mtime;
+}
+
+static char * GetPath( const char *psz_dir, const seek_index_id_t *p_id )
+{
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, p_id->p_key, p_id->i_key );
+    EndMD5( &md5 );
+
+    char *psz_hash = psz_md5_hash( &md5 );
+    if( !psz_hash )
+        return NULL;
+
+    char *psz_path;
+    if( asprintf( &psz_path, "%s" DIR_SEP "%s%s", psz_dir, psz_hash, p_id->psz_ext ) == -1 )
+        psz_path = NULL;
+    free( psz_hash );
+    return psz_path;
+}
+
+bool seek_index_Write32( FILE *p_file, uint32_t i_val )
+{
+    uint8_t buf[4];
+    SetDWBE( buf, i_val );
+    return fwrite( buf, 4, 1, p_file ) == 1;
+}
+
+bool seek_index_Write64( FILE *p_file, uint64_t i_val )
+{
+    uint8_t buf[8];
+    SetQWBE( buf, i_val );
+    return fwrite( buf, 8, 1, p_file ) == 1;
+}
+
+bool seek_index_Read32( FILE *p_file, uint32_t *pi_val )
+{
+    uint8_t buf[4];
+    if( fread( buf, 4, 1, p_file ) != 1 )
+        return false;
+    *pi_val = GetDWBE( buf );
+    return true;
+}
+
+bool seek_index_Read64( FILE *p_file, uint64_t *pi_val )
+{
+    uint8_t buf[8];
+    if( fread( buf, 8, 1, p_file ) != 1 )
+        return false;
+    *pi_val = GetQWBE( buf );
+    return true;
+}
+
+FILE * seek_index_Open( const char *psz_dir, const seek_index_id_t *p_id )
+{
+    char *psz_path = GetPath( psz_dir, p_id );
+    if( !psz_path )
+        return NULL;
+
+    FILE *p_file = vlc_fopen( psz_path, "rb" );
+    free( psz_path );
+    if( !p_file )
+        return NULL;
+
+    char magic[8];
+    uint32_t i_version, i_keylen;
+    uint64_t i_size, i_mtime;
+    if( fread( magic, 8, 1, p_file ) != 1 ||
+        memcmp( magic, p_id->psz_magic, 8 ) ||
+        !seek_index_Read32( p_file, &i_version ) || i_version != p_id->i_version ||
+        !seek_index_Read64( p_file, &i_size ) || i_size != p_id->i_size ||
+        !seek_index_Read64( p_file, &i_mtime ) || (int64_t) i_mtime != p_id->i_mtime ||
+        !seek_index_Read32( p_file, &i_keylen ) || i_keylen != p_id->i_key )
+        goto error;
+
+    /* rule out hash collisions */
+    if( p_id->i_key )
+    {
+        void *p_stored = malloc( p_id->i_key );
+        bool b_match = p_stored &&
+                       fread( p_stored, p_id->i_key, 1, p_file ) == 1 &&
+                       !memcmp( p_stored, p_id->p_key, p_id->i_key );
+        free( p_stored );
+        if( !b_match )
+            goto error;
+    }
+
+    return p_file;
+
+error:
+    fclose( p_file );
+    return NULL;
+}
+
+int seek_index_Save( vlc_object_t *p_obj, const char *psz_dir, const seek_index_id_t *p_id,
+                     bool (*pf_write)( FILE *, const void * ), const void *p_data )
+{
+    if( vlc_mkdir( psz_dir, 0700 ) && errno != EEXIST )
+    {
+        msg_Warn( p_obj, "can't create seek index directory %s", psz_dir );
+        return VLC_EGENERIC;
+    }
+
+    char *psz_path = GetPath( psz_dir, p_id );
+    if( !psz_path )
+        return VLC_ENOMEM;
+
+    char *psz_tmp;
+    if( asprintf( &psz_tmp, "%s.tmp", psz_path ) == -1 )
+    {
+        free( psz_path );
+        return VLC_ENOMEM;
+    }
+
+    int i_ret = VLC_EGENERIC;
+    FILE *p_file = vlc_fopen( psz_tmp, "wb" );
+    if( p_file )
+    {
+        bool b_ok = fwrite( p_id->psz_magic, 8, 1, p_file ) == 1 &&
+                    seek_index_Write32( p_file, p_id->i_version ) &&
+                    seek_index_Write64( p_file, p_id->i_size ) &&
+                    seek_index_Write64( p_file, p_id->i_mtime ) &&
+                    seek_index_Write32( p_file, p_id->i_key ) &&
+                    ( !p_id->i_key ||
+                      fwrite( p_id->p_key, p_id->i_key, 1, p_file ) == 1 ) &&
+                    pf_write( p_file, p_data );
+
+        if( fclose( p_file ) == 0 && b_ok &&
+            vlc_rename( psz_tmp, psz_path ) == 0 )
+            i_ret = VLC_SUCCESS;
+        else
+            vlc_unlink( psz_tmp );
+    }
+
+    if( i_ret != VLC_SUCCESS )
+        msg_Warn( p_obj, "can't write seek index %s", psz_path );
+
+    free( psz_tmp );
+    free( psz_path );
+    return i_ret;
+}
@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * seek_index.h: persistent demuxer seek indexes
+ *****************************************************************************
+ * Copyright (C) 2020 - VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_DEMUX_SEEK_INDEX_H
+#define VLC_DEMUX_SEEK_INDEX_H
+
+#include <stdio.h>
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/* Indexes built while playing are stored in the cache directory, one file
+ * per indexed media named after the hash of its key. The file starts with
+ * a header identifying the media, which is checked before loading. */
+
+typedef struct
+{
+    const char *psz_magic;  /* 8 characters */
+    uint32_t    i_version;
+    const char *psz_ext;    /* of the index files */
+    const void *p_key;      /* identifies the media, its url for instance */
+    size_t      i_key;
+    uint64_t    i_size;     /* of the media */
+    int64_t     i_mtime;    /* of the media, 0 if unknown */
+} seek_index_id_t;
+
+/* psz_var, if not NULL, names an option overriding the directory */
+char * seek_index_GetDir( vlc_object_t *, const char *psz_var, const char *psz_name );
+int64_t seek_index_GetModificationTime( const char *psz_url );
+
+/* Returns the index file positioned after the header, if it matches */
+FILE * seek_index_Open( const char *psz_dir, const seek_index_id_t * );
+/* Writes the header, then the content with pf_write, replacing the
+ * previous index at once */
+int seek_index_Save( vlc_object_t *, const char *psz_dir, const seek_index_id_t *,
+                     bool (*pf_write)( FILE *, const void * ), const void *p_data );
+
+bool seek_index_Write32( FILE *, uint32_t );
+bool seek_index_Write64( FILE *, uint64_t );
+bool seek_index_Read32( FILE *, uint32_t * );
+bool seek_index_Read64( FILE *, uint64_t * );
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif
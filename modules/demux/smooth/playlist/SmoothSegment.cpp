@@ -45,7 +45,7 @@ void SmoothSegmentChunk::onDownload(block_t **pp_block)
 {
     decrypt(pp_block);
 
-    if(!rep || ((*pp_block)->i_flags & BLOCK_FLAG_HEADER) == 0)
+    if(!rep || !*pp_block || ((*pp_block)->i_flags & BLOCK_FLAG_HEADER) == 0)
         return;
 
     IndexReader br(rep->getPlaylist()->getVLCObject());
@@ -19,11 +19,38 @@
  * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 #include <vlc_bits.h>
+#include <string.h>
+
+/* Escapes can only follow two zero bytes: when the last two bytes weren't
+ * zero, runs up to the next zero byte can be skipped with (vectorized) memchr */
+static inline size_t hxxx_ep3b_skip_nonzero( const uint8_t *p, const uint8_t *end,
+                                             unsigned i_prev, size_t i_max )
+{
+    if( (i_prev & 0x03) || end - p < 2 )
+        return 0;
+    if( i_max > (size_t)(end - p - 1) )
+        i_max = end - p - 1;
+    const uint8_t *z = memchr( p + 1, 0x00, i_max );
+    return z ? (size_t)(z - (p + 1)) : i_max;
+}
 
 static inline uint8_t *hxxx_ep3b_to_rbsp( uint8_t *p, uint8_t *end, unsigned *pi_prev, size_t i_count )
 {
     for( size_t i=0; i<i_count; i++ )
     {
+        if( i_count - i >= 16 )
+        {
+            size_t i_skip = hxxx_ep3b_skip_nonzero( p, end, *pi_prev, i_count - i );
+            if( i_skip )
+            {
+                p += i_skip;
+                i += i_skip;
+                *pi_prev = 0;
+                if( i == i_count )
+                    return p;
+            }
+        }
+
         if( ++p >= end )
             return p;
 
@@ -88,6 +115,13 @@ static size_t hxxx_ep3b_total_size( const uint8_t *p, const uint8_t *p_end )
     size_t i = 0;
     while( p < p_end )
     {
+        size_t i_skip = hxxx_ep3b_skip_nonzero( p, p_end, i_prev, SIZE_MAX );
+        if( i_skip )
+        {
+            p += i_skip;
+            i += i_skip;
+            i_prev = 0;
+        }
         uint8_t *n = hxxx_ep3b_to_rbsp( (uint8_t *)p, (uint8_t *)p_end, &i_prev, 1 );
         if( n > p )
             ++i;
@@ -110,6 +110,10 @@ static void Destroy( vlc_object_t * );
 #define TEXT_DIRECTION_LONGTEXT N_("Paragraph base direction for the Unicode bi-directional algorithm.")
 
 
+#define CACHE_SIZE_TEXT N_("Glyph cache size (kB)")
+#define CACHE_SIZE_LONGTEXT N_("Memory used to keep rendered glyphs and " \
+  "shaped text between subtitles. 0 disables the cache.")
+
 #define YUVP_TEXT N_("Use YUVP renderer")
 #define YUVP_LONGTEXT N_("This renders the font using \"paletized YUV\". " \
   "This option is only needed if you want to encode into DVB subtitles" )
@@ -211,6 +215,9 @@ vlc_module_begin ()
     add_bool( "freetype-yuvp", false, YUVP_TEXT,
               YUVP_LONGTEXT, true )
 
+    add_integer_with_range( "freetype-cache-size", 8192, 0, 262144,
+                            CACHE_SIZE_TEXT, CACHE_SIZE_LONGTEXT, true )
+
 #ifdef HAVE_FRIBIDI
     add_integer_with_range( "freetype-text-direction", 0, 0, 2, TEXT_DIRECTION_TEXT,
                             TEXT_DIRECTION_LONGTEXT, false )
@@ -1519,6 +1526,10 @@ static int Create( vlc_object_t *p_this )
         goto error;
     }
 
+    int64_t i_cache_size = var_InheritInteger( p_filter, "freetype-cache-size" );
+    if( CreateLayoutCaches( p_filter, VLC_CLIP( i_cache_size, 0, 262144 ) * 1024 ) )
+        msg_Warn( p_filter, "Failed to create the glyph caches" );
+
     p_filter->pf_render = Render;
 
     return VLC_SUCCESS;
@@ -1557,6 +1568,9 @@ static void Destroy( vlc_object_t *p_this )
     text_style_Delete( p_sys->p_default_style );
     text_style_Delete( p_sys->p_forced_style );
 
+    /* Caches reference the faces */
+    ReleaseLayoutCaches( p_filter );
+
     /* Fonts dicts */
     vlc_dictionary_clear( &p_sys->fallback_map, FreeFamilies, p_filter );
     vlc_dictionary_clear( &p_sys->face_map, FreeFace, p_filter );
@@ -46,6 +46,8 @@
 #include FT_GLYPH_H
 #include FT_STROKER_H
 
+#include "text_cache.h"
+
 /* Consistency between Freetype versions and platforms */
 #define FT_FLOOR(X)     ((X & -64) >> 6)
 #define FT_CEIL(X)      (((X + 63) & -64) >> 6)
@@ -115,6 +117,15 @@ typedef struct
     /* Current scaling of the text, default is 100 (%) */
     int               i_scale;
 
+    /**
+     * Rendering caches, keyed by face. Faces live in \ref face_map
+     * until the module is closed, so the caches must be released first.
+     * Any of them may be NULL when caching is disabled.
+     */
+    text_cache_t      *p_glyph_cache;   /**< loaded and stroked outlines */
+    text_cache_t      *p_bitmap_cache;  /**< rasterized glyphs */
+    text_cache_t      *p_run_cache;     /**< HarfBuzz shaped runs */
+
     /**
      * Select a font, based on the family, the styles and the codepoint
      */
@@ -0,0 +1,229 @@
+/*****************************************************************************
+ * text_cache.c : Bounded LRU cache for glyphs and shaped runs
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_list.h>
+
+#include "text_cache.h"
+
+#define TEXT_CACHE_MIN_BUCKETS 64
+
+typedef struct text_cache_entry_t text_cache_entry_t;
+
+struct text_cache_entry_t
+{
+    struct vlc_list     node;       /* LRU order, most recent first */
+    text_cache_entry_t *p_next;     /* bucket chain */
+    uint32_t            i_hash;
+    size_t              i_cost;
+    void               *p_value;
+    size_t              i_key;
+    unsigned char       key[];
+};
+
+struct text_cache_t
+{
+    text_cache_entry_t **pp_buckets;
+    size_t               i_buckets; /* power of 2 */
+    struct vlc_list      lru;
+    void               (*pf_free)( void * );
+    text_cache_stats_t   stats;
+};
+
+static uint32_t Hash( const void *p_key, size_t i_key )
+{
+    /* FNV-1a */
+    const unsigned char *p = p_key;
+    uint32_t i_hash = 2166136261u;
+    for( size_t i = 0; i < i_key; i++ )
+    {
+        i_hash ^= p[i];
+        i_hash *= 16777619u;
+    }
+    return i_hash;
+}
+
+static text_cache_entry_t **Lookup( text_cache_t *p_cache, uint32_t i_hash,
+                                    const void *p_key, size_t i_key )
+{
+    text_cache_entry_t **pp_entry =
+        &p_cache->pp_buckets[i_hash & (p_cache->i_buckets - 1)];
+
+    for( ; *pp_entry; pp_entry = &(*pp_entry)->p_next )
+    {
+        const text_cache_entry_t *p_entry = *pp_entry;
+        if( p_entry->i_hash == i_hash && p_entry->i_key == i_key
+         && !memcmp( p_entry->key, p_key, i_key ) )
+            break;
+    }
+    return pp_entry;
+}
+
+static void Evict( text_cache_t *p_cache, text_cache_entry_t *p_entry )
+{
+    text_cache_entry_t **pp_entry =
+        Lookup( p_cache, p_entry->i_hash, p_entry->key, p_entry->i_key );
+    assert( *pp_entry == p_entry );
+    *pp_entry = p_entry->p_next;
+
+    vlc_list_remove( &p_entry->node );
+    p_cache->stats.i_entries--;
+    p_cache->stats.i_bytes -= p_entry->i_cost;
+
+    p_cache->pf_free( p_entry->p_value );
+    free( p_entry );
+}
+
+static void Grow( text_cache_t *p_cache )
+{
+    size_t i_buckets = p_cache->i_buckets * 2;
+    text_cache_entry_t **pp_buckets = calloc( i_buckets, sizeof(*pp_buckets) );
+    if( unlikely(pp_buckets == NULL) )
+        return; /* keep the longer chains */
+
+    for( size_t i = 0; i < p_cache->i_buckets; i++ )
+    {
+        text_cache_entry_t *p_entry = p_cache->pp_buckets[i];
+        while( p_entry )
+        {
+            text_cache_entry_t *p_next = p_entry->p_next;
+            text_cache_entry_t **pp_head =
+                &pp_buckets[p_entry->i_hash & (i_buckets - 1)];
+            p_entry->p_next = *pp_head;
+            *pp_head = p_entry;
+            p_entry = p_next;
+        }
+    }
+
+    free( p_cache->pp_buckets );
+    p_cache->pp_buckets = pp_buckets;
+    p_cache->i_buckets = i_buckets;
+}
+
+text_cache_t *TextCache_New( size_t i_max_bytes, void (*pf_free)( void * ) )
+{
+    text_cache_t *p_cache = malloc( sizeof(*p_cache) );
+    if( unlikely(p_cache == NULL) )
+        return NULL;
+
+    p_cache->i_buckets = TEXT_CACHE_MIN_BUCKETS;
+    p_cache->pp_buckets = calloc( p_cache->i_buckets,
+                                  sizeof(*p_cache->pp_buckets) );
+    if( unlikely(p_cache->pp_buckets == NULL) )
+    {
+        free( p_cache );
+        return NULL;
+    }
+
+    vlc_list_init( &p_cache->lru );
+    p_cache->pf_free = pf_free;
+    memset( &p_cache->stats, 0, sizeof(p_cache->stats) );
+    p_cache->stats.i_max_bytes = i_max_bytes;
+
+    return p_cache;
+}
+
+void TextCache_Delete( text_cache_t *p_cache )
+{
+    text_cache_entry_t *p_entry;
+    vlc_list_foreach( p_entry, &p_cache->lru, node )
+    {
+        p_cache->pf_free( p_entry->p_value );
+        free( p_entry );
+    }
+
+    free( p_cache->pp_buckets );
+    free( p_cache );
+}
+
+void *TextCache_Get( text_cache_t *p_cache, const void *p_key, size_t i_key )
+{
+    text_cache_entry_t *p_entry =
+        *Lookup( p_cache, Hash( p_key, i_key ), p_key, i_key );
+
+    if( p_entry == NULL )
+    {
+        p_cache->stats.i_misses++;
+        return NULL;
+    }
+
+    p_cache->stats.i_hits++;
+    vlc_list_remove( &p_entry->node );
+    vlc_list_prepend( &p_entry->node, &p_cache->lru );
+    return p_entry->p_value;
+}
+
+int TextCache_Put( text_cache_t *p_cache, const void *p_key, size_t i_key,
+                   void *p_value, size_t i_cost )
+{
+    if( i_cost > p_cache->stats.i_max_bytes )
+        return VLC_EGENERIC;
+
+    uint32_t i_hash = Hash( p_key, i_key );
+    if( *Lookup( p_cache, i_hash, p_key, i_key ) != NULL )
+        return VLC_EGENERIC;
+
+    text_cache_entry_t *p_entry = malloc( sizeof(*p_entry) + i_key );
+    if( unlikely(p_entry == NULL) )
+        return VLC_ENOMEM;
+
+    while( p_cache->stats.i_bytes + i_cost > p_cache->stats.i_max_bytes )
+    {
+        text_cache_entry_t *p_last =
+            vlc_list_last_entry_or_null( &p_cache->lru,
+                                         text_cache_entry_t, node );
+        Evict( p_cache, p_last );
+        p_cache->stats.i_evictions++;
+    }
+
+    if( p_cache->stats.i_entries >= p_cache->i_buckets )
+        Grow( p_cache );
+
+    p_entry->i_hash = i_hash;
+    p_entry->i_cost = i_cost;
+    p_entry->p_value = p_value;
+    p_entry->i_key = i_key;
+    memcpy( p_entry->key, p_key, i_key );
+
+    text_cache_entry_t **pp_head =
+        &p_cache->pp_buckets[i_hash & (p_cache->i_buckets - 1)];
+    p_entry->p_next = *pp_head;
+    *pp_head = p_entry;
+    vlc_list_prepend( &p_entry->node, &p_cache->lru );
+
+    p_cache->stats.i_entries++;
+    p_cache->stats.i_bytes += i_cost;
+
+    return VLC_SUCCESS;
+}
+
+void TextCache_GetStats( const text_cache_t *p_cache,
+                         text_cache_stats_t *p_stats )
+{
+    *p_stats = p_cache->stats;
+}
@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * text_cache.h : Bounded LRU cache for glyphs and shaped runs
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation, Inc.,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Bounded LRU cache for glyphs and shaped runs
+ *
+ * Entries are looked up by an opaque binary key and weighted by a cost in
+ * bytes. Once the total cost exceeds the limit given at creation, the least
+ * recently used entries are released with the free callback.
+ *
+ * The cache is not thread-safe, it is only used from the renderer callbacks.
+ */
+
+typedef struct text_cache_t text_cache_t;
+
+typedef struct
+{
+    uint64_t i_hits;
+    uint64_t i_misses;
+    uint64_t i_evictions;
+    size_t   i_entries;
+    size_t   i_bytes;
+    size_t   i_max_bytes;
+} text_cache_stats_t;
+
+/**
+ * Creates a cache
+ *
+ * \param i_max_bytes total cost above which entries get evicted
+ * \param pf_free releases a value, called on eviction and deletion
+ */
+text_cache_t *TextCache_New( size_t i_max_bytes, void (*pf_free)( void * ) );
+
+/**
+ * Releases all entries and the cache itself
+ */
+void TextCache_Delete( text_cache_t *p_cache );
+
+/**
+ * Looks up a value and marks it as most recently used
+ *
+ * The value remains owned by the cache and may be evicted by the next
+ * TextCache_Put() call.
+ *
+ * \return the value or NULL if the key is not cached
+ */
+void *TextCache_Get( text_cache_t *p_cache, const void *p_key, size_t i_key );
+
+/**
+ * Inserts a value
+ *
+ * On success the cache takes ownership of the value. Values costing more
+ * than the whole cache, or keys already cached, are refused and left to the
+ * caller.
+ *
+ * \return VLC_SUCCESS or an error code
+ */
+int TextCache_Put( text_cache_t *p_cache, const void *p_key, size_t i_key,
+                   void *p_value, size_t i_cost );
+
+void TextCache_GetStats( const text_cache_t *p_cache,
+                         text_cache_stats_t *p_stats );
+
+/** @} */
+
+#endif
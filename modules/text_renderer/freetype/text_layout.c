@@ -112,10 +112,26 @@ typedef struct run_desc_t
     hb_glyph_info_t            *p_glyph_infos;
     hb_glyph_position_t        *p_glyph_positions;
     unsigned int                i_glyph_count;
+    struct shaped_run_t        *p_shaped;   /* owned copy of a cached run */
 #endif
 
 } run_desc_t;
 
+/**
+ * Identifies a loaded glyph. Faces are bound to a single size and are kept
+ * until the module is closed, so the face pointer also identifies the size.
+ * Keys are compared as raw bytes and must be zeroed before being filled.
+ */
+typedef struct glyph_cache_key_t
+{
+    FT_Face  p_face;
+    FT_UInt  i_glyph_index;
+    int      i_outline_radius;
+    bool     b_outline;
+    bool     b_embolden;
+    bool     b_oblique;
+} glyph_cache_key_t;
+
 /**
  * Glyph bitmaps. Advance and offset are 26.6 values
  */
@@ -131,6 +147,8 @@ typedef struct glyph_bitmaps_t
     int      i_y_offset;
     int      i_x_advance;
     int      i_y_advance;
+    glyph_cache_key_t cache_key;
+    bool     b_cache_key;   /* cache_key is valid */
 } glyph_bitmaps_t;
 
 typedef struct paragraph_t
@@ -298,6 +316,335 @@ static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox,
     }
 }
 
+/*
+ * Rendering caches
+ *
+ * Loaded outlines are cached per glyph key, and rasterized glyphs per glyph
+ * key, kind and 26.6 pen fraction: a bitmap rendered at a fractional origin
+ * only needs its left/top to be moved to be reused at any whole pixel
+ * position. HarfBuzz output is cached per face, direction, script and text.
+ */
+typedef struct
+{
+    FT_Glyph  p_glyph;
+    FT_Glyph  p_outline;
+    FT_Vector advance;
+} cached_glyph_t;
+
+enum
+{
+    GLYPH_KIND_GLYPH,
+    GLYPH_KIND_OUTLINE,
+};
+
+typedef struct
+{
+    glyph_cache_key_t glyph;
+    uint8_t           i_kind;
+    uint8_t           i_x_frac;
+    uint8_t           i_y_frac;
+} bitmap_cache_key_t;
+
+static size_t GlyphCost( FT_Glyph p_glyph )
+{
+    if( !p_glyph )
+        return 0;
+
+    switch( p_glyph->format )
+    {
+        case FT_GLYPH_FORMAT_OUTLINE:
+        {
+            const FT_Outline *p_outline = &((FT_OutlineGlyph)p_glyph)->outline;
+            return sizeof( FT_OutlineGlyphRec )
+                 + p_outline->n_points * ( sizeof( FT_Vector ) + 1 )
+                 + p_outline->n_contours * sizeof( short );
+        }
+        case FT_GLYPH_FORMAT_BITMAP:
+        {
+            const FT_Bitmap *p_bitmap = &((FT_BitmapGlyph)p_glyph)->bitmap;
+            return sizeof( FT_BitmapGlyphRec )
+                 + (size_t) abs( p_bitmap->pitch ) * p_bitmap->rows;
+        }
+        default:
+            return sizeof( FT_GlyphRec );
+    }
+}
+
+static void FreeCachedGlyph( void *p_data )
+{
+    cached_glyph_t *p_cached = p_data;
+    FT_Done_Glyph( p_cached->p_glyph );
+    if( p_cached->p_outline )
+        FT_Done_Glyph( p_cached->p_outline );
+    free( p_cached );
+}
+
+static void FreeCachedBitmap( void *p_data )
+{
+    FT_Done_Glyph( (FT_Glyph) p_data );
+}
+
+static int CopyCachedGlyph( const cached_glyph_t *p_cached,
+                            glyph_bitmaps_t *p_bitmaps )
+{
+    p_bitmaps->p_outline = 0;
+    if( FT_Glyph_Copy( p_cached->p_glyph, &p_bitmaps->p_glyph ) )
+        return VLC_ENOMEM;
+    if( p_cached->p_outline
+     && FT_Glyph_Copy( p_cached->p_outline, &p_bitmaps->p_outline ) )
+    {
+        FT_Done_Glyph( p_bitmaps->p_glyph );
+        return VLC_ENOMEM;
+    }
+    return VLC_SUCCESS;
+}
+
+static void CacheGlyph( filter_sys_t *p_sys, const glyph_cache_key_t *p_key,
+                        const glyph_bitmaps_t *p_bitmaps,
+                        const FT_Vector *p_advance )
+{
+    cached_glyph_t *p_cached = malloc( sizeof( *p_cached ) );
+    if( !p_cached )
+        return;
+
+    p_cached->advance = *p_advance;
+    p_cached->p_outline = 0;
+    if( FT_Glyph_Copy( p_bitmaps->p_glyph, &p_cached->p_glyph ) )
+    {
+        free( p_cached );
+        return;
+    }
+    if( p_bitmaps->p_outline
+     && FT_Glyph_Copy( p_bitmaps->p_outline, &p_cached->p_outline ) )
+    {
+        FT_Done_Glyph( p_cached->p_glyph );
+        free( p_cached );
+        return;
+    }
+
+    size_t i_cost = sizeof( *p_cached ) + GlyphCost( p_cached->p_glyph )
+                  + GlyphCost( p_cached->p_outline );
+    if( TextCache_Put( p_sys->p_glyph_cache, p_key, sizeof( *p_key ),
+                       p_cached, i_cost ) )
+        FreeCachedGlyph( p_cached );
+}
+
+/**
+ * Same as FT_Glyph_To_Bitmap() in FT_RENDER_MODE_NORMAL, going through the
+ * bitmap cache for the outline glyphs that were loaded with a cache key.
+ * On error the glyph is left untouched.
+ */
+static FT_Error RenderGlyph( filter_sys_t *p_sys, FT_Glyph *pp_glyph,
+                             const glyph_bitmaps_t *p_bitmaps, int i_kind,
+                             FT_Vector *p_pen, bool b_destroy )
+{
+    if( !p_sys->p_bitmap_cache || !p_bitmaps->b_cache_key
+     || (*pp_glyph)->format != FT_GLYPH_FORMAT_OUTLINE )
+        return FT_Glyph_To_Bitmap( pp_glyph, FT_RENDER_MODE_NORMAL,
+                                   p_pen, b_destroy );
+
+    FT_Vector frac = { .x = p_pen->x & 63, .y = p_pen->y & 63 };
+
+    bitmap_cache_key_t key;
+    memset( &key, 0, sizeof( key ) );
+    key.glyph = p_bitmaps->cache_key;
+    key.i_kind = i_kind;
+    key.i_x_frac = frac.x;
+    key.i_y_frac = frac.y;
+
+    FT_Glyph p_bitmap;
+    FT_Glyph p_cached = TextCache_Get( p_sys->p_bitmap_cache,
+                                       &key, sizeof( key ) );
+    if( p_cached )
+    {
+        FT_Error i_error = FT_Glyph_Copy( p_cached, &p_bitmap );
+        if( i_error )
+            return i_error;
+    }
+    else
+    {
+        p_bitmap = *pp_glyph;
+        FT_Error i_error = FT_Glyph_To_Bitmap( &p_bitmap, FT_RENDER_MODE_NORMAL,
+                                               &frac, 0 );
+        if( i_error )
+            return i_error;
+
+        FT_Glyph p_copy;
+        if( !FT_Glyph_Copy( p_bitmap, &p_copy )
+         && TextCache_Put( p_sys->p_bitmap_cache, &key, sizeof( key ),
+                           p_copy, GlyphCost( p_copy ) ) )
+            FT_Done_Glyph( p_copy );
+    }
+
+    FT_BitmapGlyph p_bitmap_glyph = (FT_BitmapGlyph) p_bitmap;
+    p_bitmap_glyph->left += ( p_pen->x - frac.x ) / 64;
+    p_bitmap_glyph->top  += ( p_pen->y - frac.y ) / 64;
+
+    if( b_destroy )
+        FT_Done_Glyph( *pp_glyph );
+    *pp_glyph = p_bitmap;
+    return 0;
+}
+
+#ifdef HAVE_HARFBUZZ
+typedef struct shaped_run_t
+{
+    unsigned int         i_count;
+    hb_glyph_info_t     *p_infos;
+    hb_glyph_position_t *p_positions;
+} shaped_run_t;
+
+typedef struct
+{
+    FT_Face        p_face;
+    hb_direction_t direction;
+    hb_script_t    script;
+} run_cache_key_t;
+
+static shaped_run_t *NewShapedRun( unsigned int i_count,
+                                   const hb_glyph_info_t *p_infos,
+                                   const hb_glyph_position_t *p_positions )
+{
+    shaped_run_t *p_shaped = malloc( sizeof( *p_shaped )
+                                   + i_count * sizeof( *p_infos )
+                                   + i_count * sizeof( *p_positions ) );
+    if( !p_shaped )
+        return NULL;
+
+    p_shaped->i_count = i_count;
+    p_shaped->p_infos = (hb_glyph_info_t *) &p_shaped[1];
+    p_shaped->p_positions = (hb_glyph_position_t *) &p_shaped->p_infos[i_count];
+    memcpy( p_shaped->p_infos, p_infos, i_count * sizeof( *p_infos ) );
+    memcpy( p_shaped->p_positions, p_positions,
+            i_count * sizeof( *p_positions ) );
+    return p_shaped;
+}
+
+static void *NewRunCacheKey( const paragraph_t *p_paragraph,
+                             const run_desc_t *p_run, size_t *pi_key )
+{
+    size_t i_text = ( p_run->i_end_offset - p_run->i_start_offset )
+                  * sizeof( *p_paragraph->p_code_points );
+    run_cache_key_t *p_key = malloc( sizeof( *p_key ) + i_text );
+    if( !p_key )
+        return NULL;
+
+    memset( p_key, 0, sizeof( *p_key ) );
+    p_key->p_face = p_run->p_face;
+    p_key->direction = p_run->direction;
+    p_key->script = p_run->script;
+    memcpy( &p_key[1], p_paragraph->p_code_points + p_run->i_start_offset,
+            i_text );
+
+    *pi_key = sizeof( *p_key ) + i_text;
+    return p_key;
+}
+
+/**
+ * Fills the run with the cached HarfBuzz output for its text, if any
+ */
+static bool LoadCachedRun( filter_sys_t *p_sys, const paragraph_t *p_paragraph,
+                           run_desc_t *p_run )
+{
+    if( !p_sys->p_run_cache )
+        return false;
+
+    size_t i_key;
+    void *p_key = NewRunCacheKey( p_paragraph, p_run, &i_key );
+    if( !p_key )
+        return false;
+
+    const shaped_run_t *p_cached = TextCache_Get( p_sys->p_run_cache,
+                                                  p_key, i_key );
+    free( p_key );
+    if( !p_cached )
+        return false;
+
+    p_run->p_shaped = NewShapedRun( p_cached->i_count, p_cached->p_infos,
+                                    p_cached->p_positions );
+    if( !p_run->p_shaped )
+        return false;
+
+    p_run->p_glyph_infos = p_run->p_shaped->p_infos;
+    p_run->p_glyph_positions = p_run->p_shaped->p_positions;
+    p_run->i_glyph_count = p_run->p_shaped->i_count;
+    return true;
+}
+
+static void CacheShapedRun( filter_sys_t *p_sys, const paragraph_t *p_paragraph,
+                            const run_desc_t *p_run )
+{
+    if( !p_sys->p_run_cache )
+        return;
+
+    size_t i_key;
+    void *p_key = NewRunCacheKey( p_paragraph, p_run, &i_key );
+    if( !p_key )
+        return;
+
+    shaped_run_t *p_shaped = NewShapedRun( p_run->i_glyph_count,
+                                           p_run->p_glyph_infos,
+                                           p_run->p_glyph_positions );
+    size_t i_cost = i_key + sizeof( *p_shaped ) + p_run->i_glyph_count
+                  * ( sizeof( hb_glyph_info_t ) + sizeof( hb_glyph_position_t ) );
+    if( p_shaped && TextCache_Put( p_sys->p_run_cache, p_key, i_key,
+                                   p_shaped, i_cost ) )
+        free( p_shaped );
+    free( p_key );
+}
+#endif
+
+int CreateLayoutCaches( filter_t *p_filter, size_t i_max_bytes )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( i_max_bytes == 0 )
+        return VLC_SUCCESS;
+
+    /* Bitmaps are the most expensive to produce and to store */
+    p_sys->p_glyph_cache = TextCache_New( i_max_bytes / 4, FreeCachedGlyph );
+    p_sys->p_bitmap_cache = TextCache_New( i_max_bytes / 2, FreeCachedBitmap );
+#ifdef HAVE_HARFBUZZ
+    p_sys->p_run_cache = TextCache_New( i_max_bytes / 4, free );
+#endif
+    if( !p_sys->p_glyph_cache || !p_sys->p_bitmap_cache
+#ifdef HAVE_HARFBUZZ
+     || !p_sys->p_run_cache
+#endif
+      )
+    {
+        ReleaseLayoutCaches( p_filter );
+        return VLC_ENOMEM;
+    }
+    return VLC_SUCCESS;
+}
+
+static void ReleaseLayoutCache( filter_t *p_filter, text_cache_t **pp_cache,
+                                const char *psz_name )
+{
+    if( !*pp_cache )
+        return;
+
+    text_cache_stats_t stats;
+    TextCache_GetStats( *pp_cache, &stats );
+    msg_Dbg( p_filter, "%s cache: %"PRIu64" hits, %"PRIu64" misses, "
+             "%"PRIu64" evictions, %zu entries, %zu/%zu bytes", psz_name,
+             stats.i_hits, stats.i_misses, stats.i_evictions,
+             stats.i_entries, stats.i_bytes, stats.i_max_bytes );
+
+    TextCache_Delete( *pp_cache );
+    *pp_cache = NULL;
+}
+
+void ReleaseLayoutCaches( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    ReleaseLayoutCache( p_filter, &p_sys->p_glyph_cache, "glyph" );
+    ReleaseLayoutCache( p_filter, &p_sys->p_bitmap_cache, "bitmap" );
+    ReleaseLayoutCache( p_filter, &p_sys->p_run_cache, "shaped run" );
+}
+
 static paragraph_t *NewParagraph( filter_t *p_filter,
                                   int i_size,
                                   const uni_char_t *p_code_points,
@@ -770,6 +1117,12 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
         else
             p_face = p_run->p_face;
 
+        if( LoadCachedRun( p_sys, p_paragraph, p_run ) )
+        {
+            i_total_glyphs += p_run->i_glyph_count;
+            continue;
+        }
+
         p_run->p_hb_font = hb_ft_font_create( p_face, 0 );
         if( !p_run->p_hb_font )
         {
@@ -812,6 +1165,8 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
             goto error;
         }
 
+        CacheShapedRun( p_sys, p_paragraph, p_run );
+
         i_total_glyphs += p_run->i_glyph_count;
     }
 
@@ -883,8 +1238,11 @@ static int ShapeParagraphHarfBuzz( filter_t *p_filter,
 
     for( int i = 0; i < p_paragraph->i_runs_count; ++i )
     {
-        hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
-        hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        if( p_paragraph->p_runs[ i ].p_hb_font )
+            hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
+        if( p_paragraph->p_runs[ i ].p_buffer )
+            hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        free( p_paragraph->p_runs[ i ].p_shaped );
     }
     FreeParagraph( *p_old_paragraph );
     *p_old_paragraph = p_new_paragraph;
@@ -898,6 +1256,7 @@ error:
             hb_font_destroy( p_paragraph->p_runs[ i ].p_hb_font );
         if( p_paragraph->p_runs[ i ].p_buffer )
             hb_buffer_destroy( p_paragraph->p_runs[ i ].p_buffer );
+        free( p_paragraph->p_runs[ i ].p_shaped );
     }
 
     if( p_new_paragraph )
@@ -1039,12 +1398,20 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
-        if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
+        const bool b_outline =
+            p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE);
+        const bool b_embolden = ( p_style->i_style_flags & STYLE_BOLD )
+                             && !( p_face->style_flags & FT_STYLE_FLAG_BOLD );
+        const bool b_oblique = ( p_style->i_style_flags & STYLE_ITALIC )
+                            && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC );
+        int i_radius = 0;
+
+        if( b_outline )
         {
             double f_outline_thickness =
                 var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
             f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
-            int i_radius = ( i_live_size << 6 ) * f_outline_thickness;
+            i_radius = ( i_live_size << 6 ) * f_outline_thickness;
             FT_Stroker_Set( p_sys->p_stroker,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
@@ -1101,30 +1468,57 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
-                SKIP_GLYPH( p_bitmaps )
+            glyph_cache_key_t *p_key = &p_bitmaps->cache_key;
+            memset( p_key, 0, sizeof( *p_key ) );
+            p_key->p_face = p_face;
+            p_key->i_glyph_index = i_glyph_index;
+            p_key->i_outline_radius = i_radius;
+            p_key->b_outline = b_outline;
+            p_key->b_embolden = b_embolden;
+            p_key->b_oblique = b_oblique;
+
+            const cached_glyph_t *p_cached = NULL;
+            if( p_sys->p_glyph_cache )
+                p_cached = TextCache_Get( p_sys->p_glyph_cache,
+                                          p_key, sizeof( *p_key ) );
+
+            FT_Vector advance;
+            if( p_cached )
+            {
+                if( CopyCachedGlyph( p_cached, p_bitmaps ) )
+                    SKIP_GLYPH( p_bitmaps )
+                advance = p_cached->advance;
+            }
+            else
+            {
+                if( FT_Load_Glyph( p_face, i_glyph_index,
+                                   FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+                 && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
+                if( b_embolden )
+                    FT_GlyphSlot_Embolden( p_face->glyph );
+                if( b_oblique )
+                    FT_GlyphSlot_Oblique( p_face->glyph );
 
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
-                SKIP_GLYPH( p_bitmaps )
+                if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-#undef SKIP_GLYPH
+                if( b_outline )
+                {
+                    p_bitmaps->p_outline = p_bitmaps->p_glyph;
+                    if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
+                                               p_sys->p_stroker, 0, 0 ) )
+                        p_bitmaps->p_outline = 0;
+                }
 
-            if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
-            {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
-                                           p_sys->p_stroker, 0, 0 ) )
-                    p_bitmaps->p_outline = 0;
+                advance = p_face->glyph->advance;
+                if( p_sys->p_glyph_cache )
+                    CacheGlyph( p_sys, p_key, p_bitmaps, &advance );
             }
+            p_bitmaps->b_cache_key = true;
+
+#undef SKIP_GLYPH
 
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
@@ -1132,8 +1526,8 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = advance.x;
+                p_bitmaps->i_y_advance = advance.y;
             }
 
             unsigned i_x_advance = FT_FLOOR( abs( p_bitmaps->i_x_advance ) );
@@ -1240,8 +1634,10 @@ static int LayoutLine( filter_t *p_filter,
 
         if( p_bitmaps->p_shadow )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                    &pen_shadow, 0 ) )
+            int i_shadow_kind = p_bitmaps->p_shadow == p_bitmaps->p_outline ?
+                                GLYPH_KIND_OUTLINE : GLYPH_KIND_GLYPH;
+            if( RenderGlyph( p_sys, &p_bitmaps->p_shadow, p_bitmaps,
+                             i_shadow_kind, &pen_shadow, false ) )
                 p_bitmaps->p_shadow = 0;
             else
                 FT_Glyph_Get_CBox( p_bitmaps->p_shadow, ft_glyph_bbox_pixels,
@@ -1249,8 +1645,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_glyph )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_glyph, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_sys, &p_bitmaps->p_glyph, p_bitmaps,
+                             GLYPH_KIND_GLYPH, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_glyph );
                 if( p_bitmaps->p_outline )
@@ -1265,8 +1661,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_outline )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_outline, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_sys, &p_bitmaps->p_outline, p_bitmaps,
+                             GLYPH_KIND_OUTLINE, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_outline );
                 p_bitmaps->p_outline = 0;
@@ -105,3 +105,17 @@ typedef struct
  */
 int LayoutTextBlock( filter_t *p_filter, const layout_text_block_t *p_textblock,
                      line_desc_t **pp_lines, FT_BBox *p_bbox, int *pi_max_face_height );
+
+/**
+ * Create the glyph, bitmap and shaped run caches used by the layout.
+ *
+ * \param p_filter the FreeType module object [IN]
+ * \param i_max_bytes memory budget shared by the caches, 0 disables them [IN]
+ */
+int CreateLayoutCaches( filter_t *p_filter, size_t i_max_bytes );
+
+/**
+ * Release the layout caches and print their statistics. This must happen
+ * before the font faces are released.
+ */
+void ReleaseLayoutCaches( filter_t *p_filter );
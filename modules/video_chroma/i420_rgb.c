@@ -206,6 +206,7 @@ static int Activate( vlc_object_t *p_this )
 
     p_sys->i_buffer_size = 0;
     p_sys->p_buffer = NULL;
+    p_sys->p_slices = NULL;
     switch( p_filter->fmt_out.video.i_chroma )
     {
 #ifdef PLAIN
@@ -269,6 +270,17 @@ static int Activate( vlc_object_t *p_this )
     video_format_Clean( &vfmt );
 #endif
 
+    /* The conversion and scaling buffers are shared by all the lines, and
+     * the 8 bpp dithering is not split */
+    const video_format_t *p_fmt_in = &p_filter->fmt_in.video;
+    const video_format_t *p_fmt_out = &p_filter->fmt_out.video;
+    if( p_fmt_out->i_chroma != VLC_CODEC_RGB8
+     && p_fmt_in->i_x_offset + p_fmt_in->i_visible_width
+        == p_fmt_out->i_x_offset + p_fmt_out->i_visible_width
+     && p_fmt_in->i_y_offset + p_fmt_in->i_visible_height
+        == p_fmt_out->i_y_offset + p_fmt_out->i_visible_height )
+        p_sys->p_slices = filter_slices_Hold();
+
     return 0;
 }
 
@@ -285,22 +297,64 @@ static void Deactivate( vlc_object_t *p_this )
 #ifdef PLAIN
     free( p_sys->p_base );
 #endif
+    if( p_sys->p_slices )
+        filter_slices_Release( p_sys->p_slices );
     free( p_sys->p_offset );
     free( p_sys->p_buffer );
     free( p_sys );
 }
 
+struct convert_slices
+{
+    filter_t  *p_filter;
+    picture_t *p_src;
+    picture_t *p_dest;
+};
+
+/* Same as VIDEO_FILTER_WRAPPER, with the lines split in slices */
+#define SLICED_FILTER_WRAPPER( name )                                   \
+    static void name ## _Slice( void *opaque, unsigned i_slice,        \
+                                unsigned i_slices )                    \
+    {                                                                   \
+        struct convert_slices *ctx = opaque;                            \
+        const video_format_t *fmt = &ctx->p_filter->fmt_in.video;       \
+        int i_start, i_end;                                             \
+                                                                        \
+        /* Pairs of lines share the 4:2:0 chroma */                     \
+        filter_slices_GetRange( fmt->i_y_offset + fmt->i_visible_height, \
+                                2, i_slice, i_slices, &i_start, &i_end ); \
+        name( ctx->p_filter, ctx->p_src, ctx->p_dest, i_start, i_end ); \
+    }                                                                   \
+                                                                        \
+    static picture_t *name ## _Filter ( filter_t *p_filter,             \
+                                        picture_t *p_pic )              \
+    {                                                                   \
+        filter_sys_t *p_sys = p_filter->p_sys;                          \
+        picture_t *p_outpic = filter_NewPicture( p_filter );            \
+        if( p_outpic )                                                  \
+        {                                                               \
+            struct convert_slices ctx = {                               \
+                .p_filter = p_filter, .p_src = p_pic, .p_dest = p_outpic, \
+            };                                                          \
+            filter_slices_Run( p_sys->p_slices, FILTER_SLICES_MAX,      \
+                               name ## _Slice, &ctx );                  \
+            picture_CopyProperties( p_outpic, p_pic );                  \
+        }                                                               \
+        picture_Release( p_pic );                                       \
+        return p_outpic;                                                \
+    }
+
 #ifndef PLAIN
-VIDEO_FILTER_WRAPPER( I420_R5G5B5 )
-VIDEO_FILTER_WRAPPER( I420_R5G6B5 )
-VIDEO_FILTER_WRAPPER( I420_A8R8G8B8 )
-VIDEO_FILTER_WRAPPER( I420_R8G8B8A8 )
-VIDEO_FILTER_WRAPPER( I420_B8G8R8A8 )
-VIDEO_FILTER_WRAPPER( I420_A8B8G8R8 )
+SLICED_FILTER_WRAPPER( I420_R5G5B5 )
+SLICED_FILTER_WRAPPER( I420_R5G6B5 )
+SLICED_FILTER_WRAPPER( I420_A8R8G8B8 )
+SLICED_FILTER_WRAPPER( I420_R8G8B8A8 )
+SLICED_FILTER_WRAPPER( I420_B8G8R8A8 )
+SLICED_FILTER_WRAPPER( I420_A8B8G8R8 )
 #else
 VIDEO_FILTER_WRAPPER( I420_RGB8 )
-VIDEO_FILTER_WRAPPER( I420_RGB16 )
-VIDEO_FILTER_WRAPPER( I420_RGB32 )
+SLICED_FILTER_WRAPPER( I420_RGB16 )
+SLICED_FILTER_WRAPPER( I420_RGB32 )
 
 /*****************************************************************************
  * SetYUV: compute tables and set function pointers
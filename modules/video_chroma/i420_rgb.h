@@ -40,6 +40,7 @@ typedef struct
     size_t    i_buffer_size;
     uint8_t   i_bytespp;
     int *p_offset;
+    filter_slices_t *p_slices;  /**< worker pool, if not scaling */
 
 #ifdef PLAIN
     /**< Pre-calculated conversion tables */
@@ -80,17 +81,20 @@ static inline int AllocateOrGrow( uint8_t **pp_buffer, size_t *pi_buffer,
 /*****************************************************************************
  * Prototypes
  *****************************************************************************/
+/* Except for RGB8, the conversions only process the source lines
+ * [i_start, i_end), with i_start even. Lines can only be split when
+ * the picture is not scaled. */
 #ifdef PLAIN
 void I420_RGB8         ( filter_t *, picture_t *, picture_t * );
-void I420_RGB16        ( filter_t *, picture_t *, picture_t * );
-void I420_RGB32        ( filter_t *, picture_t *, picture_t * );
+void I420_RGB16        ( filter_t *, picture_t *, picture_t *, int, int );
+void I420_RGB32        ( filter_t *, picture_t *, picture_t *, int, int );
 #else
-void I420_R5G5B5       ( filter_t *, picture_t *, picture_t * );
-void I420_R5G6B5       ( filter_t *, picture_t *, picture_t * );
-void I420_A8R8G8B8     ( filter_t *, picture_t *, picture_t * );
-void I420_R8G8B8A8     ( filter_t *, picture_t *, picture_t * );
-void I420_B8G8R8A8     ( filter_t *, picture_t *, picture_t * );
-void I420_A8B8G8R8     ( filter_t *, picture_t *, picture_t * );
+void I420_R5G5B5       ( filter_t *, picture_t *, picture_t *, int, int );
+void I420_R5G6B5       ( filter_t *, picture_t *, picture_t *, int, int );
+void I420_A8R8G8B8     ( filter_t *, picture_t *, picture_t *, int, int );
+void I420_R8G8B8A8     ( filter_t *, picture_t *, picture_t *, int, int );
+void I420_B8G8R8A8     ( filter_t *, picture_t *, picture_t *, int, int );
+void I420_A8B8G8R8     ( filter_t *, picture_t *, picture_t *, int, int );
 #endif
 
 /*****************************************************************************
@@ -100,15 +100,19 @@ static void SetOffset( int i_width, int i_height, int i_pic_width,
 }
 
 VLC_TARGET
-void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_R5G5B5( filter_t *p_filter, picture_t *p_src,
+                  picture_t *p_dest, int i_start, int i_end )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
     /* We got this one from the old arguments */
-    uint16_t *p_pic = (uint16_t*)p_dest->p->p_pixels;
-    uint8_t  *p_y   = p_src->Y_PIXELS;
-    uint8_t  *p_u   = p_src->U_PIXELS;
-    uint8_t  *p_v   = p_src->V_PIXELS;
+    uint16_t *p_pic = (uint16_t*)( p_dest->p->p_pixels
+                                 + i_start * p_dest->p->i_pitch );
+    uint8_t  *p_y   = p_src->Y_PIXELS + i_start * p_src->p[Y_PLANE].i_pitch;
+    uint8_t  *p_u   = p_src->U_PIXELS
+                     + i_start / 2 * p_src->p[U_PLANE].i_pitch;
+    uint8_t  *p_v   = p_src->V_PIXELS
+                     + i_start / 2 * p_src->p[V_PLANE].i_pitch;
 
     bool  b_hscale;                         /* horizontal scaling type */
     unsigned int i_vscale;                          /* vertical scaling type */
@@ -178,7 +182,7 @@ void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -229,7 +233,7 @@ void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -285,7 +289,7 @@ void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -340,15 +344,19 @@ void I420_R5G5B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 }
 
 VLC_TARGET
-void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_R5G6B5( filter_t *p_filter, picture_t *p_src,
+                  picture_t *p_dest, int i_start, int i_end )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
     /* We got this one from the old arguments */
-    uint16_t *p_pic = (uint16_t*)p_dest->p->p_pixels;
-    uint8_t  *p_y   = p_src->Y_PIXELS;
-    uint8_t  *p_u   = p_src->U_PIXELS;
-    uint8_t  *p_v   = p_src->V_PIXELS;
+    uint16_t *p_pic = (uint16_t*)( p_dest->p->p_pixels
+                                 + i_start * p_dest->p->i_pitch );
+    uint8_t  *p_y   = p_src->Y_PIXELS + i_start * p_src->p[Y_PLANE].i_pitch;
+    uint8_t  *p_u   = p_src->U_PIXELS
+                     + i_start / 2 * p_src->p[U_PLANE].i_pitch;
+    uint8_t  *p_v   = p_src->V_PIXELS
+                     + i_start / 2 * p_src->p[V_PLANE].i_pitch;
 
     bool  b_hscale;                         /* horizontal scaling type */
     unsigned int i_vscale;                          /* vertical scaling type */
@@ -418,7 +426,7 @@ void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -469,7 +477,7 @@ void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -525,7 +533,7 @@ void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -581,15 +589,18 @@ void I420_R5G6B5( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
 VLC_TARGET
 void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
-                                            picture_t *p_dest )
+                                            picture_t *p_dest, int i_start, int i_end )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
     /* We got this one from the old arguments */
-    uint32_t *p_pic = (uint32_t*)p_dest->p->p_pixels;
-    uint8_t  *p_y   = p_src->Y_PIXELS;
-    uint8_t  *p_u   = p_src->U_PIXELS;
-    uint8_t  *p_v   = p_src->V_PIXELS;
+    uint32_t *p_pic = (uint32_t*)( p_dest->p->p_pixels
+                                 + i_start * p_dest->p->i_pitch );
+    uint8_t  *p_y   = p_src->Y_PIXELS + i_start * p_src->p[Y_PLANE].i_pitch;
+    uint8_t  *p_u   = p_src->U_PIXELS
+                     + i_start / 2 * p_src->p[U_PLANE].i_pitch;
+    uint8_t  *p_v   = p_src->V_PIXELS
+                     + i_start / 2 * p_src->p[V_PLANE].i_pitch;
 
     bool  b_hscale;                         /* horizontal scaling type */
     unsigned int i_vscale;                          /* vertical scaling type */
@@ -658,7 +669,7 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -709,7 +720,7 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -765,7 +776,7 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -820,15 +831,19 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
 }
 
 VLC_TARGET
-void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src,
+                    picture_t *p_dest, int i_start, int i_end )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
     /* We got this one from the old arguments */
-    uint32_t *p_pic = (uint32_t*)p_dest->p->p_pixels;
-    uint8_t  *p_y   = p_src->Y_PIXELS;
-    uint8_t  *p_u   = p_src->U_PIXELS;
-    uint8_t  *p_v   = p_src->V_PIXELS;
+    uint32_t *p_pic = (uint32_t*)( p_dest->p->p_pixels
+                                 + i_start * p_dest->p->i_pitch );
+    uint8_t  *p_y   = p_src->Y_PIXELS + i_start * p_src->p[Y_PLANE].i_pitch;
+    uint8_t  *p_u   = p_src->U_PIXELS
+                     + i_start / 2 * p_src->p[U_PLANE].i_pitch;
+    uint8_t  *p_v   = p_src->V_PIXELS
+                     + i_start / 2 * p_src->p[V_PLANE].i_pitch;
 
     bool  b_hscale;                         /* horizontal scaling type */
     unsigned int i_vscale;                          /* vertical scaling type */
@@ -897,7 +912,7 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -948,7 +963,7 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -1004,7 +1019,7 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -1059,15 +1074,19 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 }
 
 VLC_TARGET
-void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src,
+                    picture_t *p_dest, int i_start, int i_end )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
     /* We got this one from the old arguments */
-    uint32_t *p_pic = (uint32_t*)p_dest->p->p_pixels;
-    uint8_t  *p_y   = p_src->Y_PIXELS;
-    uint8_t  *p_u   = p_src->U_PIXELS;
-    uint8_t  *p_v   = p_src->V_PIXELS;
+    uint32_t *p_pic = (uint32_t*)( p_dest->p->p_pixels
+                                 + i_start * p_dest->p->i_pitch );
+    uint8_t  *p_y   = p_src->Y_PIXELS + i_start * p_src->p[Y_PLANE].i_pitch;
+    uint8_t  *p_u   = p_src->U_PIXELS
+                     + i_start / 2 * p_src->p[U_PLANE].i_pitch;
+    uint8_t  *p_v   = p_src->V_PIXELS
+                     + i_start / 2 * p_src->p[V_PLANE].i_pitch;
 
     bool  b_hscale;                         /* horizontal scaling type */
     unsigned int i_vscale;                          /* vertical scaling type */
@@ -1136,7 +1155,7 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -1187,7 +1206,7 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -1243,7 +1262,7 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -1298,15 +1317,19 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 }
 
 VLC_TARGET
-void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
+void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src,
+                    picture_t *p_dest, int i_start, int i_end )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
     /* We got this one from the old arguments */
-    uint32_t *p_pic = (uint32_t*)p_dest->p->p_pixels;
-    uint8_t  *p_y   = p_src->Y_PIXELS;
-    uint8_t  *p_u   = p_src->U_PIXELS;
-    uint8_t  *p_v   = p_src->V_PIXELS;
+    uint32_t *p_pic = (uint32_t*)( p_dest->p->p_pixels
+                                 + i_start * p_dest->p->i_pitch );
+    uint8_t  *p_y   = p_src->Y_PIXELS + i_start * p_src->p[Y_PLANE].i_pitch;
+    uint8_t  *p_u   = p_src->U_PIXELS
+                     + i_start / 2 * p_src->p[U_PLANE].i_pitch;
+    uint8_t  *p_v   = p_src->V_PIXELS
+                     + i_start / 2 * p_src->p[V_PLANE].i_pitch;
 
     bool  b_hscale;                         /* horizontal scaling type */
     unsigned int i_vscale;                          /* vertical scaling type */
@@ -1375,7 +1398,7 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                     ((intptr_t)p_buffer))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -1426,7 +1449,7 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+        for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
         {
             p_pic_start = p_pic;
 
@@ -1482,7 +1505,7 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
 
     i_rewind = (-(p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width)) & 7;
 
-    for( i_y = 0; i_y < (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height); i_y++ )
+    for( i_y = i_start; i_y < (unsigned)i_end; i_y++ )
     {
         p_pic_start = p_pic;
         p_buffer = b_hscale ? p_buffer_start : p_pic;
@@ -61,10 +61,14 @@
  * Local and extern prototypes.
  *****************************************************************************/
 static int  Activate ( vlc_object_t * );
-
-static void I420_YUY2           ( filter_t *, picture_t *, picture_t * );
-static void I420_YVYU           ( filter_t *, picture_t *, picture_t * );
-static void I420_UYVY           ( filter_t *, picture_t *, picture_t * );
+static void Deactivate ( vlc_object_t * );
+
+static void I420_YUY2           ( filter_t *, picture_t *, picture_t *,
+                                  int, int );
+static void I420_YVYU           ( filter_t *, picture_t *, picture_t *,
+                                  int, int );
+static void I420_UYVY           ( filter_t *, picture_t *, picture_t *,
+                                  int, int );
 static picture_t *I420_YUY2_Filter    ( filter_t *, picture_t * );
 static picture_t *I420_YVYU_Filter    ( filter_t *, picture_t * );
 static picture_t *I420_UYVY_Filter    ( filter_t *, picture_t * );
@@ -73,7 +77,8 @@ static void I420_IUYV           ( filter_t *, picture_t *, picture_t * );
 static picture_t *I420_IUYV_Filter    ( filter_t *, picture_t * );
 #endif
 #if defined (MODULE_NAME_IS_i420_yuy2)
-static void I420_Y211           ( filter_t *, picture_t *, picture_t * );
+static void I420_Y211           ( filter_t *, picture_t *, picture_t *,
+                                  int, int );
 static picture_t *I420_Y211_Filter    ( filter_t *, picture_t * );
 #endif
 
@@ -99,7 +104,7 @@ vlc_module_begin ()
     set_capability( "video converter", 250 )
 # define vlc_CPU_capable() vlc_CPU_ALTIVEC()
 #endif
-    set_callback( Activate )
+    set_callbacks( Activate, Deactivate )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -162,9 +167,23 @@ static int Activate( vlc_object_t *p_this )
             return -1;
     }
 
+    /* The worker pool, or NULL on a single CPU */
+    p_filter->p_sys = filter_slices_Hold();
     return 0;
 }
 
+/*****************************************************************************
+ * Deactivate: release the worker pool
+ *****************************************************************************/
+static void Deactivate( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_slices_t *p_slices = p_filter->p_sys;
+
+    if( p_slices )
+        filter_slices_Release( p_slices );
+}
+
 #if 0
 static inline unsigned long long read_cycles(void)
 {
@@ -177,14 +196,60 @@ static inline unsigned long long read_cycles(void)
 
 /* Following functions are local */
 
-VIDEO_FILTER_WRAPPER( I420_YUY2 )
-VIDEO_FILTER_WRAPPER( I420_YVYU )
-VIDEO_FILTER_WRAPPER( I420_UYVY )
+/* The conversions process source lines [i_start, i_end) in pairs, sharing
+ * the 4:2:0 chroma line; AltiVec may take 4 lines at a time. */
+#if defined (MODULE_NAME_IS_i420_yuy2_altivec)
+#   define SLICE_ALIGN 4
+#else
+#   define SLICE_ALIGN 2
+#endif
+
+struct convert_slices
+{
+    filter_t  *p_filter;
+    picture_t *p_src;
+    picture_t *p_dest;
+};
+
+#define SLICED_FILTER_WRAPPER( name )                                   \
+    static void name ## _Slice( void *opaque, unsigned i_slice,        \
+                                unsigned i_slices )                    \
+    {                                                                   \
+        struct convert_slices *ctx = opaque;                            \
+        const video_format_t *fmt = &ctx->p_filter->fmt_in.video;       \
+        int i_start, i_end;                                             \
+                                                                        \
+        filter_slices_GetRange( fmt->i_y_offset + fmt->i_visible_height, \
+                                SLICE_ALIGN, i_slice, i_slices,         \
+                                &i_start, &i_end );                     \
+        name( ctx->p_filter, ctx->p_src, ctx->p_dest, i_start, i_end ); \
+    }                                                                   \
+                                                                        \
+    static picture_t *name ## _Filter ( filter_t *p_filter,             \
+                                        picture_t *p_pic )              \
+    {                                                                   \
+        picture_t *p_outpic = filter_NewPicture( p_filter );            \
+        if( p_outpic )                                                  \
+        {                                                               \
+            struct convert_slices ctx = {                               \
+                .p_filter = p_filter, .p_src = p_pic, .p_dest = p_outpic, \
+            };                                                          \
+            filter_slices_Run( p_filter->p_sys, FILTER_SLICES_MAX,      \
+                               name ## _Slice, &ctx );                  \
+            picture_CopyProperties( p_outpic, p_pic );                  \
+        }                                                               \
+        picture_Release( p_pic );                                       \
+        return p_outpic;                                                \
+    }
+
+SLICED_FILTER_WRAPPER( I420_YUY2 )
+SLICED_FILTER_WRAPPER( I420_YVYU )
+SLICED_FILTER_WRAPPER( I420_UYVY )
 #if !defined (MODULE_NAME_IS_i420_yuy2_altivec)
 VIDEO_FILTER_WRAPPER( I420_IUYV )
 #endif
 #if defined (MODULE_NAME_IS_i420_yuy2)
-VIDEO_FILTER_WRAPPER( I420_Y211 )
+SLICED_FILTER_WRAPPER( I420_Y211 )
 #endif
 
 /*****************************************************************************
@@ -192,12 +257,17 @@ VIDEO_FILTER_WRAPPER( I420_Y211 )
  *****************************************************************************/
 VLC_TARGET
 static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+                                           picture_t *p_dest,
+                       int i_start, int i_end )
 {
-    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels;
-    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS;
-    uint8_t *p_u = p_source->U_PIXELS;
-    uint8_t *p_v = p_source->V_PIXELS;
+    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels
+                               + i_start * p_dest->p->i_pitch;
+    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS
+                         + i_start * p_source->p[Y_PLANE].i_pitch;
+    uint8_t *p_u = p_source->U_PIXELS
+                 + i_start / 2 * p_source->p[U_PLANE].i_pitch;
+    uint8_t *p_v = p_source->V_PIXELS
+                 + i_start / 2 * p_source->p[V_PLANE].i_pitch;
 
     int i_x, i_y;
 
@@ -227,10 +297,10 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
     vector unsigned char y_vec;
 
     if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 32 ) |
-           ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 2 ) ) )
+           ( (i_end - i_start) % 2 ) ) )
     {
         /* Width is a multiple of 32, we take 2 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
         {
             VEC_NEXT_LINES( );
             for( i_x = (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) / 32 ; i_x-- ; )
@@ -244,10 +314,10 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
 #warning FIXME: converting widths % 16 but !widths % 32 is broken on altivec
 #if 0
     else if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 16 ) |
-                ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 4 ) ) )
+                ( (i_end - i_start) % 4 ) ) )
     {
         /* Width is only a multiple of 16, we take 4 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 4 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 4 ; i_y-- ; )
         {
             /* Line 1 and 2, pixels 0 to ( width - 16 ) */
             VEC_NEXT_LINES( );
@@ -295,7 +365,7 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
                                - ( p_filter->fmt_out.video.i_x_offset * 2 );
 
 #if !defined(MODULE_NAME_IS_i420_yuy2_sse2)
-    for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+    for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
     {
         p_line1 = p_line2;
         p_line2 += p_dest->p->i_pitch;
@@ -344,7 +414,7 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
         ((intptr_t)p_line2|(intptr_t)p_y2))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -370,7 +440,7 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -404,12 +474,17 @@ static void I420_YUY2( filter_t *p_filter, picture_t *p_source,
  *****************************************************************************/
 VLC_TARGET
 static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+                                           picture_t *p_dest,
+                       int i_start, int i_end )
 {
-    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels;
-    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS;
-    uint8_t *p_u = p_source->U_PIXELS;
-    uint8_t *p_v = p_source->V_PIXELS;
+    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels
+                               + i_start * p_dest->p->i_pitch;
+    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS
+                         + i_start * p_source->p[Y_PLANE].i_pitch;
+    uint8_t *p_u = p_source->U_PIXELS
+                 + i_start / 2 * p_source->p[U_PLANE].i_pitch;
+    uint8_t *p_v = p_source->V_PIXELS
+                 + i_start / 2 * p_source->p[V_PLANE].i_pitch;
 
     int i_x, i_y;
 
@@ -439,10 +514,10 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
     vector unsigned char y_vec;
 
     if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 32 ) |
-           ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 2 ) ) )
+           ( (i_end - i_start) % 2 ) ) )
     {
         /* Width is a multiple of 32, we take 2 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
         {
             VEC_NEXT_LINES( );
             for( i_x = (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) / 32 ; i_x-- ; )
@@ -454,10 +529,10 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
         }
     }
     else if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 16 ) |
-                ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 4 ) ) )
+                ( (i_end - i_start) % 4 ) ) )
     {
         /* Width is only a multiple of 16, we take 4 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 4 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 4 ; i_y-- ; )
         {
             /* Line 1 and 2, pixels 0 to ( width - 16 ) */
             VEC_NEXT_LINES( );
@@ -504,7 +579,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
                                - ( p_filter->fmt_out.video.i_x_offset * 2 );
 
 #if !defined(MODULE_NAME_IS_i420_yuy2_sse2)
-    for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+    for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
     {
         p_line1 = p_line2;
         p_line2 += p_dest->p->i_pitch;
@@ -552,7 +627,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
         ((intptr_t)p_line2|(intptr_t)p_y2))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -578,7 +653,7 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -611,12 +686,17 @@ static void I420_YVYU( filter_t *p_filter, picture_t *p_source,
  *****************************************************************************/
 VLC_TARGET
 static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+                                           picture_t *p_dest,
+                       int i_start, int i_end )
 {
-    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels;
-    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS;
-    uint8_t *p_u = p_source->U_PIXELS;
-    uint8_t *p_v = p_source->V_PIXELS;
+    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels
+                               + i_start * p_dest->p->i_pitch;
+    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS
+                         + i_start * p_source->p[Y_PLANE].i_pitch;
+    uint8_t *p_u = p_source->U_PIXELS
+                 + i_start / 2 * p_source->p[U_PLANE].i_pitch;
+    uint8_t *p_v = p_source->V_PIXELS
+                 + i_start / 2 * p_source->p[V_PLANE].i_pitch;
 
     int i_x, i_y;
 
@@ -646,10 +726,10 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
     vector unsigned char y_vec;
 
     if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 32 ) |
-           ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 2 ) ) )
+           ( (i_end - i_start) % 2 ) ) )
     {
         /* Width is a multiple of 32, we take 2 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
         {
             VEC_NEXT_LINES( );
             for( i_x = (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) / 32 ; i_x-- ; )
@@ -661,10 +741,10 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
         }
     }
     else if( !( ( (p_filter->fmt_in.video.i_x_offset + p_filter->fmt_in.video.i_visible_width) % 16 ) |
-                ( (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) % 4 ) ) )
+                ( (i_end - i_start) % 4 ) ) )
     {
         /* Width is only a multiple of 16, we take 4 lines at a time */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 4 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 4 ; i_y-- ; )
         {
             /* Line 1 and 2, pixels 0 to ( width - 16 ) */
             VEC_NEXT_LINES( );
@@ -711,7 +791,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
                                - ( p_filter->fmt_out.video.i_x_offset * 2 );
 
 #if !defined(MODULE_NAME_IS_i420_yuy2_sse2)
-    for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+    for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
     {
         p_line1 = p_line2;
         p_line2 += p_dest->p->i_pitch;
@@ -759,7 +839,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
         ((intptr_t)p_line2|(intptr_t)p_y2))) )
     {
         /* use faster SSE2 aligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -785,7 +865,7 @@ static void I420_UYVY( filter_t *p_filter, picture_t *p_source,
     else
     {
         /* use slower SSE2 unaligned fetch and store */
-        for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+        for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
         {
             p_line1 = p_line2;
             p_line2 += p_dest->p->i_pitch;
@@ -831,12 +911,17 @@ static void I420_IUYV( filter_t *p_filter, picture_t *p_source,
  *****************************************************************************/
 #if defined (MODULE_NAME_IS_i420_yuy2)
 static void I420_Y211( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+                                           picture_t *p_dest,
+                       int i_start, int i_end )
 {
-    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels;
-    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS;
-    uint8_t *p_u = p_source->U_PIXELS;
-    uint8_t *p_v = p_source->V_PIXELS;
+    uint8_t *p_line1, *p_line2 = p_dest->p->p_pixels
+                               + i_start * p_dest->p->i_pitch;
+    uint8_t *p_y1, *p_y2 = p_source->Y_PIXELS
+                         + i_start * p_source->p[Y_PLANE].i_pitch;
+    uint8_t *p_u = p_source->U_PIXELS
+                 + i_start / 2 * p_source->p[U_PLANE].i_pitch;
+    uint8_t *p_v = p_source->V_PIXELS
+                 + i_start / 2 * p_source->p[V_PLANE].i_pitch;
 
     int i_x, i_y;
 
@@ -850,7 +935,7 @@ static void I420_Y211( filter_t *p_filter, picture_t *p_source,
                                - p_dest->p->i_visible_pitch
                                - ( p_filter->fmt_out.video.i_x_offset * 2 );
 
-    for( i_y = (p_filter->fmt_in.video.i_y_offset + p_filter->fmt_in.video.i_visible_height) / 2 ; i_y-- ; )
+    for( i_y = (i_end - i_start) / 2 ; i_y-- ; )
     {
         p_line1 = p_line2;
         p_line2 += p_dest->p->i_pitch;
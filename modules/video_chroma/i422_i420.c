@@ -41,10 +41,11 @@
  * Local and extern prototypes.
  *****************************************************************************/
 static int  Activate ( vlc_object_t * );
+static void Deactivate ( vlc_object_t * );
 
-static void I422_I420( filter_t *, picture_t *, picture_t * );
-static void I422_YV12( filter_t *, picture_t *, picture_t * );
-static void I422_YUVA( filter_t *, picture_t *, picture_t * );
+static void I422_I420( filter_t *, picture_t *, picture_t *, int, int );
+static void I422_YV12( filter_t *, picture_t *, picture_t *, int, int );
+static void I422_YUVA( filter_t *, picture_t *, picture_t *, int, int );
 static picture_t *I422_I420_Filter( filter_t *, picture_t * );
 static picture_t *I422_YV12_Filter( filter_t *, picture_t * );
 static picture_t *I422_YUVA_Filter( filter_t *, picture_t * );
@@ -55,7 +56,7 @@ static picture_t *I422_YUVA_Filter( filter_t *, picture_t * );
 vlc_module_begin ()
     set_description( N_("Conversions from " SRC_FOURCC " to " DEST_FOURCC) )
     set_capability( "video converter", 60 )
-    set_callback( Activate )
+    set_callbacks( Activate, Deactivate )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -105,33 +106,88 @@ static int Activate( vlc_object_t *p_this )
         default:
             return -1;
     }
+
+    /* The worker pool, or NULL on a single CPU */
+    p_filter->p_sys = filter_slices_Hold();
     return 0;
 }
 
+/*****************************************************************************
+ * Deactivate: release the worker pool
+ *****************************************************************************/
+static void Deactivate( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_slices_t *p_slices = p_filter->p_sys;
+
+    if( p_slices )
+        filter_slices_Release( p_slices );
+}
+
 /* Following functions are local */
-VIDEO_FILTER_WRAPPER( I422_I420 )
-VIDEO_FILTER_WRAPPER( I422_YV12 )
-VIDEO_FILTER_WRAPPER( I422_YUVA )
+
+/* The conversions process lines [i_start, i_end) in pairs, the second line
+ * of each pair giving the 4:2:0 chroma line. */
+struct convert_slices
+{
+    filter_t  *p_filter;
+    picture_t *p_src;
+    picture_t *p_dest;
+};
+
+#define SLICED_FILTER_WRAPPER( name )                                   \
+    static void name ## _Slice( void *opaque, unsigned i_slice,        \
+                                unsigned i_slices )                    \
+    {                                                                   \
+        struct convert_slices *ctx = opaque;                            \
+        int i_start, i_end;                                             \
+                                                                        \
+        filter_slices_GetRange( ctx->p_filter->fmt_in.video.i_height, 2, \
+                                i_slice, i_slices, &i_start, &i_end );  \
+        if( i_start < i_end ) /* the copies run bottom-up */            \
+            name( ctx->p_filter, ctx->p_src, ctx->p_dest, i_start, i_end ); \
+    }                                                                   \
+                                                                        \
+    static picture_t *name ## _Filter ( filter_t *p_filter,             \
+                                        picture_t *p_pic )              \
+    {                                                                   \
+        picture_t *p_outpic = filter_NewPicture( p_filter );            \
+        if( p_outpic )                                                  \
+        {                                                               \
+            struct convert_slices ctx = {                               \
+                .p_filter = p_filter, .p_src = p_pic, .p_dest = p_outpic, \
+            };                                                          \
+            filter_slices_Run( p_filter->p_sys, FILTER_SLICES_MAX,      \
+                               name ## _Slice, &ctx );                  \
+            picture_CopyProperties( p_outpic, p_pic );                  \
+        }                                                               \
+        picture_Release( p_pic );                                       \
+        return p_outpic;                                                \
+    }
+
+SLICED_FILTER_WRAPPER( I422_I420 )
+SLICED_FILTER_WRAPPER( I422_YV12 )
+SLICED_FILTER_WRAPPER( I422_YUVA )
 
 /*****************************************************************************
  * I422_I420: planar YUV 4:2:2 to planar I420 4:2:0 Y:U:V
  *****************************************************************************/
 static void I422_I420( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+                                           picture_t *p_dest,
+                       int i_start, int i_end )
 {
     uint16_t i_dpy = p_dest->p[Y_PLANE].i_pitch;
     uint16_t i_spy = p_source->p[Y_PLANE].i_pitch;
     uint16_t i_dpuv = p_dest->p[U_PLANE].i_pitch;
     uint16_t i_spuv = p_source->p[U_PLANE].i_pitch;
     uint16_t i_width = p_filter->fmt_in.video.i_width;
-    uint16_t i_y = p_filter->fmt_in.video.i_height;
-    uint8_t *p_dy = p_dest->Y_PIXELS + (i_y-1)*i_dpy;
-    uint8_t *p_y = p_source->Y_PIXELS + (i_y-1)*i_spy;
-    uint8_t *p_du = p_dest->U_PIXELS + (i_y/2-1)*i_dpuv;
-    uint8_t *p_u = p_source->U_PIXELS + (i_y-1)*i_spuv;
-    uint8_t *p_dv = p_dest->V_PIXELS + (i_y/2-1)*i_dpuv;
-    uint8_t *p_v = p_source->V_PIXELS + (i_y-1)*i_spuv;
-    i_y /= 2;
+    uint16_t i_y = (i_end - i_start) / 2;
+    uint8_t *p_dy = p_dest->Y_PIXELS + (i_end-1)*i_dpy;
+    uint8_t *p_y = p_source->Y_PIXELS + (i_end-1)*i_spy;
+    uint8_t *p_du = p_dest->U_PIXELS + (i_end/2-1)*i_dpuv;
+    uint8_t *p_u = p_source->U_PIXELS + (i_end-1)*i_spuv;
+    uint8_t *p_dv = p_dest->V_PIXELS + (i_end/2-1)*i_dpuv;
+    uint8_t *p_v = p_source->V_PIXELS + (i_end-1)*i_spuv;
 
     for ( ; i_y--; )
     {
@@ -146,21 +202,21 @@ static void I422_I420( filter_t *p_filter, picture_t *p_source,
  * I422_YV12: planar YUV 4:2:2 to planar YV12 4:2:0 Y:V:U
  *****************************************************************************/
 static void I422_YV12( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+                                           picture_t *p_dest,
+                       int i_start, int i_end )
 {
     uint16_t i_dpy = p_dest->p[Y_PLANE].i_pitch;
     uint16_t i_spy = p_source->p[Y_PLANE].i_pitch;
     uint16_t i_dpuv = p_dest->p[U_PLANE].i_pitch;
     uint16_t i_spuv = p_source->p[U_PLANE].i_pitch;
     uint16_t i_width = p_filter->fmt_in.video.i_width;
-    uint16_t i_y = p_filter->fmt_in.video.i_height;
-    uint8_t *p_dy = p_dest->Y_PIXELS + (i_y-1)*i_dpy;
-    uint8_t *p_y = p_source->Y_PIXELS + (i_y-1)*i_spy;
-    uint8_t *p_du = p_dest->V_PIXELS + (i_y/2-1)*i_dpuv; /* U and V are swapped */
-    uint8_t *p_u = p_source->U_PIXELS + (i_y-1)*i_spuv;
-    uint8_t *p_dv = p_dest->U_PIXELS + (i_y/2-1)*i_dpuv; /* U and V are swapped */
-    uint8_t *p_v = p_source->V_PIXELS + (i_y-1)*i_spuv;
-    i_y /= 2;
+    uint16_t i_y = (i_end - i_start) / 2;
+    uint8_t *p_dy = p_dest->Y_PIXELS + (i_end-1)*i_dpy;
+    uint8_t *p_y = p_source->Y_PIXELS + (i_end-1)*i_spy;
+    uint8_t *p_du = p_dest->V_PIXELS + (i_end/2-1)*i_dpuv; /* U and V are swapped */
+    uint8_t *p_u = p_source->U_PIXELS + (i_end-1)*i_spuv;
+    uint8_t *p_dv = p_dest->U_PIXELS + (i_end/2-1)*i_dpuv; /* U and V are swapped */
+    uint8_t *p_v = p_source->V_PIXELS + (i_end-1)*i_spuv;
 
     for ( ; i_y--; )
     {
@@ -175,9 +231,16 @@ static void I422_YV12( filter_t *p_filter, picture_t *p_source,
  * I422_YUVA: planar YUV 4:2:2 to planar YUVA 4:2:0:4 Y:U:V:A
  *****************************************************************************/
 static void I422_YUVA( filter_t *p_filter, picture_t *p_source,
-                                           picture_t *p_dest )
+                                           picture_t *p_dest,
+                       int i_start, int i_end )
 {
-    I422_I420( p_filter, p_source, p_dest );
-    memset( p_dest->p[A_PLANE].p_pixels, 0xff,
-                p_dest->p[A_PLANE].i_lines * p_dest->p[A_PLANE].i_pitch );
+    plane_t *p_a = &p_dest->p[A_PLANE];
+
+    I422_I420( p_filter, p_source, p_dest, i_start, i_end );
+
+    /* The last slice also fills the margin below the picture */
+    if( i_end == (int)p_filter->fmt_in.video.i_height )
+        i_end = p_a->i_lines;
+    memset( p_a->p_pixels + i_start * p_a->i_pitch, 0xff,
+            (i_end - i_start) * p_a->i_pitch );
 }
@@ -116,9 +116,10 @@ typedef struct
     _Atomic float f_gamma;
     atomic_bool  b_brightness_threshold;
     int (*pf_process_sat_hue)( picture_t *, picture_t *, int, int, int,
-                               int, int );
+                               int, int, int, int );
     int (*pf_process_sat_hue_clip)( picture_t *, picture_t *, int, int,
-                                    int, int, int );
+                                    int, int, int, int, int );
+    filter_slices_t *p_slices;
 } filter_sys_t;
 
 static int FloatCallback( vlc_object_t *obj, char const *varname,
@@ -219,6 +220,8 @@ static int Create( vlc_object_t *p_this )
     var_AddCallback( p_filter, "brightness-threshold", BoolCallback,
                      &p_sys->b_brightness_threshold );
 
+    p_sys->p_slices = filter_slices_Hold();
+
     return VLC_SUCCESS;
 }
 
@@ -239,6 +242,128 @@ static void Destroy( vlc_object_t *p_this )
     var_DelCallback( p_filter, "gamma", FloatCallback, &p_sys->f_gamma );
     var_DelCallback( p_filter, "brightness-threshold", BoolCallback,
                      &p_sys->b_brightness_threshold );
+    if( p_sys->p_slices )
+        filter_slices_Release( p_sys->p_slices );
+}
+
+struct adjust_slices
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    const int *pi_luma;
+    bool b_16bit;
+    int i_y_offset;
+    int (*pf_process_sat_hue)( picture_t *, picture_t *, int, int, int,
+                               int, int, int, int );
+    int i_sin, i_cos, i_sat, i_x, i_y;
+    int pi_ret[FILTER_SLICES_MAX];
+};
+
+/*****************************************************************************
+ * Run the filter on a band of a Planar YUV picture
+ *****************************************************************************/
+static void FilterPlanarSlice( void *opaque, unsigned i_slice,
+                               unsigned i_slices )
+{
+    struct adjust_slices *ctx = opaque;
+    picture_t *p_pic = ctx->p_pic;
+    picture_t *p_outpic = ctx->p_outpic;
+    const int *pi_luma = ctx->pi_luma;
+    int i_start, i_end;
+
+    filter_slices_GetRange( p_pic->p[Y_PLANE].i_visible_lines, 1,
+                            i_slice, i_slices, &i_start, &i_end );
+
+    /*
+     * Do the Y plane
+     */
+    if ( ctx->b_16bit )
+    {
+        uint16_t *p_in, *p_in_end, *p_line_end;
+        uint16_t *p_out;
+        p_in = (uint16_t *) p_pic->p[Y_PLANE].p_pixels
+             + i_start * (p_pic->p[Y_PLANE].i_pitch >> 1);
+        p_in_end = p_in + (i_end - i_start)
+            * (p_pic->p[Y_PLANE].i_pitch >> 1) - 8;
+
+        p_out = (uint16_t *) p_outpic->p[Y_PLANE].p_pixels
+              + i_start * (p_outpic->p[Y_PLANE].i_pitch >> 1);
+
+        for( ; p_in < p_in_end ; )
+        {
+            p_line_end = p_in + (p_pic->p[Y_PLANE].i_visible_pitch >> 1) - 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                /* Do 8 pixels at a time */
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_line_end += 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_in += (p_pic->p[Y_PLANE].i_pitch >> 1)
+                - (p_pic->p[Y_PLANE].i_visible_pitch >> 1);
+            p_out += (p_outpic->p[Y_PLANE].i_pitch >> 1)
+                - (p_outpic->p[Y_PLANE].i_visible_pitch >> 1);
+        }
+    }
+    else
+    {
+        uint8_t *p_in, *p_in_end, *p_line_end;
+        uint8_t *p_out;
+        p_in = p_pic->p[Y_PLANE].p_pixels
+             + i_start * p_pic->p[Y_PLANE].i_pitch;
+        p_in_end = p_in + (i_end - i_start)
+                 * p_pic->p[Y_PLANE].i_pitch - 8;
+
+        p_out = p_outpic->p[Y_PLANE].p_pixels
+              + i_start * p_outpic->p[Y_PLANE].i_pitch;
+
+        for( ; p_in < p_in_end ; )
+        {
+            p_line_end = p_in + p_pic->p[Y_PLANE].i_visible_pitch - 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                /* Do 8 pixels at a time */
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_line_end += 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_in += p_pic->p[Y_PLANE].i_pitch
+                  - p_pic->p[Y_PLANE].i_visible_pitch;
+            p_out += p_outpic->p[Y_PLANE].i_pitch
+                   - p_outpic->p[Y_PLANE].i_visible_pitch;
+        }
+    }
+
+    /*
+     * Do the U and V planes
+     */
+    filter_slices_GetRange( p_pic->p[U_PLANE].i_visible_lines, 1,
+                            i_slice, i_slices, &i_start, &i_end );
+
+    ctx->pi_ret[i_slice] =
+        ctx->pf_process_sat_hue( p_pic, p_outpic, ctx->i_sin, ctx->i_cos,
+                                 ctx->i_sat, ctx->i_x, ctx->i_y,
+                                 i_start, i_end );
 }
 
 /*****************************************************************************
@@ -334,108 +459,96 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
     }
 
     /*
-     * Do the Y plane
+     * Do the U and V planes
      */
-    if ( b_16bit )
-    {
-        uint16_t *p_in, *p_in_end, *p_line_end;
-        uint16_t *p_out;
-        p_in = (uint16_t *) p_pic->p[Y_PLANE].p_pixels;
-        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
-            * (p_pic->p[Y_PLANE].i_pitch >> 1) - 8;
 
-        p_out = (uint16_t *) p_outpic->p[Y_PLANE].p_pixels;
+    int i_sin = sinf(f_hue) * f_max;
+    int i_cos = cosf(f_hue) * f_max;
 
-        for( ; p_in < p_in_end ; )
-        {
-            p_line_end = p_in + (p_pic->p[Y_PLANE].i_visible_pitch >> 1) - 8;
+    /* pow(2, (bpp * 2) - 1) */
+    int i_x = ( cosf(f_hue) + sinf(f_hue) ) * f_range * i_mid;
+    int i_y = ( cosf(f_hue) - sinf(f_hue) ) * f_range * i_mid;
 
-            for( ; p_in < p_line_end ; )
-            {
-                /* Do 8 pixels at a time */
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            }
+    struct adjust_slices ctx = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .pi_luma = pi_luma,
+        .b_16bit = b_16bit,
+        .pf_process_sat_hue = i_sat > i_range ? p_sys->pf_process_sat_hue_clip
+                                              : p_sys->pf_process_sat_hue,
+        .i_sin = i_sin, .i_cos = i_cos, .i_sat = i_sat, .i_x = i_x, .i_y = i_y,
+    };
+    /* Currently no errors are implemented in the functions, if any are added
+     * check them here */
+    filter_slices_Run( p_sys->p_slices, FILTER_SLICES_MAX,
+                       FilterPlanarSlice, &ctx );
 
-            p_line_end += 8;
+    return CopyInfoAndRelease( p_outpic, p_pic );
+}
 
-            for( ; p_in < p_line_end ; )
-            {
-                *p_out++ = pi_luma[ *p_in++ ];
-            }
+/*****************************************************************************
+ * Run the filter on a band of a Packed YUV picture
+ *****************************************************************************/
+static void FilterPackedSlice( void *opaque, unsigned i_slice,
+                               unsigned i_slices )
+{
+    struct adjust_slices *ctx = opaque;
+    picture_t *p_pic = ctx->p_pic;
+    picture_t *p_outpic = ctx->p_outpic;
+    const int *pi_luma = ctx->pi_luma;
+    uint8_t *p_in, *p_in_end, *p_line_end;
+    uint8_t *p_out;
+    int i_pitch = p_pic->p->i_pitch;
+    int i_visible_pitch = p_pic->p->i_visible_pitch;
+    int i_start, i_end;
 
-            p_in += (p_pic->p[Y_PLANE].i_pitch >> 1)
-                - (p_pic->p[Y_PLANE].i_visible_pitch >> 1);
-            p_out += (p_outpic->p[Y_PLANE].i_pitch >> 1)
-                - (p_outpic->p[Y_PLANE].i_visible_pitch >> 1);
-        }
-    }
-    else
-    {
-        uint8_t *p_in, *p_in_end, *p_line_end;
-        uint8_t *p_out;
-        p_in = p_pic->p[Y_PLANE].p_pixels;
-        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
-                 * p_pic->p[Y_PLANE].i_pitch - 8;
+    filter_slices_GetRange( p_pic->p->i_visible_lines, 1,
+                            i_slice, i_slices, &i_start, &i_end );
 
-        p_out = p_outpic->p[Y_PLANE].p_pixels;
+    /*
+     * Do the Y plane
+     */
 
-        for( ; p_in < p_in_end ; )
-        {
-            p_line_end = p_in + p_pic->p[Y_PLANE].i_visible_pitch - 8;
+    p_in = p_pic->p->p_pixels + i_start * i_pitch + ctx->i_y_offset;
+    p_in_end = p_in + (i_end - i_start) * i_pitch - 8 * 4;
 
-            for( ; p_in < p_line_end ; )
-            {
-                /* Do 8 pixels at a time */
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            }
+    p_out = p_outpic->p->p_pixels + i_start * i_pitch + ctx->i_y_offset;
 
-            p_line_end += 8;
+    for( ; p_in < p_in_end ; )
+    {
+        p_line_end = p_in + i_visible_pitch - 8 * 4;
 
-            for( ; p_in < p_line_end ; )
-            {
-                *p_out++ = pi_luma[ *p_in++ ];
-            }
+        for( ; p_in < p_line_end ; )
+        {
+            /* Do 8 pixels at a time */
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+        }
 
-            p_in += p_pic->p[Y_PLANE].i_pitch
-                  - p_pic->p[Y_PLANE].i_visible_pitch;
-            p_out += p_outpic->p[Y_PLANE].i_pitch
-                   - p_outpic->p[Y_PLANE].i_visible_pitch;
+        p_line_end += 8 * 4;
+
+        for( ; p_in < p_line_end ; )
+        {
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
         }
+
+        p_in += i_pitch - p_pic->p->i_visible_pitch;
+        p_out += i_pitch - p_outpic->p->i_visible_pitch;
     }
 
     /*
      * Do the U and V planes
      */
-
-    int i_sin = sinf(f_hue) * f_max;
-    int i_cos = cosf(f_hue) * f_max;
-
-    /* pow(2, (bpp * 2) - 1) */
-    int i_x = ( cosf(f_hue) + sinf(f_hue) ) * f_range * i_mid;
-    int i_y = ( cosf(f_hue) - sinf(f_hue) ) * f_range * i_mid;
-
-    if ( i_sat > i_range )
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
-    else
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
-
-    return CopyInfoAndRelease( p_outpic, p_pic );
+    ctx->pi_ret[i_slice] =
+        ctx->pf_process_sat_hue( p_pic, p_outpic, ctx->i_sin, ctx->i_cos,
+                                 ctx->i_sat, ctx->i_x, ctx->i_y,
+                                 i_start, i_end );
 }
 
 /*****************************************************************************
@@ -447,12 +560,8 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
     int pi_gamma[256];
 
     picture_t *p_outpic;
-    uint8_t *p_in, *p_in_end, *p_line_end;
-    uint8_t *p_out;
     int i_y_offset, i_u_offset, i_v_offset;
 
-    int i_pitch, i_visible_pitch;
-
     double  f_hue;
     double  f_gamma;
     int32_t i_cont, i_lum;
@@ -462,9 +571,6 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
 
     if( !p_pic ) return NULL;
 
-    i_pitch = p_pic->p->i_pitch;
-    i_visible_pitch = p_pic->p->i_visible_pitch;
-
     if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
                              &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
     {
@@ -530,43 +636,6 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
         i_sat = 0;
     }
 
-    /*
-     * Do the Y plane
-     */
-
-    p_in = p_pic->p->p_pixels + i_y_offset;
-    p_in_end = p_in + p_pic->p->i_visible_lines * p_pic->p->i_pitch - 8 * 4;
-
-    p_out = p_outpic->p->p_pixels + i_y_offset;
-
-    for( ; p_in < p_in_end ; )
-    {
-        p_line_end = p_in + i_visible_pitch - 8 * 4;
-
-        for( ; p_in < p_line_end ; )
-        {
-            /* Do 8 pixels at a time */
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-        }
-
-        p_line_end += 8 * 4;
-
-        for( ; p_in < p_line_end ; )
-        {
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-        }
-
-        p_in += i_pitch - p_pic->p->i_visible_pitch;
-        p_out += i_pitch - p_outpic->p->i_visible_pitch;
-    }
-
     /*
      * Do the U and V planes
      */
@@ -577,28 +646,27 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
     i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
     i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
 
-    if ( i_sat > 256 )
-    {
-        if ( p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                             i_x, i_y ) != VLC_SUCCESS )
-        {
-            /* Currently only one error can happen in the function, but if there
-             * will be more of them, this message must go away */
-            msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
-                      (char*)&(p_pic->format.i_chroma) );
-            picture_Release( p_pic );
-            return NULL;
-        }
-    }
-    else
+    struct adjust_slices ctx = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .pi_luma = pi_luma,
+        .i_y_offset = i_y_offset,
+        .pf_process_sat_hue = i_sat > 256 ? p_sys->pf_process_sat_hue_clip
+                                          : p_sys->pf_process_sat_hue,
+        .i_sin = i_sin, .i_cos = i_cos, .i_sat = i_sat, .i_x = i_x, .i_y = i_y,
+    };
+    unsigned i_slices = filter_slices_Run( p_sys->p_slices, FILTER_SLICES_MAX,
+                                           FilterPackedSlice, &ctx );
+
+    for( unsigned i = 0; i < i_slices; i++ )
     {
-        if ( p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y ) != VLC_SUCCESS )
+        if( ctx.pi_ret[i] != VLC_SUCCESS )
         {
             /* Currently only one error can happen in the function, but if there
              * will be more of them, this message must go away */
             msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
                       (char*)&(p_pic->format.i_chroma) );
+            picture_Release( p_outpic );
             picture_Release( p_pic );
             return NULL;
         }
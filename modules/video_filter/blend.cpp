@@ -31,8 +31,20 @@
 #include <vlc_plugin.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
+#include <vlc_cpu.h>
 #include "filter_picture.h"
 
+#ifdef HAVE_SSE2_INTRINSICS
+# include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+# include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+# include <arm_neon.h>
+# define BLEND_HAVE_NEON
+#endif
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -80,6 +92,18 @@ public:
     {
         return fmt;
     }
+    const picture_t *getPicture() const
+    {
+        return picture;
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
     bool isFull(unsigned) const
     {
         return true;
@@ -152,7 +176,7 @@ private:
     uint8_t *data[4];
 };
 
-template <bool swap_uv>
+template <typename pixel, unsigned shift, bool swap_uv>
 class CPictureYUVSemiPlanar : public CPicture {
 public:
     CPictureYUVSemiPlanar(const CPicture &cfg) : CPicture(cfg)
@@ -162,18 +186,18 @@ public:
     }
     void get(CPixel *px, unsigned dx, bool full = true) const
     {
-        px->i = *getPointer(0, dx);
+        px->i = *getPointer(0, dx) >> shift;
         if (full) {
-            px->j = getPointer(1, dx)[swap_uv];
-            px->k = getPointer(1, dx)[!swap_uv];
+            px->j = getPointer(1, dx)[swap_uv] >> shift;
+            px->k = getPointer(1, dx)[!swap_uv] >> shift;
         }
     }
     void merge(unsigned dx, const CPixel &spx, unsigned a, bool full)
     {
-        ::merge(getPointer(0, dx), spx.i, a);
+        mergeSample(getPointer(0, dx), spx.i, a);
         if (full) {
-            ::merge(&getPointer(1, dx)[ swap_uv], spx.j, a);
-            ::merge(&getPointer(1, dx)[!swap_uv], spx.k, a);
+            mergeSample(&getPointer(1, dx)[ swap_uv], spx.j, a);
+            mergeSample(&getPointer(1, dx)[!swap_uv], spx.k, a);
         }
     }
     bool isFull(unsigned dx) const
@@ -188,12 +212,19 @@ public:
             data[1] += picture->p[1].i_pitch;
     }
 private:
-    uint8_t *getPointer(unsigned plane, unsigned dx) const
+    static void mergeSample(pixel *dst, unsigned src, unsigned a)
+    {
+        /* samples are MSB aligned */
+        unsigned value = *dst >> shift;
+        ::merge(&value, src, a);
+        *dst = value << shift;
+    }
+    pixel *getPointer(unsigned plane, unsigned dx) const
     {
         if (plane == 0)
-            return &data[plane][x + dx];
+            return (pixel*)&data[plane][(x + dx) * sizeof(pixel)];
         else
-            return &data[plane][(x + dx) / 2 * 2];
+            return (pixel*)&data[plane][(x + dx) / 2 * 2 * sizeof(pixel)];
     }
     uint8_t *data[2];
 };
@@ -393,8 +424,9 @@ typedef CPictureYUVPlanar<uint8_t,  4,4, false, false> CPictureI410_8;
 
 typedef CPictureYUVPlanar<uint8_t,  4,1, false, false> CPictureI411_8;
 
-typedef CPictureYUVSemiPlanar<false>                   CPictureNV12;
-typedef CPictureYUVSemiPlanar<true>                    CPictureNV21;
+typedef CPictureYUVSemiPlanar<uint8_t,  0, false>      CPictureNV12;
+typedef CPictureYUVSemiPlanar<uint8_t,  0, true>       CPictureNV21;
+typedef CPictureYUVSemiPlanar<uint16_t, 6, false>      CPictureP010;
 
 typedef CPictureYUVPlanar<uint8_t,  2,2, false, true>  CPictureYV12;
 typedef CPictureYUVPlanar<uint8_t,  2,2, false, false> CPictureI420_8;
@@ -558,6 +590,800 @@ void Blend(const CPicture &dst_data, const CPicture &src_data,
     }
 }
 
+/*****************************************************************************
+ * Row kernels
+ *****************************************************************************
+ * The most common subpicture cases (YUVA onto 4:2:0 and RGBA onto RGB32)
+ * are blended a row at a time, so that they can be vectorized. All of them
+ * must give the exact same result as the generic Blend() above.
+ *****************************************************************************/
+namespace {
+
+struct blend_kernels_t {
+    const char *name;
+    /* 8 bits luma, or any not subsampled plane */
+    void (*y8)(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+               unsigned count, int alpha);
+    /* 8 bits chroma plane, using every other source sample */
+    void (*uv8)(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                unsigned count, int alpha);
+    /* 8 bits interleaved chroma plane, count is in pairs */
+    void (*nv8)(uint8_t *dst, const uint8_t *src_u, const uint8_t *src_v,
+                const uint8_t *src_a, unsigned count, int alpha);
+    /* MSB aligned 10 bits variants of y8 and nv8 */
+    void (*y10)(uint16_t *dst, const uint8_t *src, const uint8_t *src_a,
+                unsigned count, int alpha);
+    void (*nv10)(uint16_t *dst, const uint8_t *src_u, const uint8_t *src_v,
+                 const uint8_t *src_a, unsigned count, int alpha);
+    /* RGBA onto 4 bytes RGB, with red and blue swapped or not */
+    void (*rgbx)(uint8_t *dst, const uint8_t *src, unsigned count, int alpha,
+                 bool swap_rb);
+};
+
+static void merge10(uint16_t *dst, unsigned src, unsigned a)
+{
+    /* Like Blend(), leave transparent samples untouched as merge() is not
+     * exact above 8 bits */
+    if (a > 0) {
+        unsigned value = *dst >> 6;
+        ::merge(&value, src * 1023 / 255, a);
+        *dst = value << 6;
+    }
+}
+
+static void BlendY8_C(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                      unsigned count, int alpha)
+{
+    for (unsigned i = 0; i < count; i++)
+        ::merge(&dst[i], src[i], div255(alpha * src_a[i]));
+}
+
+static void BlendUV8_C(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                       unsigned count, int alpha)
+{
+    for (unsigned i = 0; i < count; i++)
+        ::merge(&dst[i], src[2 * i], div255(alpha * src_a[2 * i]));
+}
+
+static void BlendNV8_C(uint8_t *dst, const uint8_t *src_u, const uint8_t *src_v,
+                       const uint8_t *src_a, unsigned count, int alpha)
+{
+    for (unsigned i = 0; i < count; i++) {
+        const unsigned a = div255(alpha * src_a[2 * i]);
+        ::merge(&dst[2 * i + 0], src_u[2 * i], a);
+        ::merge(&dst[2 * i + 1], src_v[2 * i], a);
+    }
+}
+
+static void BlendY10_C(uint16_t *dst, const uint8_t *src, const uint8_t *src_a,
+                       unsigned count, int alpha)
+{
+    for (unsigned i = 0; i < count; i++)
+        merge10(&dst[i], src[i], div255(alpha * src_a[i]));
+}
+
+static void BlendNV10_C(uint16_t *dst, const uint8_t *src_u, const uint8_t *src_v,
+                        const uint8_t *src_a, unsigned count, int alpha)
+{
+    for (unsigned i = 0; i < count; i++) {
+        const unsigned a = div255(alpha * src_a[2 * i]);
+        merge10(&dst[2 * i + 0], src_u[2 * i], a);
+        merge10(&dst[2 * i + 1], src_v[2 * i], a);
+    }
+}
+
+static void BlendRGBX_C(uint8_t *dst, const uint8_t *src, unsigned count,
+                        int alpha, bool swap_rb)
+{
+    const unsigned offset_r = swap_rb ? 2 : 0;
+    const unsigned offset_b = swap_rb ? 0 : 2;
+
+    for (unsigned i = 0; i < count; i++) {
+        const unsigned a = div255(alpha * src[4 * i + 3]);
+        ::merge(&dst[4 * i + offset_r], src[4 * i + 0], a);
+        ::merge(&dst[4 * i + 1],        src[4 * i + 1], a);
+        ::merge(&dst[4 * i + offset_b], src[4 * i + 2], a);
+    }
+}
+
+static const blend_kernels_t kernels_c = {
+    "c",
+    BlendY8_C, BlendUV8_C, BlendNV8_C, BlendY10_C, BlendNV10_C, BlendRGBX_C,
+};
+
+#ifdef HAVE_SSE2_INTRINSICS
+/* Every 8 bits product fits in 16 bits lanes. Loops leave at least one
+ * sample to the C tail when reading every other source sample, so that
+ * they never read past the blended area. */
+# define SSE2_TARGET __attribute__ ((__target__ ("sse2")))
+
+SSE2_TARGET
+static inline __m128i Div255_SSE2(__m128i v)
+{
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)),
+                                        _mm_set1_epi16(1)), 8);
+}
+
+SSE2_TARGET
+static inline __m128i Div255x32_SSE2(__m128i v)
+{
+    return _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(v, _mm_srli_epi32(v, 8)),
+                                        _mm_set1_epi32(1)), 8);
+}
+
+SSE2_TARGET
+static inline __m128i Alpha_SSE2(__m128i src_a, int alpha)
+{
+    return Div255_SSE2(_mm_mullo_epi16(src_a, _mm_set1_epi16(alpha)));
+}
+
+SSE2_TARGET
+static inline __m128i Merge_SSE2(__m128i dst, __m128i src, __m128i a)
+{
+    const __m128i na = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    return Div255_SSE2(_mm_add_epi16(_mm_mullo_epi16(dst, na),
+                                     _mm_mullo_epi16(src, a)));
+}
+
+/* dst holds MSB aligned 10 bits samples, src 8 bits ones */
+SSE2_TARGET
+static inline __m128i Merge10_SSE2(__m128i dst, __m128i src, __m128i a)
+{
+    const __m128i value = _mm_srli_epi16(dst, 6);
+    /* src * 1023 / 255 == 4 * src + (src >= 85) + (src >= 170) + (src >= 255) */
+    src = _mm_sub_epi16(_mm_sub_epi16(_mm_slli_epi16(src, 2),
+                                      _mm_cmpgt_epi16(src, _mm_set1_epi16(84))),
+                        _mm_add_epi16(_mm_cmpgt_epi16(src, _mm_set1_epi16(169)),
+                                      _mm_cmpgt_epi16(src, _mm_set1_epi16(254))));
+
+    const __m128i na = _mm_sub_epi16(_mm_set1_epi16(255), a);
+    const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi16(value, src),
+                                      _mm_unpacklo_epi16(na, a));
+    const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi16(value, src),
+                                      _mm_unpackhi_epi16(na, a));
+    const __m128i merged = _mm_slli_epi16(_mm_packs_epi32(Div255x32_SSE2(lo),
+                                                          Div255x32_SSE2(hi)), 6);
+    const __m128i transparent = _mm_cmpeq_epi16(a, _mm_setzero_si128());
+    return _mm_or_si128(_mm_and_si128(transparent, dst),
+                        _mm_andnot_si128(transparent, merged));
+}
+
+/* 8 even samples of 16 bytes, as 16 bits lanes */
+SSE2_TARGET
+static inline __m128i LoadEven_SSE2(const uint8_t *p)
+{
+    return _mm_and_si128(_mm_loadu_si128((const __m128i *)p), _mm_set1_epi16(0xff));
+}
+
+SSE2_TARGET
+static void BlendY8_SSE2(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                         unsigned count, int alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    unsigned i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i d  = _mm_loadu_si128((const __m128i *)&dst[i]);
+        const __m128i s  = _mm_loadu_si128((const __m128i *)&src[i]);
+        const __m128i sa = _mm_loadu_si128((const __m128i *)&src_a[i]);
+
+        const __m128i lo = Merge_SSE2(_mm_unpacklo_epi8(d, zero),
+                                      _mm_unpacklo_epi8(s, zero),
+                                      Alpha_SSE2(_mm_unpacklo_epi8(sa, zero), alpha));
+        const __m128i hi = Merge_SSE2(_mm_unpackhi_epi8(d, zero),
+                                      _mm_unpackhi_epi8(s, zero),
+                                      Alpha_SSE2(_mm_unpackhi_epi8(sa, zero), alpha));
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packus_epi16(lo, hi));
+    }
+    BlendY8_C(&dst[i], &src[i], &src_a[i], count - i, alpha);
+}
+
+SSE2_TARGET
+static void BlendUV8_SSE2(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                          unsigned count, int alpha)
+{
+    unsigned i = 0;
+    for (; i + 8 < count; i += 8) {
+        const __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)&dst[i]),
+                                            _mm_setzero_si128());
+        const __m128i r = Merge_SSE2(d, LoadEven_SSE2(&src[2 * i]),
+                                     Alpha_SSE2(LoadEven_SSE2(&src_a[2 * i]), alpha));
+        _mm_storel_epi64((__m128i *)&dst[i], _mm_packus_epi16(r, r));
+    }
+    BlendUV8_C(&dst[i], &src[2 * i], &src_a[2 * i], count - i, alpha);
+}
+
+SSE2_TARGET
+static void BlendNV8_SSE2(uint8_t *dst, const uint8_t *src_u, const uint8_t *src_v,
+                          const uint8_t *src_a, unsigned count, int alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    unsigned i = 0;
+    for (; i + 8 < count; i += 8) {
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst[2 * i]);
+        const __m128i u = LoadEven_SSE2(&src_u[2 * i]);
+        const __m128i v = LoadEven_SSE2(&src_v[2 * i]);
+        const __m128i a = Alpha_SSE2(LoadEven_SSE2(&src_a[2 * i]), alpha);
+
+        const __m128i lo = Merge_SSE2(_mm_unpacklo_epi8(d, zero),
+                                      _mm_unpacklo_epi16(u, v),
+                                      _mm_unpacklo_epi16(a, a));
+        const __m128i hi = Merge_SSE2(_mm_unpackhi_epi8(d, zero),
+                                      _mm_unpackhi_epi16(u, v),
+                                      _mm_unpackhi_epi16(a, a));
+        _mm_storeu_si128((__m128i *)&dst[2 * i], _mm_packus_epi16(lo, hi));
+    }
+    BlendNV8_C(&dst[2 * i], &src_u[2 * i], &src_v[2 * i], &src_a[2 * i],
+               count - i, alpha);
+}
+
+SSE2_TARGET
+static void BlendY10_SSE2(uint16_t *dst, const uint8_t *src, const uint8_t *src_a,
+                          unsigned count, int alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i d  = _mm_loadu_si128((const __m128i *)&dst[i]);
+        const __m128i s  = _mm_loadl_epi64((const __m128i *)&src[i]);
+        const __m128i sa = _mm_loadl_epi64((const __m128i *)&src_a[i]);
+
+        const __m128i r = Merge10_SSE2(d, _mm_unpacklo_epi8(s, zero),
+                                       Alpha_SSE2(_mm_unpacklo_epi8(sa, zero), alpha));
+        _mm_storeu_si128((__m128i *)&dst[i], r);
+    }
+    BlendY10_C(&dst[i], &src[i], &src_a[i], count - i, alpha);
+}
+
+SSE2_TARGET
+static void BlendNV10_SSE2(uint16_t *dst, const uint8_t *src_u, const uint8_t *src_v,
+                           const uint8_t *src_a, unsigned count, int alpha)
+{
+    unsigned i = 0;
+    for (; i + 8 < count; i += 8) {
+        const __m128i u = LoadEven_SSE2(&src_u[2 * i]);
+        const __m128i v = LoadEven_SSE2(&src_v[2 * i]);
+        const __m128i a = Alpha_SSE2(LoadEven_SSE2(&src_a[2 * i]), alpha);
+
+        __m128i *d = (__m128i *)&dst[2 * i];
+        _mm_storeu_si128(&d[0], Merge10_SSE2(_mm_loadu_si128(&d[0]),
+                                             _mm_unpacklo_epi16(u, v),
+                                             _mm_unpacklo_epi16(a, a)));
+        _mm_storeu_si128(&d[1], Merge10_SSE2(_mm_loadu_si128(&d[1]),
+                                             _mm_unpackhi_epi16(u, v),
+                                             _mm_unpackhi_epi16(a, a)));
+    }
+    BlendNV10_C(&dst[2 * i], &src_u[2 * i], &src_v[2 * i], &src_a[2 * i],
+                count - i, alpha);
+}
+
+/* 2 pixels of 4 x 16 bits lanes */
+SSE2_TARGET
+static inline __m128i MergeRGBX_SSE2(__m128i dst, __m128i src, int alpha)
+{
+    __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src, 0xff), 0xff);
+    /* keep the destination padding byte */
+    a = _mm_and_si128(Alpha_SSE2(a, alpha),
+                      _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1));
+    return Merge_SSE2(dst, src, a);
+}
+
+SSE2_TARGET
+static void BlendRGBX_SSE2(uint8_t *dst, const uint8_t *src, unsigned count,
+                           int alpha, bool swap_rb)
+{
+    const __m128i zero = _mm_setzero_si128();
+    unsigned i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i d = _mm_loadu_si128((const __m128i *)&dst[4 * i]);
+        __m128i s = _mm_loadu_si128((const __m128i *)&src[4 * i]);
+        if (swap_rb)
+            s = _mm_or_si128(_mm_and_si128(s, _mm_set1_epi32(0xff00ff00)),
+                    _mm_or_si128(_mm_and_si128(_mm_srli_epi32(s, 16), _mm_set1_epi32(0xff)),
+                                 _mm_slli_epi32(_mm_and_si128(s, _mm_set1_epi32(0xff)), 16)));
+
+        const __m128i lo = MergeRGBX_SSE2(_mm_unpacklo_epi8(d, zero),
+                                          _mm_unpacklo_epi8(s, zero), alpha);
+        const __m128i hi = MergeRGBX_SSE2(_mm_unpackhi_epi8(d, zero),
+                                          _mm_unpackhi_epi8(s, zero), alpha);
+        _mm_storeu_si128((__m128i *)&dst[4 * i], _mm_packus_epi16(lo, hi));
+    }
+    BlendRGBX_C(&dst[4 * i], &src[4 * i], count - i, alpha, swap_rb);
+}
+
+static const blend_kernels_t kernels_sse2 = {
+    "sse2",
+    BlendY8_SSE2, BlendUV8_SSE2, BlendNV8_SSE2,
+    BlendY10_SSE2, BlendNV10_SSE2, BlendRGBX_SSE2,
+};
+#endif
+
+#ifdef HAVE_AVX2_INTRINSICS
+/* Same as the SSE2 kernels, twice as wide. Unpacks and packs work within
+ * 128 bits lanes, hence the 64 bits permutations around them. */
+# define AVX2_TARGET __attribute__ ((__target__ ("avx2")))
+
+AVX2_TARGET
+static inline __m256i Div255_AVX2(__m256i v)
+{
+    return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(v, _mm256_srli_epi16(v, 8)),
+                                              _mm256_set1_epi16(1)), 8);
+}
+
+AVX2_TARGET
+static inline __m256i Div255x32_AVX2(__m256i v)
+{
+    return _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(v, _mm256_srli_epi32(v, 8)),
+                                              _mm256_set1_epi32(1)), 8);
+}
+
+AVX2_TARGET
+static inline __m256i Alpha_AVX2(__m256i src_a, int alpha)
+{
+    return Div255_AVX2(_mm256_mullo_epi16(src_a, _mm256_set1_epi16(alpha)));
+}
+
+AVX2_TARGET
+static inline __m256i Merge_AVX2(__m256i dst, __m256i src, __m256i a)
+{
+    const __m256i na = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    return Div255_AVX2(_mm256_add_epi16(_mm256_mullo_epi16(dst, na),
+                                        _mm256_mullo_epi16(src, a)));
+}
+
+AVX2_TARGET
+static inline __m256i Merge10_AVX2(__m256i dst, __m256i src, __m256i a)
+{
+    const __m256i value = _mm256_srli_epi16(dst, 6);
+    src = _mm256_sub_epi16(_mm256_sub_epi16(_mm256_slli_epi16(src, 2),
+                                            _mm256_cmpgt_epi16(src, _mm256_set1_epi16(84))),
+                           _mm256_add_epi16(_mm256_cmpgt_epi16(src, _mm256_set1_epi16(169)),
+                                            _mm256_cmpgt_epi16(src, _mm256_set1_epi16(254))));
+
+    const __m256i na = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+    const __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(value, src),
+                                         _mm256_unpacklo_epi16(na, a));
+    const __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(value, src),
+                                         _mm256_unpackhi_epi16(na, a));
+    const __m256i merged = _mm256_slli_epi16(_mm256_packs_epi32(Div255x32_AVX2(lo),
+                                                                Div255x32_AVX2(hi)), 6);
+    return _mm256_blendv_epi8(merged, dst,
+                              _mm256_cmpeq_epi16(a, _mm256_setzero_si256()));
+}
+
+AVX2_TARGET
+static inline __m256i LoadEven_AVX2(const uint8_t *p)
+{
+    return _mm256_and_si256(_mm256_loadu_si256((const __m256i *)p),
+                            _mm256_set1_epi16(0xff));
+}
+
+AVX2_TARGET
+static inline __m256i Load16_AVX2(const uint8_t *p)
+{
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)p));
+}
+
+/* Interleave 2 x 16 samples into 2 x 8 pairs, in order */
+AVX2_TARGET
+static inline void Interleave_AVX2(__m256i *lo, __m256i *hi, __m256i u, __m256i v)
+{
+    u = _mm256_permute4x64_epi64(u, 0xd8);
+    v = _mm256_permute4x64_epi64(v, 0xd8);
+    *lo = _mm256_unpacklo_epi16(u, v);
+    *hi = _mm256_unpackhi_epi16(u, v);
+}
+
+AVX2_TARGET
+static inline __m256i Pack_AVX2(__m256i lo, __m256i hi)
+{
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+}
+
+AVX2_TARGET
+static void BlendY8_AVX2(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                         unsigned count, int alpha)
+{
+    unsigned i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const __m256i lo = Merge_AVX2(Load16_AVX2(&dst[i]), Load16_AVX2(&src[i]),
+                                      Alpha_AVX2(Load16_AVX2(&src_a[i]), alpha));
+        const __m256i hi = Merge_AVX2(Load16_AVX2(&dst[i + 16]), Load16_AVX2(&src[i + 16]),
+                                      Alpha_AVX2(Load16_AVX2(&src_a[i + 16]), alpha));
+        _mm256_storeu_si256((__m256i *)&dst[i], Pack_AVX2(lo, hi));
+    }
+    BlendY8_SSE2(&dst[i], &src[i], &src_a[i], count - i, alpha);
+}
+
+AVX2_TARGET
+static void BlendUV8_AVX2(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                          unsigned count, int alpha)
+{
+    unsigned i = 0;
+    for (; i + 16 < count; i += 16) {
+        const __m256i r = Merge_AVX2(Load16_AVX2(&dst[i]), LoadEven_AVX2(&src[2 * i]),
+                                     Alpha_AVX2(LoadEven_AVX2(&src_a[2 * i]), alpha));
+        _mm_storeu_si128((__m128i *)&dst[i],
+                         _mm256_castsi256_si128(Pack_AVX2(r, r)));
+    }
+    BlendUV8_SSE2(&dst[i], &src[2 * i], &src_a[2 * i], count - i, alpha);
+}
+
+AVX2_TARGET
+static void BlendNV8_AVX2(uint8_t *dst, const uint8_t *src_u, const uint8_t *src_v,
+                          const uint8_t *src_a, unsigned count, int alpha)
+{
+    unsigned i = 0;
+    for (; i + 16 < count; i += 16) {
+        const __m256i a = Alpha_AVX2(LoadEven_AVX2(&src_a[2 * i]), alpha);
+        __m256i uv_lo, uv_hi, a_lo, a_hi;
+        Interleave_AVX2(&uv_lo, &uv_hi, LoadEven_AVX2(&src_u[2 * i]),
+                                        LoadEven_AVX2(&src_v[2 * i]));
+        Interleave_AVX2(&a_lo, &a_hi, a, a);
+
+        const __m256i lo = Merge_AVX2(Load16_AVX2(&dst[2 * i]), uv_lo, a_lo);
+        const __m256i hi = Merge_AVX2(Load16_AVX2(&dst[2 * i + 16]), uv_hi, a_hi);
+        _mm256_storeu_si256((__m256i *)&dst[2 * i], Pack_AVX2(lo, hi));
+    }
+    BlendNV8_SSE2(&dst[2 * i], &src_u[2 * i], &src_v[2 * i], &src_a[2 * i],
+                  count - i, alpha);
+}
+
+AVX2_TARGET
+static void BlendY10_AVX2(uint16_t *dst, const uint8_t *src, const uint8_t *src_a,
+                          unsigned count, int alpha)
+{
+    unsigned i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i *d = (__m256i *)&dst[i];
+        _mm256_storeu_si256(d, Merge10_AVX2(_mm256_loadu_si256(d), Load16_AVX2(&src[i]),
+                                            Alpha_AVX2(Load16_AVX2(&src_a[i]), alpha)));
+    }
+    BlendY10_SSE2(&dst[i], &src[i], &src_a[i], count - i, alpha);
+}
+
+AVX2_TARGET
+static void BlendNV10_AVX2(uint16_t *dst, const uint8_t *src_u, const uint8_t *src_v,
+                           const uint8_t *src_a, unsigned count, int alpha)
+{
+    unsigned i = 0;
+    for (; i + 16 < count; i += 16) {
+        const __m256i a = Alpha_AVX2(LoadEven_AVX2(&src_a[2 * i]), alpha);
+        __m256i uv_lo, uv_hi, a_lo, a_hi;
+        Interleave_AVX2(&uv_lo, &uv_hi, LoadEven_AVX2(&src_u[2 * i]),
+                                        LoadEven_AVX2(&src_v[2 * i]));
+        Interleave_AVX2(&a_lo, &a_hi, a, a);
+
+        __m256i *d = (__m256i *)&dst[2 * i];
+        _mm256_storeu_si256(&d[0], Merge10_AVX2(_mm256_loadu_si256(&d[0]), uv_lo, a_lo));
+        _mm256_storeu_si256(&d[1], Merge10_AVX2(_mm256_loadu_si256(&d[1]), uv_hi, a_hi));
+    }
+    BlendNV10_SSE2(&dst[2 * i], &src_u[2 * i], &src_v[2 * i], &src_a[2 * i],
+                   count - i, alpha);
+}
+
+AVX2_TARGET
+static inline __m256i MergeRGBX_AVX2(__m256i dst, __m256i src, int alpha)
+{
+    __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src, 0xff), 0xff);
+    a = _mm256_and_si256(Alpha_AVX2(a, alpha),
+                         _mm256_set1_epi64x(0x0000ffffffffffff));
+    return Merge_AVX2(dst, src, a);
+}
+
+AVX2_TARGET
+static void BlendRGBX_AVX2(uint8_t *dst, const uint8_t *src, unsigned count,
+                           int alpha, bool swap_rb)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i d = _mm256_loadu_si256((const __m256i *)&dst[4 * i]);
+        __m256i s = _mm256_loadu_si256((const __m256i *)&src[4 * i]);
+        if (swap_rb)
+            s = _mm256_shuffle_epi8(s, _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7,
+                                                        10, 9, 8, 11, 14, 13, 12, 15,
+                                                        2, 1, 0, 3, 6, 5, 4, 7,
+                                                        10, 9, 8, 11, 14, 13, 12, 15));
+
+        /* unpacking and packing back within lanes keeps the pixel order */
+        const __m256i lo = MergeRGBX_AVX2(_mm256_unpacklo_epi8(d, zero),
+                                          _mm256_unpacklo_epi8(s, zero), alpha);
+        const __m256i hi = MergeRGBX_AVX2(_mm256_unpackhi_epi8(d, zero),
+                                          _mm256_unpackhi_epi8(s, zero), alpha);
+        _mm256_storeu_si256((__m256i *)&dst[4 * i], _mm256_packus_epi16(lo, hi));
+    }
+    BlendRGBX_SSE2(&dst[4 * i], &src[4 * i], count - i, alpha, swap_rb);
+}
+
+static const blend_kernels_t kernels_avx2 = {
+    "avx2",
+    BlendY8_AVX2, BlendUV8_AVX2, BlendNV8_AVX2,
+    BlendY10_AVX2, BlendNV10_AVX2, BlendRGBX_AVX2,
+};
+#endif
+
+#ifdef BLEND_HAVE_NEON
+static inline uint16x8_t Div255_NEON(uint16x8_t v)
+{
+    return vshrq_n_u16(vaddq_u16(vaddq_u16(v, vshrq_n_u16(v, 8)), vdupq_n_u16(1)), 8);
+}
+
+static inline uint32x4_t Div255x32_NEON(uint32x4_t v)
+{
+    return vshrq_n_u32(vaddq_u32(vaddq_u32(v, vshrq_n_u32(v, 8)), vdupq_n_u32(1)), 8);
+}
+
+static inline uint8x8_t Alpha_NEON(uint8x8_t src_a, uint8x8_t alpha)
+{
+    return vmovn_u16(Div255_NEON(vmull_u8(src_a, alpha)));
+}
+
+static inline uint8x8_t Merge_NEON(uint8x8_t dst, uint8x8_t src, uint8x8_t a)
+{
+    const uint16x8_t v = vmlal_u8(vmull_u8(dst, vsub_u8(vdup_n_u8(255), a)), src, a);
+    return vmovn_u16(Div255_NEON(v));
+}
+
+static inline uint16x8_t Merge10_NEON(uint16x8_t dst, uint8x8_t src, uint8x8_t a8)
+{
+    const uint16x8_t value = vshrq_n_u16(dst, 6);
+    /* src * 1023 / 255 == 4 * src + (src >= 85) + (src >= 170) + (src >= 255) */
+    uint8x8_t round = vshr_n_u8(vcge_u8(src, vdup_n_u8(85)), 7);
+    round = vadd_u8(round, vshr_n_u8(vcge_u8(src, vdup_n_u8(170)), 7));
+    round = vadd_u8(round, vshr_n_u8(vceq_u8(src, vdup_n_u8(255)), 7));
+    const uint16x8_t s = vaddw_u8(vshll_n_u8(src, 2), round);
+
+    const uint16x8_t a  = vmovl_u8(a8);
+    const uint16x8_t na = vsubq_u16(vdupq_n_u16(255), a);
+    uint32x4_t lo = vmull_u16(vget_low_u16(value), vget_low_u16(na));
+    uint32x4_t hi = vmull_u16(vget_high_u16(value), vget_high_u16(na));
+    lo = vmlal_u16(lo, vget_low_u16(s), vget_low_u16(a));
+    hi = vmlal_u16(hi, vget_high_u16(s), vget_high_u16(a));
+    const uint16x8_t merged = vshlq_n_u16(vcombine_u16(vmovn_u32(Div255x32_NEON(lo)),
+                                                       vmovn_u32(Div255x32_NEON(hi))), 6);
+    return vbslq_u16(vceqq_u16(a, vdupq_n_u16(0)), dst, merged);
+}
+
+static void BlendY8_NEON(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                         unsigned count, int alpha)
+{
+    const uint8x8_t valpha = vdup_n_u8(alpha);
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const uint8x8_t a = Alpha_NEON(vld1_u8(&src_a[i]), valpha);
+        vst1_u8(&dst[i], Merge_NEON(vld1_u8(&dst[i]), vld1_u8(&src[i]), a));
+    }
+    BlendY8_C(&dst[i], &src[i], &src_a[i], count - i, alpha);
+}
+
+static void BlendUV8_NEON(uint8_t *dst, const uint8_t *src, const uint8_t *src_a,
+                          unsigned count, int alpha)
+{
+    const uint8x8_t valpha = vdup_n_u8(alpha);
+    unsigned i = 0;
+    for (; i + 8 < count; i += 8) {
+        const uint8x8_t a = Alpha_NEON(vld2_u8(&src_a[2 * i]).val[0], valpha);
+        vst1_u8(&dst[i], Merge_NEON(vld1_u8(&dst[i]), vld2_u8(&src[2 * i]).val[0], a));
+    }
+    BlendUV8_C(&dst[i], &src[2 * i], &src_a[2 * i], count - i, alpha);
+}
+
+static void BlendNV8_NEON(uint8_t *dst, const uint8_t *src_u, const uint8_t *src_v,
+                          const uint8_t *src_a, unsigned count, int alpha)
+{
+    const uint8x8_t valpha = vdup_n_u8(alpha);
+    unsigned i = 0;
+    for (; i + 8 < count; i += 8) {
+        const uint8x8_t a = Alpha_NEON(vld2_u8(&src_a[2 * i]).val[0], valpha);
+        uint8x8x2_t d = vld2_u8(&dst[2 * i]);
+        d.val[0] = Merge_NEON(d.val[0], vld2_u8(&src_u[2 * i]).val[0], a);
+        d.val[1] = Merge_NEON(d.val[1], vld2_u8(&src_v[2 * i]).val[0], a);
+        vst2_u8(&dst[2 * i], d);
+    }
+    BlendNV8_C(&dst[2 * i], &src_u[2 * i], &src_v[2 * i], &src_a[2 * i],
+               count - i, alpha);
+}
+
+static void BlendY10_NEON(uint16_t *dst, const uint8_t *src, const uint8_t *src_a,
+                          unsigned count, int alpha)
+{
+    const uint8x8_t valpha = vdup_n_u8(alpha);
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const uint8x8_t a = Alpha_NEON(vld1_u8(&src_a[i]), valpha);
+        vst1q_u16(&dst[i], Merge10_NEON(vld1q_u16(&dst[i]), vld1_u8(&src[i]), a));
+    }
+    BlendY10_C(&dst[i], &src[i], &src_a[i], count - i, alpha);
+}
+
+static void BlendNV10_NEON(uint16_t *dst, const uint8_t *src_u, const uint8_t *src_v,
+                           const uint8_t *src_a, unsigned count, int alpha)
+{
+    const uint8x8_t valpha = vdup_n_u8(alpha);
+    unsigned i = 0;
+    for (; i + 8 < count; i += 8) {
+        const uint8x8_t a = Alpha_NEON(vld2_u8(&src_a[2 * i]).val[0], valpha);
+        uint16x8x2_t d = vld2q_u16(&dst[2 * i]);
+        d.val[0] = Merge10_NEON(d.val[0], vld2_u8(&src_u[2 * i]).val[0], a);
+        d.val[1] = Merge10_NEON(d.val[1], vld2_u8(&src_v[2 * i]).val[0], a);
+        vst2q_u16(&dst[2 * i], d);
+    }
+    BlendNV10_C(&dst[2 * i], &src_u[2 * i], &src_v[2 * i], &src_a[2 * i],
+                count - i, alpha);
+}
+
+static void BlendRGBX_NEON(uint8_t *dst, const uint8_t *src, unsigned count,
+                           int alpha, bool swap_rb)
+{
+    const uint8x8_t valpha = vdup_n_u8(alpha);
+    const unsigned offset_r = swap_rb ? 2 : 0;
+    const unsigned offset_b = swap_rb ? 0 : 2;
+    unsigned i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const uint8x8x4_t s = vld4_u8(&src[4 * i]);
+        const uint8x8_t a = Alpha_NEON(s.val[3], valpha);
+        uint8x8x4_t d = vld4_u8(&dst[4 * i]);
+        d.val[offset_r] = Merge_NEON(d.val[offset_r], s.val[0], a);
+        d.val[1]        = Merge_NEON(d.val[1],        s.val[1], a);
+        d.val[offset_b] = Merge_NEON(d.val[offset_b], s.val[2], a);
+        vst4_u8(&dst[4 * i], d);
+    }
+    BlendRGBX_C(&dst[4 * i], &src[4 * i], count - i, alpha, swap_rb);
+}
+
+static const blend_kernels_t kernels_neon = {
+    "neon",
+    BlendY8_NEON, BlendUV8_NEON, BlendNV8_NEON,
+    BlendY10_NEON, BlendNV10_NEON, BlendRGBX_NEON,
+};
+#endif
+
+#ifdef HAVE_SSE2_INTRINSICS
+static bool UseSSE2()
+{
+    return vlc_CPU_SSE2();
+}
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+static bool UseAVX2()
+{
+    return vlc_CPU_AVX2();
+}
+#endif
+#ifdef BLEND_HAVE_NEON
+static bool UseNEON()
+{
+    return vlc_CPU_ARM_NEON();
+}
+#endif
+
+/* Best first */
+static const struct {
+    const blend_kernels_t *kernels;
+    bool (*usable)();
+} simd_kernels[] = {
+#ifdef HAVE_AVX2_INTRINSICS
+    { &kernels_avx2, UseAVX2 },
+#endif
+#ifdef HAVE_SSE2_INTRINSICS
+    { &kernels_sse2, UseSSE2 },
+#endif
+#ifdef BLEND_HAVE_NEON
+    { &kernels_neon, UseNEON },
+#endif
+    { NULL, NULL }, /* keep the array non empty */
+};
+
+} // namespace
+
+/* YUVA onto 4:2:0 planar, U and V destination planes are given */
+static void BlendRowsYUVAToYUV420(const CPicture &dst_data, const CPicture &src_data,
+                                  unsigned width, unsigned height, int alpha,
+                                  const blend_kernels_t *kernels,
+                                  unsigned dst_u, unsigned dst_v)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX(), dy = dst_data.getY();
+    const unsigned sx = src_data.getX(), sy = src_data.getY();
+    /* chroma samples are merged at even destination columns */
+    const unsigned first = dx % 2;
+    const unsigned chroma_count = (width - first + 1) / 2;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *src_line[4];
+        for (unsigned i = 0; i < 4; i++)
+            src_line[i] = &src->p[i].p_pixels[(sy + y) * src->p[i].i_pitch + sx];
+
+        kernels->y8(&dst->p[0].p_pixels[(dy + y) * dst->p[0].i_pitch + dx],
+                    src_line[0], src_line[3], width, alpha);
+        if ((dy + y) % 2 != 0 || chroma_count == 0)
+            continue;
+
+        const unsigned chroma_y = (dy + y) / 2, chroma_x = (dx + first) / 2;
+        kernels->uv8(&dst->p[dst_u].p_pixels[chroma_y * dst->p[dst_u].i_pitch + chroma_x],
+                     &src_line[1][first], &src_line[3][first], chroma_count, alpha);
+        kernels->uv8(&dst->p[dst_v].p_pixels[chroma_y * dst->p[dst_v].i_pitch + chroma_x],
+                     &src_line[2][first], &src_line[3][first], chroma_count, alpha);
+    }
+}
+
+static void BlendRowsYUVAToI420(const CPicture &dst_data, const CPicture &src_data,
+                                unsigned width, unsigned height, int alpha,
+                                const blend_kernels_t *kernels)
+{
+    BlendRowsYUVAToYUV420(dst_data, src_data, width, height, alpha, kernels, 1, 2);
+}
+
+static void BlendRowsYUVAToYV12(const CPicture &dst_data, const CPicture &src_data,
+                                unsigned width, unsigned height, int alpha,
+                                const blend_kernels_t *kernels)
+{
+    BlendRowsYUVAToYUV420(dst_data, src_data, width, height, alpha, kernels, 2, 1);
+}
+
+/* YUVA onto 4:2:0 semi planar, 8 or MSB aligned 10 bits */
+template <typename pixel, bool swap_uv>
+static void BlendRowsYUVAToSemiPlanar(const CPicture &dst_data, const CPicture &src_data,
+                                      unsigned width, unsigned height, int alpha,
+                                      const blend_kernels_t *kernels)
+{
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    const unsigned dx = dst_data.getX(), dy = dst_data.getY();
+    const unsigned sx = src_data.getX(), sy = src_data.getY();
+    const unsigned first = dx % 2;
+    const unsigned chroma_count = (width - first + 1) / 2;
+
+    for (unsigned y = 0; y < height; y++) {
+        const uint8_t *src_line[4];
+        for (unsigned i = 0; i < 4; i++)
+            src_line[i] = &src->p[i].p_pixels[(sy + y) * src->p[i].i_pitch + sx];
+        const uint8_t *src_u = &src_line[swap_uv ? 2 : 1][first];
+        const uint8_t *src_v = &src_line[swap_uv ? 1 : 2][first];
+
+        pixel *luma = (pixel *)&dst->p[0].p_pixels[(dy + y) * dst->p[0].i_pitch] + dx;
+        if (sizeof(pixel) == 1)
+            kernels->y8((uint8_t *)luma, src_line[0], src_line[3], width, alpha);
+        else
+            kernels->y10((uint16_t *)luma, src_line[0], src_line[3], width, alpha);
+        if ((dy + y) % 2 != 0 || chroma_count == 0)
+            continue;
+
+        pixel *chroma = (pixel *)&dst->p[1].p_pixels[(dy + y) / 2 * dst->p[1].i_pitch] + dx + first;
+        if (sizeof(pixel) == 1)
+            kernels->nv8((uint8_t *)chroma, src_u, src_v, &src_line[3][first],
+                         chroma_count, alpha);
+        else
+            kernels->nv10((uint16_t *)chroma, src_u, src_v, &src_line[3][first],
+                          chroma_count, alpha);
+    }
+}
+
+static void BlendRowsRGBAToRGB32(const CPicture &dst_data, const CPicture &src_data,
+                                 unsigned width, unsigned height, int alpha,
+                                 const blend_kernels_t *kernels)
+{
+    int offset_r, offset_g, offset_b;
+    if (GetPackedRgbIndexes(dst_data.getFormat(), &offset_r, &offset_g, &offset_b) != VLC_SUCCESS ||
+        offset_g != 1 || offset_r + offset_b != 2 || offset_r == 1) {
+        Blend<CPictureRGB32, CPictureRGBA, compose<convertNone, convertNone> >(dst_data, src_data,
+                                                                               width, height, alpha);
+        return;
+    }
+
+    const picture_t *dst = dst_data.getPicture();
+    const picture_t *src = src_data.getPicture();
+    for (unsigned y = 0; y < height; y++)
+        kernels->rgbx(&dst->p[0].p_pixels[(dst_data.getY() + y) * dst->p[0].i_pitch + 4 * dst_data.getX()],
+                      &src->p[0].p_pixels[(src_data.getY() + y) * src->p[0].i_pitch + 4 * src_data.getX()],
+                      width, alpha, offset_r == 2);
+}
+
+typedef void (*blend_rows_function_t)(const CPicture &dst_data, const CPicture &src_data,
+                                      unsigned width, unsigned height, int alpha,
+                                      const blend_kernels_t *kernels);
+
 typedef void (*blend_function_t)(const CPicture &dst_data, const CPicture &src_data,
                                  unsigned width, unsigned height, int alpha);
 
@@ -594,6 +1420,7 @@ static const struct {
     YUV(VLC_CODEC_YV12,     CPictureYV12,     convertNone),
     YUV(VLC_CODEC_NV12,     CPictureNV12,     convertNone),
     YUV(VLC_CODEC_NV21,     CPictureNV21,     convertNone),
+    YUV(VLC_CODEC_P010,     CPictureP010,     convert8To10Bits),
     YUV(VLC_CODEC_J420,     CPictureI420_8,   convertNone),
     YUV(VLC_CODEC_I420,     CPictureI420_8,   convertNone),
 #ifdef WORDS_BIGENDIAN
@@ -637,11 +1464,27 @@ static const struct {
 #undef YUV
 };
 
+static const struct {
+    vlc_fourcc_t          dst;
+    vlc_fourcc_t          src;
+    blend_rows_function_t blend;
+} row_blends[] = {
+    { VLC_CODEC_I420,  VLC_CODEC_YUVA, BlendRowsYUVAToI420 },
+    { VLC_CODEC_J420,  VLC_CODEC_YUVA, BlendRowsYUVAToI420 },
+    { VLC_CODEC_YV12,  VLC_CODEC_YUVA, BlendRowsYUVAToYV12 },
+    { VLC_CODEC_NV12,  VLC_CODEC_YUVA, BlendRowsYUVAToSemiPlanar<uint8_t,  false> },
+    { VLC_CODEC_NV21,  VLC_CODEC_YUVA, BlendRowsYUVAToSemiPlanar<uint8_t,  true> },
+    { VLC_CODEC_P010,  VLC_CODEC_YUVA, BlendRowsYUVAToSemiPlanar<uint16_t, false> },
+    { VLC_CODEC_RGB32, VLC_CODEC_RGBA, BlendRowsRGBAToRGB32 },
+};
+
 struct filter_sys_t {
-    filter_sys_t() : blend(NULL)
+    filter_sys_t() : blend(NULL), blend_rows(NULL), kernels(NULL)
     {
     }
-    blend_function_t blend;
+    blend_function_t      blend;
+    blend_rows_function_t blend_rows;
+    const blend_kernels_t *kernels;
 };
 
 } // namespace
@@ -671,13 +1514,45 @@ static void Blend(filter_t *filter,
     video_format_FixRgb(&filter->fmt_out.video);
     video_format_FixRgb(&filter->fmt_in.video);
 
-    sys->blend(CPicture(dst, &filter->fmt_out.video,
-                        filter->fmt_out.video.i_x_offset + x_offset,
-                        filter->fmt_out.video.i_y_offset + y_offset),
-               CPicture(src, &filter->fmt_in.video,
-                        filter->fmt_in.video.i_x_offset,
-                        filter->fmt_in.video.i_y_offset),
-               width, height, alpha);
+    const CPicture dst_data(dst, &filter->fmt_out.video,
+                            filter->fmt_out.video.i_x_offset + x_offset,
+                            filter->fmt_out.video.i_y_offset + y_offset);
+    const CPicture src_data(src, &filter->fmt_in.video,
+                            filter->fmt_in.video.i_x_offset,
+                            filter->fmt_in.video.i_y_offset);
+    if (sys->blend_rows)
+        sys->blend_rows(dst_data, src_data, width, height, alpha, sys->kernels);
+    else
+        sys->blend(dst_data, src_data, width, height, alpha);
+}
+
+/* The "blend-kernel" variable, when created on the filter object (see
+ * blendbench), forces the kernels: "c" for the generic code, or the name
+ * of a SIMD set, failing if it is not usable. */
+static int GetKernels(filter_t *filter, const blend_kernels_t **kernels)
+{
+    char *name = var_GetNonEmptyString(filter, "blend-kernel");
+
+    *kernels = NULL;
+    if (name != NULL && !strcmp(name, kernels_c.name)) {
+        free(name);
+        return VLC_SUCCESS;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(simd_kernels) && !*kernels; i++) {
+        if (simd_kernels[i].kernels == NULL || !simd_kernels[i].usable())
+            continue;
+        if (name == NULL || !strcmp(name, simd_kernels[i].kernels->name))
+            *kernels = simd_kernels[i].kernels;
+    }
+
+    int ret = VLC_SUCCESS;
+    if (name != NULL && *kernels == NULL) {
+        msg_Err(filter, "blending kernels %s are not usable", name);
+        ret = VLC_EGENERIC;
+    }
+    free(name);
+    return ret;
 }
 
 static int Open(vlc_object_t *object)
@@ -699,6 +1574,17 @@ static int Open(vlc_object_t *object)
         return VLC_EGENERIC;
     }
 
+    if (GetKernels(filter, &sys->kernels) != VLC_SUCCESS) {
+        delete sys;
+        return VLC_EGENERIC;
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(row_blends) && sys->kernels; i++) {
+        if (row_blends[i].src == src && row_blends[i].dst == dst)
+            sys->blend_rows = row_blends[i].blend;
+    }
+    if (sys->blend_rows)
+        msg_Dbg(filter, "using %s blending kernels", sys->kernels->name);
+
     filter->pf_video_blend = Blend;
     filter->p_sys          = sys;
     return VLC_SUCCESS;
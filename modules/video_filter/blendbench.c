@@ -68,6 +68,13 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define BLEND_CHROMA_LONGTEXT N_("Chroma which the blend image will be loaded" \
                                  " in")
 
+#define WIDTH_TEXT N_("Width of generated images")
+#define WIDTH_LONGTEXT N_("Width of the images generated when no image " \
+                          "file is given")
+#define HEIGHT_TEXT N_("Height of generated images")
+#define HEIGHT_LONGTEXT N_("Height of the images generated when no image " \
+                           "file is given")
+
 #define CFG_PREFIX "blendbench-"
 
 vlc_module_begin ()
@@ -82,6 +89,8 @@ vlc_module_begin ()
               LOOPS_LONGTEXT, false )
     add_integer_with_range( CFG_PREFIX "alpha", 128, 0, 255, ALPHA_TEXT,
               ALPHA_LONGTEXT, false )
+    add_integer( CFG_PREFIX "width", 1920, WIDTH_TEXT, WIDTH_LONGTEXT, true )
+    add_integer( CFG_PREFIX "height", 1080, HEIGHT_TEXT, HEIGHT_LONGTEXT, true )
 
     set_section( N_("Base image"), NULL )
     add_loadfile(CFG_PREFIX "base-image", NULL,
@@ -99,8 +108,8 @@ vlc_module_begin ()
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
-    "blend-chroma", NULL
+    "loops", "alpha", "width", "height", "base-image", "base-chroma",
+    "blend-image", "blend-chroma", NULL
 };
 
 /*****************************************************************************
@@ -110,6 +119,7 @@ typedef struct
 {
     bool b_done;
     int i_loops, i_alpha;
+    unsigned i_width, i_height;
 
     picture_t *p_base_image;
     picture_t *p_blend_image;
@@ -118,12 +128,70 @@ typedef struct
     vlc_fourcc_t i_blend_chroma;
 } filter_sys_t;
 
+/* Deterministic content, with fully transparent and opaque areas, so that
+ * runs can be compared */
+static picture_t *blendbench_GenerateImage( vlc_object_t *p_this,
+                                            vlc_fourcc_t i_chroma,
+                                            unsigned i_width, unsigned i_height,
+                                            const char *psz_name )
+{
+    if( i_chroma == VLC_CODEC_YUVP )
+    {
+        msg_Err( p_this, "Cannot generate a palettized %s image", psz_name );
+        return NULL;
+    }
+
+    picture_t *p_pic = picture_New( i_chroma, i_width, i_height, 1, 1 );
+    if( p_pic == NULL )
+    {
+        msg_Err( p_this, "Unable to generate %s image", psz_name );
+        return NULL;
+    }
+
+    const bool b_rgba = i_chroma == VLC_CODEC_RGBA || i_chroma == VLC_CODEC_BGRA;
+    uint32_t i_seed = 0x5eed;
+    for( int i_plane = 0; i_plane < p_pic->i_planes; i_plane++ )
+    {
+        const plane_t *p = &p_pic->p[i_plane];
+        const bool b_alpha = i_plane == A_PLANE && i_chroma == VLC_CODEC_YUVA;
+
+        for( int y = 0; y < p->i_lines; y++ )
+        {
+            uint8_t *p_line = &p->p_pixels[y * p->i_pitch];
+            for( int x = 0; x < p->i_pitch; x++ )
+            {
+                i_seed = i_seed * 1103515245 + 12345;
+                p_line[x] = i_seed >> 16;
+                /* quarter transparent, quarter opaque */
+                if( b_alpha || (b_rgba && x % 4 == 3) )
+                {
+                    const unsigned i_zone = (x / 64 + y / 64) % 4;
+                    if( i_zone < 2 )
+                        p_line[x] = i_zone ? 0xff : 0x00;
+                }
+            }
+        }
+    }
+
+    msg_Dbg( p_this, "%s image generated with dim %u x %u", psz_name,
+             i_width, i_height );
+    return p_pic;
+}
+
 static int blendbench_LoadImage( vlc_object_t *p_this, picture_t **pp_pic,
-                                 vlc_fourcc_t i_chroma, char *psz_file, const char *psz_name )
+                                 vlc_fourcc_t i_chroma, char *psz_file, const char *psz_name,
+                                 unsigned i_width, unsigned i_height )
 {
     image_handler_t *p_image;
     video_format_t fmt_out;
 
+    if( EMPTY_STR( psz_file ) )
+    {
+        *pp_pic = blendbench_GenerateImage( p_this, i_chroma, i_width,
+                                            i_height, psz_name );
+        return *pp_pic ? VLC_SUCCESS : VLC_EGENERIC;
+    }
+
     video_format_Init( &fmt_out, i_chroma );
 
     p_image = image_HandlerCreate( p_this );
@@ -173,13 +241,18 @@ static int Create( vlc_object_t *p_this )
                                                   CFG_PREFIX "loops" );
     p_sys->i_alpha = var_CreateGetIntegerCommand( p_filter,
                                                   CFG_PREFIX "alpha" );
+    p_sys->i_width = __MAX( 1, var_CreateGetInteger( p_filter,
+                                                     CFG_PREFIX "width" ) );
+    p_sys->i_height = __MAX( 1, var_CreateGetInteger( p_filter,
+                                                      CFG_PREFIX "height" ) );
 
     psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
     p_sys->i_base_chroma = !psz_temp || strlen( psz_temp ) != 4 ? 0 :
         VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
     psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-image" );
     i_ret = blendbench_LoadImage( p_this, &p_sys->p_base_image,
-                                  p_sys->i_base_chroma, psz_cmd, "Base" );
+                                  p_sys->i_base_chroma, psz_cmd, "Base",
+                                  p_sys->i_width, p_sys->i_height );
     free( psz_temp );
     free( psz_cmd );
     if( i_ret != VLC_SUCCESS )
@@ -194,7 +267,7 @@ static int Create( vlc_object_t *p_this )
         ? 0 : VLC_FOURCC( psz_temp[0], psz_temp[1], psz_temp[2], psz_temp[3] );
     psz_cmd = var_CreateGetStringCommand( p_filter, CFG_PREFIX "blend-image" );
     i_ret = blendbench_LoadImage( p_this, &p_sys->p_blend_image, p_sys->i_blend_chroma,
-                                  psz_cmd, "Blend" );
+                                  psz_cmd, "Blend", p_sys->i_width, p_sys->i_height );
 
     free( psz_temp );
     free( psz_cmd );
@@ -220,55 +293,126 @@ static void Destroy( vlc_object_t *p_this )
 
     picture_Release( p_sys->p_base_image );
     picture_Release( p_sys->p_blend_image );
+    free( p_sys );
 }
 
-/*****************************************************************************
- * Render: displays previously rendered output
- *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+/* Kernel sets of the blend module, the generic code first as the reference */
+static const char *const ppsz_kernels[] = { "c", "sse2", "avx2", "neon" };
+
+static filter_t *blendbench_CreateBlender( filter_t *p_filter,
+                                           const char *psz_kernel )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    filter_t *p_blend;
-
-    if( p_sys->b_done )
-        return p_pic;
-
-    p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
+    filter_t *p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
     if( !p_blend )
-    {
-        picture_Release( p_pic );
         return NULL;
-    }
+
     p_blend->fmt_out.video = p_sys->p_base_image->format;
     p_blend->fmt_in.video = p_sys->p_blend_image->format;
+    var_Create( p_blend, "blend-kernel", VLC_VAR_STRING );
+    var_SetString( p_blend, "blend-kernel", psz_kernel );
     p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
     if( !p_blend->p_module )
     {
-        picture_Release( p_pic );
         vlc_object_delete(p_blend);
         return NULL;
     }
+    return p_blend;
+}
+
+static void blendbench_DeleteBlender( filter_t *p_blend )
+{
+    module_unneed( p_blend, p_blend->p_module );
+    vlc_object_delete(p_blend);
+}
 
-    vlc_tick_t time = vlc_tick_now();
-    for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
+static bool blendbench_Equal( const picture_t *p_a, const picture_t *p_b )
+{
+    for( int i_plane = 0; i_plane < p_a->i_planes; i_plane++ )
     {
-        p_blend->pf_video_blend( p_blend,
-                                 p_sys->p_base_image, p_sys->p_blend_image,
-                                 0, 0, p_sys->i_alpha );
+        const plane_t *a = &p_a->p[i_plane];
+        const plane_t *b = &p_b->p[i_plane];
+        for( int y = 0; y < a->i_visible_lines; y++ )
+            if( memcmp( &a->p_pixels[y * a->i_pitch],
+                        &b->p_pixels[y * b->i_pitch], a->i_visible_pitch ) )
+                return false;
     }
-    time = vlc_tick_now() - time;
+    return true;
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    picture_t *p_reference = NULL;
+    vlc_tick_t i_reference_time = 0;
 
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              secf_from_vlc_tick(time) );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * CLOCK_FREQ,
-              (float) p_sys->i_loops / time * CLOCK_FREQ *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+    if( p_sys->b_done )
+        return p_pic;
 
-    module_unneed( p_blend, p_blend->p_module );
+    for( size_t i = 0; i < ARRAY_SIZE(ppsz_kernels); i++ )
+    {
+        const char *psz_kernel = ppsz_kernels[i];
+        filter_t *p_blend = blendbench_CreateBlender( p_filter, psz_kernel );
+        if( !p_blend )
+        {
+            if( i == 0 )
+                break;
+            msg_Dbg( p_filter, "%s kernels not available", psz_kernel );
+            continue;
+        }
+
+        /* Every run blends onto a fresh copy of the base image, so that
+         * the results of the kernels can be compared */
+        picture_t *p_base = picture_NewFromFormat( &p_sys->p_base_image->format );
+        if( !p_base )
+        {
+            blendbench_DeleteBlender( p_blend );
+            break;
+        }
+        picture_Copy( p_base, p_sys->p_base_image );
+        p_blend->pf_video_blend( p_blend, p_base, p_sys->p_blend_image,
+                                 0, 0, p_sys->i_alpha );
 
-    vlc_object_delete(p_blend);
+        if( p_reference == NULL )
+            p_reference = picture_Hold( p_base );
+        else if( !blendbench_Equal( p_reference, p_base ) )
+            msg_Err( p_filter, "%s kernels do not match the C code",
+                     psz_kernel );
+
+        vlc_tick_t time = vlc_tick_now();
+        for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
+        {
+            p_blend->pf_video_blend( p_blend,
+                                     p_base, p_sys->p_blend_image,
+                                     0, 0, p_sys->i_alpha );
+        }
+        time = __MAX( 1, vlc_tick_now() - time );
+        if( i_reference_time == 0 )
+            i_reference_time = time;
+
+        picture_Release( p_base );
+        blendbench_DeleteBlender( p_blend );
+
+        msg_Info( p_filter, "%s: blended %d images in %f sec", psz_kernel,
+                  p_sys->i_loops, secf_from_vlc_tick(time) );
+        msg_Info( p_filter, "%s: speed is %f images/second, %f pixels/second"
+                  " (x%.2f)", psz_kernel,
+                  (float) p_sys->i_loops / time * CLOCK_FREQ,
+                  (float) p_sys->i_loops / time * CLOCK_FREQ *
+                      p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
+                      p_sys->p_blend_image->p[Y_PLANE].i_visible_lines,
+                  (float) i_reference_time / time );
+    }
+
+    if( p_reference == NULL )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+    picture_Release( p_reference );
 
     p_sys->b_done = true;
     return p_pic;
@@ -46,6 +46,25 @@
  * Internal functions
  *****************************************************************************/
 
+/**
+ * Internal helper function: gets the lines of the given field belonging to
+ * the given slice, as the pointers to the first line and past the last line.
+ * The field lines are 2 lines apart.
+ */
+static void GetFieldSlice( const plane_t *p_plane, int i_field,
+                           unsigned i_slice, unsigned i_slices,
+                           uint8_t **pp_out, uint8_t **pp_out_end )
+{
+    int i_start, i_end;
+    filter_slices_GetRange( (p_plane->i_visible_lines - i_field + 1) / 2, 1,
+                            i_slice, i_slices, &i_start, &i_end );
+
+    *pp_out = p_plane->p_pixels + (i_field + 2*i_start) * p_plane->i_pitch;
+    *pp_out_end = i_end > i_start
+                ? p_plane->p_pixels + (i_field + 2*i_end - 1) * p_plane->i_pitch
+                : *pp_out;
+}
+
 /**
  * Internal helper function: dims (darkens) the given field
  * of the given picture.
@@ -65,12 +84,15 @@
  * @param p_dst Input/output picture. Will be modified in-place.
  * @param i_field Darken which field? 0 = top, 1 = bottom.
  * @param i_strength Strength of effect: 1, 2 or 3 (division by 2, 4 or 8).
+ * @param i_slice Darken the lines of this slice only.
+ * @param i_slices Total number of slices.
  * @see RenderPhosphor()
  * @see ComposeFrame()
  */
 static void DarkenField( picture_t *p_dst,
                          const int i_field, const int i_strength,
-                         bool process_chroma )
+                         bool process_chroma,
+                         unsigned i_slice, unsigned i_slices )
 {
     assert( p_dst != NULL );
     assert( i_field == 0 || i_field == 1 );
@@ -92,13 +114,8 @@ static void DarkenField( picture_t *p_dst,
     int i_plane = Y_PLANE;
     uint8_t *p_out, *p_out_end;
     int w = p_dst->p[i_plane].i_visible_pitch;
-    p_out = p_dst->p[i_plane].p_pixels;
-    p_out_end = p_out + p_dst->p[i_plane].i_pitch
-                      * p_dst->p[i_plane].i_visible_lines;
-
-    /* skip first line for bottom field */
-    if( i_field == 1 )
-        p_out += p_dst->p[i_plane].i_pitch;
+    GetFieldSlice( &p_dst->p[i_plane], i_field, i_slice, i_slices,
+                   &p_out, &p_out_end );
 
     int wm8 = w % 8;   /* remainder */
     int w8  = w - wm8; /* part of width that is divisible by 8 */
@@ -129,13 +146,8 @@ static void DarkenField( picture_t *p_dst,
              i_plane++ )
         {
             w = p_dst->p[i_plane].i_visible_pitch;
-            p_out = p_dst->p[i_plane].p_pixels;
-            p_out_end = p_out + p_dst->p[i_plane].i_pitch
-                              * p_dst->p[i_plane].i_visible_lines;
-
-            /* skip first line for bottom field */
-            if( i_field == 1 )
-                p_out += p_dst->p[i_plane].i_pitch;
+            GetFieldSlice( &p_dst->p[i_plane], i_field, i_slice, i_slices,
+                           &p_out, &p_out_end );
 
             for( ; p_out < p_out_end ; p_out += 2*p_dst->p[i_plane].i_pitch )
             {
@@ -152,7 +164,8 @@ static void DarkenField( picture_t *p_dst,
 VLC_MMX
 static void DarkenFieldMMX( picture_t *p_dst,
                             const int i_field, const int i_strength,
-                            bool process_chroma )
+                            bool process_chroma,
+                            unsigned i_slice, unsigned i_slices )
 {
     assert( p_dst != NULL );
     assert( i_field == 0 || i_field == 1 );
@@ -166,13 +179,8 @@ static void DarkenFieldMMX( picture_t *p_dst,
     int i_plane = Y_PLANE;
     uint8_t *p_out, *p_out_end;
     int w = p_dst->p[i_plane].i_visible_pitch;
-    p_out = p_dst->p[i_plane].p_pixels;
-    p_out_end = p_out + p_dst->p[i_plane].i_pitch
-                      * p_dst->p[i_plane].i_visible_lines;
-
-    /* skip first line for bottom field */
-    if( i_field == 1 )
-        p_out += p_dst->p[i_plane].i_pitch;
+    GetFieldSlice( &p_dst->p[i_plane], i_field, i_slice, i_slices,
+                   &p_out, &p_out_end );
 
     int wm8 = w % 8;   /* remainder */
     int w8  = w - wm8; /* part of width that is divisible by 8 */
@@ -215,13 +223,8 @@ static void DarkenFieldMMX( picture_t *p_dst,
             wm8 = w % 8;   /* remainder */
             w8  = w - wm8; /* part of width that is divisible by 8 */
 
-            p_out = p_dst->p[i_plane].p_pixels;
-            p_out_end = p_out + p_dst->p[i_plane].i_pitch
-                              * p_dst->p[i_plane].i_visible_lines;
-
-            /* skip first line for bottom field */
-            if( i_field == 1 )
-                p_out += p_dst->p[i_plane].i_pitch;
+            GetFieldSlice( &p_dst->p[i_plane], i_field, i_slice, i_slices,
+                           &p_out, &p_out_end );
 
             for( ; p_out < p_out_end ; p_out += 2*p_dst->p[i_plane].i_pitch )
             {
@@ -271,6 +274,30 @@ static void DarkenFieldMMX( picture_t *p_dst,
 }
 #endif
 
+/** Internal helper for RenderPhosphor(): DarkenField() parameters. */
+struct darken_slices
+{
+    picture_t *p_dst;
+    int i_field;
+    int i_strength;
+    bool process_chroma;
+};
+
+static void DarkenFieldSlice( void *opaque, unsigned i_slice,
+                              unsigned i_slices )
+{
+    const struct darken_slices *ctx = opaque;
+
+#ifdef CAN_COMPILE_MMXEXT
+    if( vlc_CPU_MMXEXT() )
+        DarkenFieldMMX( ctx->p_dst, ctx->i_field, ctx->i_strength,
+                        ctx->process_chroma, i_slice, i_slices );
+    else
+#endif
+        DarkenField( ctx->p_dst, ctx->i_field, ctx->i_strength,
+                     ctx->process_chroma, i_slice, i_slices );
+}
+
 /*****************************************************************************
  * Public functions
  *****************************************************************************/
@@ -357,16 +384,16 @@ int RenderPhosphor( filter_t *p_filter,
     */
     if( p_sys->phosphor.i_dimmer_strength > 0 )
     {
-#ifdef CAN_COMPILE_MMXEXT
-        if( vlc_CPU_MMXEXT() )
-            DarkenFieldMMX( p_dst, !i_field, p_sys->phosphor.i_dimmer_strength,
-                p_sys->chroma->p[1].h.num == p_sys->chroma->p[1].h.den &&
-                p_sys->chroma->p[2].h.num == p_sys->chroma->p[2].h.den );
-        else
-#endif
-            DarkenField( p_dst, !i_field, p_sys->phosphor.i_dimmer_strength,
+        struct darken_slices ctx = {
+            .p_dst = p_dst,
+            .i_field = !i_field,
+            .i_strength = p_sys->phosphor.i_dimmer_strength,
+            .process_chroma =
                 p_sys->chroma->p[1].h.num == p_sys->chroma->p[1].h.den &&
-                p_sys->chroma->p[2].h.num == p_sys->chroma->p[2].h.den );
+                p_sys->chroma->p[2].h.num == p_sys->chroma->p[2].h.den,
+        };
+        filter_slices_Run( p_sys->p_slices, p_sys->i_slices,
+                           DarkenFieldSlice, &ctx );
     }
     return VLC_SUCCESS;
 }
@@ -507,13 +507,18 @@ static inline void XDeintBand8x8MMXEXT( uint8_t *dst, int i_dst,
 }
 #endif
 
-/*****************************************************************************
- * Public functions
- *****************************************************************************/
+struct x_slices
+{
+    picture_t *p_outpic;
+    picture_t *p_pic;
+};
 
-int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+/* Renders the bands of 8 lines of each plane belonging to the given slice */
+static void RenderXSlice( void *opaque, unsigned i_slice, unsigned i_slices )
 {
-    VLC_UNUSED(p_filter);
+    const struct x_slices *ctx = opaque;
+    picture_t *p_outpic = ctx->p_outpic;
+    picture_t *p_pic = ctx->p_pic;
     int i_plane;
 #if defined (CAN_COMPILE_MMXEXT)
     const bool mmxext = vlc_CPU_MMXEXT();
@@ -531,9 +536,13 @@ int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
         const int i_dst = p_outpic->p[i_plane].i_pitch;
         const int i_src = p_pic->p[i_plane].i_pitch;
 
-        int y, x;
+        int y, x, y_start, y_end;
+
+        /* The last, partial band counts as one */
+        filter_slices_GetRange( i_mby + ( i_mody ? 1 : 0 ), 1,
+                                i_slice, i_slices, &y_start, &y_end );
 
-        for( y = 0; y < i_mby; y++ )
+        for( y = y_start; y < y_end && y < i_mby; y++ )
         {
             uint8_t *dst = &p_outpic->p[i_plane].p_pixels[8*y*i_dst];
             uint8_t *src = &p_pic->p[i_plane].p_pixels[8*y*i_src];
@@ -547,7 +556,7 @@ int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
         }
 
         /* Last line (C only)*/
-        if( i_mody )
+        if( i_mody && y == i_mby && y < y_end )
         {
             uint8_t *dst = &p_outpic->p[i_plane].p_pixels[8*y*i_dst];
             uint8_t *src = &p_pic->p[i_plane].p_pixels[8*y*i_src];
@@ -569,5 +578,17 @@ int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
     if( mmxext )
         emms();
 #endif
+}
+
+/*****************************************************************************
+ * Public functions
+ *****************************************************************************/
+
+int RenderX( filter_t *p_filter, picture_t *p_outpic, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    struct x_slices ctx = { .p_outpic = p_outpic, .p_pic = p_pic };
+
+    filter_slices_Run( p_sys->p_slices, p_sys->i_slices, RenderXSlice, &ctx );
     return VLC_SUCCESS;
 }
@@ -287,6 +287,11 @@ static void Close( vlc_object_t *p_this );
                                     "Best simulation, but requires more CPU "\
                                     "and memory bandwidth.")
 
+#define THREADS_TEXT N_("Threads")
+#define THREADS_LONGTEXT N_("Number of threads used to render each " \
+                            "picture (0 = one per CPU, 1 = no threading). " \
+                            "The output does not depend on this value.")
+
 #define PHOSPHOR_DIMMER_TEXT N_("Phosphor old field dimmer strength")
 #define PHOSPHOR_DIMMER_LONGTEXT N_("This controls the strength of the "\
                                     "darkening filter that simulates CRT TV "\
@@ -313,6 +318,9 @@ vlc_module_begin ()
                 PHOSPHOR_DIMMER_LONGTEXT, true )
         change_integer_list( phosphor_dimmer_list, phosphor_dimmer_list_text )
         change_safe ()
+    add_integer_with_range( FILTER_CFG_PREFIX "threads", 0, 0, FILTER_SLICES_MAX,
+                            THREADS_TEXT, THREADS_LONGTEXT, true )
+        change_safe ()
     add_shortcut( "deinterlace" )
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -328,7 +336,7 @@ vlc_module_end ()
  * and reading logic for them implemented in Open().
  */
 static const char *const ppsz_filter_options[] = {
-    "mode", "phosphor-chroma", "phosphor-dimmer",
+    "mode", "phosphor-chroma", "phosphor-dimmer", "threads",
     NULL
 };
 
@@ -636,6 +644,13 @@ notsupp:
     }
     free( psz_mode );
 
+    /* Slice threading: only the algorithms using filter_slices_Run() benefit */
+    unsigned i_threads = var_GetInteger( p_filter, FILTER_CFG_PREFIX "threads" );
+    if( i_threads == 0 )
+        i_threads = FILTER_SLICES_MAX;
+    p_sys->i_slices = VLC_CLIP( i_threads, 1, FILTER_SLICES_MAX );
+    p_sys->p_slices = p_sys->i_slices > 1 ? filter_slices_Hold() : NULL;
+
     if( !p_filter->b_allow_fmt_out_change &&
         ( fmt.i_chroma != p_filter->fmt_in.video.i_chroma ||
           fmt.i_height != p_filter->fmt_in.video.i_height ) )
@@ -661,7 +676,10 @@ notsupp:
 void Close( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t*)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
 
     Flush( p_filter );
-    free( p_filter->p_sys );
+    if( p_sys->p_slices )
+        filter_slices_Release( p_sys->p_slices );
+    free( p_sys );
 }
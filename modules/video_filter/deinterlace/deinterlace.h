@@ -34,6 +34,7 @@ struct vlc_object_t;
 
 #include <vlc_common.h>
 #include <vlc_mouse.h>
+#include <vlc_filter.h>
 
 /* Local algorithm headers */
 #include "algo_basic.h"
@@ -77,6 +78,10 @@ typedef struct
 
     struct deinterlace_ctx   context;
 
+    /** Shared worker threads, NULL if rendering on the filter thread only */
+    filter_slices_t *p_slices;
+    unsigned         i_slices; /**< Maximum number of slices per picture */
+
     /* Algorithm-specific substructures */
     union {
         phosphor_sys_t phosphor; /**< Phosphor algorithm state. */
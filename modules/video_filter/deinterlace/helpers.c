@@ -94,6 +94,37 @@ static void FieldFromPlane( plane_t *p_dst, const plane_t *p_src, int i_field )
         p_dst->p_pixels += p_src->i_pitch;
 }
 
+/**
+ * This internal function copies the lines of the given slice between two
+ * planes, using plane_CopyPixels().
+ *
+ * The lines that both planes can hold are split in slices as done by
+ * filter_slices_GetRange(). The slices can be copied concurrently.
+ *
+ * @param p_dst Destination plane.
+ * @param p_src Source plane.
+ * @param i_slice Slice to copy.
+ * @param i_slices Total number of slices.
+ * @see ComposeFrame()
+ */
+static void CopyPlaneSlice( plane_t *p_dst, const plane_t *p_src,
+                            unsigned i_slice, unsigned i_slices )
+{
+    int i_start, i_end;
+    filter_slices_GetRange( __MIN( p_dst->i_visible_lines,
+                                   p_src->i_visible_lines ), 1,
+                            i_slice, i_slices, &i_start, &i_end );
+
+    plane_t dst = *p_dst;
+    plane_t src = *p_src;
+    dst.p_pixels += i_start * dst.i_pitch;
+    src.p_pixels += i_start * src.i_pitch;
+    dst.i_lines = dst.i_visible_lines = i_end - i_start;
+    src.i_lines = src.i_visible_lines = i_end - i_start;
+
+    plane_CopyPixels( &dst, &src );
+}
+
 #define T 10
 /**
  * Internal helper function for EstimateNumBlocksWithMotion():
@@ -251,24 +282,27 @@ static int TestForMotionInBlockMMX( uint8_t *p_pix_p, uint8_t *p_pix_c,
  * Public functions
  *****************************************************************************/
 
-/* See header for function doc. */
-void ComposeFrame( filter_t *p_filter,
-                   picture_t *p_outpic,
-                   picture_t *p_inpic_top, picture_t *p_inpic_bottom,
-                   compose_chroma_t i_output_chroma, bool swapped_uv_conversion )
+/** Internal helper for ComposeFrame(): its parameters. */
+struct compose_slices
 {
-    assert( p_outpic != NULL );
-    assert( p_inpic_top != NULL );
-    assert( p_inpic_bottom != NULL );
-
-    /* Valid 4:2:0 chroma handling modes. */
-    assert( i_output_chroma == CC_ALTLINE       ||
-            i_output_chroma == CC_UPCONVERT     ||
-            i_output_chroma == CC_SOURCE_TOP    ||
-            i_output_chroma == CC_SOURCE_BOTTOM ||
-            i_output_chroma == CC_MERGE );
-
-    filter_sys_t *p_sys = p_filter->p_sys;
+    filter_t *p_filter;
+    picture_t *p_outpic;
+    picture_t *p_inpic_top;
+    picture_t *p_inpic_bottom;
+    compose_chroma_t i_output_chroma;
+    bool swapped_uv_conversion;
+};
+
+static void ComposeFrameSlice( void *opaque, unsigned i_slice,
+                               unsigned i_slices )
+{
+    const struct compose_slices *ctx = opaque;
+    filter_sys_t *p_sys = ctx->p_filter->p_sys;
+    picture_t *p_outpic = ctx->p_outpic;
+    picture_t *p_inpic_top = ctx->p_inpic_top;
+    picture_t *p_inpic_bottom = ctx->p_inpic_bottom;
+    const compose_chroma_t i_output_chroma = ctx->i_output_chroma;
+    const bool swapped_uv_conversion = ctx->swapped_uv_conversion;
 
     const bool b_upconvert_chroma = i_output_chroma == CC_UPCONVERT;
 
@@ -309,8 +343,8 @@ void ComposeFrame( filter_t *p_filter,
             FieldFromPlane( &src_bottom, &p_inpic_bottom->p[i_plane], 1 );
 
             /* Copy each field from the corresponding source. */
-            plane_CopyPixels( &dst_top,    &src_top    );
-            plane_CopyPixels( &dst_bottom, &src_bottom );
+            CopyPlaneSlice( &dst_top,    &src_top,    i_slice, i_slices );
+            CopyPlaneSlice( &dst_bottom, &src_bottom, i_slice, i_slices );
         }
         else /* Input 4:2:0, on a chroma plane, and not in altline mode. */
         {
@@ -333,35 +367,46 @@ void ComposeFrame( filter_t *p_filter,
                 FieldFromPlane( &dst_bottom, &p_outpic->p[i_out_plane], 1 );
 
                 /* Copy each field from the corresponding source. */
-                plane_CopyPixels( &dst_top,    &p_inpic_top->p[i_plane]    );
-                plane_CopyPixels( &dst_bottom, &p_inpic_bottom->p[i_plane] );
+                CopyPlaneSlice( &dst_top,    &p_inpic_top->p[i_plane],
+                                i_slice, i_slices );
+                CopyPlaneSlice( &dst_bottom, &p_inpic_bottom->p[i_plane],
+                                i_slice, i_slices );
             }
             else if( i_output_chroma == CC_SOURCE_TOP )
             {
                 /* Copy chroma of input top field. Ignore chroma of input
                    bottom field. Input and output are both 4:2:0, so we just
                    copy the whole plane. */
-                plane_CopyPixels( &p_outpic->p[i_out_plane],
-                                  &p_inpic_top->p[i_plane] );
+                CopyPlaneSlice( &p_outpic->p[i_out_plane],
+                                &p_inpic_top->p[i_plane], i_slice, i_slices );
             }
             else if( i_output_chroma == CC_SOURCE_BOTTOM )
             {
                 /* Copy chroma of input bottom field. Ignore chroma of input
                    top field. Input and output are both 4:2:0, so we just
                    copy the whole plane. */
-                plane_CopyPixels( &p_outpic->p[i_out_plane],
-                                  &p_inpic_bottom->p[i_plane] );
+                CopyPlaneSlice( &p_outpic->p[i_out_plane],
+                                &p_inpic_bottom->p[i_plane],
+                                i_slice, i_slices );
             }
             else /* i_output_chroma == CC_MERGE */
             {
                 /* Average the chroma of the input fields.
                    Input and output are both 4:2:0. */
+                int i_start, i_end;
+                filter_slices_GetRange( p_outpic->p[i_out_plane].i_visible_lines,
+                                        1, i_slice, i_slices,
+                                        &i_start, &i_end );
+
                 uint8_t *p_in_top, *p_in_bottom, *p_out_end, *p_out;
-                p_in_top    = p_inpic_top->p[i_plane].p_pixels;
-                p_in_bottom = p_inpic_bottom->p[i_plane].p_pixels;
-                p_out = p_outpic->p[i_out_plane].p_pixels;
+                p_in_top    = p_inpic_top->p[i_plane].p_pixels
+                            + i_start * p_inpic_top->p[i_plane].i_pitch;
+                p_in_bottom = p_inpic_bottom->p[i_plane].p_pixels
+                            + i_start * p_inpic_bottom->p[i_plane].i_pitch;
+                p_out = p_outpic->p[i_out_plane].p_pixels
+                      + i_start * p_outpic->p[i_out_plane].i_pitch;
                 p_out_end = p_out + p_outpic->p[i_out_plane].i_pitch
-                                  * p_outpic->p[i_out_plane].i_visible_lines;
+                                  * (i_end - i_start);
 
                 int w = FFMIN3( p_inpic_top->p[i_plane].i_visible_pitch,
                                 p_inpic_bottom->p[i_plane].i_visible_pitch,
@@ -381,35 +426,62 @@ void ComposeFrame( filter_t *p_filter,
 }
 
 /* See header for function doc. */
-int EstimateNumBlocksWithMotion( const picture_t* p_prev,
-                                 const picture_t* p_curr,
-                                 int *pi_top, int *pi_bot)
+void ComposeFrame( filter_t *p_filter,
+                   picture_t *p_outpic,
+                   picture_t *p_inpic_top, picture_t *p_inpic_bottom,
+                   compose_chroma_t i_output_chroma, bool swapped_uv_conversion )
 {
-    assert( p_prev != NULL );
-    assert( p_curr != NULL );
+    assert( p_outpic != NULL );
+    assert( p_inpic_top != NULL );
+    assert( p_inpic_bottom != NULL );
 
-    int i_score_top = 0;
-    int i_score_bot = 0;
+    /* Valid 4:2:0 chroma handling modes. */
+    assert( i_output_chroma == CC_ALTLINE       ||
+            i_output_chroma == CC_UPCONVERT     ||
+            i_output_chroma == CC_SOURCE_TOP    ||
+            i_output_chroma == CC_SOURCE_BOTTOM ||
+            i_output_chroma == CC_MERGE );
 
-    if( p_prev->i_planes != p_curr->i_planes )
-        return -1;
+    struct compose_slices ctx = {
+        .p_filter = p_filter,
+        .p_outpic = p_outpic,
+        .p_inpic_top = p_inpic_top,
+        .p_inpic_bottom = p_inpic_bottom,
+        .i_output_chroma = i_output_chroma,
+        .swapped_uv_conversion = swapped_uv_conversion,
+    };
+    filter_sys_t *p_sys = p_filter->p_sys;
+    filter_slices_Run( p_sys->p_slices, p_sys->i_slices,
+                       ComposeFrameSlice, &ctx );
+}
 
-    int (*motion_in_block)(uint8_t *, uint8_t *, int , int, int *, int *) =
-        TestForMotionInBlock;
-    /* We must tell our inline helper whether to use MMX acceleration. */
-#ifdef CAN_COMPILE_MMXEXT
-    if (vlc_CPU_MMXEXT())
-        motion_in_block = TestForMotionInBlockMMX;
-#endif
+/**
+ * Internal helper for EstimateNumBlocksWithMotion(): the pictures, and the
+ * block counts of each slice. The slice counts are summed by the caller.
+ */
+struct motion_slices
+{
+    const picture_t *p_prev;
+    const picture_t *p_curr;
+    int (*motion_in_block)(uint8_t *, uint8_t *, int , int, int *, int *);
+    int pi_score[FILTER_SLICES_MAX];
+    int pi_score_top[FILTER_SLICES_MAX];
+    int pi_score_bot[FILTER_SLICES_MAX];
+};
+
+static void EstimateNumBlocksWithMotionSlice( void *opaque, unsigned i_slice,
+                                              unsigned i_slices )
+{
+    struct motion_slices *ctx = opaque;
+    const picture_t *p_prev = ctx->p_prev;
+    const picture_t *p_curr = ctx->p_curr;
 
     int i_score = 0;
+    int i_score_top = 0;
+    int i_score_bot = 0;
+
     for( int i_plane = 0 ; i_plane < p_prev->i_planes ; i_plane++ )
     {
-        /* Sanity check */
-        if( p_prev->p[i_plane].i_visible_lines !=
-            p_curr->p[i_plane].i_visible_lines )
-            return -1;
-
         const int i_pitch_prev = p_prev->p[i_plane].i_pitch;
         const int i_pitch_curr = p_curr->p[i_plane].i_pitch;
 
@@ -420,7 +492,11 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
                              p_curr->p[i_plane].i_visible_pitch );
         const int i_mbx = w / 8;
 
-        for( int by = 0; by < i_mby; ++by )
+        int i_start, i_end;
+        filter_slices_GetRange( i_mby, 1, i_slice, i_slices,
+                                &i_start, &i_end );
+
+        for( int by = i_start; by < i_end; ++by )
         {
             uint8_t *p_pix_p = &p_prev->p[i_plane].p_pixels[i_pitch_prev*8*by];
             uint8_t *p_pix_c = &p_curr->p[i_plane].p_pixels[i_pitch_curr*8*by];
@@ -428,9 +504,9 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
             for( int bx = 0; bx < i_mbx; ++bx )
             {
                 int i_top_temp, i_bot_temp;
-                i_score += motion_in_block( p_pix_p, p_pix_c,
-                                            i_pitch_prev, i_pitch_curr,
-                                            &i_top_temp, &i_bot_temp );
+                i_score += ctx->motion_in_block( p_pix_p, p_pix_c,
+                                                 i_pitch_prev, i_pitch_curr,
+                                                 &i_top_temp, &i_bot_temp );
                 i_score_top += i_top_temp;
                 i_score_bot += i_bot_temp;
 
@@ -440,6 +516,57 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
         }
     }
 
+    ctx->pi_score[i_slice] = i_score;
+    ctx->pi_score_top[i_slice] = i_score_top;
+    ctx->pi_score_bot[i_slice] = i_score_bot;
+}
+
+/* See header for function doc. */
+int EstimateNumBlocksWithMotion( filter_t *p_filter,
+                                 const picture_t* p_prev,
+                                 const picture_t* p_curr,
+                                 int *pi_top, int *pi_bot)
+{
+    assert( p_prev != NULL );
+    assert( p_curr != NULL );
+
+    if( p_prev->i_planes != p_curr->i_planes )
+        return -1;
+
+    for( int i_plane = 0 ; i_plane < p_prev->i_planes ; i_plane++ )
+    {
+        /* Sanity check */
+        if( p_prev->p[i_plane].i_visible_lines !=
+            p_curr->p[i_plane].i_visible_lines )
+            return -1;
+    }
+
+    struct motion_slices ctx = {
+        .p_prev = p_prev,
+        .p_curr = p_curr,
+        .motion_in_block = TestForMotionInBlock,
+    };
+    /* We must tell our inline helper whether to use MMX acceleration. */
+#ifdef CAN_COMPILE_MMXEXT
+    if (vlc_CPU_MMXEXT())
+        ctx.motion_in_block = TestForMotionInBlockMMX;
+#endif
+
+    filter_sys_t *p_sys = p_filter->p_sys;
+    unsigned i_slices = filter_slices_Run( p_sys->p_slices, p_sys->i_slices,
+                                           EstimateNumBlocksWithMotionSlice,
+                                           &ctx );
+
+    int i_score = 0;
+    int i_score_top = 0;
+    int i_score_bot = 0;
+    for( unsigned i = 0; i < i_slices; i++ )
+    {
+        i_score += ctx.pi_score[i];
+        i_score_top += ctx.pi_score_top[i];
+        i_score_bot += ctx.pi_score_bot[i];
+    }
+
     if( pi_top )
         (*pi_top) = i_score_top;
     if( pi_bot )
@@ -451,12 +578,25 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
 /* Threshold (value from Transcode 1.1.5) */
 #define T 100
 
+/**
+ * Internal helper for CalculateInterlaceScore(): the pictures, and the score
+ * of each slice. The slice scores are summed in order by the caller.
+ */
+struct interlace_score_slices
+{
+    const picture_t *p_pic_top;
+    const picture_t *p_pic_bot;
+    int32_t pi_score[FILTER_SLICES_MAX];
+};
+
 #ifdef CAN_COMPILE_MMXEXT
 VLC_MMX
-static int CalculateInterlaceScoreMMX( const picture_t* p_pic_top,
-                                       const picture_t* p_pic_bot )
+static void CalculateInterlaceScoreSliceMMX( void *opaque, unsigned i_slice,
+                                             unsigned i_slices )
 {
-    assert( p_pic_top->i_planes == p_pic_bot->i_planes );
+    struct interlace_score_slices *ctx = opaque;
+    const picture_t *p_pic_top = ctx->p_pic_top;
+    const picture_t *p_pic_bot = ctx->p_pic_bot;
 
     /* Amount of bits must be known for MMX, thus int32_t.
        Doesn't hurt the C implementation. */
@@ -467,20 +607,20 @@ static int CalculateInterlaceScoreMMX( const picture_t* p_pic_top,
 
     for( int i_plane = 0 ; i_plane < p_pic_top->i_planes ; ++i_plane )
     {
-        /* Sanity check */
-        if( p_pic_top->p[i_plane].i_visible_lines !=
-            p_pic_bot->p[i_plane].i_visible_lines )
-            return -1;
-
         const int i_lasty = p_pic_top->p[i_plane].i_visible_lines-1;
         const int w = FFMIN( p_pic_top->p[i_plane].i_visible_pitch,
                              p_pic_bot->p[i_plane].i_visible_pitch );
         const int wm8 = w % 8;   /* remainder */
         const int w8  = w - wm8; /* part of width that is divisible by 8 */
 
-        /* Current line / neighbouring lines picture pointers */
-        const picture_t *cur = p_pic_bot;
-        const picture_t *ngh = p_pic_top;
+        int i_start, i_end;
+        filter_slices_GetRange( i_lasty - 1, 1, i_slice, i_slices,
+                                &i_start, &i_end );
+
+        /* Current line / neighbouring lines picture pointers.
+           The bottom field is on odd lines. */
+        const picture_t *cur = (i_start % 2) ? p_pic_top : p_pic_bot;
+        const picture_t *ngh = (i_start % 2) ? p_pic_bot : p_pic_top;
         int wc = cur->p[i_plane].i_pitch;
         int wn = ngh->p[i_plane].i_pitch;
 
@@ -488,7 +628,7 @@ static int CalculateInterlaceScoreMMX( const picture_t* p_pic_top,
            works better for anime, which may contain horizontal,
            one pixel thick cartoon outlines.
         */
-        for( int y = 1; y < i_lasty; ++y )
+        for( int y = 1 + i_start; y < 1 + i_end; ++y )
         {
             uint8_t *p_c = &cur->p[i_plane].p_pixels[y*wc];     /* this line */
             uint8_t *p_p = &ngh->p[i_plane].p_pixels[(y-1)*wn]; /* prev line */
@@ -583,51 +723,33 @@ static int CalculateInterlaceScoreMMX( const picture_t* p_pic_top,
     movd_r2m( mm7, i_score_mmx );
     emms();
 
-    return i_score_mmx/255 + i_score_c;
+    /* Exact: each slice counts whole pixels */
+    ctx->pi_score[i_slice] = i_score_mmx/255 + i_score_c;
 }
 #endif
 
-/* See header for function doc. */
-int CalculateInterlaceScore( const picture_t* p_pic_top,
-                             const picture_t* p_pic_bot )
+static void CalculateInterlaceScoreSlice( void *opaque, unsigned i_slice,
+                                          unsigned i_slices )
 {
-    /*
-        We use the comb metric from the IVTC filter of Transcode 1.1.5.
-        This was found to work better for the particular purpose of IVTC
-        than RenderX()'s comb metric.
-
-        Note that we *must not* subsample at all in order to catch interlacing
-        in telecined frames with localized motion (e.g. anime with characters
-        talking, where only mouths move and everything else stays still.)
-    */
-
-    assert( p_pic_top != NULL );
-    assert( p_pic_bot != NULL );
-
-    if( p_pic_top->i_planes != p_pic_bot->i_planes )
-        return -1;
-
-#ifdef CAN_COMPILE_MMXEXT
-    if (vlc_CPU_MMXEXT())
-        return CalculateInterlaceScoreMMX( p_pic_top, p_pic_bot );
-#endif
-
+    struct interlace_score_slices *ctx = opaque;
+    const picture_t *p_pic_top = ctx->p_pic_top;
+    const picture_t *p_pic_bot = ctx->p_pic_bot;
     int32_t i_score = 0;
 
     for( int i_plane = 0 ; i_plane < p_pic_top->i_planes ; ++i_plane )
     {
-        /* Sanity check */
-        if( p_pic_top->p[i_plane].i_visible_lines !=
-            p_pic_bot->p[i_plane].i_visible_lines )
-            return -1;
-
         const int i_lasty = p_pic_top->p[i_plane].i_visible_lines-1;
         const int w = FFMIN( p_pic_top->p[i_plane].i_visible_pitch,
                              p_pic_bot->p[i_plane].i_visible_pitch );
 
-        /* Current line / neighbouring lines picture pointers */
-        const picture_t *cur = p_pic_bot;
-        const picture_t *ngh = p_pic_top;
+        int i_start, i_end;
+        filter_slices_GetRange( i_lasty - 1, 1, i_slice, i_slices,
+                                &i_start, &i_end );
+
+        /* Current line / neighbouring lines picture pointers.
+           The bottom field is on odd lines. */
+        const picture_t *cur = (i_start % 2) ? p_pic_top : p_pic_bot;
+        const picture_t *ngh = (i_start % 2) ? p_pic_bot : p_pic_top;
         int wc = cur->p[i_plane].i_pitch;
         int wn = ngh->p[i_plane].i_pitch;
 
@@ -635,7 +757,7 @@ int CalculateInterlaceScore( const picture_t* p_pic_top,
            works better for anime, which may contain horizontal,
            one pixel thick cartoon outlines.
         */
-        for( int y = 1; y < i_lasty; ++y )
+        for( int y = 1 + i_start; y < 1 + i_end; ++y )
         {
             uint8_t *p_c = &cur->p[i_plane].p_pixels[y*wc];     /* this line */
             uint8_t *p_p = &ngh->p[i_plane].p_pixels[(y-1)*wn]; /* prev line */
@@ -676,6 +798,55 @@ int CalculateInterlaceScore( const picture_t* p_pic_top,
         }
     }
 
+    ctx->pi_score[i_slice] = i_score;
+}
+
+/* See header for function doc. */
+int CalculateInterlaceScore( filter_t *p_filter,
+                             const picture_t* p_pic_top,
+                             const picture_t* p_pic_bot )
+{
+    /*
+        We use the comb metric from the IVTC filter of Transcode 1.1.5.
+        This was found to work better for the particular purpose of IVTC
+        than RenderX()'s comb metric.
+
+        Note that we *must not* subsample at all in order to catch interlacing
+        in telecined frames with localized motion (e.g. anime with characters
+        talking, where only mouths move and everything else stays still.)
+    */
+
+    assert( p_pic_top != NULL );
+    assert( p_pic_bot != NULL );
+
+    if( p_pic_top->i_planes != p_pic_bot->i_planes )
+        return -1;
+
+    for( int i_plane = 0 ; i_plane < p_pic_top->i_planes ; ++i_plane )
+    {
+        /* Sanity check */
+        if( p_pic_top->p[i_plane].i_visible_lines !=
+            p_pic_bot->p[i_plane].i_visible_lines )
+            return -1;
+    }
+
+    struct interlace_score_slices ctx = {
+        .p_pic_top = p_pic_top,
+        .p_pic_bot = p_pic_bot,
+    };
+    filter_slice_cb pf_slice = CalculateInterlaceScoreSlice;
+#ifdef CAN_COMPILE_MMXEXT
+    if (vlc_CPU_MMXEXT())
+        pf_slice = CalculateInterlaceScoreSliceMMX;
+#endif
+
+    filter_sys_t *p_sys = p_filter->p_sys;
+    unsigned i_slices = filter_slices_Run( p_sys->p_slices, p_sys->i_slices,
+                                           pf_slice, &ctx );
+
+    int32_t i_score = 0;
+    for( unsigned i = 0; i < i_slices; i++ )
+        i_score += ctx.pi_score[i];
     return i_score;
 }
 #undef T
@@ -120,6 +120,7 @@ void ComposeFrame( filter_t *p_filter,
  * chroma, and odd-numbered chroma lines the "bottom field" for chroma.
  * This is correct for IVTC purposes.
  *
+ * @param p_filter The filter instance (determines the slices).
  * @param[in] p_prev Previous picture
  * @param[in] p_curr Current picture
  * @param[out] pi_top Number of 8x8 blocks where top field has motion.
@@ -129,7 +130,8 @@ void ComposeFrame( filter_t *p_filter,
  * @see TestForMotionInBlock()
  * @see RenderIVTC()
  */
-int EstimateNumBlocksWithMotion( const picture_t* p_prev,
+int EstimateNumBlocksWithMotion( filter_t *p_filter,
+                                 const picture_t* p_prev,
                                  const picture_t* p_curr,
                                  int *pi_top, int *pi_bot);
 
@@ -155,6 +157,7 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
  * each other locally (in the temporal sense) to make meaningful decisions
  * about progressive or interlaced frames.
  *
+ * @param p_filter The filter instance (determines the slices).
  * @param p_pic_top Picture to take the top field from.
  * @param p_pic_bot Picture to take the bottom field from (same or different).
  * @return Interlace score, >= 0. Higher values mean more interlaced.
@@ -162,7 +165,8 @@ int EstimateNumBlocksWithMotion( const picture_t* p_prev,
  * @see RenderIVTC()
  * @see ComposeFrame()
  */
-int CalculateInterlaceScore( const picture_t* p_pic_top,
+int CalculateInterlaceScore( filter_t *p_filter,
+                             const picture_t* p_pic_top,
                              const picture_t* p_pic_bot );
 
 #endif
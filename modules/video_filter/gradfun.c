@@ -108,6 +108,8 @@ typedef struct
     int              radius;
     const vlc_chroma_description_t *chroma;
     struct vf_priv_s cfg;
+    uint16_t         *buf[3];
+    filter_slices_t  *slices;
 } filter_sys_t;
 
 static int Open(vlc_object_t *object)
@@ -131,12 +133,13 @@ static int Open(vlc_object_t *object)
     sys->radius   = var_CreateGetIntegerCommand(filter, CFG_PREFIX "radius");
     var_AddCallback(filter, CFG_PREFIX "strength", Callback, NULL);
     var_AddCallback(filter, CFG_PREFIX "radius",   Callback, NULL);
-    sys->cfg.buf = NULL;
 
     struct vf_priv_s *cfg = &sys->cfg;
     cfg->thresh      = 0.0;
     cfg->radius      = 0;
-    cfg->buf         = NULL;
+    for (int i = 0; i < 3; i++)
+        sys->buf[i] = NULL;
+    sys->slices = filter_slices_Hold();
 
 #if HAVE_SSE2 && HAVE_6REGS
     if (vlc_CPU_SSE2())
@@ -168,10 +171,50 @@ static void Close(vlc_object_t *object)
 
     var_DelCallback(filter, CFG_PREFIX "radius",   Callback, NULL);
     var_DelCallback(filter, CFG_PREFIX "strength", Callback, NULL);
-    aligned_free(sys->cfg.buf);
+    if (sys->slices)
+        filter_slices_Release(sys->slices);
+    for (int i = 0; i < 3; i++)
+        aligned_free(sys->buf[i]);
     free(sys);
 }
 
+struct plane_slices
+{
+    filter_sys_t *sys;
+    const video_format_t *fmt;
+    picture_t *src;
+    picture_t *dst;
+};
+
+/* The box blur slides down each plane, so the slices are whole planes,
+ * and each slice has its own blur buffer. */
+static void FilterPlanes(void *opaque, unsigned slice, unsigned slices)
+{
+    struct plane_slices *ctx = opaque;
+    filter_sys_t *sys = ctx->sys;
+    const video_format_t *fmt = ctx->fmt;
+    const struct vf_priv_s *cfg = &sys->cfg;
+    uint16_t *buf = sys->buf[slice];
+
+    for (int i = slice; i < ctx->dst->i_planes; i += slices) {
+        const plane_t *srcp = &ctx->src->p[i];
+        plane_t       *dstp = &ctx->dst->p[i];
+
+        const vlc_chroma_description_t *chroma = sys->chroma;
+        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
+        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
+        int r = (cfg->radius  * chroma->p[i].w.num / chroma->p[i].w.den +
+                 cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
+        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
+        if (__MIN(w, h) > 2 * r && buf) {
+            filter_plane(cfg, buf, dstp->p_pixels, srcp->p_pixels,
+                         w, h, dstp->i_pitch, srcp->i_pitch, r);
+        } else {
+            plane_CopyPixels(dstp, srcp);
+        }
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     filter_sys_t *sys = filter->p_sys;
@@ -193,28 +236,18 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     cfg->thresh = (1 << 15) / strength;
     if (cfg->radius != radius) {
         cfg->radius = radius;
-        cfg->buf    = aligned_alloc(16,
-                                   (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) * sizeof(*cfg->buf));
-    }
-
-    for (int i = 0; i < dst->i_planes; i++) {
-        const plane_t *srcp = &src->p[i];
-        plane_t       *dstp = &dst->p[i];
-
-        const vlc_chroma_description_t *chroma = sys->chroma;
-        int w = fmt->i_width  * chroma->p[i].w.num / chroma->p[i].w.den;
-        int h = fmt->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
-        int r = (cfg->radius  * chroma->p[i].w.num / chroma->p[i].w.den +
-                 cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
-        r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
-        if (__MIN(w, h) > 2 * r && cfg->buf) {
-            filter_plane(cfg, dstp->p_pixels, srcp->p_pixels,
-                         w, h, dstp->i_pitch, srcp->i_pitch, r);
-        } else {
-            plane_CopyPixels(dstp, srcp);
+        for (int i = 0; i < 3; i++) {
+            aligned_free(sys->buf[i]);
+            sys->buf[i] = aligned_alloc(16,
+                                   (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) * sizeof(*sys->buf[i]));
         }
     }
 
+    struct plane_slices ctx = {
+        .sys = sys, .fmt = fmt, .src = src, .dst = dst,
+    };
+    filter_slices_Run(sys->slices, 3, FilterPlanes, &ctx);
+
     picture_CopyProperties(dst, src);
     picture_Release(src);
     return dst;
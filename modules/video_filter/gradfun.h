@@ -31,7 +31,6 @@
 struct vf_priv_s {
     int thresh;
     int radius;
-    uint16_t *buf;
     void (*filter_line)(uint8_t *dst, uint8_t *src, uint16_t *dc,
                         int width, int thresh, const uint16_t *dithers);
     void (*blur_line)(uint16_t *dc, uint16_t *buf, uint16_t *buf1,
@@ -222,14 +221,15 @@ static void blur_line_sse2(uint16_t *dc, uint16_t *buf, uint16_t *buf1,
 }
 #endif // HAVE_6REGS && HAVE_SSE2
 
-static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
+static void filter_plane(const struct vf_priv_s *ctx, uint16_t *ctx_buf,
+                         uint8_t *dst, uint8_t *src,
                          int width, int height, int dstride, int sstride, int r)
 {
     int bstride = ((width+15)&~15)/2;
     int y;
     uint32_t dc_factor = (1<<21)/(r*r);
-    uint16_t *dc = ctx->buf+16;
-    uint16_t *buf = ctx->buf+bstride+32;
+    uint16_t *dc = ctx_buf+16;
+    uint16_t *buf = ctx_buf+bstride+32;
     int thresh = ctx->thresh;
 
     memset(dc, 0, (bstride+16)*sizeof(*buf));
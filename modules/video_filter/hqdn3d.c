@@ -95,6 +95,8 @@ typedef struct
     bool   b_recalc_coefs;
     vlc_mutex_t coefs_mutex;
     float  luma_spat, luma_temp, chroma_spat, chroma_temp;
+
+    filter_slices_t *slices;
 } filter_sys_t;
 
 /*****************************************************************************
@@ -137,10 +139,15 @@ static int Open(vlc_object_t *this)
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
     }
-    cfg->Line = malloc(wmax*sizeof(unsigned int));
-    if (!cfg->Line) {
-        free(sys);
-        return VLC_ENOMEM;
+    /* One line buffer per plane, as the planes are denoised concurrently */
+    for (int i = 0; i < 3; ++i) {
+        cfg->Line[i] = malloc(wmax*sizeof(unsigned int));
+        if (!cfg->Line[i]) {
+            for (int j = 0; j < i; ++j)
+                free(cfg->Line[j]);
+            free(sys);
+            return VLC_ENOMEM;
+        }
     }
 
     config_ChainParse(filter, FILTER_PREFIX, filter_options,
@@ -153,6 +160,7 @@ static int Open(vlc_object_t *this)
     sys->chroma_spat = var_CreateGetFloatCommand(filter, FILTER_PREFIX "chroma-spat");
     sys->luma_temp = var_CreateGetFloatCommand(filter, FILTER_PREFIX "luma-temp");
     sys->chroma_temp = var_CreateGetFloatCommand(filter, FILTER_PREFIX "chroma-temp");
+    sys->slices = filter_slices_Hold();
 
     filter->p_sys = sys;
     filter->pf_video_filter = Filter;
@@ -179,16 +187,44 @@ static void Close(vlc_object_t *this)
     var_DelCallback( filter, FILTER_PREFIX "luma-temp", DenoiseCallback, sys );
     var_DelCallback( filter, FILTER_PREFIX "chroma-temp", DenoiseCallback, sys );
 
+    if (sys->slices)
+        filter_slices_Release(sys->slices);
     for (int i = 0; i < 3; ++i) {
         free(cfg->Frame[i]);
+        free(cfg->Line[i]);
     }
-    free(cfg->Line);
     free(sys);
 }
 
 /*****************************************************************************
  * Filter
  *****************************************************************************/
+struct denoise_slices
+{
+    filter_sys_t *sys;
+    picture_t *src;
+    picture_t *dst;
+};
+
+/* The filter is recursive in both directions within a plane, so the slices
+ * are whole planes. */
+static void DenoisePlanes(void *opaque, unsigned slice, unsigned slices)
+{
+    struct denoise_slices *ctx = opaque;
+    filter_sys_t *sys = ctx->sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+
+    for (unsigned i = slice; i < 3; i += slices) {
+        int *spat = cfg->Coefs[i == 0 ? 0 : 2];
+        int *temp = cfg->Coefs[i == 0 ? 1 : 3];
+
+        deNoise(ctx->src->p[i].p_pixels, ctx->dst->p[i].p_pixels,
+                cfg->Line[i], &cfg->Frame[i], sys->w[i], sys->h[i],
+                ctx->src->p[i].i_pitch, ctx->dst->p[i].i_pitch,
+                spat, spat, temp);
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     picture_t *dst;
@@ -218,24 +254,8 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     }
     vlc_mutex_unlock( &sys->coefs_mutex );
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
+    struct denoise_slices ctx = { .sys = sys, .src = src, .dst = dst };
+    filter_slices_Run(sys->slices, 3, DenoisePlanes, &ctx);
 
     if(unlikely(!cfg->Frame[0] || !cfg->Frame[1] || !cfg->Frame[2]))
     {
@@ -89,6 +89,7 @@ typedef struct
 {
     atomic_uint_fast32_t sincos;
     motion_sensors_t *p_motion;
+    filter_slices_t *p_slices;
 } filter_sys_t;
 
 typedef union {
@@ -176,6 +177,8 @@ static int Create( vlc_object_t *p_this )
         p_sys->p_motion = NULL;
     }
 
+    p_sys->p_slices = filter_slices_Hold();
+
     return VLC_SUCCESS;
 }
 
@@ -194,38 +197,33 @@ static void Destroy( vlc_object_t *p_this )
         var_DelCallback( p_filter, FILTER_PREFIX "angle",
                          RotateCallback, p_sys );
     }
+    if( p_sys->p_slices )
+        filter_slices_Release( p_sys->p_slices );
     free( p_sys );
 }
 
+struct rotate_slices
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    int i_sin, i_cos;
+    int i_y_offset, i_u_offset, i_v_offset;
+};
+
 /*****************************************************************************
  *
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void FilterSlice( void *opaque, unsigned i_slice, unsigned i_slices )
 {
-    picture_t *p_outpic;
-    filter_sys_t *p_sys = p_filter->p_sys;
-
-    if( !p_pic ) return NULL;
-
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
-
-    if( p_sys->p_motion != NULL )
-    {
-        int i_angle = motion_get_angle( p_sys->p_motion );
-        store_trigo( p_sys, i_angle / 20.f );
-    }
-
-    int i_sin, i_cos;
-    fetch_trigo( p_sys, &i_sin, &i_cos );
+    const struct rotate_slices *ctx = opaque;
+    const picture_t *p_pic = ctx->p_pic;
+    picture_t *p_outpic = ctx->p_outpic;
+    const int i_sin = ctx->i_sin;
+    const int i_cos = ctx->i_cos;
 
     for( int i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
     {
-        plane_t *p_srcp = &p_pic->p[i_plane];
+        const plane_t *p_srcp = &p_pic->p[i_plane];
         plane_t *p_dstp = &p_outpic->p[i_plane];
 
         const int i_visible_lines = p_srcp->i_visible_lines;
@@ -234,6 +232,10 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         const int i_aspect = __MAX( 1, ( i_visible_lines * p_pic->p[Y_PLANE].i_visible_pitch ) / ( p_pic->p[Y_PLANE].i_visible_lines * i_visible_pitch ));
         /* = 2 for U and V planes in YUV 4:2:2, = 1 otherwise */
 
+        int i_start, i_end;
+        filter_slices_GetRange( i_visible_lines, 1, i_slice, i_slices,
+                                &i_start, &i_end );
+
         const int i_line_center = i_visible_lines>>1;
         const int i_col_center  = i_visible_pitch>>1;
 
@@ -245,7 +247,10 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                              - i_sin * i_col_center + (1<<11) );
         int i_col_orig0 =    i_sin * i_line_center / i_aspect
                            - i_cos * i_col_center + (1<<11);
-        for( int y = 0; y < i_visible_lines; y++)
+        /* Each line moves the origin by (i_cos, -i_sin) / i_aspect */
+        i_line_orig0 += i_start * ( i_cos / i_aspect );
+        i_col_orig0  -= i_start * ( i_sin / i_aspect );
+        for( int y = i_start; y < i_end; y++)
         {
             uint8_t *p_out = &p_dstp->p_pixels[y * p_dstp->i_pitch];
 
@@ -321,64 +326,75 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             i_col_orig0 += i_col_next;
         }
     }
-
-    return CopyInfoAndRelease( p_outpic, p_pic );
 }
 
 /*****************************************************************************
  *
  *****************************************************************************/
-static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     picture_t *p_outpic;
     filter_sys_t *p_sys = p_filter->p_sys;
 
     if( !p_pic ) return NULL;
 
-    int i_u_offset, i_v_offset, i_y_offset;
-
-    if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
-                             &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
     {
-        msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
-                  (char*)&(p_pic->format.i_chroma) );
         picture_Release( p_pic );
         return NULL;
     }
 
-    p_outpic = filter_NewPicture( p_filter );
-    if( !p_outpic )
+    if( p_sys->p_motion != NULL )
     {
-        picture_Release( p_pic );
-        return NULL;
+        int i_angle = motion_get_angle( p_sys->p_motion );
+        store_trigo( p_sys, i_angle / 20.f );
     }
 
+    int i_sin, i_cos;
+    fetch_trigo( p_sys, &i_sin, &i_cos );
+
+    struct rotate_slices ctx = {
+        .p_pic = p_pic, .p_outpic = p_outpic, .i_sin = i_sin, .i_cos = i_cos,
+    };
+    filter_slices_Run( p_sys->p_slices, FILTER_SLICES_MAX, FilterSlice, &ctx );
+
+    return CopyInfoAndRelease( p_outpic, p_pic );
+}
+
+/*****************************************************************************
+ *
+ *****************************************************************************/
+static void FilterPackedSlice( void *opaque, unsigned i_slice,
+                               unsigned i_slices )
+{
+    const struct rotate_slices *ctx = opaque;
+    const picture_t *p_pic = ctx->p_pic;
+    picture_t *p_outpic = ctx->p_outpic;
+    const int i_sin = ctx->i_sin;
+    const int i_cos = ctx->i_cos;
+
     const int i_visible_pitch = p_pic->p->i_visible_pitch>>1; /* In fact it's i_visible_pixels */
     const int i_visible_lines = p_pic->p->i_visible_lines;
 
-    const uint8_t *p_in   = p_pic->p->p_pixels+i_y_offset;
-    const uint8_t *p_in_u = p_pic->p->p_pixels+i_u_offset;
-    const uint8_t *p_in_v = p_pic->p->p_pixels+i_v_offset;
+    const uint8_t *p_in   = p_pic->p->p_pixels+ctx->i_y_offset;
+    const uint8_t *p_in_u = p_pic->p->p_pixels+ctx->i_u_offset;
+    const uint8_t *p_in_v = p_pic->p->p_pixels+ctx->i_v_offset;
     const int i_in_pitch  = p_pic->p->i_pitch;
 
-    uint8_t *p_out   = p_outpic->p->p_pixels+i_y_offset;
-    uint8_t *p_out_u = p_outpic->p->p_pixels+i_u_offset;
-    uint8_t *p_out_v = p_outpic->p->p_pixels+i_v_offset;
+    uint8_t *p_out   = p_outpic->p->p_pixels+ctx->i_y_offset;
+    uint8_t *p_out_u = p_outpic->p->p_pixels+ctx->i_u_offset;
+    uint8_t *p_out_v = p_outpic->p->p_pixels+ctx->i_v_offset;
     const int i_out_pitch = p_outpic->p->i_pitch;
 
     const int i_line_center = i_visible_lines>>1;
     const int i_col_center  = i_visible_pitch>>1;
 
-    if( p_sys->p_motion != NULL )
-    {
-        int i_angle = motion_get_angle( p_sys->p_motion );
-        store_trigo( p_sys, i_angle / 20.f );
-    }
-
-    int i_sin, i_cos;
-    fetch_trigo( p_sys, &i_sin, &i_cos );
+    int i_start, i_end;
+    filter_slices_GetRange( i_visible_lines, 1, i_slice, i_slices,
+                            &i_start, &i_end );
 
-    for( int i_line = 0; i_line < i_visible_lines; i_line++ )
+    for( int i_line = i_start; i_line < i_end; i_line++ )
     {
         for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
         {
@@ -428,6 +444,52 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
             }
         }
     }
+}
+
+/*****************************************************************************
+ *
+ *****************************************************************************/
+static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( !p_pic ) return NULL;
+
+    int i_u_offset, i_v_offset, i_y_offset;
+
+    if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
+                             &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
+    {
+        msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
+                  (char*)&(p_pic->format.i_chroma) );
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    p_outpic = filter_NewPicture( p_filter );
+    if( !p_outpic )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    if( p_sys->p_motion != NULL )
+    {
+        int i_angle = motion_get_angle( p_sys->p_motion );
+        store_trigo( p_sys, i_angle / 20.f );
+    }
+
+    int i_sin, i_cos;
+    fetch_trigo( p_sys, &i_sin, &i_cos );
+
+    struct rotate_slices ctx = {
+        .p_pic = p_pic, .p_outpic = p_outpic, .i_sin = i_sin, .i_cos = i_cos,
+        .i_y_offset = i_y_offset, .i_u_offset = i_u_offset,
+        .i_v_offset = i_v_offset,
+    };
+    filter_slices_Run( p_sys->p_slices, FILTER_SLICES_MAX,
+                       FilterPackedSlice, &ctx );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
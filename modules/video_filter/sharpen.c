@@ -91,6 +91,7 @@ static const char *const ppsz_filter_options[] = {
 typedef struct
 {
     atomic_int sigma;
+    filter_slices_t *p_slices;
 } filter_sys_t;
 
 /*****************************************************************************
@@ -130,6 +131,8 @@ static int Create( vlc_object_t *p_this )
     var_AddCallback( p_filter, FILTER_PREFIX "sigma",
                      SharpenCallback, p_sys );
 
+    p_sys->p_slices = filter_slices_Hold();
+
     return VLC_SUCCESS;
 }
 
@@ -145,6 +148,8 @@ static void Destroy( vlc_object_t *p_this )
     filter_sys_t *p_sys = p_filter->p_sys;
 
     var_DelCallback( p_filter, FILTER_PREFIX "sigma", SharpenCallback, p_sys );
+    if( p_sys->p_slices )
+        filter_slices_Release( p_sys->p_slices );
     free( p_sys );
 }
 
@@ -159,6 +164,13 @@ static void Destroy( vlc_object_t *p_this )
 #define IS_YUV_420_10BITS(fmt) (fmt == VLC_CODEC_I420_10L ||    \
                                 fmt == VLC_CODEC_I420_10B)
 
+struct sharpen_slices
+{
+    picture_t *p_pic;
+    picture_t *p_outpic;
+    int sigma;
+};
+
 #define SHARPEN_FRAME(maxval, data_t)                                   \
     do                                                                  \
     {                                                                   \
@@ -168,11 +180,12 @@ static void Destroy( vlc_object_t *p_this )
         const unsigned data_sz = sizeof(data_t);                        \
         const int i_src_line_len = p_pic->p[Y_PLANE].i_pitch / data_sz; \
         const int i_out_line_len = p_outpic->p[Y_PLANE].i_pitch / data_sz; \
-        const int sigma = atomic_load(&p_sys->sigma);         \
                                                                         \
-        memcpy(p_out, p_src, i_visible_pitch);                          \
+        if( i_start == 0 )                                              \
+            memcpy(p_out, p_src, i_visible_pitch);                      \
                                                                         \
-        for( unsigned i = 1; i < i_visible_lines - 1; i++ )             \
+        for( unsigned i = __MAX(i_start, 1);                            \
+             i < __MIN((unsigned)i_end, i_visible_lines - 1); i++ )     \
         {                                                               \
             p_out[i * i_out_line_len] = p_src[i * i_src_line_len];      \
                                                                         \
@@ -199,18 +212,37 @@ static void Destroy( vlc_object_t *p_this )
             p_out[i * i_out_line_len + i_visible_pitch / data_sz - 1] = \
                 p_src[i * i_src_line_len + i_visible_pitch / data_sz - 1];  \
         }                                                               \
-        memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],          \
-               &p_src[(i_visible_lines - 1) * i_src_line_len],          \
-               i_visible_pitch);                                        \
+        if( (unsigned)i_end == i_visible_lines )                        \
+            memcpy(&p_out[(i_visible_lines - 1) * i_out_line_len],      \
+                   &p_src[(i_visible_lines - 1) * i_src_line_len],      \
+                   i_visible_pitch);                                    \
     } while (0)
 
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static void SharpenSlice( void *opaque, unsigned i_slice, unsigned i_slices )
 {
-    picture_t *p_outpic;
+    const struct sharpen_slices *ctx = opaque;
+    const picture_t *p_pic = ctx->p_pic;
+    picture_t *p_outpic = ctx->p_outpic;
+    const int sigma = ctx->sigma;
     const int v1 = -1;
     const int v2 = 3; /* 2^3 = 8 */
     const unsigned i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
     const unsigned i_visible_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
+    int i_start, i_end;
+
+    /* Each band reads one line above and below it, but only writes its own */
+    filter_slices_GetRange( i_visible_lines, 1, i_slice, i_slices,
+                            &i_start, &i_end );
+
+    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
+        SHARPEN_FRAME(255, uint8_t);
+    else
+        SHARPEN_FRAME(1023, uint16_t);
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    picture_t *p_outpic;
 
     p_outpic = filter_NewPicture( p_filter );
     if( !p_outpic )
@@ -221,10 +253,13 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    if (!IS_YUV_420_10BITS(p_pic->format.i_chroma))
-        SHARPEN_FRAME(255, uint8_t);
-    else
-        SHARPEN_FRAME(1023, uint16_t);
+    struct sharpen_slices ctx = {
+        .p_pic = p_pic,
+        .p_outpic = p_outpic,
+        .sigma = atomic_load(&p_sys->sigma),
+    };
+    filter_slices_Run( p_sys->p_slices, FILTER_SLICES_MAX,
+                       SharpenSlice, &ctx );
 
     plane_CopyPixels( &p_outpic->p[U_PLANE], &p_pic->p[U_PLANE] );
     plane_CopyPixels( &p_outpic->p[V_PLANE], &p_pic->p[V_PLANE] );
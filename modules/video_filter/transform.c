@@ -116,7 +116,8 @@ static void R270(int *sx, int *sy, int w, int h, int dx, int dy)
 typedef void (*convert_t)(int *, int *, int, int, int, int);
 
 #define PLANE(f,bits) \
-static void Plane##bits##_##f(plane_t *restrict dst, const plane_t *restrict src) \
+static void Plane##bits##_##f(plane_t *restrict dst, const plane_t *restrict src, \
+                              int y_start, int y_end) \
 { \
     const uint##bits##_t *src_pixels = (const void *)src->p_pixels; \
     uint##bits##_t *restrict dst_pixels = (void *)dst->p_pixels; \
@@ -124,7 +125,7 @@ static void Plane##bits##_##f(plane_t *restrict dst, const plane_t *restrict src
     const unsigned dst_width = dst->i_pitch / sizeof (*dst_pixels); \
     const unsigned dst_visible_width = dst->i_visible_pitch / sizeof (*dst_pixels); \
  \
-    for (int y = 0; y < dst->i_visible_lines; y++) { \
+    for (int y = y_start; y < y_end; y++) { \
         for (unsigned x = 0; x < dst_visible_width; x++) { \
             int sx, sy; \
             (f)(&sx, &sy, dst_visible_width, dst->i_visible_lines, x, y); \
@@ -134,13 +135,14 @@ static void Plane##bits##_##f(plane_t *restrict dst, const plane_t *restrict src
     } \
 }
 
-static void Plane_VFlip(plane_t *restrict dst, const plane_t *restrict src)
+static void Plane_VFlip(plane_t *restrict dst, const plane_t *restrict src,
+                        int y_start, int y_end)
 {
-    const uint8_t *src_pixels = src->p_pixels;
+    const uint8_t *src_pixels = src->p_pixels + y_start * src->i_pitch;
     uint8_t *restrict dst_pixels = dst->p_pixels;
 
-    dst_pixels += dst->i_pitch * dst->i_visible_lines;
-    for (int y = 0; y < dst->i_visible_lines; y++) {
+    dst_pixels += dst->i_pitch * (dst->i_visible_lines - y_start);
+    for (int y = y_start; y < y_end; y++) {
         dst_pixels -= dst->i_pitch;
         memcpy(dst_pixels, src_pixels, dst->i_visible_pitch);
         src_pixels += src->i_pitch;
@@ -148,9 +150,10 @@ static void Plane_VFlip(plane_t *restrict dst, const plane_t *restrict src)
 }
 
 #define I422(f) \
-static void Plane422_##f(plane_t *restrict dst, const plane_t *restrict src) \
+static void Plane422_##f(plane_t *restrict dst, const plane_t *restrict src, \
+                         int y_start, int y_end) \
 { \
-    for (int y = 0; y < dst->i_visible_lines; y += 2) { \
+    for (int y = y_start; y < y_end; y += 2) { \
         for (int x = 0; x < dst->i_visible_pitch; x++) { \
             int sx, sy, uv; \
             (f)(&sx, &sy, dst->i_visible_pitch, dst->i_visible_lines / 2, \
@@ -164,11 +167,12 @@ static void Plane422_##f(plane_t *restrict dst, const plane_t *restrict src) \
 }
 
 #define YUY2(f) \
-static void PlaneYUY2_##f(plane_t *restrict dst, const plane_t *restrict src) \
+static void PlaneYUY2_##f(plane_t *restrict dst, const plane_t *restrict src, \
+                          int y_start, int y_end) \
 { \
     unsigned dst_visible_width = dst->i_visible_pitch / 2; \
  \
-    for (int y = 0; y < dst->i_visible_lines; y += 2) { \
+    for (int y = y_start; y < y_end; y += 2) { \
         for (unsigned x = 0; x < dst_visible_width; x+= 2) { \
             int sx0, sy0, sx1, sy1; \
             (f)(&sx0, &sy0, dst_visible_width, dst->i_visible_lines, x, y); \
@@ -228,16 +232,20 @@ YUY2(AntiTranspose)
 YUY2(R90)
 YUY2(R270)
 
+/* The plane functions write the destination lines [y_start, y_end) */
+typedef void (*plane_transform_t)(plane_t *dst, const plane_t *src,
+                                  int y_start, int y_end);
+
 typedef struct {
     char      name[16];
     convert_t convert;
     convert_t iconvert;
     video_transform_t operation;
-    void      (*plane8) (plane_t *dst, const plane_t *src);
-    void      (*plane16)(plane_t *dst, const plane_t *src);
-    void      (*plane32)(plane_t *dst, const plane_t *src);
-    void      (*i422)(plane_t *dst, const plane_t *src);
-    void      (*yuyv)(plane_t *dst, const plane_t *src);
+    plane_transform_t plane8;
+    plane_transform_t plane16;
+    plane_transform_t plane32;
+    plane_transform_t i422;
+    plane_transform_t yuyv;
 } transform_description_t;
 
 #define DESC(str, f, invf, op) \
@@ -265,10 +273,34 @@ static const size_t n_transforms =
 typedef struct
 {
     const vlc_chroma_description_t *chroma;
-    void (*plane[PICTURE_PLANE_MAX])(plane_t *, const plane_t *);
+    plane_transform_t plane[PICTURE_PLANE_MAX];
     convert_t convert;
+    filter_slices_t *slices;
 } filter_sys_t;
 
+struct transform_slices
+{
+    const filter_sys_t *sys;
+    picture_t *dst;
+    const picture_t *src;
+};
+
+static void FilterSlice(void *opaque, unsigned slice, unsigned slices)
+{
+    const struct transform_slices *ctx = opaque;
+    const filter_sys_t *sys = ctx->sys;
+
+    for (unsigned i = 0; i < sys->chroma->plane_count; i++) {
+        plane_t *dst = &ctx->dst->p[i];
+        int y_start, y_end;
+
+        /* Even boundaries, as the 4:2:2 and YUY2 rotations do line pairs */
+        filter_slices_GetRange(dst->i_visible_lines, 2, slice, slices,
+                               &y_start, &y_end);
+        (sys->plane[i])(dst, &ctx->src->p[i], y_start, y_end);
+    }
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     filter_sys_t *sys = filter->p_sys;
@@ -279,9 +311,8 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
         return NULL;
     }
 
-    const vlc_chroma_description_t *chroma = sys->chroma;
-    for (unsigned i = 0; i < chroma->plane_count; i++)
-         (sys->plane[i])(&dst->p[i], &src->p[i]);
+    struct transform_slices ctx = { .sys = sys, .dst = dst, .src = src };
+    filter_slices_Run(sys->slices, FILTER_SLICES_MAX, FilterSlice, &ctx);
 
     picture_CopyProperties(dst, src);
     picture_Release(src);
@@ -433,6 +464,8 @@ static int Open(vlc_object_t *object)
             goto error;
     }
 
+    sys->slices = filter_slices_Hold();
+
     filter->p_sys           = sys;
     filter->pf_video_filter = Filter;
     filter->pf_video_mouse  = Mouse;
@@ -447,5 +480,7 @@ static void Close(vlc_object_t *object)
     filter_t     *filter = (filter_t *)object;
     filter_sys_t *sys    = filter->p_sys;
 
+    if (sys->slices)
+        filter_slices_Release(sys->slices);
     free(sys);
 }
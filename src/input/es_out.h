@@ -91,7 +91,10 @@ enum es_out_query_private_e
     ES_OUT_SET_VBI_PAGE,                            /* arg1=unsigned res=can fail */
 
     /* Set VBI/Teletext menu transparent */
-    ES_OUT_SET_VBI_TRANSPARENCY                     /* arg1=bool res=can fail */
+    ES_OUT_SET_VBI_TRANSPARENCY,                    /* arg1=bool res=can fail */
+
+    /* Seek inside the timeshift buffer */
+    ES_OUT_SET_TIMESHIFT_TIME,                      /* arg1=vlc_tick_t i_time arg2=bool b_absolute res=can fail */
 };
 
 static inline void es_out_SetMode( es_out_t *p_out, int i_mode )
@@ -149,6 +152,10 @@ static inline int es_out_SetFrameNext( es_out_t *p_out )
 {
     return es_out_Control( p_out, ES_OUT_SET_FRAME_NEXT );
 }
+static inline int es_out_SetTimeshiftTime( es_out_t *p_out, vlc_tick_t i_time, bool b_absolute )
+{
+    return es_out_Control( p_out, ES_OUT_SET_TIMESHIFT_TIME, i_time, b_absolute );
+}
 static inline void es_out_SetTimes( es_out_t *p_out, double f_position,
                                     vlc_tick_t i_time, vlc_tick_t i_normal_time,
                                     vlc_tick_t i_length )
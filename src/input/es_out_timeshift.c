@@ -160,12 +160,39 @@ typedef struct attribute_packed
     } u;
 } ts_cmd_t;
 
+enum
+{
+    TS_CMD_PLAY,    /* new command */
+    TS_CMD_REPLAY,  /* command already executed before rewinding */
+    TS_CMD_SKIP,    /* command jumped over by a forward seek */
+};
+
+/* Minimal interval between two index entries */
+#define TS_INDEX_INTERVAL VLC_TICK_FROM_MS(500)
+
+typedef struct
+{
+    int        i_cmd;   /* Position in the storage command array */
+    vlc_tick_t i_date;  /* Reception date of the command */
+    vlc_tick_t i_time;  /* Estimated stream time, or VLC_TICK_INVALID */
+} ts_index_entry_t;
+
+/* Blocks are kept in memory up to i_size_max bytes, and only written to the
+ * storage files beyond that */
+typedef struct
+{
+    int64_t i_size;
+    int64_t i_size_max;
+    bool    b_history;  /* Keep played blocks to allow rewinding */
+} ts_memory_t;
+
 typedef struct ts_storage_t ts_storage_t;
 struct ts_storage_t
 {
     ts_storage_t *p_next;
 
     /* */
+    const char *psz_tmp_path; /* Directory of the file, created on demand */
 #ifdef _WIN32
     char    *psz_file;  /* Filename */
 #endif
@@ -174,11 +201,17 @@ struct ts_storage_t
     FILE    *p_filew;   /* FILE handle for data writing */
     FILE    *p_filer;   /* FILE handle for data reading */
 
+    ts_memory_t *p_memory;
+
     /* */
+    int      i_cmd_h;   /* First command that can be played again */
     int      i_cmd_r;
     int      i_cmd_w;
     int      i_cmd_max;
     ts_cmd_t *p_cmd;
+
+    /* Seek points */
+    DECL_ARRAY(ts_index_entry_t) index;
 };
 
 typedef struct
@@ -188,6 +221,7 @@ typedef struct
     es_out_t       *p_out;
     int64_t        i_tmp_size_max;
     const char     *psz_tmp_path;
+    vlc_tick_t     i_history;
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -207,16 +241,31 @@ typedef struct
     vlc_tick_t     i_buffering_delay;
 
     /* */
+    ts_storage_t   *p_storage_h; /* Oldest storage, played unless rewinding */
     ts_storage_t   *p_storage_r;
     ts_storage_t   *p_storage_w;
+    ts_memory_t    memory;
 
     vlc_tick_t     i_cmd_delay;
 
+    /* Seek state */
+    vlc_tick_t     i_push_date;  /* Reception date of the newest command */
+    vlc_tick_t     i_pop_date;   /* Reception date of the last played command */
+    vlc_tick_t     i_times_time; /* Stream time of the last ES_OUT_SET_TIMES */
+    vlc_tick_t     i_times_date;
+    vlc_tick_t     i_index_date;
+    bool           b_index_video;
+    int64_t        i_replay;     /* Commands to play again after rewinding */
+    int64_t        i_skip;       /* Commands to jump over */
+    bool           b_seek_flush;
+    bool           b_seek_clock;
+
 } ts_thread_t;
 
 struct es_out_id_t
 {
     es_out_id_t *p_es;
+    int         i_cat;
 };
 
 typedef struct
@@ -227,6 +276,8 @@ typedef struct
     /* Configuration */
     int64_t        i_tmp_size_max;    /* Maximal temporary file size in byte */
     char           *psz_tmp_path;     /* Path for temporary files */
+    int64_t        i_mem_size_max;    /* Maximal size of data kept in memory */
+    vlc_tick_t     i_history;         /* Duration kept after playback */
 
     /* Lock for all following fields */
     vlc_mutex_t    lock;
@@ -255,16 +306,18 @@ static void         TsAutoStop( es_out_t * );
 
 static void         TsStop( ts_thread_t * );
 static void         TsPushCmd( ts_thread_t *, ts_cmd_t * );
-static int          TsPopCmdLocked( ts_thread_t *, ts_cmd_t *, bool b_flush );
+static int          TsPopCmdLocked( ts_thread_t *, ts_cmd_t *, bool b_flush, int *pi_state );
 static bool         TsHasCmd( ts_thread_t * );
 static bool         TsIsUnused( ts_thread_t * );
 static int          TsChangePause( ts_thread_t *, bool b_source_paused, bool b_paused, vlc_tick_t i_date );
 static int          TsChangeRate( ts_thread_t *, float src_rate, float rate );
+static int          TsSeek( ts_thread_t *, vlc_tick_t i_time, bool b_absolute );
 
 static void         *TsRun( void * );
 
-static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max );
+static ts_storage_t *TsStorageNew( const char *psz_path, int64_t i_tmp_size_max, ts_memory_t * );
 static void         TsStorageDelete( ts_storage_t * );
+static void         TsStorageDropHistory( ts_storage_t *, int i_cmd );
 static void         TsStoragePack( ts_storage_t *p_storage );
 static bool         TsStorageIsFull( ts_storage_t *, const ts_cmd_t *p_cmd );
 static bool         TsStorageIsEmpty( ts_storage_t * );
@@ -272,6 +325,7 @@ static void         TsStoragePushCmd( ts_storage_t *, const ts_cmd_t *p_cmd, boo
 static void         TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_flush );
 
 static void CmdClean( ts_cmd_t * );
+static bool CmdIsTiming( const ts_cmd_t * );
 static void cmd_cleanup_routine( void *p ) { CmdClean( p ); }
 
 static int  CmdInitAdd    ( ts_cmd_t *, es_out_id_t *, const es_format_t *, bool b_copy );
@@ -330,6 +384,9 @@ es_out_t *input_EsOutTimeshiftNew( input_thread_t *p_input, es_out_t *p_next_out
     msg_Dbg( p_input, "using timeshift granularity of %d MiB",
              (int)p_sys->i_tmp_size_max/(1024*1024) );
 
+    p_sys->i_mem_size_max = __MAX( var_InheritInteger( p_input, "input-timeshift-memory" ), 0 );
+    p_sys->i_history = vlc_tick_from_sec( __MAX( var_InheritInteger( p_input, "input-timeshift-history" ), 0 ) );
+
     p_sys->psz_tmp_path = var_InheritString( p_input, "input-timeshift-path" );
 #if defined (_WIN32) && !VLC_WINSTORE_APP
     if( p_sys->psz_tmp_path == NULL )
@@ -428,6 +485,7 @@ static es_out_id_t *Add( es_out_t *p_out, const es_format_t *p_fmt )
         return NULL;
     }
 
+    p_es->i_cat = p_fmt->i_cat;
     TAB_APPEND( p_sys->i_es, p_sys->pp_es, p_es );
 
     if( p_sys->b_delayed )
@@ -724,6 +782,16 @@ static int ControlLocked( es_out_t *p_out, int i_query, va_list args )
     case ES_OUT_POST_SUBNODE:
         return es_out_vaControl( p_sys->p_out, i_query, args );
 
+    case ES_OUT_SET_TIMESHIFT_TIME:
+    {
+        const vlc_tick_t i_time = va_arg( args, vlc_tick_t );
+        const bool b_absolute = va_arg( args, int );
+
+        if( !p_sys->b_delayed )
+            return VLC_EGENERIC;
+        return TsSeek( p_sys->p_ts, i_time, b_absolute );
+    }
+
     case ES_OUT_MODIFY_PCR_SYSTEM:
     {
         const bool    b_absolute = va_arg( args, int );
@@ -797,6 +865,7 @@ static int TsStart( es_out_t *p_out )
 
     p_ts->i_tmp_size_max = p_sys->i_tmp_size_max;
     p_ts->psz_tmp_path = p_sys->psz_tmp_path;
+    p_ts->i_history = p_sys->i_history;
     p_ts->p_input = p_sys->p_input;
     p_ts->p_out = p_sys->p_out;
     vlc_mutex_init( &p_ts->lock );
@@ -809,8 +878,22 @@ static int TsStart( es_out_t *p_out )
     p_ts->i_rate_delay = 0;
     p_ts->i_buffering_delay = 0;
     p_ts->i_cmd_delay = 0;
+    p_ts->p_storage_h = NULL;
     p_ts->p_storage_r = NULL;
     p_ts->p_storage_w = NULL;
+    p_ts->memory.i_size = 0;
+    p_ts->memory.i_size_max = p_sys->i_mem_size_max;
+    p_ts->memory.b_history = p_sys->i_history > 0;
+    p_ts->i_push_date = VLC_TICK_INVALID;
+    p_ts->i_pop_date = VLC_TICK_INVALID;
+    p_ts->i_times_time = VLC_TICK_INVALID;
+    p_ts->i_times_date = VLC_TICK_INVALID;
+    p_ts->i_index_date = VLC_TICK_INVALID;
+    p_ts->b_index_video = false;
+    p_ts->i_replay = 0;
+    p_ts->i_skip = 0;
+    p_ts->b_seek_flush = false;
+    p_ts->b_seek_clock = false;
 
     p_sys->b_delayed = true;
     if( vlc_clone( &p_ts->thread, TsRun, p_ts, VLC_THREAD_PRIORITY_INPUT ) )
@@ -846,26 +929,80 @@ static void TsStop( ts_thread_t *p_ts )
     for( ;; )
     {
         ts_cmd_t cmd;
+        int i_state;
 
-        if( TsPopCmdLocked( p_ts, &cmd, true ) )
+        if( TsPopCmdLocked( p_ts, &cmd, true, &i_state ) )
             break;
 
-        CmdClean( &cmd );
+        /* Replayed commands were cleaned when first executed */
+        if( i_state != TS_CMD_REPLAY )
+            CmdClean( &cmd );
     }
     assert( !p_ts->p_storage_r || !p_ts->p_storage_r->p_next );
-    if( p_ts->p_storage_r )
-        TsStorageDelete( p_ts->p_storage_r );
+    while( p_ts->p_storage_h )
+    {
+        ts_storage_t *p_next = p_ts->p_storage_h->p_next;
+
+        TsStorageDelete( p_ts->p_storage_h );
+        p_ts->p_storage_h = p_next;
+    }
+    assert( p_ts->memory.i_size == 0 );
     vlc_mutex_unlock( &p_ts->lock );
 
     TsDestroy( p_ts );
 }
+static bool TsIsIndexPoint( ts_thread_t *p_ts, const ts_cmd_t *p_cmd )
+{
+    if( p_cmd->i_type != C_SEND )
+        return false;
+
+    if( p_ts->i_index_date != VLC_TICK_INVALID &&
+        p_cmd->i_date < p_ts->i_index_date + TS_INDEX_INTERVAL )
+        return false;
+
+    /* Prefer video key frames, when the demuxer flags them */
+    if( p_cmd->u.send.p_es->i_cat == VIDEO_ES &&
+        (p_cmd->u.send.p_block->i_flags & BLOCK_FLAG_TYPE_I) )
+    {
+        p_ts->b_index_video = true;
+        return true;
+    }
+    return !p_ts->b_index_video;
+}
+static void TsIndexCmdLocked( ts_thread_t *p_ts, const ts_cmd_t *p_cmd, bool b_index )
+{
+    ts_storage_t *p_storage = p_ts->p_storage_w;
+
+    p_ts->i_push_date = p_cmd->i_date;
+    if( p_cmd->i_type == C_CONTROL &&
+        p_cmd->u.control.i_query == ES_OUT_SET_TIMES )
+    {
+        p_ts->i_times_time = p_cmd->u.control.u.times.i_time;
+        p_ts->i_times_date = p_cmd->i_date;
+    }
+
+    if( !b_index )
+        return;
+
+    ts_index_entry_t entry = {
+        .i_cmd = p_storage->i_cmd_w - 1,
+        .i_date = p_cmd->i_date,
+        .i_time = VLC_TICK_INVALID,
+    };
+    if( p_ts->i_times_time != VLC_TICK_INVALID )
+        entry.i_time = p_ts->i_times_time + p_cmd->i_date - p_ts->i_times_date;
+
+    ARRAY_APPEND( p_storage->index, entry );
+    p_ts->i_index_date = p_cmd->i_date;
+}
 static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 {
     vlc_mutex_lock( &p_ts->lock );
 
     if( !p_ts->p_storage_w || TsStorageIsFull( p_ts->p_storage_w, p_cmd ) )
     {
-        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max );
+        ts_storage_t *p_storage = TsStorageNew( p_ts->psz_tmp_path, p_ts->i_tmp_size_max,
+                                                &p_ts->memory );
 
         if( !p_storage )
         {
@@ -877,7 +1014,7 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
 
         if( !p_ts->p_storage_w )
         {
-            p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
+            p_ts->p_storage_h = p_ts->p_storage_r = p_ts->p_storage_w = p_storage;
         }
         else
         {
@@ -888,13 +1025,34 @@ static void TsPushCmd( ts_thread_t *p_ts, ts_cmd_t *p_cmd )
     }
 
     /* TODO return error and warn the user (but only once) */
+    const bool b_index = TsIsIndexPoint( p_ts, p_cmd );
+    const int i_cmd_w = p_ts->p_storage_w->i_cmd_w;
     TsStoragePushCmd( p_ts->p_storage_w, p_cmd, p_ts->p_storage_r == p_ts->p_storage_w );
+    if( p_ts->p_storage_w->i_cmd_w > i_cmd_w )
+        TsIndexCmdLocked( p_ts, &p_ts->p_storage_w->p_cmd[i_cmd_w], b_index );
 
     vlc_cond_signal( &p_ts->wait );
 
     vlc_mutex_unlock( &p_ts->lock );
 }
-static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
+static void TsHistoryTrimLocked( ts_thread_t *p_ts, bool b_drop )
+{
+    while( p_ts->p_storage_h != p_ts->p_storage_r )
+    {
+        ts_storage_t *p_storage = p_ts->p_storage_h;
+
+        /* Keep played storages with data inside the history window */
+        if( !b_drop && p_ts->i_history > 0 && p_storage->i_cmd_w > 0 &&
+            p_storage->p_cmd[p_storage->i_cmd_w - 1].i_date + p_ts->i_history > p_ts->i_pop_date )
+            break;
+
+        p_ts->p_storage_h = p_storage->p_next;
+        TsStorageDelete( p_storage );
+    }
+    if( b_drop )
+        TsStorageDropHistory( p_ts->p_storage_r, p_ts->p_storage_r->i_cmd_r );
+}
+static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush, int *pi_state )
 {
     vlc_mutex_assert( &p_ts->lock );
 
@@ -902,6 +1060,22 @@ static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
         return VLC_EGENERIC;
 
     TsStoragePopCmd( p_ts->p_storage_r, p_cmd, b_flush );
+    p_ts->i_pop_date = p_cmd->i_date;
+
+    if( p_ts->i_replay > 0 )
+    {
+        p_ts->i_replay--;
+        *pi_state = TS_CMD_REPLAY;
+    }
+    else if( p_ts->i_skip > 0 )
+    {
+        p_ts->i_skip--;
+        *pi_state = TS_CMD_SKIP;
+    }
+    else
+    {
+        *pi_state = TS_CMD_PLAY;
+    }
 
     while( TsStorageIsEmpty( p_ts->p_storage_r ) )
     {
@@ -909,10 +1083,14 @@ static int TsPopCmdLocked( ts_thread_t *p_ts, ts_cmd_t *p_cmd, bool b_flush )
         if( !p_next )
             break;
 
-        TsStorageDelete( p_ts->p_storage_r );
         p_ts->p_storage_r = p_next;
     }
 
+    /* Older commands may refer to the ES being deleted, they must not be
+     * played again */
+    TsHistoryTrimLocked( p_ts, p_ts->i_history > 0 && p_cmd->i_type == C_DEL &&
+                               *pi_state != TS_CMD_REPLAY );
+
     return VLC_SUCCESS;
 }
 static bool TsHasCmd( ts_thread_t *p_ts )
@@ -932,6 +1110,7 @@ static bool TsIsUnused( ts_thread_t *p_ts )
     vlc_mutex_lock( &p_ts->lock );
     b_unused = !p_ts->b_paused &&
                p_ts->rate == p_ts->rate_source &&
+               p_ts->i_history == 0 &&
                TsStorageIsEmpty( p_ts->p_storage_r );
     vlc_mutex_unlock( &p_ts->lock );
 
@@ -987,6 +1166,116 @@ static int TsChangeRate( ts_thread_t *p_ts, float src_rate, float rate )
     return i_ret;
 }
 
+static int64_t TsCmdOrdinal( const ts_storage_t *p_head,
+                             const ts_storage_t *p_storage, int i_cmd )
+{
+    int64_t i_ordinal = i_cmd;
+
+    for( ; p_head != p_storage; p_head = p_head->p_next )
+        i_ordinal += p_head->i_cmd_w;
+    return i_ordinal;
+}
+static void TsAdvanceLocked( ts_thread_t *p_ts, int64_t i_count )
+{
+    while( i_count > 0 )
+    {
+        ts_storage_t *p_storage = p_ts->p_storage_r;
+        const int i_step = __MIN( i_count, p_storage->i_cmd_w - p_storage->i_cmd_r );
+
+        p_storage->i_cmd_r += i_step;
+        i_count -= i_step;
+
+        if( p_storage->i_cmd_r < p_storage->i_cmd_w || !p_storage->p_next )
+            break;
+        p_ts->p_storage_r = p_storage->p_next;
+    }
+}
+static int TsSeek( ts_thread_t *p_ts, vlc_tick_t i_time, bool b_absolute )
+{
+    ts_storage_t *p_target = NULL;
+    int i_target = 0;
+    vlc_tick_t i_end;
+
+    vlc_mutex_lock( &p_ts->lock );
+
+    /* Relative seeks are done in reception time, absolute ones using the
+     * stream time reported along with the commands */
+    if( !b_absolute )
+    {
+        if( p_ts->i_pop_date == VLC_TICK_INVALID )
+            goto error;
+        i_time += p_ts->i_pop_date;
+        i_end = p_ts->i_push_date;
+    }
+    else
+    {
+        if( p_ts->i_times_time == VLC_TICK_INVALID )
+            goto error;
+        i_end = p_ts->i_times_time + p_ts->i_push_date - p_ts->i_times_date;
+    }
+    if( i_time > i_end )
+        goto error;
+
+    for( ts_storage_t *p_storage = p_ts->p_storage_h; p_storage; p_storage = p_storage->p_next )
+    {
+        /* Without history, only the commands not played yet can be reached */
+        const int i_min = p_ts->i_history > 0 ? p_storage->i_cmd_h : p_storage->i_cmd_r;
+
+        for( int i = 0; i < p_storage->index.i_size; i++ )
+        {
+            const ts_index_entry_t *p_entry = &p_storage->index.p_elems[i];
+            const vlc_tick_t i_entry = b_absolute ? p_entry->i_time : p_entry->i_date;
+
+            if( p_entry->i_cmd < i_min || i_entry == VLC_TICK_INVALID )
+                continue;
+            if( i_entry > i_time )
+                break;
+            p_target = p_storage;
+            i_target = p_entry->i_cmd;
+        }
+    }
+    if( p_target == NULL )
+        goto error;
+
+    const int64_t i_distance =
+        TsCmdOrdinal( p_ts->p_storage_h, p_target, i_target ) -
+        TsCmdOrdinal( p_ts->p_storage_h, p_ts->p_storage_r, p_ts->p_storage_r->i_cmd_r );
+
+    if( i_distance < 0 )
+    {
+        /* Rewind, the commands up to the current position were executed */
+        for( ts_storage_t *p_storage = p_target; ; p_storage = p_storage->p_next )
+        {
+            p_storage->i_cmd_r = p_storage == p_target ? i_target : 0;
+            if( p_storage == p_ts->p_storage_r )
+                break;
+        }
+        p_ts->p_storage_r = p_target;
+        p_ts->i_replay -= i_distance;
+        p_ts->i_skip = 0;
+    }
+    else
+    {
+        /* Commands played again can be jumped over directly, the following
+         * ones must still be processed */
+        const int64_t i_replayed = __MIN( i_distance, p_ts->i_replay );
+
+        TsAdvanceLocked( p_ts, i_replayed );
+        p_ts->i_replay -= i_replayed;
+        p_ts->i_skip = i_distance - i_replayed;
+    }
+    p_ts->b_seek_flush = true;
+    p_ts->b_seek_clock = true;
+
+    vlc_cond_signal( &p_ts->wait );
+    vlc_mutex_unlock( &p_ts->lock );
+    return VLC_SUCCESS;
+
+error:
+    vlc_mutex_unlock( &p_ts->lock );
+    return VLC_EGENERIC;
+}
+
 static void *TsRun( void *p_data )
 {
     ts_thread_t *p_ts = p_data;
@@ -997,6 +1286,9 @@ static void *TsRun( void *p_data )
         ts_cmd_t cmd;
         vlc_tick_t  i_deadline;
         bool b_buffering;
+        bool b_flush;
+        bool b_execute;
+        int i_state;
 
         /* Pop a command to execute */
         vlc_mutex_lock( &p_ts->lock );
@@ -1007,7 +1299,7 @@ static void *TsRun( void *p_data )
             const int canc = vlc_savecancel();
             b_buffering = es_out_GetBuffering( p_ts->p_out );
 
-            if( ( !p_ts->b_paused || b_buffering ) && !TsPopCmdLocked( p_ts, &cmd, false ) )
+            if( ( !p_ts->b_paused || b_buffering ) && !TsPopCmdLocked( p_ts, &cmd, false, &i_state ) )
             {
                 vlc_restorecancel( canc );
                 break;
@@ -1017,69 +1309,111 @@ static void *TsRun( void *p_data )
             vlc_cond_wait( &p_ts->wait, &p_ts->lock );
         }
 
-        if( b_buffering && i_buffering_date < 0 )
+        /* Replayed commands only feed data and timing again, while jumped
+         * over ones only update the state of the ES */
+        b_execute = true;
+        if( i_state == TS_CMD_REPLAY )
+            b_execute = CmdIsTiming( &cmd );
+        else if( i_state == TS_CMD_SKIP )
+            b_execute = !CmdIsTiming( &cmd );
+
+        /* After a seek, flush the decoders at once and play the first
+         * command that is not jumped over without delay */
+        b_flush = p_ts->b_seek_flush;
+        p_ts->b_seek_flush = false;
+        if( i_state != TS_CMD_SKIP && p_ts->b_seek_clock )
         {
-            i_buffering_date = cmd.i_date;
-        }
-        else if( i_buffering_date > 0 )
-        {
-            p_ts->i_buffering_delay += i_buffering_date - cmd.i_date; /* It is < 0 */
-            if( b_buffering )
-                i_buffering_date = cmd.i_date;
-            else
-                i_buffering_date = -1;
+            p_ts->b_seek_clock = false;
+            p_ts->i_cmd_delay = vlc_tick_now() - cmd.i_date;
+            p_ts->i_buffering_delay = 0;
+            p_ts->i_rate_delay = 0;
+            p_ts->i_rate_date = -1;
+            i_buffering_date = -1;
         }
 
-        if( p_ts->i_rate_date < 0 )
-            p_ts->i_rate_date = cmd.i_date;
-
-        p_ts->i_rate_delay = 0;
-        if( p_ts->rate_source != p_ts->rate )
+        if( i_state == TS_CMD_SKIP )
         {
-            const vlc_tick_t i_duration = cmd.i_date - p_ts->i_rate_date;
-            p_ts->i_rate_delay = i_duration * p_ts->rate_source / p_ts->rate - i_duration;
+            /* Already jumped over, do not wait nor account for it */
+            i_deadline = VLC_TICK_0;
         }
-        if( p_ts->i_cmd_delay + p_ts->i_rate_delay + p_ts->i_buffering_delay < 0 && p_ts->rate != p_ts->rate_source )
+        else
         {
-            const int canc = vlc_savecancel();
-
-            /* Auto reset to rate 1.0 */
-            msg_Warn( p_ts->p_input, "es out timeshift: auto reset rate to %f", p_ts->rate_source );
+            if( b_buffering && i_buffering_date < 0 )
+            {
+                i_buffering_date = cmd.i_date;
+            }
+            else if( i_buffering_date > 0 )
+            {
+                p_ts->i_buffering_delay += i_buffering_date - cmd.i_date; /* It is < 0 */
+                if( b_buffering )
+                    i_buffering_date = cmd.i_date;
+                else
+                    i_buffering_date = -1;
+            }
 
-            p_ts->i_cmd_delay = 0;
-            p_ts->i_buffering_delay = 0;
+            if( p_ts->i_rate_date < 0 )
+                p_ts->i_rate_date = cmd.i_date;
 
             p_ts->i_rate_delay = 0;
-            p_ts->i_rate_date = -1;
-            p_ts->rate = p_ts->rate_source;
-
-            if( !es_out_SetRate( p_ts->p_out, p_ts->rate_source, p_ts->rate ) )
+            if( p_ts->rate_source != p_ts->rate )
             {
-                vlc_value_t val = { .f_float = p_ts->rate };
-                /* Warn back input
-                 * FIXME it is perfectly safe BUT it is ugly as it may hide a
-                 * rate change requested by user */
-                input_ControlPushHelper( p_ts->p_input, INPUT_CONTROL_SET_RATE, &val );
+                const vlc_tick_t i_duration = cmd.i_date - p_ts->i_rate_date;
+                p_ts->i_rate_delay = i_duration * p_ts->rate_source / p_ts->rate - i_duration;
             }
+            if( p_ts->i_cmd_delay + p_ts->i_rate_delay + p_ts->i_buffering_delay < 0 && p_ts->rate != p_ts->rate_source )
+            {
+                const int canc = vlc_savecancel();
 
-            vlc_restorecancel( canc );
+                /* Auto reset to rate 1.0 */
+                msg_Warn( p_ts->p_input, "es out timeshift: auto reset rate to %f", p_ts->rate_source );
+
+                p_ts->i_cmd_delay = 0;
+                p_ts->i_buffering_delay = 0;
+
+                p_ts->i_rate_delay = 0;
+                p_ts->i_rate_date = -1;
+                p_ts->rate = p_ts->rate_source;
+
+                if( !es_out_SetRate( p_ts->p_out, p_ts->rate_source, p_ts->rate ) )
+                {
+                    vlc_value_t val = { .f_float = p_ts->rate };
+                    /* Warn back input
+                     * FIXME it is perfectly safe BUT it is ugly as it may hide a
+                     * rate change requested by user */
+                    input_ControlPushHelper( p_ts->p_input, INPUT_CONTROL_SET_RATE, &val );
+                }
+
+                vlc_restorecancel( canc );
+            }
+            i_deadline = cmd.i_date + p_ts->i_cmd_delay + p_ts->i_rate_delay + p_ts->i_buffering_delay;
         }
-        i_deadline = cmd.i_date + p_ts->i_cmd_delay + p_ts->i_rate_delay + p_ts->i_buffering_delay;
 
         vlc_cleanup_pop();
         vlc_mutex_unlock( &p_ts->lock );
 
         /* Regulate the speed of command processing to the same one than
          * reading  */
-        vlc_cleanup_push( cmd_cleanup_routine, &cmd );
+        if( b_execute )
+        {
+            vlc_cleanup_push( cmd_cleanup_routine, &cmd );
 
-        vlc_tick_wait( i_deadline );
+            vlc_tick_wait( i_deadline );
 
-        vlc_cleanup_pop();
+            vlc_cleanup_pop();
+        }
 
         /* Execute the command  */
         const int canc = vlc_savecancel();
-        switch( cmd.i_type )
+        if( b_flush )
+            es_out_Control( p_ts->p_out, ES_OUT_RESET_PCR );
+
+        if( !b_execute )
+        {
+            /* Replayed commands were cleaned when first executed */
+            if( i_state == TS_CMD_SKIP )
+                CmdClean( &cmd );
+        }
+        else switch( cmd.i_type )
         {
         case C_ADD:
             CmdExecuteAdd( p_ts->p_out, &cmd );
@@ -1109,25 +1443,56 @@ static void *TsRun( void *p_data )
 /*****************************************************************************
  *
  *****************************************************************************/
-static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max )
+static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_max,
+                                   ts_memory_t *p_memory )
 {
     ts_storage_t *p_storage = malloc( sizeof (*p_storage) );
     if( unlikely(p_storage == NULL) )
         return NULL;
 
-    char *psz_file;
-    int fd = GetTmpFile( &psz_file, psz_tmp_path );
-    if( fd == -1 )
+    p_storage->p_next = NULL;
+
+    /* The file is only created when data does not fit in memory */
+    p_storage->psz_tmp_path = psz_tmp_path;
+#ifdef _WIN32
+    p_storage->psz_file = NULL;
+#endif
+    p_storage->p_filew = NULL;
+    p_storage->p_filer = NULL;
+    p_storage->p_memory = p_memory;
+
+    /* */
+    p_storage->i_file_max = i_tmp_size_max;
+    p_storage->i_file_size = 0;
+
+    /* */
+    p_storage->i_cmd_h = 0;
+    p_storage->i_cmd_w = 0;
+    p_storage->i_cmd_r = 0;
+    p_storage->i_cmd_max = 30000;
+    p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
+    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
+    ARRAY_INIT( p_storage->index );
+
+    if( !p_storage->p_cmd )
     {
         free( p_storage );
         return NULL;
     }
+    return p_storage;
+}
+
+static int TsStorageOpenFile( ts_storage_t *p_storage )
+{
+    char *psz_file;
+    int fd = GetTmpFile( &psz_file, p_storage->psz_tmp_path );
+    if( fd == -1 )
+        return VLC_EGENERIC;
 
     p_storage->p_filew = fdopen( fd, "w+b" );
     if( p_storage->p_filew == NULL )
     {
         vlc_close( fd );
-        vlc_unlink( psz_file );
         goto error;
     }
 
@@ -1135,7 +1500,7 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
     if( p_storage->p_filer == NULL )
     {
         fclose( p_storage->p_filew );
-        vlc_unlink( psz_file );
+        p_storage->p_filew = NULL;
         goto error;
     }
 
@@ -1145,29 +1510,11 @@ static ts_storage_t *TsStorageNew( const char *psz_tmp_path, int64_t i_tmp_size_
 #else
     p_storage->psz_file = psz_file;
 #endif
-    p_storage->p_next = NULL;
-
-    /* */
-    p_storage->i_file_max = i_tmp_size_max;
-    p_storage->i_file_size = 0;
-
-    /* */
-    p_storage->i_cmd_w = 0;
-    p_storage->i_cmd_r = 0;
-    p_storage->i_cmd_max = 30000;
-    p_storage->p_cmd = vlc_alloc( p_storage->i_cmd_max, sizeof(*p_storage->p_cmd) );
-    //fprintf( stderr, "\nSTORAGE name=%s size=%d KiB\n", p_storage->psz_file, p_storage->i_cmd_max * sizeof(*p_storage->p_cmd) /1024 );
-
-    if( !p_storage->p_cmd )
-    {
-        TsStorageDelete( p_storage );
-        return NULL;
-    }
-    return p_storage;
+    return VLC_SUCCESS;
 error:
+    vlc_unlink( psz_file );
     free( psz_file );
-    free( p_storage );
-    return NULL;
+    return VLC_EGENERIC;
 }
 
 static void TsStorageDelete( ts_storage_t *p_storage )
@@ -1180,17 +1527,41 @@ static void TsStorageDelete( ts_storage_t *p_storage )
 
         CmdClean( &cmd );
     }
+    TsStorageDropHistory( p_storage, p_storage->i_cmd_r );
     free( p_storage->p_cmd );
+    ARRAY_RESET( p_storage->index );
 
-    fclose( p_storage->p_filer );
-    fclose( p_storage->p_filew );
+    if( p_storage->p_filew != NULL )
+    {
+        fclose( p_storage->p_filer );
+        fclose( p_storage->p_filew );
+    }
 #ifdef _WIN32
-    vlc_unlink( p_storage->psz_file );
+    if( p_storage->psz_file != NULL )
+        vlc_unlink( p_storage->psz_file );
     free( p_storage->psz_file );
 #endif
     free( p_storage );
 }
 
+/* Releases the blocks kept in memory for the played commands before i_cmd */
+static void TsStorageDropHistory( ts_storage_t *p_storage, int i_cmd )
+{
+    for( ; p_storage->i_cmd_h < i_cmd; p_storage->i_cmd_h++ )
+    {
+        ts_cmd_t *p_cmd = &p_storage->p_cmd[p_storage->i_cmd_h];
+        if( p_cmd->i_type != C_SEND || p_cmd->u.send.i_offset >= 0 ||
+            !p_cmd->u.send.p_block )
+            continue;
+
+        block_t *p_block = p_cmd->u.send.p_block;
+
+        p_storage->p_memory->i_size -= sizeof(*p_block) + p_block->i_buffer;
+        p_cmd->u.send.p_block = NULL;
+        block_Release( p_block );
+    }
+}
+
 static void TsStoragePack( ts_storage_t *p_storage )
 {
     /* Try to release a bit of memory */
@@ -1221,12 +1592,29 @@ static bool TsStorageIsEmpty( ts_storage_t *p_storage )
 static void TsStoragePushCmd( ts_storage_t *p_storage, const ts_cmd_t *p_cmd, bool b_flush )
 {
     ts_cmd_t cmd = *p_cmd;
+    ts_memory_t *p_memory = p_storage->p_memory;
 
     assert( !TsStorageIsFull( p_storage, p_cmd ) );
 
     if( cmd.i_type == C_SEND )
     {
         block_t *p_block = cmd.u.send.p_block;
+        const size_t i_size = sizeof(*p_block) + p_block->i_buffer;
+
+        /* Keep the block as is while it fits in memory */
+        if( p_memory->i_size + i_size <= p_memory->i_size_max )
+        {
+            p_memory->i_size += i_size;
+            cmd.u.send.i_offset = -1;
+            p_storage->p_cmd[p_storage->i_cmd_w++] = cmd;
+            return;
+        }
+
+        if( p_storage->p_filew == NULL && TsStorageOpenFile( p_storage ) )
+        {
+            block_Release( p_block );
+            return;
+        }
 
         cmd.u.send.p_block = NULL;
         cmd.u.send.i_offset = ftell( p_storage->p_filew );
@@ -1257,8 +1645,25 @@ static void TsStoragePopCmd( ts_storage_t *p_storage, ts_cmd_t *p_cmd, bool b_fl
 {
     assert( !TsStorageIsEmpty( p_storage ) );
 
-    *p_cmd = p_storage->p_cmd[p_storage->i_cmd_r++];
-    if( p_cmd->i_type == C_SEND )
+    ts_cmd_t *p_stored = &p_storage->p_cmd[p_storage->i_cmd_r++];
+
+    *p_cmd = *p_stored;
+    if( p_cmd->i_type == C_SEND && p_cmd->u.send.i_offset < 0 )
+    {
+        block_t *p_block = p_stored->u.send.p_block;
+
+        if( !p_storage->p_memory->b_history )
+        {
+            p_storage->p_memory->i_size -= sizeof(*p_block) + p_block->i_buffer;
+            p_stored->u.send.p_block = NULL;
+        }
+        else
+        {
+            /* The stored block is kept to play it again after rewinding */
+            p_cmd->u.send.p_block = b_flush ? NULL : block_Duplicate( p_block );
+        }
+    }
+    else if( p_cmd->i_type == C_SEND )
     {
         block_t block;
 
@@ -1310,6 +1715,26 @@ static void CmdClean( ts_cmd_t *p_cmd )
     }
 }
 
+/* Data and clock references, which are needed again to play from a seek
+ * point, as opposed to the commands changing the ES state */
+static bool CmdIsTiming( const ts_cmd_t *p_cmd )
+{
+    if( p_cmd->i_type == C_SEND )
+        return true;
+    if( p_cmd->i_type != C_CONTROL )
+        return false;
+
+    switch( p_cmd->u.control.i_query )
+    {
+    case ES_OUT_SET_PCR:
+    case ES_OUT_SET_GROUP_PCR:
+    case ES_OUT_SET_TIMES:
+        return true;
+    default:
+        return false;
+    }
+}
+
 static int CmdInitAdd( ts_cmd_t *p_cmd, es_out_id_t *p_es, const es_format_t *p_fmt, bool b_copy )
 {
     p_cmd->i_type = C_ADD;
@@ -1861,6 +1861,14 @@ static bool Control( input_thread_t *p_input,
                 break;
             }
 
+            /* Seek inside the timeshift buffer when the target is there */
+            if( !es_out_SetTimeshiftTime( priv->p_es_out, param.time.i_val,
+                                          absolute ) )
+            {
+                b_force_update = true;
+                break;
+            }
+
             /* Reset the decoders states and clock sync (before calling the demuxer */
             es_out_Control( priv->p_es_out, ES_OUT_RESET_PCR );
 
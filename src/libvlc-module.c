@@ -732,6 +732,16 @@ static const char *const ppsz_prefres[] = {
     "This is the maximum size in bytes of the temporary files " \
     "that will be used to store the timeshifted streams." )
 
+#define INPUT_TIMESHIFT_MEMORY_TEXT N_("Timeshift memory")
+#define INPUT_TIMESHIFT_MEMORY_LONGTEXT N_( \
+    "This is the maximum size in bytes of the timeshifted streams that " \
+    "is kept in memory before using temporary files." )
+
+#define INPUT_TIMESHIFT_HISTORY_TEXT N_("Timeshift history (seconds)")
+#define INPUT_TIMESHIFT_HISTORY_LONGTEXT N_( \
+    "Duration of the already played timeshifted streams that is kept " \
+    "to allow seeking backward. 0 disables it." )
+
 #define INPUT_TITLE_FORMAT_TEXT N_( "Change title according to current media" )
 #define INPUT_TITLE_FORMAT_LONGTEXT N_( "This option allows you to set the title according to what's being played<br>"  \
     "$a: Artist<br>$b: Album<br>$c: Copyright<br>$t: Title<br>$g: Genre<br>"  \
@@ -2051,6 +2061,10 @@ vlc_module_begin ()
                   INPUT_TIMESHIFT_PATH_TEXT, INPUT_TIMESHIFT_PATH_LONGTEXT)
     add_integer( "input-timeshift-granularity", -1, INPUT_TIMESHIFT_GRANULARITY_TEXT,
                  INPUT_TIMESHIFT_GRANULARITY_LONGTEXT, true )
+    add_integer( "input-timeshift-memory", 32*1024*1024, INPUT_TIMESHIFT_MEMORY_TEXT,
+                 INPUT_TIMESHIFT_MEMORY_LONGTEXT, true )
+    add_integer( "input-timeshift-history", 0, INPUT_TIMESHIFT_HISTORY_TEXT,
+                 INPUT_TIMESHIFT_HISTORY_LONGTEXT, true )
 
     add_string( "input-title-format", "$Z", INPUT_TITLE_FORMAT_TEXT, INPUT_TITLE_FORMAT_LONGTEXT, false );
 
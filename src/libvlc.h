@@ -39,6 +39,7 @@ void system_Configure ( libvlc_int_t *, int, const char *const [] );
 void system_End(void);
 #endif
 void vlc_CPU_dump(vlc_object_t *);
+void block_PoolCleanup(vlc_object_t *);
 
 /*
  * Threads subsystem
@@ -27,6 +27,7 @@
 
 #include <sys/stat.h>
 #include <assert.h>
+#include <stdatomic.h>
 #include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -34,6 +35,7 @@
 #include <vlc_common.h>
 #include <vlc_block.h>
 #include <vlc_fs.h>
+#include "libvlc.h"
 
 #ifndef NDEBUG
 static void block_Check (block_t *block)
@@ -105,6 +107,401 @@ static void BlockMetaCopy( block_t *restrict out, const block_t *in )
 /** Initial reserved header and footer size. */
 #define BLOCK_PADDING      32
 
+/**
+ * Block recycling.
+ *
+ * Payload sizes up to 2^BLOCK_POOL_MAX_SHIFT bytes are rounded up to a size
+ * class, four per power of two, so that a class wastes at most a fifth of its
+ * size: 188 bytes TS packets take the 192 bytes class. Released blocks of a
+ * class are kept in a bounded cache of the releasing thread, which spills to
+ * and refills from a bounded depot shared by all threads, so that producer
+ * and consumer threads recycle each other's blocks without taking a lock on
+ * every call.
+ *
+ * The depot frees the blocks that it did not hand out for a whole
+ * BLOCK_POOL_TRIM_PERIOD, and when a thread exits. All the cached blocks,
+ * in thread caches and in the depot, stay within BLOCK_POOL_TOTAL_BYTES.
+ *
+ * AddressSanitizer builds do not recycle blocks, so that accesses to released
+ * blocks are still reported.
+ */
+#if defined(__SANITIZE_ADDRESS__)
+# define BLOCK_POOL_DISABLED
+#elif defined(__has_feature)
+# if __has_feature(address_sanitizer)
+#  define BLOCK_POOL_DISABLED
+# endif
+#endif
+
+#define BLOCK_POOL_MIN_SHIFT   6
+#define BLOCK_POOL_MAX_SHIFT   16
+/** One class up to 2^BLOCK_POOL_MIN_SHIFT bytes, then four per power of two */
+#define BLOCK_POOL_CLASSES     (1 + 4 * (BLOCK_POOL_MAX_SHIFT - BLOCK_POOL_MIN_SHIFT))
+
+/** Per size class bounds of each thread cache and of the depot. */
+#define BLOCK_POOL_CACHE_BYTES (128 << 10)
+#define BLOCK_POOL_DEPOT_BYTES (512 << 10)
+/** Bound of all cached blocks. */
+#define BLOCK_POOL_TOTAL_BYTES (32 << 20)
+#define BLOCK_POOL_TRIM_PERIOD VLC_TICK_FROM_SEC(1)
+
+struct block_pool_stats
+{
+    unsigned long allocs; /**< pooled allocations */
+    unsigned long hits; /**< served from the thread cache */
+    unsigned long refills; /**< blocks moved from the depot */
+    unsigned long spills; /**< blocks moved to the depot */
+    unsigned long frees; /**< blocks returned to the heap */
+};
+
+struct block_pool_cache
+{
+    block_t *list[BLOCK_POOL_CLASSES];
+    unsigned count[BLOCK_POOL_CLASSES];
+    struct block_pool_stats stats[BLOCK_POOL_CLASSES];
+};
+
+static struct
+{
+    vlc_mutex_t lock;
+    block_t *list[BLOCK_POOL_CLASSES];
+    unsigned count[BLOCK_POOL_CLASSES];
+    /** lowest count since the last trim: blocks that were not handed out */
+    unsigned low[BLOCK_POOL_CLASSES];
+    vlc_tick_t trim_deadline;
+    struct block_pool_stats stats[BLOCK_POOL_CLASSES];
+} block_depot = { .lock = VLC_STATIC_MUTEX };
+
+/** Size of all cached blocks, headers included. */
+static atomic_size_t block_pool_bytes = ATOMIC_VAR_INIT(0);
+
+static vlc_threadvar_t block_pool_key;
+static bool block_pool_key_valid;
+
+/** Payload size of a size class. */
+static size_t block_pool_ClassSize(unsigned c)
+{
+    if (c == 0)
+        return (size_t)1 << BLOCK_POOL_MIN_SHIFT;
+
+    unsigned shift = BLOCK_POOL_MIN_SHIFT + (c - 1) / 4;
+
+    return ((size_t)1 << shift) + ((size_t)((c - 1) % 4 + 1) << (shift - 2));
+}
+
+/** Returns the size class of a payload size, or BLOCK_POOL_CLASSES. */
+static unsigned block_pool_Class(size_t size)
+{
+#ifdef BLOCK_POOL_DISABLED
+    (void) size;
+    return BLOCK_POOL_CLASSES;
+#else
+    if (size <= ((size_t)1 << BLOCK_POOL_MIN_SHIFT))
+        return 0;
+    if (size > ((size_t)1 << BLOCK_POOL_MAX_SHIFT))
+        return BLOCK_POOL_CLASSES;
+
+    /* the power of two below, then the quarter of it */
+    unsigned n = size - 1;
+    unsigned shift = (sizeof (n) * 8 - 1) - vlc_clz(n);
+
+    return 1 + 4 * (shift - BLOCK_POOL_MIN_SHIFT) + ((n >> (shift - 2)) & 3);
+#endif
+}
+
+/** Block buffer size of a pooled size class. */
+#define BLOCK_POOL_SIZE(c) \
+    (BLOCK_ALIGN + (2 * BLOCK_PADDING) + block_pool_ClassSize(c))
+
+static unsigned block_pool_CacheMax(unsigned c)
+{
+    return BLOCK_POOL_CACHE_BYTES / block_pool_ClassSize(c);
+}
+
+static unsigned block_pool_DepotMax(unsigned c)
+{
+    return BLOCK_POOL_DEPOT_BYTES / block_pool_ClassSize(c);
+}
+
+static void block_pool_FreeList(block_t *list)
+{
+    size_t bytes = 0;
+
+    while (list != NULL)
+    {
+        block_t *next = list->p_next;
+
+        bytes += sizeof (*list) + list->i_size;
+        free(list);
+        list = next;
+    }
+    atomic_fetch_sub_explicit(&block_pool_bytes, bytes, memory_order_relaxed);
+}
+
+/** Merges a thread statistics into the depot ones; depot must be locked. */
+static void block_pool_MergeStats(struct block_pool_stats *restrict stats)
+{
+    for (unsigned c = 0; c < BLOCK_POOL_CLASSES; c++)
+    {
+        struct block_pool_stats *total = &block_depot.stats[c];
+
+        total->allocs += stats[c].allocs;
+        total->hits += stats[c].hits;
+        total->refills += stats[c].refills;
+        total->spills += stats[c].spills;
+        total->frees += stats[c].frees;
+    }
+    memset(stats, 0, BLOCK_POOL_CLASSES * sizeof (*stats));
+}
+
+/** Takes the depot blocks that were not handed out since the last trim;
+ * depot must be locked. */
+static block_t *block_pool_Trim(block_t *excess)
+{
+    for (unsigned c = 0; c < BLOCK_POOL_CLASSES; c++)
+    {
+        while (block_depot.low[c] > 0)
+        {
+            block_t *b = block_depot.list[c];
+
+            block_depot.list[c] = b->p_next;
+            block_depot.count[c]--;
+            block_depot.low[c]--;
+            block_depot.stats[c].frees++;
+            b->p_next = excess;
+            excess = b;
+        }
+        block_depot.low[c] = block_depot.count[c];
+    }
+    block_depot.trim_deadline = vlc_tick_now() + BLOCK_POOL_TRIM_PERIOD;
+    return excess;
+}
+
+/** Moves up to count blocks of a class from a thread cache to the depot,
+ * and frees what does not fit. */
+static void block_pool_Spill(struct block_pool_cache *cache, unsigned c,
+                             unsigned count)
+{
+    block_t *excess = NULL;
+
+    vlc_mutex_lock(&block_depot.lock);
+    while (count > 0 && cache->list[c] != NULL)
+    {
+        block_t *b = cache->list[c];
+
+        cache->list[c] = b->p_next;
+        cache->count[c]--;
+        count--;
+
+        if (block_depot.count[c] < block_pool_DepotMax(c))
+        {
+            b->p_next = block_depot.list[c];
+            block_depot.list[c] = b;
+            block_depot.count[c]++;
+            cache->stats[c].spills++;
+        }
+        else
+        {
+            b->p_next = excess;
+            excess = b;
+            cache->stats[c].frees++;
+        }
+    }
+    block_pool_MergeStats(cache->stats);
+    if (vlc_tick_now() >= block_depot.trim_deadline)
+        excess = block_pool_Trim(excess);
+    vlc_mutex_unlock(&block_depot.lock);
+
+    block_pool_FreeList(excess);
+}
+
+static void block_pool_Refill(struct block_pool_cache *cache, unsigned c)
+{
+    unsigned count = (block_pool_CacheMax(c) + 1) / 2;
+    block_t *excess = NULL;
+
+    vlc_mutex_lock(&block_depot.lock);
+    while (count > 0 && block_depot.list[c] != NULL)
+    {
+        block_t *b = block_depot.list[c];
+
+        block_depot.list[c] = b->p_next;
+        block_depot.count[c]--;
+        b->p_next = cache->list[c];
+        cache->list[c] = b;
+        cache->count[c]++;
+        cache->stats[c].refills++;
+        count--;
+    }
+    if (block_depot.low[c] > block_depot.count[c])
+        block_depot.low[c] = block_depot.count[c];
+    if (vlc_tick_now() >= block_depot.trim_deadline)
+        excess = block_pool_Trim(excess);
+    vlc_mutex_unlock(&block_depot.lock);
+
+    block_pool_FreeList(excess);
+}
+
+static void block_pool_CacheDestroy(void *data)
+{
+    struct block_pool_cache *cache = data;
+
+    for (unsigned c = 0; c < BLOCK_POOL_CLASSES; c++)
+        block_pool_Spill(cache, c, cache->count[c]);
+    free(cache);
+
+    /* the exiting thread is no longer using the depot */
+    vlc_mutex_lock(&block_depot.lock);
+    block_t *excess = block_pool_Trim(NULL);
+    vlc_mutex_unlock(&block_depot.lock);
+
+    block_pool_FreeList(excess);
+}
+
+static void block_pool_Init(void)
+{
+    block_pool_key_valid =
+        vlc_threadvar_create(&block_pool_key, block_pool_CacheDestroy) == 0;
+}
+
+static struct block_pool_cache *block_pool_GetCache(void)
+{
+    static vlc_once_t once = VLC_STATIC_ONCE;
+
+    vlc_once(&once, block_pool_Init);
+    if (unlikely(!block_pool_key_valid))
+        return NULL;
+
+    struct block_pool_cache *cache = vlc_threadvar_get(block_pool_key);
+    if (unlikely(cache == NULL))
+    {
+        cache = calloc(1, sizeof (*cache));
+        if (cache != NULL && vlc_threadvar_set(block_pool_key, cache))
+        {
+            free(cache);
+            cache = NULL;
+        }
+    }
+    return cache;
+}
+
+static void block_pool_Release(block_t *block)
+{
+    unsigned c = block_pool_Class(block->i_size - BLOCK_ALIGN - 2 * BLOCK_PADDING);
+    size_t bytes = sizeof (*block) + block->i_size;
+
+    assert(block->p_start == (unsigned char *)(block + 1));
+    assert(c < BLOCK_POOL_CLASSES && block->i_size == BLOCK_POOL_SIZE(c));
+
+    struct block_pool_cache *cache = block_pool_GetCache();
+    if (unlikely(cache == NULL))
+    {
+        free(block);
+        return;
+    }
+
+    if (atomic_load_explicit(&block_pool_bytes, memory_order_relaxed)
+         + bytes > BLOCK_POOL_TOTAL_BYTES)
+    {
+        cache->stats[c].frees++;
+        free(block);
+        return;
+    }
+
+    if (cache->count[c] >= block_pool_CacheMax(c))
+        block_pool_Spill(cache, c, (cache->count[c] + 1) / 2);
+
+    block->p_next = cache->list[c];
+    cache->list[c] = block;
+    cache->count[c]++;
+    atomic_fetch_add_explicit(&block_pool_bytes, bytes, memory_order_relaxed);
+}
+
+static const struct vlc_block_callbacks block_pool_cbs =
+{
+    block_pool_Release,
+};
+
+static block_t *block_pool_Alloc(unsigned c)
+{
+    struct block_pool_cache *cache = block_pool_GetCache();
+    if (unlikely(cache == NULL))
+        return NULL;
+
+    cache->stats[c].allocs++;
+    if (cache->list[c] != NULL)
+        cache->stats[c].hits++;
+    else
+        block_pool_Refill(cache, c);
+
+    block_t *b = cache->list[c];
+    if (b != NULL)
+    {
+        cache->list[c] = b->p_next;
+        cache->count[c]--;
+        atomic_fetch_sub_explicit(&block_pool_bytes,
+                                  sizeof (*b) + BLOCK_POOL_SIZE(c),
+                                  memory_order_relaxed);
+    }
+    else
+    {
+        b = malloc(sizeof (*b) + BLOCK_POOL_SIZE(c));
+        if (unlikely(b == NULL))
+            return NULL;
+    }
+
+    return block_Init(b, &block_pool_cbs, b + 1, BLOCK_POOL_SIZE(c));
+}
+
+void block_PoolCleanup(vlc_object_t *obj)
+{
+    struct block_pool_cache *cache = block_pool_GetCache();
+    block_t *excess = NULL;
+
+    vlc_mutex_lock(&block_depot.lock);
+    if (cache != NULL)
+        block_pool_MergeStats(cache->stats);
+
+    for (unsigned c = 0; c < BLOCK_POOL_CLASSES; c++)
+    {
+        const struct block_pool_stats *st = &block_depot.stats[c];
+
+        if (st->allocs == 0)
+            continue;
+        msg_Dbg(obj, "block pool %6zu bytes: %lu allocs, %lu hits, "
+                "%lu refills, %lu spills, %lu freed, %u in depot",
+                block_pool_ClassSize(c), st->allocs, st->hits, st->refills,
+                st->spills, st->frees, block_depot.count[c]);
+    }
+
+    /* release the depot, and the cache of this thread */
+    for (unsigned c = 0; c < BLOCK_POOL_CLASSES; c++)
+    {
+        block_t **pp = &block_depot.list[c];
+
+        while (*pp != NULL)
+            pp = &(*pp)->p_next;
+        *pp = excess;
+        excess = block_depot.list[c];
+        block_depot.list[c] = NULL;
+        block_depot.count[c] = block_depot.low[c] = 0;
+
+        if (cache != NULL)
+        {
+            pp = &cache->list[c];
+            while (*pp != NULL)
+                pp = &(*pp)->p_next;
+            *pp = excess;
+            excess = cache->list[c];
+            cache->list[c] = NULL;
+            cache->count[c] = 0;
+        }
+    }
+    vlc_mutex_unlock(&block_depot.lock);
+
+    block_pool_FreeList(excess);
+}
+
 block_t *block_Alloc (size_t size)
 {
     if (unlikely(size >> 27))
@@ -113,17 +510,26 @@ block_t *block_Alloc (size_t size)
         return NULL;
     }
 
-    /* 2 * BLOCK_PADDING: pre + post padding */
-    const size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
-                       + size;
-    if (unlikely(alloc <= size))
-        return NULL;
+    block_t *b = NULL;
+    unsigned c = block_pool_Class(size);
 
-    block_t *b = malloc (alloc);
-    if (unlikely(b == NULL))
-        return NULL;
+    if (c < BLOCK_POOL_CLASSES)
+        b = block_pool_Alloc(c);
+    if (b == NULL)
+    {
+        /* 2 * BLOCK_PADDING: pre + post padding */
+        const size_t alloc = sizeof (block_t) + BLOCK_ALIGN + (2 * BLOCK_PADDING)
+                           + size;
+        if (unlikely(alloc <= size))
+            return NULL;
+
+        b = malloc (alloc);
+        if (unlikely(b == NULL))
+            return NULL;
+
+        block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
+    }
 
-    block_Init(b, &block_generic_cbs, b + 1, alloc - sizeof (*b));
     static_assert ((BLOCK_PADDING % BLOCK_ALIGN) == 0,
                    "BLOCK_PADDING must be a multiple of BLOCK_ALIGN");
     b->p_buffer += BLOCK_PADDING + BLOCK_ALIGN - 1;
@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * filter_slices.c : Slice threading for CPU filters
+ *****************************************************************************
+ * Copyright (C) 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_list.h>
+
+/** A filter_slices_Run() call, queued while some slices are not started */
+struct slice_job
+{
+    filter_slice_cb cb;
+    void           *opaque;
+    unsigned        i_slices;
+    unsigned        i_next;  /**< next slice to start */
+    unsigned        i_done;  /**< number of finished slices */
+    vlc_cond_t      done;
+    struct vlc_list node;
+};
+
+struct filter_slices_t
+{
+    vlc_mutex_t     lock;
+    vlc_cond_t      wait;
+    struct vlc_list jobs;
+    bool            b_quit;
+
+    unsigned        i_refs;
+    unsigned        i_threads;
+    vlc_thread_t   *p_threads;
+};
+
+static vlc_mutex_t pool_lock = VLC_STATIC_MUTEX;
+static filter_slices_t *pool = NULL;
+
+/* Takes the next slice of a job. Must be called with the pool locked. */
+static unsigned TakeSlice( struct slice_job *p_job )
+{
+    assert( p_job->i_next < p_job->i_slices );
+
+    unsigned i_slice = p_job->i_next++;
+    if( p_job->i_next == p_job->i_slices )
+        vlc_list_remove( &p_job->node );
+    return i_slice;
+}
+
+static void *Worker( void *data )
+{
+    filter_slices_t *p_pool = data;
+
+    vlc_mutex_lock( &p_pool->lock );
+    for( ;; )
+    {
+        while( !p_pool->b_quit && vlc_list_is_empty( &p_pool->jobs ) )
+            vlc_cond_wait( &p_pool->wait, &p_pool->lock );
+        if( p_pool->b_quit )
+            break;
+
+        struct slice_job *p_job =
+            vlc_list_first_entry_or_null( &p_pool->jobs, struct slice_job,
+                                          node );
+        unsigned i_slice = TakeSlice( p_job );
+
+        vlc_mutex_unlock( &p_pool->lock );
+        p_job->cb( p_job->opaque, i_slice, p_job->i_slices );
+        vlc_mutex_lock( &p_pool->lock );
+
+        if( ++p_job->i_done == p_job->i_slices )
+            vlc_cond_signal( &p_job->done );
+    }
+    vlc_mutex_unlock( &p_pool->lock );
+
+    return NULL;
+}
+
+static void StopWorkers( filter_slices_t *p_pool )
+{
+    vlc_mutex_lock( &p_pool->lock );
+    p_pool->b_quit = true;
+    vlc_cond_broadcast( &p_pool->wait );
+    vlc_mutex_unlock( &p_pool->lock );
+
+    for( unsigned i = 0; i < p_pool->i_threads; i++ )
+        vlc_join( p_pool->p_threads[i], NULL );
+}
+
+filter_slices_t *filter_slices_Hold( void )
+{
+    vlc_mutex_lock( &pool_lock );
+    if( pool != NULL )
+    {
+        pool->i_refs++;
+        vlc_mutex_unlock( &pool_lock );
+        return pool;
+    }
+
+    /* The calling threads process slices too */
+    unsigned i_threads = __MIN( vlc_GetCPUCount(), FILTER_SLICES_MAX ) - 1;
+    if( i_threads == 0 )
+        goto error;
+
+    filter_slices_t *p_pool = malloc( sizeof( *p_pool ) );
+    if( unlikely(p_pool == NULL) )
+        goto error;
+    p_pool->p_threads = vlc_alloc( i_threads, sizeof( *p_pool->p_threads ) );
+    if( unlikely(p_pool->p_threads == NULL) )
+    {
+        free( p_pool );
+        goto error;
+    }
+
+    vlc_mutex_init( &p_pool->lock );
+    vlc_cond_init( &p_pool->wait );
+    vlc_list_init( &p_pool->jobs );
+    p_pool->b_quit = false;
+    p_pool->i_refs = 1;
+    p_pool->i_threads = 0;
+
+    for( ; p_pool->i_threads < i_threads; p_pool->i_threads++ )
+        if( vlc_clone( &p_pool->p_threads[p_pool->i_threads], Worker, p_pool,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+            break;
+
+    if( p_pool->i_threads == 0 )
+    {
+        free( p_pool->p_threads );
+        free( p_pool );
+        goto error;
+    }
+
+    pool = p_pool;
+    vlc_mutex_unlock( &pool_lock );
+    return p_pool;
+
+error:
+    vlc_mutex_unlock( &pool_lock );
+    return NULL;
+}
+
+void filter_slices_Release( filter_slices_t *p_pool )
+{
+    vlc_mutex_lock( &pool_lock );
+    assert( p_pool == pool );
+    if( --p_pool->i_refs > 0 )
+    {
+        vlc_mutex_unlock( &pool_lock );
+        return;
+    }
+    pool = NULL;
+    vlc_mutex_unlock( &pool_lock );
+
+    StopWorkers( p_pool );
+    assert( vlc_list_is_empty( &p_pool->jobs ) );
+    free( p_pool->p_threads );
+    free( p_pool );
+}
+
+unsigned filter_slices_Run( filter_slices_t *p_pool, unsigned i_max_slices,
+                           filter_slice_cb cb, void *opaque )
+{
+    assert( i_max_slices > 0 && i_max_slices <= FILTER_SLICES_MAX );
+
+    if( p_pool == NULL || i_max_slices == 1 )
+    {
+        cb( opaque, 0, 1 );
+        return 1;
+    }
+
+    const unsigned i_slices = __MIN( i_max_slices, p_pool->i_threads + 1 );
+    struct slice_job job = {
+        .cb = cb,
+        .opaque = opaque,
+        .i_slices = i_slices,
+        .i_next = 0,
+        .i_done = 0,
+    };
+    vlc_cond_init( &job.done );
+
+    vlc_mutex_lock( &p_pool->lock );
+    vlc_list_append( &job.node, &p_pool->jobs );
+    if( i_slices > 2 )
+        vlc_cond_broadcast( &p_pool->wait );
+    else
+        vlc_cond_signal( &p_pool->wait );
+
+    /* Help with our own job rather than idling */
+    while( job.i_next < job.i_slices )
+    {
+        unsigned i_slice = TakeSlice( &job );
+
+        vlc_mutex_unlock( &p_pool->lock );
+        cb( opaque, i_slice, i_slices );
+        vlc_mutex_lock( &p_pool->lock );
+
+        job.i_done++;
+    }
+
+    while( job.i_done < job.i_slices )
+        vlc_cond_wait( &job.done, &p_pool->lock );
+    vlc_mutex_unlock( &p_pool->lock );
+
+    return i_slices;
+}
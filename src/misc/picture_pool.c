@@ -34,19 +34,36 @@
 #include <vlc_picture_pool.h>
 #include "picture.h"
 
-#define POOL_MAX (CHAR_BIT * sizeof (unsigned long long))
-
-static_assert ((POOL_MAX & (POOL_MAX - 1)) == 0, "Not a power of two");
+/* Free pictures are tracked with one bit per picture in an array of atomic
+ * words, so that getting and returning pictures does not take a lock. The
+ * lock and condition variable are only used to put picture_pool_Wait() to
+ * sleep, and only signaled when a waiter is registered. */
+#define POOL_WORD_BITS (CHAR_BIT * sizeof (unsigned long long))
+#define POOL_WORDS(count) (((count) + POOL_WORD_BITS - 1) / POOL_WORD_BITS)
+
+struct picture_pool_slot {
+    picture_pool_t *pool;
+    picture_t *picture;
+};
 
 struct picture_pool_t {
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
-    bool               canceled;
-    unsigned long long available;
-    atomic_ushort      refs;
-    unsigned short     picture_count;
-    picture_t  *picture[];
+    atomic_bool        canceled;
+    atomic_uint        waiters;
+    atomic_uint        refs;
+    unsigned           picture_count;
+
+    /* statistics */
+    atomic_ulong       gets;
+    atomic_ulong       misses;
+    atomic_ulong       waits;
+    atomic_uint        used;
+    atomic_uint        used_max;
+
+    atomic_ullong     *available;
+    struct picture_pool_slot slot[];
 };
 
 static void picture_pool_Destroy(picture_pool_t *pool)
@@ -55,68 +72,137 @@ static void picture_pool_Destroy(picture_pool_t *pool)
         return;
 
     atomic_thread_fence(memory_order_acquire);
-    aligned_free(pool);
+    free(pool);
 }
 
 void picture_pool_Release(picture_pool_t *pool)
 {
     for (unsigned i = 0; i < pool->picture_count; i++)
-        picture_Release(pool->picture[i]);
+        picture_Release(pool->slot[i].picture);
     picture_pool_Destroy(pool);
 }
 
-static void picture_pool_ReleasePicture(picture_t *clone)
+/** Takes the lowest free picture index, or returns -1 if none is free. */
+static int picture_pool_TryAcquire(picture_pool_t *pool)
 {
-    picture_priv_t *priv = (picture_priv_t *)clone;
-    uintptr_t sys = (uintptr_t)priv->gc.opaque;
-    picture_pool_t *pool = (void *)(sys & ~(POOL_MAX - 1));
-    unsigned offset = sys & (POOL_MAX - 1);
-    picture_t *picture = pool->picture[offset];
+    for (unsigned w = 0; w < POOL_WORDS(pool->picture_count); w++)
+    {
+        unsigned long long word = atomic_load_explicit(&pool->available[w],
+                                                       memory_order_relaxed);
+        while (word != 0)
+        {
+            unsigned long long bit = word & -word;
+
+            if (atomic_compare_exchange_weak_explicit(&pool->available[w],
+                                                      &word, word & ~bit,
+                                                      memory_order_acquire,
+                                                      memory_order_relaxed))
+            {
+                unsigned used = atomic_fetch_add_explicit(&pool->used, 1,
+                                                    memory_order_relaxed) + 1;
+                unsigned max = atomic_load_explicit(&pool->used_max,
+                                                    memory_order_relaxed);
+                while (used > max
+                    && !atomic_compare_exchange_weak_explicit(&pool->used_max,
+                                    &max, used, memory_order_relaxed,
+                                    memory_order_relaxed));
+                return w * POOL_WORD_BITS + ctz(bit);
+            }
+        }
+    }
+    return -1;
+}
+
+/** Gives a picture back to the pool, and wakes a waiter up. */
+static void picture_pool_PutSlot(picture_pool_t *pool, unsigned offset)
+{
+    unsigned long long bit = 1ULL << (offset % POOL_WORD_BITS);
 
-    picture_Release(picture);
+    atomic_fetch_sub_explicit(&pool->used, 1, memory_order_relaxed);
+    unsigned long long prev =
+        atomic_fetch_or(&pool->available[offset / POOL_WORD_BITS], bit);
+    assert(!(prev & bit));
+    (void) prev;
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
+    /* Pairs with the waiter registration in picture_pool_Wait(): either the
+     * waiter sees the picture, or the picture is seen with the waiter. */
+    if (atomic_load(&pool->waiters) != 0)
+    {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
 
+static void picture_pool_ReleasePicture(picture_t *clone)
+{
+    picture_priv_t *priv = (picture_priv_t *)clone;
+    struct picture_pool_slot *slot = priv->gc.opaque;
+    picture_pool_t *pool = slot->pool;
+
+    picture_Release(slot->picture);
+    picture_pool_PutSlot(pool, slot - pool->slot);
     picture_pool_Destroy(pool);
 }
 
 static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
                                             unsigned offset)
 {
-    picture_t *picture = pool->picture[offset];
-    uintptr_t sys = ((uintptr_t)pool) + offset;
-
-    return picture_InternalClone(picture, picture_pool_ReleasePicture,
-                                 (void*)sys);
+    struct picture_pool_slot *slot = &pool->slot[offset];
+    picture_t *clone = picture_InternalClone(slot->picture,
+                                             picture_pool_ReleasePicture,
+                                             slot);
+    if (clone != NULL) {
+        assert(clone->p_next == NULL);
+        atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+    }
+    else
+    {   /* give the picture back */
+        picture_pool_PutSlot(pool, offset);
+    }
+    return clone;
 }
 
 picture_pool_t *picture_pool_New(unsigned count, picture_t *const *tab)
 {
-    if (unlikely(count > POOL_MAX))
-        return NULL;
-
     picture_pool_t *pool;
-    size_t size = sizeof (*pool) + count * sizeof (picture_t *);
+    size_t words = POOL_WORDS(count);
+    size_t size = sizeof (*pool) + count * sizeof (pool->slot[0]);
 
-    size += (-size) & (POOL_MAX - 1);
-    pool = aligned_alloc(POOL_MAX, size);
+    /* bitmap words after the slots */
+    size += (-size) & (_Alignof (atomic_ullong) - 1);
+    size_t bitmap_offset = size;
+    size += words * sizeof (atomic_ullong);
+
+    pool = malloc(size);
     if (unlikely(pool == NULL))
         return NULL;
 
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
-    if (count == POOL_MAX)
-        pool->available = ~0ULL;
-    else
-        pool->available = (1ULL << count) - 1;
+    atomic_init(&pool->canceled, false);
+    atomic_init(&pool->waiters, 0);
     atomic_init(&pool->refs,  1);
+    atomic_init(&pool->gets, 0);
+    atomic_init(&pool->misses, 0);
+    atomic_init(&pool->waits, 0);
+    atomic_init(&pool->used, 0);
+    atomic_init(&pool->used_max, 0);
     pool->picture_count = count;
-    memcpy(pool->picture, tab, count * sizeof (picture_t *));
-    pool->canceled = false;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        pool->slot[i].pool = pool;
+        pool->slot[i].picture = tab[i];
+    }
+
+    pool->available = (atomic_ullong *)((char *)pool + bitmap_offset);
+    for (size_t w = 0; w < words; w++)
+    {
+        unsigned bits = count - w * POOL_WORD_BITS;
+        atomic_init(&pool->available[w], (bits >= POOL_WORD_BITS)
+                    ? ~0ULL : (1ULL << bits) - 1);
+    }
     return pool;
 }
 
@@ -169,73 +255,73 @@ error:
 
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    unsigned long long available;
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-    available = pool->available;
+    atomic_fetch_add_explicit(&pool->gets, 1, memory_order_relaxed);
+    if (unlikely(atomic_load(&pool->canceled)))
+        return NULL;
 
-    while (available != 0)
+    int i = picture_pool_TryAcquire(pool);
+    if (i < 0)
     {
-        int i = ctz(available);
-
-        if (unlikely(pool->canceled))
-            break;
-
-        pool->available &= ~(1ULL << i);
-        vlc_mutex_unlock(&pool->lock);
-        available &= ~(1ULL << i);
-
-        picture_t *clone = picture_pool_ClonePicture(pool, i);
-        if (clone != NULL) {
-            assert(clone->p_next == NULL);
-            atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
-        }
-        return clone;
+        atomic_fetch_add_explicit(&pool->misses, 1, memory_order_relaxed);
+        return NULL;
     }
-
-    vlc_mutex_unlock(&pool->lock);
-    return NULL;
+    return picture_pool_ClonePicture(pool, i);
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    while (pool->available == 0)
+    atomic_fetch_add_explicit(&pool->gets, 1, memory_order_relaxed);
+    int i = atomic_load(&pool->canceled) ? -1 : picture_pool_TryAcquire(pool);
+    if (i < 0)
     {
-        if (pool->canceled)
+        vlc_mutex_lock(&pool->lock);
+        atomic_fetch_add(&pool->waiters, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        atomic_fetch_add_explicit(&pool->waits, 1, memory_order_relaxed);
+
+        while ((i = picture_pool_TryAcquire(pool)) < 0)
         {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
+            if (atomic_load(&pool->canceled))
+                break;
+            vlc_cond_wait(&pool->wait, &pool->lock);
         }
-        vlc_cond_wait(&pool->wait, &pool->lock);
-    }
 
-    int i = ctz(pool->available);
-    pool->available &= ~(1ULL << i);
-    vlc_mutex_unlock(&pool->lock);
+        atomic_fetch_sub(&pool->waiters, 1);
+        vlc_mutex_unlock(&pool->lock);
 
-    picture_t *clone = picture_pool_ClonePicture(pool, i);
-    if (clone != NULL) {
-        assert(clone->p_next == NULL);
-        atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+        if (i < 0)
+            return NULL;
     }
-    return clone;
+    return picture_pool_ClonePicture(pool, i);
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
     vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load_explicit(&pool->refs, memory_order_relaxed) > 0);
 
-    pool->canceled = canceled;
+    atomic_store(&pool->canceled, canceled);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
 }
 
+void picture_pool_GetStats(const picture_pool_t *pool,
+                           struct picture_pool_stats *stats)
+{
+    picture_pool_t *p = (picture_pool_t *)pool;
+
+    stats->gets = atomic_load_explicit(&p->gets, memory_order_relaxed);
+    stats->misses = atomic_load_explicit(&p->misses, memory_order_relaxed);
+    stats->waits = atomic_load_explicit(&p->waits, memory_order_relaxed);
+    stats->used = atomic_load_explicit(&p->used, memory_order_relaxed);
+    stats->used_max = atomic_load_explicit(&p->used_max, memory_order_relaxed);
+}
+
 unsigned picture_pool_GetSize(const picture_pool_t *pool)
 {
     return pool->picture_count;
@@ -38,6 +38,7 @@ struct subpicture_private_t
 {
     video_format_t src;
     video_format_t dst;
+    unsigned       i_updates;
 };
 
 subpicture_t *subpicture_New( const subpicture_updater_t *p_upd )
@@ -63,6 +64,7 @@ subpicture_t *subpicture_New( const subpicture_updater_t *p_upd )
         }
         video_format_Init( &p_private->src, 0 );
         video_format_Init( &p_private->dst, 0 );
+        p_private->i_updates = 0;
 
         p_subpic->updater   = *p_upd;
         p_subpic->p_private = p_private;
@@ -174,6 +176,12 @@ void subpicture_Update( subpicture_t *p_subpicture,
 
     video_format_Copy( &p_private->src, p_fmt_src );
     video_format_Copy( &p_private->dst, p_fmt_dst );
+    p_private->i_updates++;
+}
+
+unsigned subpicture_GetUpdates( const subpicture_t *p_subpicture )
+{
+    return p_subpicture->p_private ? p_subpicture->p_private->i_updates : 0;
 }
 
 
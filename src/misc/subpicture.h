@@ -30,3 +30,6 @@ subpicture_region_t * subpicture_region_NewInternal( const video_format_t *p_fmt
 subpicture_region_private_t *subpicture_region_private_New(video_format_t *);
 void subpicture_region_private_Delete(subpicture_region_private_t *);
 
+/* Number of times the updater regenerated the regions */
+unsigned subpicture_GetUpdates(const subpicture_t *);
+
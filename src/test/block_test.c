@@ -86,11 +86,65 @@ static void test_block (void)
     //assert (block == NULL);
 }
 
+/* AddressSanitizer builds do not recycle blocks */
+#if defined(__SANITIZE_ADDRESS__)
+# define BLOCK_TEST_NO_POOL
+#elif defined(__has_feature)
+# if __has_feature(address_sanitizer)
+#  define BLOCK_TEST_NO_POOL
+# endif
+#endif
+
+static void test_block_Recycle (void)
+{
+    static const size_t sizes[] = { 0, 1, 188, 512, 513, 4096, 65536, 65537 };
+
+    for (size_t i = 0; i < ARRAY_SIZE(sizes); i++)
+    {
+        block_t *block = block_Alloc (sizes[i]);
+        assert (block != NULL);
+        assert (block->i_buffer == sizes[i]);
+        assert (((uintptr_t)block->p_buffer % 32) == 0);
+        memset (block->p_buffer, 'B', block->i_buffer);
+
+        uint8_t *buffer = block->p_buffer;
+        block_Release (block);
+
+        /* a released block of the same size class is handed out again */
+        block = block_Alloc (sizes[i]);
+        assert (block != NULL);
+#ifndef BLOCK_TEST_NO_POOL
+        if (sizes[i] <= 65536)
+            assert (block->p_buffer == buffer);
+#else
+        (void) buffer;
+#endif
+        assert (block->i_buffer == sizes[i]);
+        assert (block->i_flags == 0 && block->p_next == NULL);
+        assert (block->i_pts == VLC_TICK_INVALID);
+        block_Release (block);
+    }
+
+#ifndef BLOCK_TEST_NO_POOL
+    /* TS packets share a size class with slightly larger blocks */
+    block_t *block = block_Alloc (188);
+    assert (block != NULL);
+    uint8_t *buffer = block->p_buffer;
+    block_Release (block);
+
+    block = block_Alloc (190);
+    assert (block != NULL);
+    assert (block->p_buffer == buffer);
+    block_Release (block);
+#endif
+}
+
 int main (void)
 {
     test_block_File(false);
     test_block_File(true);
     test_block ();
+    test_block_Recycle ();
     return 0;
 }
 
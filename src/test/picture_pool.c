@@ -108,6 +108,67 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+#define LARGE_PICTURES 150
+
+static void *test_large_wait(void *data)
+{
+    return picture_pool_Wait(data);
+}
+
+static void test_large(void)
+{
+    picture_t *pics[LARGE_PICTURES];
+    struct picture_pool_stats stats;
+    video_format_t small;
+
+    video_format_Setup(&small, VLC_CODEC_I420, 16, 16, 16, 16, 1, 1);
+    pool = picture_pool_NewFromFormat(&small, LARGE_PICTURES);
+    assert(pool != NULL);
+    assert(picture_pool_GetSize(pool) == LARGE_PICTURES);
+
+    for (unsigned i = 0; i < LARGE_PICTURES; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+        for (unsigned j = 0; j < i; j++)
+            assert(pics[j]->p[0].p_pixels != pics[i]->p[0].p_pixels);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+
+    picture_pool_GetStats(pool, &stats);
+    assert(stats.gets == LARGE_PICTURES + 1);
+    assert(stats.misses == 1);
+    assert(stats.used == LARGE_PICTURES);
+    assert(stats.used_max == LARGE_PICTURES);
+
+    /* a picture freed in the last bitmap word wakes up a waiter */
+    vlc_thread_t th;
+    void *waited;
+
+    assert(vlc_clone(&th, test_large_wait, pool, VLC_THREAD_PRIORITY_LOW) == 0);
+    void *plane = pics[LARGE_PICTURES - 1]->p[0].p_pixels;
+    picture_Release(pics[LARGE_PICTURES - 1]);
+    vlc_join(th, &waited);
+    pics[LARGE_PICTURES - 1] = waited;
+    assert(pics[LARGE_PICTURES - 1] != NULL);
+    assert(pics[LARGE_PICTURES - 1]->p[0].p_pixels == plane);
+
+    for (unsigned i = 0; i < LARGE_PICTURES; i++)
+        picture_Release(pics[i]);
+
+    picture_pool_GetStats(pool, &stats);
+    assert(stats.used == 0);
+    assert(stats.used_max == LARGE_PICTURES);
+
+    reserve = picture_pool_Reserve(pool, LARGE_PICTURES - 1);
+    assert(reserve != NULL);
+    pics[0] = picture_pool_Get(pool);
+    assert(pics[0] != NULL);
+    assert(picture_pool_Get(pool) == NULL);
+    picture_Release(pics[0]);
+    picture_pool_Release(reserve);
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -124,6 +185,7 @@ int main(void)
 
     test(false);
     test(true);
+    test_large();
 
     return 0;
 }
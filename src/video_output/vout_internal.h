@@ -287,6 +287,7 @@ void spu_SetClockDelay(spu_t *spu, size_t channel_id, vlc_tick_t delay);
 void spu_SetClockRate(spu_t *spu, size_t channel_id, float rate);
 void spu_ChangeChannelOrderMargin(spu_t *, enum vlc_vout_order, int);
 void spu_SetHighlight(spu_t *, const vlc_spu_highlight_t*);
+void spu_GetRenderCacheStats(spu_t *, unsigned *hits, unsigned *misses);
 
 /**
  * This function will (un)pause the display of pictures.
@@ -58,6 +58,7 @@ typedef struct {
     vlc_tick_t stop;  /* set to subpicture at rendering time */
     bool is_late;
     enum vlc_vout_order channel_order;
+    uint64_t serial; /* unique per subpicture, for the render cache */
 } spu_render_entry_t;
 
 typedef struct VLC_VECTOR(spu_render_entry_t) spu_render_vector;
@@ -75,6 +76,19 @@ typedef struct VLC_VECTOR(struct spu_channel) spu_channel_vector;
 typedef struct VLC_VECTOR(subpicture_t *) spu_prerender_vector;
 #define SPU_CHROMALIST_COUNT 8
 
+/* Settings affecting the placement of the regions */
+typedef struct {
+    int margin;
+    int secondary_margin;
+    int secondary_alignment;
+    bool force_crop;
+    int crop[4];
+    video_palette_t palette;
+} spu_render_settings_t;
+
+typedef struct spu_render_cached spu_render_cached_t;
+typedef struct VLC_VECTOR(spu_render_cached_t) spu_render_cached_vector;
+
 struct spu_private_t {
     vlc_mutex_t  lock;            /* lock to protect all followings fields */
     input_thread_t *input;
@@ -126,8 +140,23 @@ struct spu_private_t {
         vlc_fourcc_t    chroma_list[SPU_CHROMALIST_COUNT+1];
     } prerender;
 
+    /* Regions of the last rendering, reused while their subpicture is
+     * unchanged and rendered with the same parameters */
+    struct
+    {
+        spu_render_cached_vector regions;
+        spu_render_settings_t settings;
+        video_format_t  fmtdst;
+        video_format_t  fmtsrc;
+        vlc_fourcc_t    chroma_list[SPU_CHROMALIST_COUNT+1];
+        bool            external_scale;
+        unsigned        hits;
+        unsigned        misses;
+    } cache;
+
     /* */
     vlc_tick_t          last_sort_date;
+    uint64_t            last_serial;
     vout_thread_t       *vout;
 };
 
@@ -147,7 +176,8 @@ static void spu_channel_Init(struct spu_channel *channel, size_t id,
 }
 
 static int spu_channel_Push(struct spu_channel *channel, subpicture_t *subpic,
-                            vlc_tick_t orgstart, vlc_tick_t orgstop)
+                            vlc_tick_t orgstart, vlc_tick_t orgstop,
+                            uint64_t serial)
 {
     const spu_render_entry_t entry = {
         .subpic = subpic,
@@ -155,6 +185,7 @@ static int spu_channel_Push(struct spu_channel *channel, subpicture_t *subpic,
         .orgstop = orgstop,
         .start = subpic->i_start,
         .stop = subpic->i_stop,
+        .serial = serial,
     };
     return vlc_vector_push(&channel->entries, entry) ? VLC_SUCCESS : VLC_EGENERIC;
 }
@@ -772,6 +803,20 @@ spu_SelectSubpictures(spu_t *spu, vlc_tick_t system_now,
 
 
 
+static int SpuRenderAlpha(const subpicture_t *subpic, int region_alpha,
+                          vlc_tick_t render_date)
+{
+    int fade_alpha = 255;
+    if (subpic->b_fade) {
+        vlc_tick_t fade_start = subpic->i_start + 3 * (subpic->i_stop - subpic->i_start) / 4;
+
+        if (fade_start <= render_date && fade_start < subpic->i_stop)
+            fade_alpha = 255 * (subpic->i_stop - render_date) /
+                               (subpic->i_stop - fade_start);
+    }
+    return fade_alpha * subpic->i_alpha * region_alpha / 65025;
+}
+
 /**
  * It will transform the provided region into another region suitable for rendering.
  */
@@ -1104,16 +1149,183 @@ static void SpuRenderRegion(spu_t *spu,
         dst->i_align   = 0;
         assert(!dst->p_picture);
         dst->p_picture = picture_Hold(region_picture);
-        int fade_alpha = 255;
-        if (subpic->b_fade) {
-            vlc_tick_t fade_start = subpic->i_start + 3 * (subpic->i_stop - subpic->i_start) / 4;
+        dst->i_alpha   = SpuRenderAlpha(subpic, region->i_alpha, render_date);
+    }
+}
+
+/*****************************************************************************
+ * Render cache
+ *****************************************************************************
+ * Static subpictures are rendered to the same regions frame after frame:
+ * each rendered region is kept, and handed out again as long as its
+ * subpicture is selected, unchanged, for the same output. Only the fading
+ * alpha is recomputed then.
+ *****************************************************************************/
+struct spu_render_cached {
+    /* Key: the region of a subpicture, in the state it was rendered */
+    uint64_t serial;
+    unsigned updates;
+    enum vlc_vout_order channel_order;
+    const subpicture_region_t *source;
+
+    subpicture_region_t *output;
+    spu_area_t area; /* as returned by SpuRenderRegion() */
+    bool used;       /* by the current rendering */
+};
+
+static void SpuRenderSettingsGet(spu_private_t *sys,
+                                 spu_render_settings_t *settings)
+{
+    /* compared with memcmp() */
+    memset(settings, 0, sizeof(*settings));
+    settings->margin = sys->margin;
+    settings->secondary_margin = sys->secondary_margin;
+    settings->secondary_alignment = sys->secondary_alignment;
+    settings->force_crop = sys->force_crop;
+    settings->crop[0] = sys->crop.x;
+    settings->crop[1] = sys->crop.y;
+    settings->crop[2] = sys->crop.width;
+    settings->crop[3] = sys->crop.height;
+    settings->palette = sys->palette;
+}
+
+static bool SpuRenderFormatEqual(const video_format_t *a, const video_format_t *b)
+{
+    return a->i_chroma         == b->i_chroma &&
+           a->i_width          == b->i_width &&
+           a->i_height         == b->i_height &&
+           a->i_x_offset       == b->i_x_offset &&
+           a->i_y_offset       == b->i_y_offset &&
+           a->i_visible_width  == b->i_visible_width &&
+           a->i_visible_height == b->i_visible_height &&
+           a->i_sar_num        == b->i_sar_num &&
+           a->i_sar_den        == b->i_sar_den;
+}
+
+static subpicture_region_t *SpuRenderRegionDuplicate(const subpicture_region_t *r)
+{
+    subpicture_region_t *region = subpicture_region_NewInternal(&r->fmt);
+    if (!region)
+        return NULL;
+    region->i_x       = r->i_x;
+    region->i_y       = r->i_y;
+    region->i_align   = r->i_align;
+    region->i_alpha   = r->i_alpha;
+    region->zoom_h    = r->zoom_h;
+    region->zoom_v    = r->zoom_v;
+    region->p_picture = picture_Hold(r->p_picture);
+    return region;
+}
+
+static void SpuRenderCacheReset(spu_private_t *sys)
+{
+    for (size_t i = 0; i < sys->cache.regions.size; i++)
+        subpicture_region_Delete(sys->cache.regions.data[i].output);
+    vlc_vector_clear(&sys->cache.regions);
+}
+
+/* Flushes the cache if the rendering parameters changed, and marks the
+ * remaining regions as unused */
+static void SpuRenderCacheBegin(spu_private_t *sys,
+                                const vlc_fourcc_t *chroma_list,
+                                const video_format_t *fmt_dst,
+                                const video_format_t *fmt_src,
+                                bool external_scale)
+{
+    spu_render_settings_t settings;
+    SpuRenderSettingsGet(sys, &settings);
+
+    bool changed = sys->cache.external_scale != external_scale ||
+                   !SpuRenderFormatEqual(&sys->cache.fmtdst, fmt_dst) ||
+                   !SpuRenderFormatEqual(&sys->cache.fmtsrc, fmt_src) ||
+                   memcmp(&settings, &sys->cache.settings, sizeof(settings));
+    for (size_t i = 0; !changed && i <= SPU_CHROMALIST_COUNT; i++) {
+        changed = sys->cache.chroma_list[i] != chroma_list[i];
+        if (chroma_list[i] == 0)
+            break;
+    }
+
+    if (changed) {
+        SpuRenderCacheReset(sys);
+
+        sys->cache.settings = settings;
+        sys->cache.fmtdst = *fmt_dst;
+        sys->cache.fmtsrc = *fmt_src;
+        sys->cache.fmtdst.p_palette = sys->cache.fmtsrc.p_palette = NULL;
+        size_t i = 0;
+        for (; i < SPU_CHROMALIST_COUNT && chroma_list[i]; i++)
+            sys->cache.chroma_list[i] = chroma_list[i];
+        sys->cache.chroma_list[i] = 0;
+        sys->cache.external_scale = external_scale;
+    }
+
+    for (size_t i = 0; i < sys->cache.regions.size; i++)
+        sys->cache.regions.data[i].used = false;
+}
+
+static spu_render_cached_t *SpuRenderCacheFind(spu_private_t *sys,
+                                               const spu_render_entry_t *entry,
+                                               const subpicture_region_t *region)
+{
+    const unsigned updates = subpicture_GetUpdates(entry->subpic);
 
-            if (fade_start <= render_date && fade_start < subpic->i_stop)
-                fade_alpha = 255 * (subpic->i_stop - render_date) /
-                                   (subpic->i_stop - fade_start);
+    for (size_t i = 0; i < sys->cache.regions.size; i++) {
+        spu_render_cached_t *cached = &sys->cache.regions.data[i];
+        if (cached->source == region &&
+            cached->serial == entry->serial &&
+            cached->updates == updates &&
+            cached->channel_order == entry->channel_order) {
+            cached->used = true;
+            return cached;
         }
-        dst->i_alpha   = fade_alpha * subpic->i_alpha * region->i_alpha / 65025;
     }
+    return NULL;
+}
+
+static void SpuRenderCacheStore(spu_private_t *sys,
+                                const spu_render_entry_t *entry,
+                                const subpicture_region_t *region,
+                                const subpicture_region_t *output,
+                                spu_area_t area)
+{
+    spu_render_cached_t cached = {
+        .serial = entry->serial,
+        .updates = subpicture_GetUpdates(entry->subpic),
+        .channel_order = entry->channel_order,
+        .source = region,
+        .output = SpuRenderRegionDuplicate(output),
+        .area = area,
+        .used = true,
+    };
+    if (!cached.output)
+        return;
+    if (!vlc_vector_push(&sys->cache.regions, cached))
+        subpicture_region_Delete(cached.output);
+}
+
+/* Drops the regions that the last rendering did not use */
+static void SpuRenderCachePurge(spu_private_t *sys)
+{
+    for (size_t i = sys->cache.regions.size; i-- > 0;) {
+        if (sys->cache.regions.data[i].used)
+            continue;
+        subpicture_region_Delete(sys->cache.regions.data[i].output);
+        vlc_vector_remove(&sys->cache.regions, i);
+    }
+}
+
+/**
+ * Returns the number of regions served from the render cache, and the
+ * number of the ones that were rendered.
+ */
+void spu_GetRenderCacheStats(spu_t *spu, unsigned *hits, unsigned *misses)
+{
+    spu_private_t *sys = spu->p;
+
+    vlc_mutex_lock(&sys->lock);
+    *hits = sys->cache.hits;
+    *misses = sys->cache.misses;
+    vlc_mutex_unlock(&sys->lock);
 }
 
 /**
@@ -1129,6 +1341,8 @@ static subpicture_t *SpuRenderSubpictures(spu_t *spu,
                                           vlc_tick_t render_subtitle_date,
                                           bool external_scale)
 {
+    spu_private_t *sys = spu->p;
+
     /* Count the number of regions and subtitle regions */
     unsigned int subtitle_region_count = 0;
     unsigned int region_count          = 0;
@@ -1226,16 +1440,30 @@ static subpicture_t *SpuRenderSubpictures(spu_t *spu,
             const bool do_external_scale = external_scale && region->fmt.i_chroma != VLC_CODEC_TEXT;
             spu_scale_t virtual_scale = external_scale ? (spu_scale_t){ SCALE_UNIT, SCALE_UNIT } : scale;
 
-            /* */
-            SpuRenderRegion(spu, output_last_ptr, &area,
-                            entry, region, virtual_scale,
-                            chroma_list, fmt_dst,
-                            i_original_width, i_original_height,
-                            subtitle_area, subtitle_area_count,
-                            subpic->b_subtitle ? render_subtitle_date : system_now);
-            if (*output_last_ptr)
-            {
-                if (do_external_scale)
+            /* Subtitles are turned into absolute ones by their first
+             * rendering, which can move them: only the following
+             * renderings do not depend on the other regions. */
+            const bool cacheable = !subpic->b_subtitle || subpic->b_absolute;
+            const vlc_tick_t render_date = subpic->b_subtitle ? render_subtitle_date
+                                                              : system_now;
+            spu_render_cached_t *cached =
+                cacheable ? SpuRenderCacheFind(sys, entry, region) : NULL;
+
+            if (cached) {
+                area = cached->area;
+                *output_last_ptr = SpuRenderRegionDuplicate(cached->output);
+                if (*output_last_ptr)
+                    (*output_last_ptr)->i_alpha =
+                        SpuRenderAlpha(subpic, region->i_alpha, render_date);
+                sys->cache.hits++;
+            } else {
+                SpuRenderRegion(spu, output_last_ptr, &area,
+                                entry, region, virtual_scale,
+                                chroma_list, fmt_dst,
+                                i_original_width, i_original_height,
+                                subtitle_area, subtitle_area_count,
+                                render_date);
+                if (*output_last_ptr && do_external_scale)
                 {
                     if (scale.h != SCALE_UNIT)
                     {
@@ -1248,9 +1476,14 @@ static subpicture_t *SpuRenderSubpictures(spu_t *spu,
                         (*output_last_ptr)->zoom_v.den = SCALE_UNIT;
                     }
                 }
-
-                output_last_ptr = &(*output_last_ptr)->p_next;
+                /* Regions whose text rendering failed are retried */
+                if (*output_last_ptr && cacheable)
+                    SpuRenderCacheStore(sys, entry, region,
+                                        *output_last_ptr, area);
+                sys->cache.misses++;
             }
+            if (*output_last_ptr)
+                output_last_ptr = &(*output_last_ptr)->p_next;
 
             if (subpic->b_subtitle) {
                 area = spu_area_unscaled(area, scale);
@@ -1612,6 +1845,12 @@ static void spu_Cleanup(spu_t *spu)
     vlc_vector_clear(&sys->prerender.vector);
     video_format_Clean(&sys->prerender.fmtdst);
     video_format_Clean(&sys->prerender.fmtsrc);
+
+    if (sys->cache.hits + sys->cache.misses > 0)
+        msg_Dbg(spu, "render cache: %u hits, %u misses",
+                sys->cache.hits, sys->cache.misses);
+    SpuRenderCacheReset(sys);
+    vlc_vector_destroy(&sys->cache.regions);
 }
 
 /**
@@ -1685,6 +1924,12 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     sys->prerender.chroma_list[0] = 0;
     sys->prerender.chroma_list[SPU_CHROMALIST_COUNT] = 0;
 
+    vlc_vector_init(&sys->cache.regions);
+    video_format_Init(&sys->cache.fmtdst, 0);
+    video_format_Init(&sys->cache.fmtsrc, 0);
+    sys->cache.chroma_list[0] = 0;
+    sys->cache.hits = sys->cache.misses = 0;
+
     /* Load text and scale module */
     sys->text = SpuRenderCreateAndLoadText(spu);
     vlc_mutex_init(&sys->textlock);
@@ -1710,6 +1955,7 @@ spu_t *spu_Create(vlc_object_t *object, vout_thread_t *vout)
     }
     /* */
     sys->last_sort_date = -1;
+    sys->last_serial = 0;
     sys->vout = vout;
 
     if(vlc_clone(&sys->prerender.thread, spu_PrerenderThread, spu, VLC_THREAD_PRIORITY_VIDEO))
@@ -1876,7 +2122,8 @@ void spu_PutSubpicture(spu_t *spu, subpicture_t *subpic)
         subpic->i_stop = times[1];
     }
 
-    if (spu_channel_Push(channel, subpic, orgstart, orgstop))
+    if (spu_channel_Push(channel, subpic, orgstart, orgstop,
+                         ++sys->last_serial))
     {
         vlc_mutex_unlock(&sys->lock);
         msg_Err(spu, "subpicture heap full");
@@ -1957,6 +2204,7 @@ subpicture_t *spu_Render(spu_t *spu,
                              ignore_osd, &subpicture_count);
     if (!subpicture_array)
     {
+        SpuRenderCacheReset(sys);
         vlc_mutex_unlock(&sys->lock);
         return NULL;
     }
@@ -1984,7 +2232,8 @@ subpicture_t *spu_Render(spu_t *spu,
      * XXX The order is *really* important for overlap subtitles positionning */
     qsort(subpicture_array, subpicture_count, sizeof(*subpicture_array), SpuRenderCmp);
 
-    /* Render the subpictures */
+    /* Render the subpictures, reusing the regions that did not change */
+    SpuRenderCacheBegin(sys, chroma_list, fmt_dst, fmt_src, external_scale);
     subpicture_t *render = SpuRenderSubpictures(spu,
                                                 subpicture_count, subpicture_array,
                                                 chroma_list,
@@ -1993,6 +2242,7 @@ subpicture_t *spu_Render(spu_t *spu,
                                                 system_now,
                                                 render_subtitle_date,
                                                 external_scale);
+    SpuRenderCachePurge(sys);
     free(subpicture_array);
     vlc_mutex_unlock(&sys->lock);
 
@@ -0,0 +1,229 @@
+/*****************************************************************************
+ * ts_probe.c: MPEG-TS boundaries probing unit testing
+ *****************************************************************************
+ * Copyright (C) 2020 VideoLabs, VideoLAN and VLC Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_stream.h>
+
+/* A seekable stream with the PAT and the PMT in the first packets:
+ * the demuxer probes its boundaries while parsing its first batch of
+ * packets, which must remain readable */
+
+#define TS_SIZE     188
+#define PMT_PID     0x100
+#define ES_PID      0x101
+#define ES_PACKETS  2000
+#define ES_PAYLOAD  (TS_SIZE - 4 - 8 - 14)
+#define PCR_STEP    3600 /* 40ms */
+#define PTS_DELAY   9000
+
+static uint32_t crc32_mpeg(const uint8_t *p, size_t len)
+{
+    uint32_t crc = 0xffffffff;
+    for(size_t i = 0; i < len; i++)
+    {
+        crc ^= (uint32_t)p[i] << 24;
+        for(int j = 0; j < 8; j++)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+    }
+    return crc;
+}
+
+static void write_section(uint8_t *p, unsigned pid, unsigned cc,
+                          const uint8_t *section, size_t len)
+{
+    memset(p, 0xff, TS_SIZE);
+    p[0] = 0x47;
+    p[1] = 0x40 | (pid >> 8);
+    p[2] = pid & 0xff;
+    p[3] = 0x10 | (cc & 0x0f);
+    p[4] = 0x00; /* pointer field */
+    memcpy(&p[5], section, len);
+    SetDWBE(&p[5 + len], crc32_mpeg(section, len));
+}
+
+static void write_psi(uint8_t *p)
+{
+    const uint8_t pat[] = {
+        0x00, 0xb0, 13, 0x00, 0x01, 0xc1, 0x00, 0x00,
+        0x00, 0x01, 0xe0 | (PMT_PID >> 8), PMT_PID & 0xff,
+    };
+    write_section(p, 0, 0, pat, sizeof(pat));
+
+    const uint8_t pmt[] = {
+        0x02, 0xb0, 18, 0x00, 0x01, 0xc1, 0x00, 0x00,
+        0xe0 | (ES_PID >> 8), ES_PID & 0xff, 0xf0, 0x00,
+        0x03, 0xe0 | (ES_PID >> 8), ES_PID & 0xff, 0xf0, 0x00,
+    };
+    write_section(&p[TS_SIZE], PMT_PID, 0, pmt, sizeof(pmt));
+}
+
+/* one PES per packet, with a PCR, filled with its index */
+static void write_es(uint8_t *p, unsigned i)
+{
+    const uint64_t pcr = 90000 + (uint64_t) i * PCR_STEP;
+    const uint64_t pts = pcr + PTS_DELAY;
+
+    p[0] = 0x47;
+    p[1] = 0x40 | (ES_PID >> 8);
+    p[2] = ES_PID & 0xff;
+    p[3] = 0x30 | (i & 0x0f);
+    p[4] = 7;
+    p[5] = 0x10;
+    p[6] = pcr >> 25;
+    p[7] = pcr >> 17;
+    p[8] = pcr >> 9;
+    p[9] = pcr >> 1;
+    p[10] = ((pcr & 1) << 7) | 0x7e;
+    p[11] = 0x00;
+
+    uint8_t *pes = &p[12];
+    pes[0] = 0x00; pes[1] = 0x00; pes[2] = 0x01; pes[3] = 0xc0;
+    SetWBE(&pes[4], 3 + 5 + ES_PAYLOAD);
+    pes[6] = 0x80;
+    pes[7] = 0x80;
+    pes[8] = 5;
+    pes[9] = 0x21 | ((pts >> 29) & 0x0e);
+    pes[10] = pts >> 22;
+    pes[11] = ((pts >> 14) & 0xfe) | 0x01;
+    pes[12] = pts >> 7;
+    pes[13] = ((pts << 1) & 0xfe) | 0x01;
+    memset(&pes[14], i & 0xff, ES_PAYLOAD);
+}
+
+struct test_es_out
+{
+    es_out_t out;
+    unsigned i_blocks;
+    int      i_last; /* fill value of the last block */
+    bool     b_error;
+};
+
+static es_out_id_t *EsOutAdd(es_out_t *out, const es_format_t *fmt)
+{
+    VLC_UNUSED(out);
+    return (es_out_id_t *)(uintptr_t)(fmt->i_id + 1);
+}
+
+static int EsOutSend(es_out_t *out, es_out_id_t *id, block_t *p_block)
+{
+    struct test_es_out *ctx = container_of(out, struct test_es_out, out);
+    VLC_UNUSED(id);
+
+    /* parsed packets must be intact and in order */
+    if(p_block->i_buffer != ES_PAYLOAD ||
+       (ctx->i_last >= 0 && p_block->p_buffer[0] != ((ctx->i_last + 1) & 0xff)))
+        ctx->b_error = true;
+    for(size_t i = 1; i < p_block->i_buffer; i++)
+        if(p_block->p_buffer[i] != p_block->p_buffer[0])
+            ctx->b_error = true;
+
+    if(p_block->i_buffer)
+        ctx->i_last = p_block->p_buffer[0];
+    ctx->i_blocks++;
+    block_Release(p_block);
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel(es_out_t *out, es_out_id_t *id)
+{
+    VLC_UNUSED(out);
+    VLC_UNUSED(id);
+}
+
+static int EsOutControl(es_out_t *out, int query, va_list args)
+{
+    VLC_UNUSED(out);
+    VLC_UNUSED(query);
+    VLC_UNUSED(args);
+    return VLC_EGENERIC;
+}
+
+static void EsOutDestroy(es_out_t *out)
+{
+    VLC_UNUSED(out);
+}
+
+static const struct es_out_callbacks test_es_out_cbs =
+{
+    EsOutAdd,
+    EsOutSend,
+    EsOutDel,
+    EsOutControl,
+    EsOutDestroy,
+};
+
+int main(void)
+{
+    test_init();
+
+    const size_t i_size = (2 + ES_PACKETS) * TS_SIZE;
+    uint8_t *p_data = malloc(i_size);
+    assert(p_data);
+    write_psi(p_data);
+    for(unsigned i = 0; i < ES_PACKETS; i++)
+        write_es(&p_data[(2 + i) * TS_SIZE], i);
+
+    libvlc_instance_t *vlc = libvlc_new(0, NULL);
+    assert(vlc);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    stream_t *s = vlc_stream_MemoryNew(obj, p_data, i_size, false);
+    assert(s);
+
+    struct test_es_out ctx = {
+        .out = { .cbs = &test_es_out_cbs },
+        .i_last = -1,
+    };
+    demux_t *demux = demux_New(obj, "ts", s, &ctx.out);
+    if(!demux)
+    {
+        /* built without the TS demuxer */
+        vlc_stream_Delete(s);
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    /* the PMT is parsed, and the boundaries probed, on the first call */
+    assert(demux_Demux(demux) == VLC_DEMUXER_SUCCESS);
+    vlc_tick_t i_length = 0;
+    assert(demux_Control(demux, DEMUX_GET_LENGTH, &i_length) == VLC_SUCCESS);
+    assert(i_length >= VLC_TICK_FROM_MS(40) * (ES_PACKETS - 1));
+
+    int ret;
+    while((ret = demux_Demux(demux)) == VLC_DEMUXER_SUCCESS);
+    assert(ret == VLC_DEMUXER_EOF);
+
+    assert(!ctx.b_error);
+    assert(ctx.i_blocks > ES_PACKETS / 2);
+
+    demux_Delete(demux); /* also deletes the stream, and the data */
+    libvlc_release(vlc);
+    return 0;
+}
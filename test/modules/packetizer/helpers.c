@@ -64,30 +64,63 @@ static int check_set( const uint8_t *p_set, const uint8_t *p_end,
     return 0;
 }
 
+static const struct
+{
+    const char *psz_name;
+    const uint8_t *(*pf_find)(const uint8_t *, const uint8_t *);
+} annexb_finders[] = {
+    { "bits", startcode_FindAnnexB_Bits },
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    { "sse2", startcode_FindAnnexB_SSE2 },
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    { "avx2", startcode_FindAnnexB_AVX2 },
+#endif
+#ifdef STARTCODE_HAVE_NEON
+    { "neon", startcode_FindAnnexB_NEON },
+#endif
+};
+
+static bool annexb_finder_usable( const char *psz_name )
+{
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    if( !strcmp( psz_name, "sse2" ) )
+        return vlc_CPU_SSE2();
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( !strcmp( psz_name, "avx2" ) )
+        return vlc_CPU_AVX2();
+#endif
+#ifdef STARTCODE_HAVE_NEON
+    if( !strcmp( psz_name, "neon" ) )
+        return vlc_CPU_ARM_NEON();
+#endif
+    return true;
+}
+
 static int run_annexb_sets( const uint8_t *p_set, const uint8_t *p_end,
                             const struct results_s *p_results, size_t i_results,
                             ssize_t i_results_offset )
 {
-    int i_ret;
-
-    printf("checking bits code:\n");
-    i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
-                       startcode_FindAnnexB_Bits );
-    if( i_ret != 0 )
-        return i_ret;
-
-    /* Perform same tests on simd optimized code */
-    if( startcode_FindAnnexB_Bits != startcode_FindAnnexB )
+    for( size_t i=0; i<ARRAY_SIZE(annexb_finders); i++ )
     {
-        printf("checking asm:\n");
-        i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
-                           startcode_FindAnnexB );
+        if( !annexb_finder_usable( annexb_finders[i].psz_name ) )
+        {
+            printf("%s not supported by cpu, skipping test:\n",
+                   annexb_finders[i].psz_name);
+            continue;
+        }
+
+        printf("checking %s code:\n", annexb_finders[i].psz_name);
+        int i_ret = check_set( p_set, p_end, p_results, i_results, i_results_offset,
+                               annexb_finders[i].pf_find );
         if( i_ret != 0 )
             return i_ret;
     }
-    else printf("asm not built in, skipping test:\n");
 
-    return 0;
+    printf("checking dispatched code:\n");
+    return check_set( p_set, p_end, p_results, i_results, i_results_offset,
+                      startcode_FindAnnexB );
 }
 
 int main( void )
@@ -134,5 +167,19 @@ int main( void )
             return i_ret;
     }
 
+    /* single startcode at every position around vector boundaries */
+    uint8_t sweep[96 + 3 + 7];
+    for( size_t i=0; i<96; i++ )
+    {
+        memset( sweep, 0x42, sizeof(sweep) );
+        memcpy( &sweep[i], test1_annexbdata + 1, 3 );
+        const struct results_s sweep_result = { i, 3 };
+        printf("* Running tests on sweep %zu:\n", i);
+        i_ret = run_annexb_sets( sweep, sweep + i + 3 + (i & 7),
+                                 &sweep_result, 1, 0 );
+        if( i_ret != 0 )
+            return i_ret;
+    }
+
     return 0;
 }
@@ -0,0 +1,213 @@
+/*****************************************************************************
+ * startcode_bench.c: Annex B startcode and emulation prevention scan timing
+ *****************************************************************************
+ * Copyright © 2020 VideoLabs and VideoLAN Authors
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Usage: test_modules_packetizer_startcode_bench [elementary stream files]
+ * Without files, a synthetic stream with sparse startcodes is used. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_tick.h>
+
+#include "../modules/packetizer/startcode_helper.h"
+#include "../modules/packetizer/hxxx_ep3b.h"
+
+#define BENCH_MIN_BYTES (256 << 20)
+
+typedef const uint8_t *(*startcode_finder_t)(const uint8_t *, const uint8_t *);
+
+static const struct
+{
+    const char *psz_name;
+    startcode_finder_t pf_find;
+} finders[] = {
+    { "bits", startcode_FindAnnexB_Bits },
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    { "sse2", startcode_FindAnnexB_SSE2 },
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    { "avx2", startcode_FindAnnexB_AVX2 },
+#endif
+#ifdef STARTCODE_HAVE_NEON
+    { "neon", startcode_FindAnnexB_NEON },
+#endif
+};
+
+static bool finder_usable( const char *psz_name )
+{
+#if defined(CAN_COMPILE_SSE2) || defined(HAVE_SSE2_INTRINSICS)
+    if( !strcmp( psz_name, "sse2" ) )
+        return vlc_CPU_SSE2();
+#endif
+#ifdef HAVE_AVX2_INTRINSICS
+    if( !strcmp( psz_name, "avx2" ) )
+        return vlc_CPU_AVX2();
+#endif
+#ifdef STARTCODE_HAVE_NEON
+    if( !strcmp( psz_name, "neon" ) )
+        return vlc_CPU_ARM_NEON();
+#endif
+    VLC_UNUSED(psz_name);
+    return true;
+}
+
+static size_t count_startcodes( startcode_finder_t pf_find,
+                                const uint8_t *p, const uint8_t *p_end )
+{
+    size_t i_count = 0;
+    while( (p = pf_find( p, p_end )) != NULL )
+    {
+        i_count++;
+        p += 3;
+    }
+    return i_count;
+}
+
+/* total size of all NAL payloads after emulation prevention removal */
+static size_t count_rbsp( const uint8_t *p, const uint8_t *p_end )
+{
+    size_t i_total = 0;
+    p = startcode_FindAnnexB( p, p_end );
+    while( p != NULL )
+    {
+        const uint8_t *p_next = startcode_FindAnnexB( p + 3, p_end );
+        i_total += hxxx_ep3b_total_size( p + 3, p_next ? p_next : p_end );
+        p = p_next;
+    }
+    return i_total;
+}
+
+static void report( const char *psz_name, size_t i_bytes, vlc_tick_t i_time )
+{
+    if( i_time <= 0 )
+        i_time = 1;
+    printf( "  %-6s %8.1f MiB/s\n", psz_name,
+            (double) i_bytes * CLOCK_FREQ / i_time / (1 << 20) );
+}
+
+static int bench( const uint8_t *p_data, size_t i_data )
+{
+    const unsigned i_loops = __MAX( 1, BENCH_MIN_BYTES / __MAX( i_data, 1 ) );
+    size_t i_expected = 0;
+
+    printf( "%zu bytes, %u loops\n", i_data, i_loops );
+
+    for( size_t i=0; i<ARRAY_SIZE(finders); i++ )
+    {
+        if( !finder_usable( finders[i].psz_name ) )
+            continue;
+
+        size_t i_count = 0;
+        vlc_tick_t i_start = vlc_tick_now();
+        for( unsigned j=0; j<i_loops; j++ )
+            i_count = count_startcodes( finders[i].pf_find, p_data, &p_data[i_data] );
+        report( finders[i].psz_name, i_data * i_loops, vlc_tick_now() - i_start );
+
+        /* all variants must agree */
+        if( i == 0 )
+            i_expected = i_count;
+        else if( i_count != i_expected )
+        {
+            printf( "%s found %zu startcodes, expected %zu\n",
+                    finders[i].psz_name, i_count, i_expected );
+            return 1;
+        }
+    }
+
+    size_t i_rbsp = 0;
+    vlc_tick_t i_start = vlc_tick_now();
+    for( unsigned j=0; j<i_loops; j++ )
+        i_rbsp = count_rbsp( p_data, &p_data[i_data] );
+    report( "ep3b", i_data * i_loops, vlc_tick_now() - i_start );
+    printf( "  %zu startcodes, %zu rbsp bytes\n", i_expected, i_rbsp );
+
+    return 0;
+}
+
+static uint8_t * load_file( const char *psz_path, size_t *pi_size )
+{
+    FILE *p_file = fopen( psz_path, "rb" );
+    if( p_file == NULL )
+        return NULL;
+
+    uint8_t *p_data = NULL;
+    long i_size;
+    if( fseek( p_file, 0, SEEK_END ) == 0 && (i_size = ftell( p_file )) > 0 &&
+        fseek( p_file, 0, SEEK_SET ) == 0 &&
+        (p_data = malloc( i_size )) != NULL &&
+        fread( p_data, i_size, 1, p_file ) == 1 )
+        *pi_size = i_size;
+    else
+    {
+        free( p_data );
+        p_data = NULL;
+    }
+    fclose( p_file );
+    return p_data;
+}
+
+int main( int argc, char **argv )
+{
+    int i_ret = 0;
+
+    if( argc < 2 )
+    {
+        /* slice sized payloads with some escapes */
+        const size_t i_data = 4 << 20;
+        uint8_t *p_data = malloc( i_data );
+        assert( p_data );
+        uint32_t seed = 0x5eed;
+        for( size_t i=0; i<i_data; i++ )
+        {
+            seed = seed * 1103515245 + 12345;
+            p_data[i] = (seed >> 16) | 1;
+        }
+        for( size_t i=0; i + 4 < i_data; i += 4096 + (i & 511) )
+            memcpy( &p_data[i], "\x00\x00\x01\x65", 4 );
+        for( size_t i=1000; i + 3 < i_data; i += 1500 )
+            memcpy( &p_data[i], "\x00\x00\x03", 3 );
+
+        printf( "synthetic stream: " );
+        i_ret = bench( p_data, i_data );
+        free( p_data );
+        return i_ret;
+    }
+
+    for( int i=1; i<argc && i_ret == 0; i++ )
+    {
+        size_t i_data;
+        uint8_t *p_data = load_file( argv[i], &i_data );
+        if( p_data == NULL )
+        {
+            fprintf( stderr, "cannot read %s\n", argv[i] );
+            return 1;
+        }
+        printf( "%s: ", argv[i] );
+        i_ret = bench( p_data, i_data );
+        free( p_data );
+    }
+
+    return i_ret;
+}
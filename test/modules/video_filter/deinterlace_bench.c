@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * deinterlace_bench.c: deinterlacer slice threading timing and consistency
+ *****************************************************************************
+ * Copyright © 2020 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Usage: test_modules_video_filter_deinterlace_bench [frames]
+ * Deinterlaces synthetic 1080i I420 frames with each algorithm and several
+ * thread counts, and checks that the output does not depend on the latter. */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+#include <vlc_tick.h>
+
+#define WIDTH  1920
+#define HEIGHT 1080
+
+static const char *const modes[] = {
+    "x", "yadif", "yadif2x", "phosphor", "ivtc",
+};
+
+/* Two fields 1/50th of a second apart, with a moving diagonal pattern */
+static picture_t *create_frame( const video_format_t *fmt, unsigned i_frame )
+{
+    picture_t *pic = picture_NewFromFormat( fmt );
+    if( pic == NULL )
+        return NULL;
+
+    for( int i = 0; i < pic->i_planes; i++ )
+    {
+        plane_t *p = &pic->p[i];
+        for( int y = 0; y < p->i_visible_lines; y++ )
+        {
+            const unsigned t = 2 * i_frame + (y & 1);
+            uint8_t *line = &p->p_pixels[y * p->i_pitch];
+            for( int x = 0; x < p->i_visible_pitch; x++ )
+                line[x] = ((x + y + 6 * t) ^ (x >> 4)) + 37 * i;
+        }
+    }
+
+    pic->date = VLC_TICK_0 + i_frame * VLC_TICK_FROM_MS(40);
+    pic->b_progressive = false;
+    pic->b_top_field_first = true;
+    pic->i_nb_fields = 2;
+    return pic;
+}
+
+static uint32_t checksum( uint32_t i_hash, const picture_t *pic )
+{
+    /* FNV-1a over the visible pixels */
+    for( int i = 0; i < pic->i_planes; i++ )
+    {
+        const plane_t *p = &pic->p[i];
+        for( int y = 0; y < p->i_visible_lines; y++ )
+            for( int x = 0; x < p->i_visible_pitch; x++ )
+            {
+                i_hash ^= p->p_pixels[y * p->i_pitch + x];
+                i_hash *= 16777619u;
+            }
+    }
+    return i_hash;
+}
+
+static int bench( vlc_object_t *obj, const char *psz_mode, unsigned i_threads,
+                  picture_t **frames, unsigned i_frames,
+                  uint32_t *pi_hash, vlc_tick_t *pi_time )
+{
+    filter_chain_t *chain = filter_chain_NewVideo( obj, false, NULL );
+    if( chain == NULL )
+        return VLC_ENOMEM;
+
+    es_format_t fmt;
+    es_format_Init( &fmt, VIDEO_ES, VLC_CODEC_I420 );
+    video_format_Copy( &fmt.video, &frames[0]->format );
+    filter_chain_Reset( chain, &fmt, NULL, &fmt );
+    es_format_Clean( &fmt );
+
+    char psz_filter[64];
+    snprintf( psz_filter, sizeof(psz_filter),
+              "deinterlace{mode=%s,threads=%u}", psz_mode, i_threads );
+    if( filter_chain_AppendFromString( chain, psz_filter ) != 1 )
+    {
+        filter_chain_Delete( chain );
+        return VLC_EGENERIC;
+    }
+
+    uint32_t i_hash = 2166136261u;
+    vlc_tick_t i_time = 0;
+
+    for( unsigned i = 0; i < i_frames; i++ )
+    {
+        vlc_tick_t i_start = vlc_tick_now();
+        picture_t *out = filter_chain_VideoFilter( chain,
+                                                   picture_Hold( frames[i] ) );
+        i_time += vlc_tick_now() - i_start;
+
+        while( out != NULL )
+        {
+            i_hash = checksum( i_hash, out );
+            picture_Release( out );
+
+            /* the following outputs of the same input, e.g. with yadif2x */
+            i_start = vlc_tick_now();
+            out = filter_chain_VideoFilter( chain, NULL );
+            i_time += vlc_tick_now() - i_start;
+        }
+    }
+
+    filter_chain_Delete( chain );
+    *pi_hash = i_hash;
+    *pi_time = i_time;
+    return VLC_SUCCESS;
+}
+
+int main( int argc, char **argv )
+{
+    /* Benchmarks may run longer than the default test timeout */
+    setenv( "VLC_TEST_TIMEOUT", "0", 0 );
+    test_init();
+
+    unsigned i_frames = argc > 1 ? strtoul( argv[1], NULL, 10 ) : 50;
+    if( i_frames == 0 )
+        return 1;
+
+    libvlc_instance_t *vlc = libvlc_new( 0, NULL );
+    if( vlc == NULL )
+        return 1;
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    video_format_t fmt;
+    video_format_Init( &fmt, VLC_CODEC_I420 );
+    video_format_Setup( &fmt, VLC_CODEC_I420, WIDTH, HEIGHT, WIDTH, HEIGHT,
+                        1, 1 );
+    fmt.i_frame_rate = 25;
+    fmt.i_frame_rate_base = 1;
+
+    picture_t **frames = vlc_alloc( i_frames, sizeof(*frames) );
+    assert( frames != NULL );
+    for( unsigned i = 0; i < i_frames; i++ )
+    {
+        frames[i] = create_frame( &fmt, i );
+        assert( frames[i] != NULL );
+    }
+
+    /* 1 thread first: the reference for the output and the speedup */
+    unsigned pi_threads[] = { 1, 2, 4, vlc_GetCPUCount() };
+    int i_ret = 0;
+
+    printf( "%ux%u I420, %u frames, %u CPUs\n", WIDTH, HEIGHT, i_frames,
+            vlc_GetCPUCount() );
+
+    for( size_t i = 0; i < ARRAY_SIZE(modes) && i_ret == 0; i++ )
+    {
+        uint32_t i_ref_hash = 0;
+        vlc_tick_t i_ref_time = 0;
+
+        for( size_t j = 0; j < ARRAY_SIZE(pi_threads); j++ )
+        {
+            if( j == ARRAY_SIZE(pi_threads) - 1 && pi_threads[j] <= 4 )
+                break; /* already measured */
+
+            uint32_t i_hash;
+            vlc_tick_t i_time;
+            if( bench( obj, modes[i], pi_threads[j], frames, i_frames,
+                       &i_hash, &i_time ) )
+            {
+                fprintf( stderr, "cannot create deinterlace mode %s\n",
+                         modes[i] );
+                i_ret = 1;
+                break;
+            }
+            if( i_time <= 0 )
+                i_time = 1;
+
+            if( j == 0 )
+            {
+                i_ref_hash = i_hash;
+                i_ref_time = i_time;
+            }
+
+            printf( "  %-8s %2u threads %8.1f fps  x%.2f  %08"PRIx32"\n",
+                    modes[i], pi_threads[j],
+                    (double) i_frames * CLOCK_FREQ / i_time,
+                    (double) i_ref_time / i_time, i_hash );
+
+            /* the output must not depend on the number of threads */
+            if( i_hash != i_ref_hash )
+            {
+                fprintf( stderr, "%s output differs with %u threads\n",
+                         modes[i], pi_threads[j] );
+                i_ret = 1;
+                break;
+            }
+        }
+    }
+
+    for( unsigned i = 0; i < i_frames; i++ )
+        picture_Release( frames[i] );
+    free( frames );
+    libvlc_release( vlc );
+    return i_ret;
+}